@@ -1,3 +1,6 @@
+import os
+import warnings
+
 from ._version import __version__
 from enum import Enum
 from importlib.util import find_spec
@@ -27,8 +30,40 @@ def variogram(type, *args, **kwargs):
     return _gaussianfft.variogram(type, *args, **kwargs)
 
 
+def simulate_to_file(filenames, *args, **kwargs):
+    if isinstance(filenames, (str, os.PathLike)):
+        filenames = [filenames]
+    return _gaussianfft.simulate_to_file([os.fspath(f) for f in filenames], *args, **kwargs)
+
+
+_unset = object()
+
+
+def cache_dir(path=_unset):
+    if path is _unset:
+        return _gaussianfft.cache_dir()
+    _gaussianfft.cache_dir('' if path is None else os.fspath(path))
+
+
+if os.environ.get('GAUSSIANFFT_CACHE_DIR'):
+    cache_dir(os.environ['GAUSSIANFFT_CACHE_DIR'])
+
+if os.environ.get('GAUSSIANFFT_FFT_BACKEND'):
+    try:
+        fft_backend(os.environ['GAUSSIANFFT_FFT_BACKEND'])
+    except RuntimeError as e:
+        warnings.warn(f'Ignoring GAUSSIANFFT_FFT_BACKEND: {e}')
+
+
 __all__ = [
     'variogram', 'simulate', 'seed', 'advanced', 'simulation_size',
     'quote', 'Variogram', 'VariogramType', 'util', 'SizeTVector', 'DoubleVector',
+    'profiling', 'last_run_stats', 'last_run_trace', 'simulate_to_file',
+    'simulate_multi', 'nested_variogram', 'Simulator', 'FieldSequence',
+    'simulate_traces', 'VariogramMap', 'Transform', 'simulate_jobs',
+    'simulate_points', 'EclipseGrid', 'simulate_eclipse_grid',
+    'cache_dir', 'release_workspace', 'huge_pages', 'seed_streams', 'RandomStream',
+    'legacy_noise', 'simulate_active', 'simulate_slabs', 'fft_backend',
+    'fft_threads', 'fft_benchmark', 'workspace_limit',
     '__version__',
 ]
@@ -1,5 +1,6 @@
 from enum import Enum
-from typing import Collection, Iterable, Optional, Union, overload
+from os import PathLike
+from typing import Callable, Collection, Dict, Iterable, Iterator, List, Optional, Tuple, Union, overload
 
 from numpy import ndarray
 
@@ -55,6 +56,57 @@ class Variogram(object):
     @overload
     def corr(self, dx: float) -> float:...
 
+    def corr_array(
+            self,
+            dx: ndarray,
+            dy: Optional[ndarray] = None,
+            dz: Optional[ndarray] = None,
+    ) -> ndarray:
+        """
+Correlation function for arrays of lags. This is much faster than calling
+Variogram.corr in a loop, and the lags are evaluated in parallel.
+
+Parameters
+----------
+dx: numpy.ndarray
+    Lags in x-direction.
+dy, dz: numpy.ndarray, optional
+    Lags in y- and z-direction, with the same shape as dx. Leave out dz, or
+    both dy and dz, for 2D and 1D lags, as for Variogram.corr.
+
+Returns
+-------
+numpy.ndarray with the same shape as dx.
+
+Examples
+--------
+>>> import gaussianfft
+>>> import numpy as np
+>>> v = gaussianfft.variogram('spherical', 100.0, 50.0)
+>>> x, y = np.meshgrid(np.linspace(-100, 100, 201), np.linspace(-100, 100, 201))
+>>> corr = v.corr_array(x, y)
+        """
+        pass
+
+    def cov_matrix(self, points_a: ndarray, points_b: Optional[ndarray] = None) -> ndarray:
+        """
+Covariance matrix between two sets of points. The rows are evaluated in
+parallel.
+
+Parameters
+----------
+points_a: numpy.ndarray
+    Points with shape (n_a, dim), where dim is 1, 2 or 3, or shape (n_a,)
+    for 1D points.
+points_b: numpy.ndarray, optional
+    Points with shape (n_b, dim) or (n_b,). Default is points_a.
+
+Returns
+-------
+numpy.ndarray with shape (n_a, n_b).
+        """
+        pass
+
 
 """
 gaussianfft.variogram
@@ -115,13 +167,103 @@ Multiple directions
     pass
 
 
+"""
+gaussianfft.Transform
+"""
+
+
+class Transform(object):
+    """
+Pipeline of pointwise transforms of a simulated field. The steps are applied in
+the order they are added, in a single parallel pass that writes the final values
+directly, either when simulating (see gaussianfft.simulate) or with
+Transform.apply. Each method returns the transform, so calls can be chained.
+
+Examples
+--------
+>>> v = gaussianfft.variogram('spherical', 200.0, 100.0)
+
+Porosity with mean 0.2, standard deviation 0.03 and a trend
+
+>>> t = gaussianfft.Transform().affine(0.03, 0.2).trend(porosity_trend)
+>>> poro = gaussianfft.simulate(v, 100, 10.0, 100, 10.0, transform=t)
+
+Three facies with proportions 0.3, 0.5 and 0.2, as an int8 array
+
+>>> t = gaussianfft.Transform().thresholds([-0.5244, 0.8416])
+>>> facies = gaussianfft.simulate(v, 100, 10.0, 100, 10.0, transform=t)
+    """
+    def __init__(self): ...
+
+    @property
+    def has_thresholds(self) -> bool: ...
+
+    def affine(self, scale: float = 1.0, shift: float = 0.0) -> 'Transform':
+        """
+Adds the step value = scale*value + shift.
+        """
+        ...
+
+    def trend(self, trend: ndarray) -> 'Transform':
+        """
+Adds the step value = value + trend, where trend has one value per cell, with the
+ordering of the result of gaussianfft.simulate, or the shape (nx, ny, nz) in
+Fortran order.
+        """
+        ...
+
+    def exp(self) -> 'Transform':
+        """
+Adds the step value = exp(value).
+        """
+        ...
+
+    def lognormal(self, mean: float, std: float) -> 'Transform':
+        """
+Adds steps that transform a standard normal value to a lognormal value with the
+given mean and standard deviation.
+        """
+        ...
+
+    def table(self, x: Collection[float], y: Collection[float]) -> 'Transform':
+        """
+Adds a piecewise linear mapping given by a table, for instance a normal score
+back transform. x must be increasing. Values outside the table are mapped to the
+first or last y.
+        """
+        ...
+
+    def thresholds(self, thresholds: Collection[float]) -> 'Transform':
+        """
+Ends the pipeline by truncating the values into integer codes. The code is the
+number of thresholds that are less than or equal to the value, so n thresholds
+give the codes 0, ..., n. The thresholds must be increasing, and there can be at
+most 127. The result has type int8.
+        """
+        ...
+
+    def apply(self, field: ndarray) -> ndarray:
+        """
+Applies the transform to a field, and returns a new array with the same shape.
+        """
+        ...
+
+
 """
 gaussianfft.simulate
 """
 
 
 @overload
-def simulate(variogram: Variogram, nx: int, ny: int, nz: int, dx: float, dy: float, dz: float) -> ndarray:
+def simulate(
+        variogram: Variogram,
+        nx: int, dx: float,
+        ny: int = 1, dy: float = -1.0,
+        nz: int = 1, dz: float = -1.0,
+        transform: Optional['Transform'] = None,
+        rotation: float = 0.0,
+        block: Tuple[float, ...] = (),
+) -> ndarray:
     """
 Simulates a Gaussian random field with the corresponding variogram in one, two or
 three dimensions. The random generator seed may be set by using gaussianfft.seed.
@@ -137,12 +279,29 @@ nx, ny, nz: int
 dx, dy, dz: float
     Grid resolution in x, y and z directions. dx is always required. dy and dz are
     required if respectively ny and nz are greater than 1.
+transform: gaussianfft.Transform, optional
+    Post-processing of the standard normal field, applied while the result is
+    copied out, so no intermediate arrays are needed.
+rotation: float, optional
+    Counterclockwise rotation of the grid x-axis in degrees, as in the header of
+    a rotated Storm grid or surface. The azimuth of the variogram is then taken
+    relative to the unrotated axes and converted to the frame of the grid, so
+    the padding follows the grid rather than its axis-aligned bounding box.
+    Default is 0.0.
+block: tuple of float, optional
+    Block sizes (bx, by, bz) along the grid axes, for simulation directly on a
+    coarse grid. The values are then averages over blocks of this size around
+    each cell center, typically (dx, dy, dz), rather than point values, so they
+    have the lower variance and smoother covariance of upscaled values. The box
+    average is applied to the spectrum of the filter, so the cost is that of the
+    coarse grid. Missing sizes are 0.0, which gives point support along that axis.
+    Default is point support.
 
 Returns
 -------
 out: numpy.ndarray
     One-dimensional array with the simulation result. Uses Fortran ordering if the
-    simulation is multi-dimensional.
+    simulation is multi-dimensional. The type is int8 if transform has thresholds.
 
 Examples
 --------
@@ -179,37 +338,1178 @@ def simulate(variogram: Variogram, nx: int, dx: float) -> ndarray:...
 
 
 """
-gaussianfft.seed
+gaussianfft.Simulator
 """
 
 
-@overload
-def seed(seed: int) -> None:
+class FieldSequence(Iterator[ndarray]):
+    def __iter__(self) -> 'FieldSequence': ...
+
+    def __next__(self) -> ndarray: ...
+
+
+class Simulator(object):
     """
-Sets the current simulation seed. If this has not been set when calling
-gaussianfft.simulate, it is set to the current time with second precision. Be wary of
-the latter, in particular if gaussianfft is used in a parallel-processing context.
+Simulator for Gaussian random fields with a fixed variogram and grid. The
+filter is computed once, when the simulator is created, so repeated simulations
+are faster than calls to gaussianfft.simulate.
+
+The simulator also keeps a latent noise state in the Fourier domain, which is
+used for sequences of correlated fields, z_t = rho z_(t-1) + sqrt(1 - rho^2) e_t,
+and for gradual deformation, z(theta) = cos(theta) z + sin(theta) v. Each new
+field in a sequence or deformation needs a single inverse Fourier transform.
+
+Parameters
+----------
+variogram, nx, dx, ny, dy, nz, dz:
+    See gaussianfft.simulate.
+padx, pady, padz: int, optional
+    See gaussianfft.advanced.simulate.
 
 Examples
 --------
 >>> import gaussianfft
->>> gaussianfft.seed(123)
+>>> import numpy as np
+>>> v = gaussianfft.variogram('gaussian', 250.0, 125.0)
+>>> sim = gaussianfft.Simulator(v, 100, 10.0, 100, 10.0)
+>>> fields = [sim.simulate() for _ in range(10)]
+
+A sequence of 20 fields where consecutive fields have correlation 0.9
+
+>>> chain = list(sim.sequence(0.9, 20))
+
+Gradual deformation
+
+>>> candidates = [sim.deform(theta) for theta in np.linspace(-0.5, 0.5, 11)]
+>>> sim.accept(0.2)
+    """
+    def __init__(
+            self,
+            variogram: Variogram,
+            nx: int, dx: float,
+            ny: int = 1, dy: float = -1.0,
+            nz: int = 1, dz: float = -1.0,
+            padx: int = -1, pady: int = -1, padz: int = -1,
+    ) -> None: ...
+
+    @property
+    def padded_size(self) -> List[int]:
+        """Grid size after padding in each simulated direction."""
+        ...
+
+    def simulate(self) -> ndarray:
+        """
+Simulates a new, independent field. Gives the same values as gaussianfft.simulate
+with the same seed. The latent state is not changed.
+        """
+        ...
+
+    def simulate_with_derivatives(self, laplacian: bool = False) -> Tuple[ndarray, ndarray]:
+        """
+Simulates a new field as Simulator.simulate, together with its derivatives.
+The derivatives are computed from the same spectrum as the field, by one batched
+inverse Fourier transform, and are exact for the periodic field on the padded
+grid.
+
+Parameters
+----------
+laplacian: bool, optional
+    Also return the Laplacian of the field. Default is False.
+
+Returns
+-------
+Tuple of the field and an np.ndarray with shape (m, n), where n is the size of
+the field. The rows are the derivatives with respect to x, y and z, one for each
+simulated direction, followed by the Laplacian if it is requested. Units are per
+unit of dx, dy and dz.
+        """
+        ...
+
+    def reset(self) -> None:
+        """Draws a new, independent latent state."""
+        ...
+
+    def field(self) -> ndarray:
+        """Returns the field of the current latent state. A state is drawn if there is none."""
+        ...
+
+    def step(self, rho: float) -> ndarray:
+        """
+Updates the latent state to rho w + sqrt(1 - rho^2) e, where e is new noise,
+and returns its field. The correlation between the field and the previous field
+is rho in every cell. If there is no state, a new one is drawn.
+        """
+        ...
+
+    def sequence(self, rho: float, n: int = -1) -> FieldSequence:
+        """
+Iterator over a sequence of correlated fields. The first field is the current
+state (see Simulator.field), and each of the following is Simulator.step(rho).
+
+Parameters
+----------
+rho: float
+    Correlation between consecutive fields, in [-1, 1].
+n: int, optional
+    Number of fields. Default is -1, which gives an infinite sequence.
+        """
+        ...
+
+    def deform(self, theta: float) -> ndarray:
+        """
+Returns the field cos(theta) w + sin(theta) v, where w is the current latent
+state and v is an independent proposal state. The state is not changed, so the
+deformation parameter theta may be optimized by calling this repeatedly. The
+fields have the same variogram for all values of theta.
+        """
+        ...
+
+    def accept(self, theta: float) -> None:
+        """
+Sets the latent state to the one given by Simulator.deform(theta). The next
+call to Simulator.deform uses a new proposal state.
+        """
+        ...
+
+    @property
+    def noise_size(self) -> int:
+        """Number of noise values for Simulator.apply; the number of cells in the padded grid."""
+        ...
+
+    def apply(self, noise: ndarray, out: Optional[ndarray] = None) -> ndarray:
+        """
+Applies the simulation operator to white noise, field = L noise. This is the
+operator used by Simulator.simulate, so standard normal noise gives fields with
+the variogram of the simulator. The noise is defined on the padded grid.
+
+Parameters
+----------
+noise: np.ndarray
+    Noise with shape (n,) or (batch, n), where n = Simulator.noise_size. The
+    values are ordered as the padded grid (see Simulator.padded_size), with x
+    running fastest.
+out: np.ndarray, optional
+    C-contiguous float64 array for the result, with shape (m,) or (batch, m)
+    where m = nx*ny*nz.
+
+Returns
+-------
+np.ndarray with the fields, ordered as the result of gaussianfft.simulate.
+        """
+        ...
+
+    def apply_adjoint(self, field_gradient: ndarray, out: Optional[ndarray] = None) -> ndarray:
+        """
+Applies the adjoint of the simulation operator, L^T field_gradient. If
+field_gradient is the gradient of an objective function with respect to the
+field, the result is the gradient with respect to the noise of
+Simulator.apply. Each call needs two Fourier transforms per batch item.
+
+Parameters
+----------
+field_gradient: np.ndarray
+    Values with shape (m,) or (batch, m), where m = nx*ny*nz.
+out: np.ndarray, optional
+    C-contiguous float64 array for the result, with shape (n,) or (batch, n)
+    where n = Simulator.noise_size.
+
+Returns
+-------
+np.ndarray with values on the padded grid, ordered as the noise of Simulator.apply.
+        """
+        ...
+
+
+"""
+gaussianfft.VariogramMap
+"""
+
+
+class VariogramMap(object):
+    """
+Empirical variogram map of gridded fields, accumulated over any number of
+realizations. For each lag h = (a dx, b dy, c dz), the estimate is
+
+    gamma(h) = sum (z(x + h) - z(x))^2 / (2 N(h)),
+
+where the sum is over the N(h) pairs of active cells separated by h, in all
+realizations. The sums for all lags are computed with Fourier transforms of a
+zero-padded grid, so adding a field is O(n log n) rather than O(n^2).
+
+Parameters
+----------
+nx, dx, ny, dy, nz, dz:
+    Grid size and cell size, see gaussianfft.simulate.
+mask: np.ndarray, optional
+    Boolean array with nx*ny*nz values, ordered as the result of
+    gaussianfft.simulate. Only cells where mask is True are used.
+
+Examples
+--------
+>>> v = gaussianfft.variogram('spherical', 200.0, 100.0)
+>>> vmap = gaussianfft.VariogramMap(100, 10.0, 100, 10.0)
+>>> for _ in range(10):
+...     vmap.add(gaussianfft.simulate(v, 100, 10.0, 100, 10.0))
+>>> distance, gamma, pairs = vmap.radial(20.0)
+>>> distance, gamma, pairs = vmap.directional(0.0, 20.0, tolerance=15.0)
+    """
+    def __init__(
+            self,
+            nx: int,
+            dx: float,
+            ny: int = 1,
+            dy: float = -1.0,
+            nz: int = 1,
+            dz: float = -1.0,
+            mask: Optional[ndarray] = None,
+    ): ...
+
+    @property
+    def n_realizations(self) -> int: ...
+
+    def add(self, field: ndarray) -> None:
+        """
+Adds a realization with nx*ny*nz values, ordered as the result of
+gaussianfft.simulate, or shaped (nx, ny, nz) in Fortran order.
+        """
+        ...
+
+    def map(self) -> Tuple[ndarray, ndarray]:
+        """
+Returns (gamma, pairs), the variogram and the number of pairs for each lag,
+as arrays with shape (2nx - 1, 2ny - 1, 2nz - 1). Lag (a, b, c) is at index
+(a + nx - 1, b + ny - 1, c + nz - 1), so zero lag is in the center. gamma is
+NaN for lags without pairs.
+        """
+        ...
+
+    def radial(self, bin_width: float, n_bins: int = 0) -> Tuple[ndarray, ndarray, ndarray]:
+        """
+Omnidirectional variogram, binned by lag distance.
+
+Parameters
+----------
+bin_width: float
+    Width of the distance bins. Bin i holds lags with distance in
+    [i, i + 1)*bin_width, except zero lag.
+n_bins: int, optional
+    Number of bins. Default is 0, which gives bins for all lags in the grid.
+
+Returns
+-------
+(distance, gamma, pairs), where distance is the mean lag distance of the pairs
+in each bin and pairs is the number of pairs of cells. Empty bins have NaN
+distance and gamma.
+        """
+        ...
+
+    def directional(
+            self,
+            azimuth: float,
+            bin_width: float,
+            tolerance: float = 22.5,
+            dip: float = 0.0,
+            n_bins: int = 0,
+    ) -> Tuple[ndarray, ndarray, ndarray]:
+        """
+Directional variogram, binned by lag distance. As VariogramMap.radial, but only
+lags within the angle tolerance of the direction, in either sense, are used.
+
+Parameters
+----------
+azimuth: float
+    Azimuth of the direction in degrees, with the same convention as the azimuth
+    of gaussianfft.variogram. The direction of a variogram's main range is the
+    direction with the same azimuth and dip.
+bin_width: float
+    Width of the distance bins.
+tolerance: float, optional
+    Angle tolerance in degrees. Default is 22.5.
+dip: float, optional
+    Dip of the direction in degrees. Default is 0.
+n_bins: int, optional
+    Number of bins. Default is 0, which gives bins for all lags in the grid.
+        """
+        ...
+
+
+"""
+gaussianfft.nested_variogram
+"""
+
+
+def nested_variogram(
+        structures: List[Tuple[float, Variogram]],
+        nugget: float = 0.0,
+) -> Variogram:
+    """
+Creates a nested variogram, that is, a sum of variogram structures with
+different types, ranges and orientations, and an optional nugget effect.
+The covariance is the weighted sum of the correlation functions of the
+structures, plus the nugget at zero distance. A nested field is simulated with
+a single filter and Fourier transform, at the same cost as a single structure.
+The padding is chosen from the longest structure in each direction.
+
+Parameters
+----------
+structures: list of (float, Variogram)
+    Weight (sill) and variogram of each structure. The variograms are copied.
+nugget: float, optional
+    Sill of the nugget effect. Default is 0.0.
+
+Returns
+-------
+out: Variogram
+    An instance of gaussianfft.Variogram. The variance of the simulated fields is
+    the sum of the weights and the nugget. Variogram.corr is the covariance
+    divided by this variance.
+
+Examples
+--------
+>>> import gaussianfft
+>>> short = gaussianfft.variogram('spherical', 200.0, 100.0, 5.0)
+>>> long = gaussianfft.variogram('gaussian', 2000.0, 1000.0, 20.0, azimuth=30.0)
+>>> v = gaussianfft.nested_variogram([(0.5, short), (0.4, long)], nugget=0.1)
+>>> field = gaussianfft.simulate(v, 100, 20.0, 100, 20.0, 20, 1.0)
     """
     pass
 
 
-@overload
-def seed() -> int:
+"""
+gaussianfft.simulate_active
+"""
+
+
+def simulate_active(
+        variogram: Variogram,
+        active: ndarray,
+        nx: int, dx: float,
+        ny: int = 1, dy: float = -1.0,
+        nz: int = 1, dz: float = -1.0,
+        transform: Optional['Transform'] = None,
+) -> ndarray:
     """
-Gets the current simulation seed. Throws RunTimeError if the seed has not been set
-yet.
+Simulates a Gaussian random field as gaussianfft.simulate, but only returns the
+selected cells, e.g. the active cells of a zone. The selected cells are copied
+directly from the Fourier transform buffer, so memory use and copy time of the
+output are proportional to the number of selected cells. With the same seed, the
+result is the same as from gaussianfft.simulate, indexed by the selection.
+
+Parameters
+----------
+variogram: gaussianfft.Variogram
+    An instance of gaussianfft.Variogram (see gaussianfft.variogram).
+active: numpy.ndarray
+    Either a boolean mask with nx*ny*nz values in Fortran order, or an integer
+    array of cell indices i + nx*(j + ny*k) in any order, as from
+    gaussianfft.EclipseGrid.active_indices. Convert an integer actnum with
+    actnum.astype(bool).
+nx, dx, ny, dy, nz, dz:
+    Grid size and resolution, see gaussianfft.simulate.
+transform: gaussianfft.Transform, optional
+    Post-processing of the standard normal field, see gaussianfft.simulate. A
+    trend must have one value for each selected cell.
+
+Returns
+-------
+out: numpy.ndarray
+    One-dimensional array with the values of the selected cells, in the order
+    of active.
 
 Examples
 --------
+>>> import numpy as np
 >>> import gaussianfft
->>> gaussianfft.seed(123)
->>> gaussianfft.seed()
-123
+>>> v = gaussianfft.variogram('spherical', 1000.0, 500.0, 20.0)
+>>> actnum = np.ones((200, 200, 50), dtype=np.int32)
+>>> actnum[:, :, 20:30] = 0
+>>> z = gaussianfft.simulate_active(v, actnum.astype(bool), 200, 25.0, 200, 25.0, 50, 1.0)
+>>> z.shape
+(1600000,)
+    """
+    pass
+
+
+"""
+gaussianfft.simulate_multi
+"""
+
+
+def simulate_multi(
+        variograms: List[Variogram],
+        nx: int, dx: float,
+        ny: int = 1, dy: float = -1.0,
+        nz: int = 1, dz: float = -1.0,
+) -> List[ndarray]:
+    """
+Simulates one Gaussian random field for each variogram on the same grid.
+This is faster than calling gaussianfft.simulate once for each variogram,
+since all fields use one padded grid, large enough for every variogram, and
+the filters, noise and Fourier transforms of all fields are computed together.
+Note that the fields are not the same as from gaussianfft.simulate with the
+same seed. The memory usage is proportional to the number of variograms.
+
+Parameters
+----------
+variograms: list of gaussianfft.Variogram
+    One field is simulated for each variogram.
+nx, dx, ny, dy, nz, dz:
+    See gaussianfft.simulate.
+
+Returns
+-------
+list of numpy.ndarray
+    One flattened (Fortran order) field per variogram.
+
+Examples
+--------
+>>> import gaussianfft
+>>> v1 = gaussianfft.variogram('spherical', 1000.0, 500.0, 20.0)
+>>> v2 = gaussianfft.variogram('gaussian', 400.0, 400.0, 10.0)
+>>> f1, f2 = gaussianfft.simulate_multi([v1, v2], 100, 10.0, 100, 10.0, 20, 1.0)
+    """
+    pass
+
+
+"""
+gaussianfft.simulate_jobs
+"""
+
+
+def simulate_jobs(
+        jobs: List[Dict[str, object]],
+        n_threads: int = 0,
+) -> List[ndarray]:
+    """
+Simulates one Gaussian random field for each job, for instance one per zone of a
+model, with several jobs running at the same time on different cores. The
+padded grid of each job is found first, and the largest jobs are started first,
+so the total time is close to the time of the largest job when there are enough
+cores. Each job is simulated with its own seed, so the results do not depend on
+the number of threads, and a job with seed s gives the same field as
+gaussianfft.simulate after gaussianfft.seed(s). Memory usage is proportional to
+the jobs running at the same time.
+
+Parameters
+----------
+jobs: list of dict
+    Each job is a dict with the keys 'variogram', 'nx' and 'dx', and optionally
+    'ny', 'dy', 'nz', 'dz' (see gaussianfft.simulate) and 'seed'. Jobs without a
+    seed get consecutive seeds drawn from the generator set by gaussianfft.seed.
+n_threads: int, optional
+    Number of jobs to run at the same time. Default is 0, which means one per core.
+
+Returns
+-------
+list of numpy.ndarray
+    One flattened (Fortran order) field per job, in the order of the jobs.
+
+Examples
+--------
+>>> v1 = gaussianfft.variogram('spherical', 1000.0, 500.0, 20.0)
+>>> v2 = gaussianfft.variogram('gaussian', 400.0, 400.0, 10.0)
+>>> zones = gaussianfft.simulate_jobs([
+...     dict(variogram=v1, nx=200, dx=25.0, ny=200, dy=25.0, nz=40, dz=1.0),
+...     dict(variogram=v2, nx=100, dx=25.0, ny=100, dy=25.0, nz=10, dz=2.0, seed=42),
+... ])
+    """
+    pass
+
+
+"""
+gaussianfft.simulate_traces
+"""
+
+
+def simulate_traces(
+        variogram: Variogram,
+        n_traces: int,
+        nx: int, dx: float,
+        padx: int = -1,
+) -> ndarray:
+    """
+Simulates many independent 1D Gaussian random fields (traces), e.g. well logs
+or vertical columns. The filter is computed once and the traces are transformed
+in batches, so this is much faster than calling gaussianfft.simulate for each
+trace. With the same seed, trace number t is the same as the field from the
+t'th of n_traces consecutive calls to gaussianfft.simulate(variogram, nx, dx).
+
+Parameters
+----------
+variogram: gaussianfft.Variogram
+    Variogram of the traces. The x-direction of the variogram is used.
+n_traces: int
+    Number of traces.
+nx, dx:
+    See gaussianfft.simulate.
+padx: int, optional
+    See gaussianfft.advanced.simulate.
+
+Returns
+-------
+numpy.ndarray with shape (n_traces, nx)
+
+Examples
+--------
+>>> import gaussianfft
+>>> v = gaussianfft.variogram('exponential', 25.0)
+>>> logs = gaussianfft.simulate_traces(v, 10000, 400, 0.5)
+    """
+    pass
+
+
+"""
+gaussianfft.simulate_points
+"""
+
+
+def simulate_points(
+        variogram: Variogram,
+        points: ndarray,
+        n_features: int = 1000,
+) -> ndarray:
+    """
+Simulates a Gaussian random field at scattered points without a grid, as a sum
+of random Fourier features with frequencies drawn from the spectral density of
+the variogram. The values are exactly Gaussian, and the covariance approaches the
+variogram as n_features grows; the error in the covariance is of the order
+1/sqrt(n_features). The cost is proportional to the number of points times
+n_features, independent of the extent of the points, so this is suited for few
+points spread over a large area, e.g. well locations. The random generator seed
+may be set by using gaussianfft.seed.
+
+Parameters
+----------
+variogram: gaussianfft.Variogram
+    Variogram of the field. The nugget of a nested variogram is added
+    independently at each point.
+points: array_like
+    Coordinates, with shape (n,) for 1D, or (n, dim) with dim 1, 2 or 3.
+n_features: int, optional
+    Number of random Fourier features. Default is 1000.
+
+Returns
+-------
+numpy.ndarray with shape (n,)
+
+Examples
+--------
+>>> import gaussianfft
+>>> import numpy
+>>> v = gaussianfft.variogram('spherical', 1000.0, 500.0, azimuth=30.0)
+>>> xy = numpy.random.uniform(0.0, 20000.0, size=(500, 2))
+>>> values = gaussianfft.simulate_points(v, xy)
+    """
+    pass
+
+
+"""
+gaussianfft.EclipseGrid
+"""
+
+
+class EclipseGrid(object):
+    """
+Corner-point grid read from an Eclipse grid file (GRDECL) with the keywords
+SPECGRID, COORD, ZCORN and, optionally, ACTNUM. Use with
+gaussianfft.simulate_eclipse_grid.
+
+Parameters
+----------
+filename: str
+    Name of the grid file.
+    """
+    def __init__(self, filename: str): ...
+
+    @property
+    def ni(self) -> int: ...
+
+    @property
+    def nj(self) -> int: ...
+
+    @property
+    def nk(self) -> int: ...
+
+    def active_indices(self) -> ndarray:
+        """
+Index i + j*ni + k*ni*nj of each active cell, in the order of the values from
+gaussianfft.simulate_eclipse_grid.
+        """
+        ...
+
+    def add_parameter(self, name: str, values: ndarray) -> None:
+        """
+Adds a parameter with one value for each active cell, e.g. a field from
+gaussianfft.simulate_eclipse_grid. Inactive cells get the value 0.
+        """
+        ...
+
+    def write(self, filename: str) -> None:
+        """
+Writes the grid and its parameters to an Eclipse grid file.
+        """
+        ...
+
+
+"""
+gaussianfft.simulate_eclipse_grid
+"""
+
+
+def simulate_eclipse_grid(
+        variogram: Variogram,
+        grid: EclipseGrid,
+        dx: float, dy: float, dz: float,
+        n_realizations: int = 1,
+) -> ndarray:
+    """
+Simulates a Gaussian random field at the centers of the active cells of a
+corner-point grid. The field is simulated on a regular, axis aligned box with
+cell size dx, dy, dz that covers the cell centers, and interpolated trilinearly
+at the centers. The box is interpolated one layer at a time as it is
+simulated, and is never held in memory. The cell centers and the interpolation
+weights are computed once and kept for the last few grids, so repeated calls
+on the same grid only simulate and interpolate. The random generator seed may
+be set by using gaussianfft.seed.
+
+Parameters
+----------
+variogram: gaussianfft.Variogram
+    Variogram of the field, with ranges and azimuth in the coordinates of the
+    grid.
+grid: gaussianfft.EclipseGrid
+    The corner-point grid.
+dx, dy, dz: float
+    Cell size of the simulation box. It should be at most the size of the
+    grid cells in each direction.
+n_realizations: int, optional
+    Number of realizations. Default is 1.
+
+Returns
+-------
+numpy.ndarray with one value for each active cell, ordered as
+grid.active_indices(). With n_realizations other than 1, the shape is
+(n_realizations, number of active cells).
+
+Examples
+--------
+>>> import gaussianfft
+>>> grid = gaussianfft.EclipseGrid('reservoir.grdecl')
+>>> v = gaussianfft.variogram('spherical', 1000.0, 500.0, 10.0, azimuth=30.0)
+>>> poro = gaussianfft.simulate_eclipse_grid(v, grid, 50.0, 50.0, 1.0)
+>>> grid.add_parameter('PORO', 0.2 + 0.03 * poro)
+>>> grid.write('poro.grdecl')
+    """
+    pass
+
+
+"""
+gaussianfft.simulate_to_file
+"""
+
+
+def simulate_to_file(
+        filenames: Union[str, PathLike, List[Union[str, PathLike]]],
+        variogram: Variogram,
+        nx: int, dx: float,
+        ny: int, dy: float,
+        nz: int, dz: float,
+        mask: Optional[ndarray] = None,
+        missing_code: float = -999.0,
+        x0: float = 0.0, y0: float = 0.0, z0: float = 0.0,
+        rotation: float = 0.0,
+) -> None:
+    """
+Simulates one realization per file name and writes each of them directly to a
+Storm grid file (storm_petro_binary, float32, big endian) as it is simulated.
+The realizations are written one layer at a time from the FFT buffer, so no
+complete realization is held in memory. The filter is computed only once for all
+files. The random generator seed may be set by using gaussianfft.seed.
+
+Parameters
+----------
+filenames: str or list of str
+    File name(s) to write. One realization is simulated for each file.
+variogram, nx, ny, nz, dx, dy, dz:
+    See gaussianfft.simulate. All grid sizes and resolutions are required.
+mask: numpy.ndarray, optional
+    Boolean array with nx*ny*nz values in Fortran ordering. Cells where the mask
+    is False are written as missing_code.
+missing_code: float, optional
+    Value of inactive cells in the file. Default is -999.0.
+x0, y0, z0: float, optional
+    Origin and top of the grid. Default is 0.0.
+rotation: float, optional
+    Rotation of the grid in degrees, as written to the Storm header. Default is 0.0.
+
+Examples
+--------
+>>> import gaussianfft
+>>> v = gaussianfft.variogram('spherical', 1000.0, 500.0, 20.0)
+>>> files = ['real_{}.storm'.format(i) for i in range(10)]
+>>> gaussianfft.simulate_to_file(files, v, 200, 25.0, 200, 25.0, 100, 1.0)
+    """
+    pass
+
+
+"""
+gaussianfft.simulate_slabs
+"""
+
+
+def simulate_slabs(
+        variogram: Variogram,
+        range_z: float,
+        nx: int, dx: float,
+        ny: int, dy: float,
+        nz: int, dz: float,
+        out: Optional[ndarray] = None,
+        callback: Optional[Callable[[int, ndarray], None]] = None,
+) -> Optional[ndarray]:
+    """
+Simulates a 3D field one horizontal layer at a time, for the separable covariance
+C(dx, dy) exp(-3|dz|/range_z), where C is the horizontal covariance of variogram.
+The noise of the layers is a vertical AR(1) sequence, and each layer is filtered
+by a 2D FFT. Only one padded layer is kept in memory, and there is no padding
+in z, which makes this much leaner than gaussianfft.simulate for grids with many
+layers.
+The random generator seed may be set by using gaussianfft.seed.
+
+Parameters
+----------
+variogram: gaussianfft.Variogram
+    Horizontal variogram. Only its horizontal ranges and azimuth are used, and it
+    cannot have dip.
+range_z: float
+    Range of the exponential correlation in z.
+nx, ny, nz, dx, dy, dz:
+    See gaussianfft.simulate. All grid sizes and resolutions are required, and
+    ny may be 1.
+out: numpy.ndarray, optional
+    C-contiguous float64 array with nx*ny*nz values that the layers are written
+    to in Fortran ordering, such as a numpy.memmap of a file.
+callback: callable, optional
+    Called as callback(k, layer) for each layer k, where layer is a new array with
+    nx*ny values in Fortran ordering. Nothing is stored, and None is returned.
+
+Returns
+-------
+out: numpy.ndarray or None
+    One-dimensional array with the simulation result in Fortran ordering, or
+    None if callback is given.
+
+Examples
+--------
+>>> import gaussianfft
+>>> v = gaussianfft.variogram('spherical', 1000.0, 500.0)
+>>> z = gaussianfft.simulate_slabs(v, 5.0, 200, 25.0, 200, 25.0, 2000, 0.2)
+    """
+    pass
+
+
+"""
+gaussianfft.seed
+"""
+
+
+@overload
+def seed(seed: int) -> None:
+    """
+Sets the current simulation seed. If this has not been set when calling
+gaussianfft.simulate, it is set to the current time with second precision. Be wary of
+the latter, in particular if gaussianfft is used in a parallel-processing context.
+
+Examples
+--------
+>>> import gaussianfft
+>>> gaussianfft.seed(123)
+    """
+    pass
+
+
+@overload
+def seed(stream: RandomStream) -> None:
+    """
+Continues the simulations from a random stream made by gaussianfft.seed_streams.
+The stream object itself is not advanced.
+
+Examples
+--------
+>>> import gaussianfft
+>>> streams = gaussianfft.seed_streams(123, 4)
+>>> gaussianfft.seed(streams[2])
+    """
+    pass
+
+
+@overload
+def seed() -> int:
+    """
+Gets the current simulation seed. Throws RunTimeError if the seed has not been set
+yet.
+
+Examples
+--------
+>>> import gaussianfft
+>>> gaussianfft.seed(123)
+>>> gaussianfft.seed()
+123
+    """
+    pass
+
+
+"""
+gaussianfft.seed_streams
+"""
+
+
+class RandomStream(object):
+    """
+State of the random generator at the start of an independent stream. Made by
+gaussianfft.seed_streams, activated by gaussianfft.seed(stream), and may be pickled.
+    """
+    @property
+    def seed(self) -> int: ...
+
+
+def seed_streams(master_seed: int, n_streams: int) -> List[RandomStream]:
+    """
+Makes independent random streams for parallel processes or threads. Stream i
+continues i*2^65 numbers after gaussianfft.seed(master_seed), using the jump-ahead
+of the dSFMT generator, so the streams never overlap. Each worker activates its
+own stream with gaussianfft.seed(stream). The streams may be pickled, and the
+results do not depend on when the workers are started.
+
+Parameters
+----------
+master_seed: int
+    Seed of the first stream.
+n_streams: int
+    Number of streams.
+
+Returns
+-------
+list of gaussianfft.RandomStream
+
+Examples
+--------
+>>> import multiprocessing
+>>> import gaussianfft
+>>> v = gaussianfft.variogram('gaussian', 10.0)
+>>> def worker(stream):
+...     gaussianfft.seed(stream)
+...     return gaussianfft.simulate(v, 100, 1.0)
+>>> with multiprocessing.Pool(4) as pool:
+...     fields = pool.map(worker, gaussianfft.seed_streams(123, 4))
+    """
+    pass
+
+
+"""
+gaussianfft.profiling
+"""
+
+
+@overload
+def profiling(enabled: bool) -> None:
+    """
+Turns collection of timings and memory statistics on or off. Profiling is off by
+default, and has no measurable cost then. When on, statistics for the last call to
+gaussianfft.simulate are available through gaussianfft.last_run_stats and
+gaussianfft.last_run_trace.
+
+Examples
+--------
+>>> import gaussianfft
+>>> gaussianfft.profiling(True)
+    """
+    pass
+
+
+@overload
+def profiling() -> bool:
+    """
+Returns True if profiling is turned on.
+    """
+    pass
+
+
+def last_run_stats() -> Dict[str, object]:
+    """
+Statistics for the last simulation run while profiling was turned on (see
+gaussianfft.profiling).
+
+Returns
+-------
+out: dict
+    padded_size: grid size after padding in each simulated direction.
+    fft_factors: prime factors of each padded size. Large factors give slow FFTs.
+    n_fields: number of simulated fields.
+    seconds: dict with the accumulated wall time in seconds of each stage. The
+        transform of the filter is counted both in 'filter' and in 'fft'. With
+        several fields, noise generation and extraction run on threads of their
+        own while the current field is transformed. Their time is included, so
+        the stages may add up to more than the wall time of the run.
+    bytes_allocated: total number of bytes allocated for grids and FFT buffers.
+    peak_bytes: largest number of those bytes held at the same time.
+    pooled_bytes: number of bytes in FFT buffers kept for later simulations
+        after the run, see gaussianfft.release_workspace.
+
+Examples
+--------
+>>> import gaussianfft
+>>> gaussianfft.profiling(True)
+>>> v = gaussianfft.variogram('gaussian', 250.0)
+>>> z = gaussianfft.simulate(v, 100, 10.0, 100, 10.0)
+>>> stats = gaussianfft.last_run_stats()
+>>> stats['padded_size'], stats['fft_factors']
+    """
+    pass
+
+
+def last_run_trace() -> str:
+    """
+The stages of the last simulation run while profiling was turned on, as a JSON
+string in the Chrome trace event format. Save it to a file and open it in
+chrome://tracing or https://ui.perfetto.dev.
+
+Examples
+--------
+>>> import gaussianfft
+>>> with open('trace.json', 'w') as f:
+...     f.write(gaussianfft.last_run_trace())
+    """
+    pass
+
+
+"""
+gaussianfft.cache_dir
+"""
+
+
+@overload
+def cache_dir(path: Optional[Union[str, PathLike]]) -> None:
+    """
+Sets the directory where filter spectra are cached between simulations and
+processes. A simulation that uses the same variogram, grid size and padding as an
+earlier one then maps the spectrum file read-only instead of computing it, and
+processes that use the same spectrum share one copy in memory. The directory is
+created if it does not exist. None or an empty string turns the cache off, which
+is the default unless the environment variable GAUSSIANFFT_CACHE_DIR is set when
+gaussianfft is imported. The simulated fields are the same with and without the
+cache.
+
+Examples
+--------
+>>> import gaussianfft
+>>> gaussianfft.cache_dir('/tmp/gaussianfft-cache')
+    """
+    pass
+
+
+@overload
+def cache_dir() -> Optional[str]:
+    """
+Returns the directory where filter spectra are cached, or None if the cache is
+turned off.
+    """
+    pass
+
+
+"""
+gaussianfft.fft_backend
+"""
+
+
+@overload
+def fft_backend(name: str) -> None:
+    """
+Selects the implementation of the FFTs used by all simulations:
+
+- 'fftw': the FFT library gaussianfft was built with, which is FFTW3, or Intel MKL
+  or ARM Performance Libraries through their FFTW3 interface. This is the default.
+  Not available if gaussianfft was built with USE_FFTW=OFF.
+- 'portable': mixed-radix FFTs without external dependencies. These are slower,
+  and are meant for checking results and timings against the default, see
+  gaussianfft.last_run_stats and gaussianfft.fft_benchmark. This is the default if
+  'fftw' is not available.
+
+The default may also be set with the environment variable GAUSSIANFFT_FFT_BACKEND
+when gaussianfft is imported. The simulated fields are the same with both
+backends, up to rounding errors. Raises RuntimeError for an unknown name.
+
+Examples
+--------
+>>> import gaussianfft
+>>> gaussianfft.fft_backend('portable')
+    """
+    pass
+
+
+@overload
+def fft_backend() -> str:
+    """
+Returns the name of the FFT implementation in use, see gaussianfft.fft_backend.
+    """
+    pass
+
+
+"""
+gaussianfft.fft_threads
+"""
+
+
+@overload
+def fft_threads(n: int) -> None:
+    """
+Sets the number of threads used by each FFT. Only the 'fftw' backend uses more
+than one thread, and only if gaussianfft was built with USE_FFTW_THREADS; otherwise
+the setting has no effect. The default is 1, as simulations of several fields
+already run in parallel. Raises RuntimeError if n is less than 1.
+
+Examples
+--------
+>>> import gaussianfft
+>>> gaussianfft.fft_threads(4)
+    """
+    pass
+
+
+@overload
+def fft_threads() -> int:
+    """
+Returns the number of threads used by each FFT, see gaussianfft.fft_threads.
+    """
+    pass
+
+
+"""
+gaussianfft.fft_benchmark
+"""
+
+
+def fft_benchmark(shape: Collection[int], repeats: int = 10) -> Dict[str, float]:
+    """
+Times the FFT backends on a grid of the given shape, and returns a dict from the
+name of each available backend to the average number of seconds of one forward
+and one inverse transform, see gaussianfft.fft_backend. The shape is (nx,),
+(nx, ny) or (nx, ny, nz), and should include the padding, see
+gaussianfft.simulation_size. Planning is done before the timing starts.
+
+Examples
+--------
+>>> import gaussianfft
+>>> gaussianfft.fft_benchmark((256, 256, 64), repeats=5)
+{'fftw': 0.012, 'portable': 0.19}
+    """
+    pass
+
+
+"""
+gaussianfft.release_workspace
+"""
+
+
+def release_workspace() -> int:
+    """
+Returns the FFT buffers that are kept between simulations to the operating
+system, and returns the number of bytes freed. Simulations keep their buffers in
+a pool when they are done, so that the next simulation on a grid of the same
+size does not have to allocate and clear them again. The pool is kept within
+gaussianfft.workspace_limit. The FFT plans made for each grid size are freed as
+well; they are otherwise kept until the process exits.
+
+Examples
+--------
+>>> import gaussianfft
+>>> gaussianfft.release_workspace()
+    """
+    pass
+
+
+"""
+gaussianfft.workspace_limit
+"""
+
+
+@overload
+def workspace_limit(bytes: int) -> None:
+    """
+Sets the largest number of bytes kept in FFT buffers between simulations, see
+gaussianfft.release_workspace. When the limit is reached, the buffers that
+have been unused the longest are returned to the operating system first. The
+default is 1 GB, and 0 turns the pool off.
+
+Examples
+--------
+>>> import gaussianfft
+>>> gaussianfft.workspace_limit(4 * 2**30)
+    """
+    pass
+
+
+@overload
+def workspace_limit() -> int:
+    """
+Returns the largest number of bytes kept in FFT buffers between simulations,
+see gaussianfft.workspace_limit.
+    """
+    pass
+
+
+@overload
+def huge_pages(enabled: bool) -> None:
+    """
+Turns transparent huge pages on or off for FFT buffers of 2 MB or more. This
+reduces page faults and TLB misses for large grids, but may use more memory. It
+only has an effect on Linux, and only for buffers allocated afterwards, see
+gaussianfft.release_workspace. Huge pages are off by default.
+
+Examples
+--------
+>>> import gaussianfft
+>>> gaussianfft.huge_pages(True)
+    """
+    pass
+
+
+@overload
+def huge_pages() -> bool:
+    """
+Returns True if huge pages are used for large FFT buffers.
+    """
+    pass
+
+
+"""
+gaussianfft.legacy_noise
+"""
+
+
+@overload
+def legacy_noise(enabled: bool) -> None:
+    """
+Turns legacy noise on or off. The simulations make the white noise in blocks,
+with the Box-Muller transform of uniforms generated several at a time. With
+legacy noise, the noise is drawn one value at a time as in older versions,
+which is slower, but gives the same fields from a seed as those versions.
+Legacy noise is off by default.
+
+Examples
+--------
+>>> import gaussianfft
+>>> v = gaussianfft.variogram('gaussian', 100.0)
+>>> gaussianfft.legacy_noise(True)
+>>> gaussianfft.seed(1323)
+>>> field = gaussianfft.simulate(v, 100, 20.0)
+    """
+    pass
+
+
+@overload
+def legacy_noise() -> bool:
+    """
+Returns True if the noise is drawn as in older versions, see gaussianfft.legacy_noise.
     """
     pass
 
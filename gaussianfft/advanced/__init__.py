@@ -1,4 +1,4 @@
 from _gaussianfft.advanced import *
 
 
-__all__ = ['simulate']
+__all__ = ['simulate', 'simulation_plan']
@@ -1,5 +1,5 @@
-from .. import Variogram
-from typing import overload
+from .. import Transform, Variogram
+from typing import Dict, Optional, overload
 
 from numpy import ndarray
 
@@ -14,6 +14,10 @@ def simulate(
         padx: int = -1, pady: int = -1, padz: int = -1,
 
         sx: float = 1.0, sy: float = 1.0, sz: float = 1.0,
+
+        max_memory: int = 0,
+
+        transform: Optional[Transform] = None,
 ) -> ndarray:
     """
 Same as gaussianfft.simulate, but with a few additional advanced and
@@ -38,6 +42,15 @@ sx, sy, sz: float
     values of the smoothing kernel at one variogram range and MUST therefore be
     greater than 0 and less than 1. A value close to or greater than 1 means no
     smoothing.
+max_memory: int
+    Memory budget in bytes. If the simulation needs more memory than this, a
+    leaner strategy is used (see gaussianfft.advanced.simulation_plan), and if no
+    strategy fits, RuntimeError is raised before the simulation starts. FFT
+    buffers kept from earlier simulations count against the budget, and are
+    released if needed (see gaussianfft.release_workspace). Default is 0, which
+    means no limit.
+transform: gaussianfft.Transform, optional
+    See gaussianfft.simulate.
 
 Returns
 -------
@@ -65,3 +78,45 @@ def simulate(
         padx: int = -1,
         sx: float = 1.0,
 ) -> ndarray:...
+
+
+def simulation_plan(
+        variogram: Variogram,
+        nx: int, dx: float,
+        ny: int = 1, dy: float = -1.0,
+        nz: int = 1, dz: float = -1.0,
+
+        padx: int = -1, pady: int = -1, padz: int = -1,
+
+        max_memory: int = 0,
+) -> Dict[str, object]:
+    """
+Estimates the memory and work needed by gaussianfft.advanced.simulate, without
+simulating. Strategies are tried in the order 'standard', 'lean' and
+'single_precision', and the first one needing at most max_memory bytes is used.
+The lean strategy keeps a single FFT grid and gives the same result as the standard
+one. The single precision strategy also does the transforms in single precision.
+One-dimensional simulations always use the standard strategy.
+
+Parameters
+----------
+variogram, nx, ny, nz, dx, dy, dz, padx, pady, padz, max_memory:
+    See gaussianfft.advanced.simulate.
+
+Returns
+-------
+out: dict
+    strategy: name of the selected strategy.
+    padded_size: grid size after padding in each simulated direction.
+    buffers: dict with the largest number of bytes held by each buffer.
+    peak_bytes: largest number of bytes held at the same time.
+    flops: approximate number of floating point operations.
+
+Examples
+--------
+>>> import gaussianfft
+>>> v = gaussianfft.variogram('gaussian', 250.0)
+>>> plan = gaussianfft.advanced.simulation_plan(v, 400, 5.0, 400, 5.0, 100, 1.0, max_memory=2**30)
+>>> plan['strategy'], plan['peak_bytes']
+  """
+    pass
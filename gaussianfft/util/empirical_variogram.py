@@ -74,12 +74,10 @@ class EmpiricalVariogram:
         :return:
         """
         midpoints = self.find_midpoints(resolution)
-        true_variogram = []
-        for m in midpoints:
-            # This will only work for a variogram with equal ranges in each dimension. Should otherwise use
-            # self.v.corr(m1, m2[, m3]) instead
-            true_variogram.append(self.v.corr(m))
-        return midpoints, np.array(true_variogram)
+        # This will only work for a variogram with equal ranges in each dimension. Should otherwise use
+        # self.v.corr_array(m1, m2[, m3]) instead
+        true_variogram = self.v.corr_array(np.asarray(midpoints, dtype=float))
+        return midpoints, true_variogram
 
     def pick_reference_points(self, strategy, n=0, offset=0, seed=None):
         """
@@ -158,7 +156,7 @@ class EmpiricalVariogram:
         p_idx = self.tuple_indexes.index(ref)
         dists = cdist(self.points[p_idx].reshape((1, 3)), self.points)
         dists = dists.flatten()
-        s_values = [np.sqrt((1-self.v.corr(d)) * 2) for d in dists]
+        s_values = np.sqrt((1 - self.v.corr_array(dists)) * 2)
         s = np.zeros((self.nx, self.ny, self.nz))
         s[self.indexes[:, 0], self.indexes[:, 1], self.indexes[:, 2]] = s_values
         return s
@@ -4,19 +4,262 @@
 #include <pybind11/stl.h>
 #include <pybind11/numpy.h>
 
+#include <algorithm>
+#include <cstring>
 #include <iostream>
+#include <memory>
 
 #include "nrlib/iotools/stringtools.hpp"
 #include "nrlib/exception/exception.hpp"
+#include "nrlib/fft/fftbackend.hpp"
+#include "nrlib/fft/workspacepool.hpp"
 #include "nrlib/grid/grid.hpp"
 #include "nrlib/grid/grid2d.hpp"
 #include "nrlib/math/constants.hpp"
+#include "nrlib/profiling/profiling.hpp"
 #include "nrlib/random/random.hpp"
+#include "nrlib/stormgrid/stormcontgrid.hpp"
+#include "nrlib/stormgrid/stormcontgridwriter.hpp"
 #include "nrlib/variogram/variogram.hpp"
+#include "nrlib/variogram/variogramtypes.hpp"
 #include "nrlib/variogram/gaussianfield.hpp"
 
 namespace py = pybind11;
 
+namespace {
+  // Number of vectors in a batch of size n, given as a 1D array with n
+  // values or a 2D array with one vector in each row.
+  size_t BatchSize(const py::array & values, size_t n, const std::string & name)
+  {
+    if (values.ndim() == 1 && static_cast<size_t>(values.shape(0)) == n)
+      return 1;
+    if (values.ndim() == 2 && static_cast<size_t>(values.shape(1)) == n)
+      return static_cast<size_t>(values.shape(0));
+    throw NRLib::Exception("The " + name + " must have shape (" + NRLib::ToString(n) + ",) or (batch, "
+                           + NRLib::ToString(n) + ").");
+  }
+
+  // Output array with the same number of dimensions as the input. Uses out
+  // if it is given, after checking its type and shape.
+  py::array_t<double> OutputArray(py::object out, size_t n_batch, size_t n, bool batched)
+  {
+    std::vector<py::ssize_t> shape;
+    if (batched)
+      shape.push_back(static_cast<py::ssize_t>(n_batch));
+    shape.push_back(static_cast<py::ssize_t>(n));
+    if (out.is_none())
+      return py::array_t<double>(shape);
+
+    if (!py::isinstance<py::array_t<double, py::array::c_style> >(out))
+      throw NRLib::Exception("out must be a C-contiguous array of float64.");
+    py::array_t<double> result = out.cast<py::array_t<double> >();
+    if (!result.writeable()
+        || static_cast<size_t>(result.ndim()) != shape.size()
+        || !std::equal(shape.begin(), shape.end(), result.shape()))
+      throw NRLib::Exception("out must be a writeable array with the shape of the result.");
+    return result;
+  }
+
+  // Applies transform to values, in a new Fortran ordered array of the
+  // given shape. The array has type int8 if the transform has thresholds.
+  py::array TransformValues(const NRLib::FieldTransform    & transform,
+                            const double                   * values,
+                            const std::vector<py::ssize_t> & shape)
+  {
+    size_t n = 1;
+    for (size_t d = 0; d < shape.size(); d++)
+      n *= static_cast<size_t>(shape[d]);
+    if (transform.HasThresholds()) {
+      py::array_t<signed char, py::array::f_style> codes(shape);
+      signed char * codes_data = codes.mutable_data();
+      {
+        py::gil_scoped_release release;
+        transform.Apply(values, n, codes_data);
+      }
+      return codes;
+    }
+    py::array_t<double, py::array::f_style> out(shape);
+    double * out_data = out.mutable_data();
+    {
+      py::gil_scoped_release release;
+      transform.Apply(values, n, out_data);
+    }
+    return out;
+  }
+
+  // Writes each realization to its own Storm file, one layer at a time.
+  class StormFileSink : public NRLib::GaussianFieldSink {
+  public:
+    /// header holds the volume and missing code, but no values.
+    StormFileSink(const std::vector<std::string> & filenames,
+                  const NRLib::StormContGrid     & header,
+                  size_t                           nx,
+                  size_t                           ny,
+                  size_t                           nz,
+                  const bool                     * mask)
+      : filenames_(filenames),
+        header_(header),
+        nx_(nx),
+        ny_(ny),
+        nz_(nz),
+        mask_(mask),
+        layer_(nx * ny) {}
+
+    void BeginField(int m)
+    {
+      writer_.reset(new NRLib::StormContGridWriter(filenames_[m], header_, nx_, ny_, nz_));
+    }
+
+    void AddLayer(size_t k, size_t ni, size_t nj, const double * values, size_t stride)
+    {
+      WriteLayer(k, ni, nj, values, stride);
+    }
+
+    void AddLayer(size_t k, size_t ni, size_t nj, const float * values, size_t stride)
+    {
+      WriteLayer(k, ni, nj, values, stride);
+    }
+
+    void EndField(int /*m*/)
+    {
+      writer_->Close();
+      writer_.reset();
+    }
+
+  private:
+    template <typename T>
+    void WriteLayer(size_t k, size_t ni, size_t nj, const T * values, size_t stride)
+    {
+      NRLib::Profiling::ScopedTimer timer("write");
+      const bool * mask = (mask_ != NULL) ? mask_ + k * ni * nj : NULL;
+      for (size_t j = 0; j < nj; j++) {
+        for (size_t i = 0; i < ni; i++) {
+          if (mask != NULL && !mask[i + j * ni])
+            layer_[i + j * ni] = header_.GetMissingCode();
+          else
+            layer_[i + j * ni] = static_cast<float>(values[i + j * stride]);
+        }
+      }
+      writer_->WriteLayer(layer_);
+    }
+
+    const std::vector<std::string>             & filenames_;
+    const NRLib::StormContGrid                 & header_;
+    size_t                                       nx_;
+    size_t                                       ny_;
+    size_t                                       nz_;
+    const bool                                 * mask_;
+    std::unique_ptr<NRLib::StormContGridWriter>  writer_;
+    std::vector<float>                           layer_;
+  };
+
+  // Passes each layer to a Python callable as callback(k, layer), where layer
+  // is a new array with nx*ny values, x running fastest.
+  class CallbackSink : public NRLib::GaussianFieldSink {
+  public:
+    CallbackSink(py::object callback) : callback_(callback) {}
+
+    void AddLayer(size_t k, size_t ni, size_t nj, const double * values, size_t stride)
+    {
+      py::array_t<double> layer(static_cast<py::ssize_t>(ni * nj));
+      double * data = layer.mutable_data();
+      for (size_t j = 0; j < nj; j++)
+        std::copy(values + j * stride, values + j * stride + ni, data + j * ni);
+      callback_(k, layer);
+    }
+
+  private:
+    py::object callback_;
+  };
+
+  // Writes the layers to an array in Fortran ordering.
+  class ArraySink : public NRLib::GaussianFieldSink {
+  public:
+    explicit ArraySink(double * data) : data_(data) {}
+
+    void AddLayer(size_t k, size_t ni, size_t nj, const double * values, size_t stride)
+    {
+      double * layer = data_ + k * ni * nj;
+      for (size_t j = 0; j < nj; j++)
+        std::copy(values + j * stride, values + j * stride + ni, layer + j * ni);
+    }
+
+  private:
+    double * data_;
+  };
+
+  // Applies a transform to each row of a layer as it is extracted from the
+  // FFT buffer, and writes the final values, e.g. int8 codes, to out. The
+  // untransformed field is never stored.
+  template <typename T>
+  class TransformSink : public NRLib::GaussianFieldSink {
+  public:
+    TransformSink(const NRLib::FieldTransform & transform, T * out, size_t n)
+      : transform_(transform), out_(out), n_(n) {}
+
+    void AddLayer(size_t k, size_t ni, size_t nj, const double * values, size_t stride)
+    {
+      for (size_t j = 0; j < nj; j++) {
+        size_t begin = ni * (j + nj * k);
+        transform_.Apply(values + j * stride, begin, ni, n_, out_ + begin);
+      }
+    }
+
+    void AddLayer(size_t k, size_t ni, size_t nj, const float * values, size_t stride)
+    {
+      row_.resize(ni);
+      for (size_t j = 0; j < nj; j++) {
+        size_t begin = ni * (j + nj * k);
+        std::copy(values + j * stride, values + j * stride + ni, row_.begin());
+        transform_.Apply(&row_[0], begin, ni, n_, out_ + begin);
+      }
+    }
+
+  private:
+    const NRLib::FieldTransform & transform_;
+    T                           * out_;
+    size_t                        n_;
+    std::vector<double>           row_;
+  };
+
+  // Simulates a 2D field (nz = 1) or a 3D field and applies transform on the
+  // way out of the FFT buffer. The lean simulations give the same fields as
+  // the standard ones, with a single FFT grid.
+  template <typename T>
+  py::array SimulateTransformed(const NRLib::Variogram             & variogram,
+                                size_t                               nx,
+                                double                               dx,
+                                size_t                               ny,
+                                double                               dy,
+                                size_t                               nz,
+                                double                               dz,
+                                int                                  padding_x,
+                                int                                  padding_y,
+                                int                                  padding_z,
+                                double                               scaling_x,
+                                double                               scaling_y,
+                                double                               scaling_z,
+                                NRLib::GaussianFieldPlan::Strategy   strategy,
+                                const NRLib::FieldTransform        & transform)
+  {
+    size_t n = nx * ny * nz;
+    py::array_t<T, py::array::f_style> out(std::vector<py::ssize_t>(1, static_cast<py::ssize_t>(n)));
+    TransformSink<T> sink(transform, out.mutable_data(), n);
+    if (strategy != NRLib::GaussianFieldPlan::SINGLE_PRECISION)
+      strategy = NRLib::GaussianFieldPlan::LEAN;
+    {
+      py::gil_scoped_release release;
+      if (nz == 1U)
+        NRLib::Simulate2DGaussianField(variogram, nx, dx, ny, dy, 1, sink, NULL,
+                                       padding_x, padding_y, scaling_x, scaling_y, strategy);
+      else
+        NRLib::Simulate3DGaussianField(variogram, nx, dx, ny, dy, nz, dz, 1, sink,
+                                       padding_x, padding_y, padding_z, scaling_x, scaling_y, scaling_z, strategy);
+    }
+    return out;
+  }
+}
+
 /***************************/
 std::string GaussFFT::Quote()
 {
@@ -92,33 +335,144 @@ NRLib::Variogram * GaussFFT::CreateVariogram(const std::string & type,
   return NRLib::Variogram::Create(t, power, range_x, range_y, range_z, azimuth_angle, dip_angle, 1.0);
 }
 
+/*********************************************************************/
+NRLib::Variogram * GaussFFT::CreateNestedVariogram(const std::vector<std::pair<double, NRLib::Variogram *> > & structures,
+                                                   double                                                      nugget)
+{
+  std::vector<double>                   weights;
+  std::vector<const NRLib::Variogram *> variograms;
+  for (size_t i = 0; i < structures.size(); ++i) {
+    if (structures[i].second == NULL)
+      throw NRLib::Exception("The structures of a nested variogram can not be None.");
+    weights.push_back(structures[i].first);
+    variograms.push_back(structures[i].second);
+  }
+  return new NRLib::NestedVario(weights, variograms, nugget);
+}
+
+/*********************************************************************/
+py::array_t<double> GaussFFT::VariogramCorrArray(const NRLib::Variogram                                             & variogram,
+                                                 const py::array_t<double, py::array::c_style | py::array::forcecast> & dx,
+                                                 py::object                                                           dy,
+                                                 py::object                                                           dz)
+{
+  typedef py::array_t<double, py::array::c_style | py::array::forcecast> Array;
+  if (dy.is_none() && !dz.is_none())
+    throw NRLib::Exception("dz can not be given without dy.");
+  Array dy_array;
+  Array dz_array;
+  const double * dy_data = NULL;
+  const double * dz_data = NULL;
+  if (!dy.is_none()) {
+    dy_array = dy.cast<Array>();
+    if (dy_array.request().shape != dx.request().shape)
+      throw NRLib::Exception("dx and dy must have the same shape.");
+    dy_data = dy_array.data();
+  }
+  if (!dz.is_none()) {
+    dz_array = dz.cast<Array>();
+    if (dz_array.request().shape != dx.request().shape)
+      throw NRLib::Exception("dx and dz must have the same shape.");
+    dz_data = dz_array.data();
+  }
+
+  py::array_t<double> corr(dx.request().shape);
+  size_t         n         = static_cast<size_t>(dx.size());
+  const double * dx_data   = dx.data();
+  double       * corr_data = corr.mutable_data();
+  {
+    py::gil_scoped_release release;
+    variogram.GetCorrArray(dx_data, dy_data, dz_data, n, corr_data);
+  }
+  return corr;
+}
+
+/*********************************************************************/
+py::array_t<double> GaussFFT::VariogramCovMatrix(const NRLib::Variogram                                             & variogram,
+                                                 const py::array_t<double, py::array::c_style | py::array::forcecast> & points_a,
+                                                 py::object                                                           points_b)
+{
+  typedef py::array_t<double, py::array::c_style | py::array::forcecast> Array;
+  Array b = points_b.is_none() ? points_a : points_b.cast<Array>();
+  if (points_a.ndim() < 1 || points_a.ndim() > 2 || b.ndim() < 1 || b.ndim() > 2)
+    throw NRLib::Exception("The points must be given as arrays with shape (n,) or (n, dim).");
+  size_t dim   = (points_a.ndim() == 2) ? static_cast<size_t>(points_a.shape(1)) : 1;
+  size_t dim_b = (b.ndim() == 2)        ? static_cast<size_t>(b.shape(1))        : 1;
+  if (dim != dim_b)
+    throw NRLib::Exception("The two sets of points must have the same number of coordinates.");
+  if (dim < 1 || dim > 3)
+    throw NRLib::Exception("The points must have 1, 2 or 3 coordinates.");
+
+  size_t n_a = static_cast<size_t>(points_a.shape(0));
+  size_t n_b = static_cast<size_t>(b.shape(0));
+  std::vector<py::ssize_t> shape;
+  shape.push_back(static_cast<py::ssize_t>(n_a));
+  shape.push_back(static_cast<py::ssize_t>(n_b));
+  py::array_t<double> cov(shape);
+  const double * a_data   = points_a.data();
+  const double * b_data   = b.data();
+  double       * cov_data = cov.mutable_data();
+  {
+    py::gil_scoped_release release;
+    variogram.GetCovMatrix(a_data, n_a, b_data, n_b, dim, cov_data);
+  }
+  return cov;
+}
+
 /******************************************************************/
-py::array_t<double> GaussFFT::Simulate(NRLib::Variogram * variogram,
-                                       size_t             nx,
-                                       double             dx,
-                                       size_t             ny,
-                                       double             dy,
-                                       size_t             nz,
-                                       double             dz)
+py::array GaussFFT::Simulate(NRLib::Variogram            * variogram,
+                             size_t                        nx,
+                             double                        dx,
+                             size_t                        ny,
+                             double                        dy,
+                             size_t                        nz,
+                             double                        dz,
+                             const NRLib::FieldTransform * transform,
+                             double                        rotation,
+                             const std::vector<double>   & block)
 {
-  return SimulateWithAdvancedSettings(variogram, nx, dx, ny, dy, nz, dz, -1, -1,-1, 1.0, 1.0, 1.0);
+  if (rotation == 0.0 && block.empty())
+    return SimulateWithAdvancedSettings(variogram, nx, dx, ny, dy, nz, dz, -1, -1,-1, 1.0, 1.0, 1.0, 0, transform);
+  if (block.size() > 3)
+    throw NRLib::Exception("block must have at most three sizes, (bx, by, bz).");
+  std::unique_ptr<NRLib::Variogram> local(variogram->CloneInFrame(rotation * NRLib::Degree));
+  if (!block.empty())
+    local->SetBlockSupport(block[0], (block.size() > 1) ? block[1] : 0.0, (block.size() > 2) ? block[2] : 0.0);
+  return SimulateWithAdvancedSettings(local.get(), nx, dx, ny, dy, nz, dz, -1, -1,-1, 1.0, 1.0, 1.0, 0, transform);
 }
 
 /***********************************************************************************/
-py::array_t<double> GaussFFT::SimulateWithAdvancedSettings(NRLib::Variogram * variogram,
-                                                           size_t             nx,
-                                                           double             dx,
-                                                           size_t             ny,
-                                                           double             dy,
-                                                           size_t             nz,
-                                                           double             dz,
-                                                           int                padding_x,
-                                                           int                padding_y,
-                                                           int                padding_z,
-                                                           double             scaling_x,
-                                                           double             scaling_y,
-                                                           double             scaling_z)
+py::array GaussFFT::SimulateWithAdvancedSettings(NRLib::Variogram            * variogram,
+                                                 size_t                        nx,
+                                                 double                        dx,
+                                                 size_t                        ny,
+                                                 double                        dy,
+                                                 size_t                        nz,
+                                                 double                        dz,
+                                                 int                           padding_x,
+                                                 int                           padding_y,
+                                                 int                           padding_z,
+                                                 double                        scaling_x,
+                                                 double                        scaling_y,
+                                                 double                        scaling_z,
+                                                 size_t                        max_memory,
+                                                 const NRLib::FieldTransform * transform)
 {
+  NRLib::Profiling::RunScope run;
+  // Fail before allocating anything if the simulation does not fit
+  NRLib::GaussianFieldPlan::Strategy strategy =
+    PlanSimulation(variogram, nx, dx, ny, dy, nz, dz, padding_x, padding_y, padding_z, max_memory).strategy;
+
+  size_t n = nx;
+  if (ny > 1U && dy >= 0.0) {
+    n *= ny;
+    if (nz > 1U && dz >= 0.0)
+      n *= nz;
+  }
+  if (transform != NULL && transform->GetTrendSize() > 0 && transform->GetTrendSize() != n)
+    throw NRLib::Exception("The trend of the transform has " + NRLib::ToString(transform->GetTrendSize())
+                           + " values, but the field has " + NRLib::ToString(n) + ".");
+
   try {
     NRLib::Random::GetStartSeed();
   }
@@ -126,19 +480,826 @@ py::array_t<double> GaussFFT::SimulateWithAdvancedSettings(NRLib::Variogram * va
     // NRLib::Random is not initialized yet. Use empty initializer:
     NRLib::Random::Initialize();
   }
+  bool is_1d = (ny <= 1U || dy < 0.0);
+  if (transform != NULL && !transform->IsEmpty() && !is_1d) {
+    // The transform is applied while extracting the layers from the FFT buffer,
+    // and writes the final type directly
+    size_t nz_field = (nz <= 1U || dz < 0.0) ? 1U : nz;
+    if (transform->HasThresholds())
+      return SimulateTransformed<signed char>(*variogram, nx, dx, ny, dy, nz_field, dz,
+                                              padding_x, padding_y, padding_z, scaling_x, scaling_y, scaling_z,
+                                              strategy, *transform);
+    return SimulateTransformed<double>(*variogram, nx, dx, ny, dy, nz_field, dz,
+                                       padding_x, padding_y, padding_z, scaling_x, scaling_y, scaling_z,
+                                       strategy, *transform);
+  }
+
   std::vector<double> result;
-  if (ny <= 1U || dy < 0.0) {
-    result = GaussFFT::Simulate1D(variogram, nx, dx,                 padding_x,                       scaling_x                      );
+  if (is_1d) {
+    result = GaussFFT::Simulate1D(variogram, nx, dx,                 padding_x,                       scaling_x                                );
   }
   else if (nz <= 1U || dz < 0.0) {
-    result = GaussFFT::Simulate2D(variogram, nx, dx, ny, dy,         padding_x, padding_y,            scaling_x, scaling_y           );
+    result = GaussFFT::Simulate2D(variogram, nx, dx, ny, dy,         padding_x, padding_y,            scaling_x, scaling_y,            strategy);
+  }
+  else {
+    result = GaussFFT::Simulate3D(variogram, nx, dx, ny, dy, nz, dz, padding_x, padding_y, padding_z, scaling_x, scaling_y, scaling_z, strategy);
+  }
+
+  NRLib::Profiling::ScopedTimer timer("copy_out");
+  if (transform == NULL || transform->IsEmpty()) {
+    py::array_t<double> np_result = py::cast(result);
+    return np_result;
+  }
+  // 1D fields are small, and are transformed after the simulation
+  std::vector<py::ssize_t> shape(1, static_cast<py::ssize_t>(result.size()));
+  return TransformValues(*transform, result.data(), shape);
+}
+
+/***********************************************************************************/
+py::array GaussFFT::SimulateActive(NRLib::Variogram            * variogram,
+                                   py::array                     active,
+                                   size_t                        nx,
+                                   double                        dx,
+                                   size_t                        ny,
+                                   double                        dy,
+                                   size_t                        nz,
+                                   double                        dz,
+                                   const NRLib::FieldTransform * transform)
+{
+  NRLib::Profiling::RunScope run;
+  // Same choice of dimension as in SimulateWithAdvancedSettings
+  if (ny <= 1U || dy < 0.0)
+    ny = 1U;
+  if (ny <= 1U || nz <= 1U || dz < 0.0)
+    nz = 1U;
+  NRLib::GaussianFieldPlan::Strategy strategy =
+    PlanSimulation(variogram, nx, dx, ny, dy, nz, dz, -1, -1, -1, 0).strategy;
+  size_t n = nx * ny * nz;
+
+  std::vector<size_t> cells;
+  if (active.dtype().kind() == 'b') {
+    py::array_t<bool, py::array::f_style | py::array::forcecast> mask(active);
+    if (static_cast<size_t>(mask.size()) != n)
+      throw NRLib::Exception("The mask must have nx*ny*nz = " + NRLib::ToString(n)
+                             + " values, but has " + NRLib::ToString(mask.size()) + ".");
+    const bool * mask_data = mask.data();
+    for (size_t c = 0; c < n; c++) {
+      if (mask_data[c])
+        cells.push_back(c);
+    }
+  }
+  else {
+    py::array_t<long long, py::array::c_style | py::array::forcecast> indices(active);
+    const long long * index_data = indices.data();
+    cells.resize(indices.size());
+    for (size_t c = 0; c < cells.size(); c++) {
+      if (index_data[c] < 0 || static_cast<size_t>(index_data[c]) >= n)
+        throw NRLib::Exception("Cell index " + NRLib::ToString(index_data[c]) + " is outside the grid of "
+                               + NRLib::ToString(n) + " cells.");
+      cells[c] = static_cast<size_t>(index_data[c]);
+    }
+  }
+  if (transform != NULL && transform->GetTrendSize() > 0 && transform->GetTrendSize() != cells.size())
+    throw NRLib::Exception("The trend of the transform has " + NRLib::ToString(transform->GetTrendSize())
+                           + " values, but " + NRLib::ToString(cells.size()) + " cells are selected.");
+
+  try {
+    NRLib::Random::GetStartSeed();
+  }
+  catch (NRLib::Exception e) {
+    // NRLib::Random is not initialized yet. Use empty initializer:
+    NRLib::Random::Initialize();
+  }
+  std::vector<double> values(cells.size());
+  if (nz > 1U) {
+    py::gil_scoped_release release;
+    NRLib::SimulateGaussianFieldAtCells(*variogram, nx, dx, ny, dy, nz, dz, cells, 1, values.data(), strategy);
   }
   else {
-    result = GaussFFT::Simulate3D(variogram, nx, dx, ny, dy, nz, dz, padding_x, padding_y, padding_z, scaling_x, scaling_y, scaling_z);
+    // 1D and 2D fields are small, and are simulated as in Simulate to give the same values.
+    std::vector<double> field;
+    if (ny <= 1U)
+      field = GaussFFT::Simulate1D(variogram, nx, dx, -1, 1.0);
+    else
+      field = GaussFFT::Simulate2D(variogram, nx, dx, ny, dy, -1, -1, 1.0, 1.0, strategy);
+    for (size_t c = 0; c < cells.size(); c++)
+      values[c] = field[cells[c]];
+  }
+
+  NRLib::Profiling::ScopedTimer timer("copy_out");
+  if (transform == NULL || transform->IsEmpty()) {
+    py::array_t<double> np_result = py::cast(values);
+    return np_result;
+  }
+  std::vector<py::ssize_t> shape(1, static_cast<py::ssize_t>(values.size()));
+  return TransformValues(*transform, values.data(), shape);
+}
+
+/********************************************************************/
+void GaussFFT::TransformAddTrend(NRLib::FieldTransform                                            & transform,
+                                 const py::array_t<double, py::array::f_style | py::array::forcecast> & trend)
+{
+  transform.AddTrend(std::vector<double>(trend.data(), trend.data() + trend.size()));
+}
+
+/********************************************************************/
+py::array GaussFFT::TransformApply(const NRLib::FieldTransform                                      & transform,
+                                   const py::array_t<double, py::array::f_style | py::array::forcecast> & field)
+{
+  if (transform.GetTrendSize() > 0 && transform.GetTrendSize() != static_cast<size_t>(field.size()))
+    throw NRLib::Exception("The trend of the transform has " + NRLib::ToString(transform.GetTrendSize())
+                           + " values, but the field has " + NRLib::ToString(field.size()) + ".");
+  std::vector<py::ssize_t> shape(field.shape(), field.shape() + field.ndim());
+  return TransformValues(transform, field.data(), shape);
+}
+
+/********************************************************************/
+NRLib::GaussianFieldPlan GaussFFT::PlanSimulation(NRLib::Variogram * variogram,
+                                                  size_t             nx,
+                                                  double             dx,
+                                                  size_t             ny,
+                                                  double             dy,
+                                                  size_t             nz,
+                                                  double             dz,
+                                                  int                padding_x,
+                                                  int                padding_y,
+                                                  int                padding_z,
+                                                  size_t             max_memory)
+{
+  // Same choice of dimension as in SimulateWithAdvancedSettings
+  if (ny <= 1U || dy < 0.0)
+    ny = 1U;
+  if (ny <= 1U || nz <= 1U || dz < 0.0)
+    nz = 1U;
+
+  // The simulated values are copied to a std::vector and then to the
+  // returned numpy array after the FFT buffers have been released.
+  size_t copy_bytes = 2 * nx * ny * nz * sizeof(double);
+  if (max_memory > 0 && copy_bytes > max_memory) {
+    throw NRLib::Exception("The simulation result needs " + NRLib::ToString(copy_bytes / 1048576.0, 1)
+                           + " MB of memory, but max_memory is " + NRLib::ToString(max_memory / 1048576.0, 1) + " MB.");
   }
 
-  py::array_t<double> np_result = py::cast(result);
-  return np_result;
+  NRLib::GaussianFieldPlan plan = NRLib::PlanGaussianFieldSimulation(*variogram, nx, dx, ny, dy, nz, dz, 1, max_memory,
+                                                                     padding_x, padding_y, padding_z);
+  NRLib::GaussianFieldPlan::Buffer copy;
+  copy.name  = "returned_copies";
+  copy.bytes = copy_bytes;
+  plan.buffers.push_back(copy);
+  plan.peak_bytes = std::max(plan.peak_bytes, copy_bytes);
+  return plan;
+}
+
+/********************************************************************/
+py::dict GaussFFT::SimulationPlan(NRLib::Variogram * variogram,
+                                  size_t             nx,
+                                  double             dx,
+                                  size_t             ny,
+                                  double             dy,
+                                  size_t             nz,
+                                  double             dz,
+                                  int                padding_x,
+                                  int                padding_y,
+                                  int                padding_z,
+                                  size_t             max_memory)
+{
+  NRLib::GaussianFieldPlan plan = PlanSimulation(variogram, nx, dx, ny, dy, nz, dz,
+                                                 padding_x, padding_y, padding_z, max_memory);
+  py::dict buffers;
+  for (size_t i = 0; i < plan.buffers.size(); ++i)
+    buffers[py::str(plan.buffers[i].name)] = plan.buffers[i].bytes;
+
+  py::dict out;
+  out["strategy"]    = NRLib::GaussianFieldPlan::StrategyName(plan.strategy);
+  out["padded_size"] = plan.padded_size;
+  out["buffers"]     = buffers;
+  out["peak_bytes"]  = plan.peak_bytes;
+  out["flops"]       = plan.flops;
+  return out;
+}
+
+/********************************************************************/
+void GaussFFT::SimulateToFile(const std::vector<std::string> & filenames,
+                              NRLib::Variogram               * variogram,
+                              size_t                           nx,
+                              double                           dx,
+                              size_t                           ny,
+                              double                           dy,
+                              size_t                           nz,
+                              double                           dz,
+                              py::object                       mask,
+                              float                            missing_code,
+                              double                           x0,
+                              double                           y0,
+                              double                           z0,
+                              double                           rotation)
+{
+  NRLib::Profiling::RunScope run;
+  if (filenames.empty())
+    return;
+  if (dx <= 0.0 || dy <= 0.0 || dz <= 0.0)
+    throw NRLib::Exception("dx, dy and dz must be positive when simulating to a Storm grid file.");
+
+  py::array_t<bool, py::array::f_style | py::array::forcecast> mask_array;
+  const bool * mask_data = NULL;
+  if (!mask.is_none()) {
+    mask_array = mask.cast<py::array_t<bool, py::array::f_style | py::array::forcecast> >();
+    if (static_cast<size_t>(mask_array.size()) != nx * ny * nz)
+      throw NRLib::Exception("The mask must have nx*ny*nz = " + NRLib::ToString(nx * ny * nz)
+                             + " values, but has " + NRLib::ToString(mask_array.size()) + ".");
+    mask_data = mask_array.data();
+  }
+
+  try {
+    NRLib::Random::GetStartSeed();
+  }
+  catch (NRLib::Exception e) {
+    // NRLib::Random is not initialized yet. Use empty initializer:
+    NRLib::Random::Initialize();
+  }
+
+  NRLib::Volume volume(x0, y0, z0, nx * dx, ny * dy, nz * dz, rotation * NRLib::Degree);
+  NRLib::StormContGrid header(volume, 0, 0, 0);
+  header.SetMissingCode(missing_code);
+
+  StormFileSink sink(filenames, header, nx, ny, nz, mask_data);
+  NRLib::Simulate3DGaussianField(*variogram, nx, dx, ny, dy, nz, dz, static_cast<int>(filenames.size()), sink);
+}
+
+/********************************************************************/
+py::object GaussFFT::SimulateSlabs(NRLib::Variogram * variogram,
+                                   double             range_z,
+                                   size_t             nx,
+                                   double             dx,
+                                   size_t             ny,
+                                   double             dy,
+                                   size_t             nz,
+                                   double             dz,
+                                   py::object         out,
+                                   py::object         callback)
+{
+  NRLib::Profiling::RunScope run;
+  if (dx <= 0.0 || dy <= 0.0 || dz <= 0.0)
+    throw NRLib::Exception("dx, dy and dz must be positive in a slab simulation.");
+  if (!out.is_none() && !callback.is_none())
+    throw NRLib::Exception("Give either out or callback, not both.");
+
+  try {
+    NRLib::Random::GetStartSeed();
+  }
+  catch (NRLib::Exception e) {
+    // NRLib::Random is not initialized yet. Use empty initializer:
+    NRLib::Random::Initialize();
+  }
+
+  if (!callback.is_none()) {
+    CallbackSink sink(callback);
+    NRLib::Simulate3DGaussianFieldSlabs(*variogram, range_z, nx, dx, ny, dy, nz, dz, 1, sink);
+    return py::none();
+  }
+  py::array_t<double> result = OutputArray(out, 1, nx * ny * nz, false);
+  ArraySink sink(result.mutable_data());
+  NRLib::Simulate3DGaussianFieldSlabs(*variogram, range_z, nx, dx, ny, dy, nz, dz, 1, sink);
+  return result;
+}
+
+/********************************************************************/
+std::vector<py::array_t<double> > GaussFFT::SimulateMulti(const std::vector<NRLib::Variogram *> & variograms,
+                                                          size_t                                 nx,
+                                                          double                                 dx,
+                                                          size_t                                 ny,
+                                                          double                                 dy,
+                                                          size_t                                 nz,
+                                                          double                                 dz)
+{
+  NRLib::Profiling::RunScope run;
+  try {
+    NRLib::Random::GetStartSeed();
+  }
+  catch (NRLib::Exception e) {
+    // NRLib::Random is not initialized yet. Use empty initializer:
+    NRLib::Random::Initialize();
+  }
+  // Same choice of dimension as in SimulateWithAdvancedSettings
+  if (ny <= 1U || dy < 0.0)
+    ny = 1U;
+  if (ny <= 1U || nz <= 1U || dz < 0.0)
+    nz = 1U;
+
+  std::vector<const NRLib::Variogram *> vario(variograms.begin(), variograms.end());
+  std::vector<NRLib::Grid<double> > fields;
+  NRLib::SimulateMultipleGaussianFields(vario, nx, dx, ny, dy, nz, dz, fields);
+
+  NRLib::Profiling::ScopedTimer timer("copy_out");
+  std::vector<py::array_t<double> > result;
+  for (size_t m = 0; m < fields.size(); ++m)
+    result.push_back(py::cast(fields[m].GetStorage()));
+  return result;
+}
+
+/********************************************************************/
+std::vector<py::array_t<double> > GaussFFT::SimulateJobs(const std::vector<py::dict> & jobs,
+                                                         size_t                        n_threads)
+{
+  NRLib::Profiling::RunScope run;
+  try {
+    NRLib::Random::GetStartSeed();
+  }
+  catch (NRLib::Exception e) {
+    // NRLib::Random is not initialized yet. Use empty initializer:
+    NRLib::Random::Initialize();
+  }
+
+  std::vector<NRLib::GaussianFieldJob> specs(jobs.size());
+  for (size_t j = 0; j < jobs.size(); j++) {
+    const py::dict & job = jobs[j];
+    if (!job.contains("variogram") || !job.contains("nx") || !job.contains("dx"))
+      throw NRLib::Exception("Job " + NRLib::ToString(j) + " must have the keys 'variogram', 'nx' and 'dx'.");
+    NRLib::GaussianFieldJob & spec = specs[j];
+    spec.variogram = job["variogram"].cast<NRLib::Variogram *>();
+    spec.nx        = job["nx"].cast<size_t>();
+    spec.dx        = job["dx"].cast<double>();
+    spec.ny        = job.contains("ny") ? job["ny"].cast<size_t>() : 1U;
+    spec.dy        = job.contains("dy") ? job["dy"].cast<double>() : -1.0;
+    spec.nz        = job.contains("nz") ? job["nz"].cast<size_t>() : 1U;
+    spec.dz        = job.contains("dz") ? job["dz"].cast<double>() : -1.0;
+    // Jobs without a seed get consecutive draws, so the result only depends on gaussianfft.seed
+    spec.seed      = (job.contains("seed") && !job["seed"].is_none())
+                     ? job["seed"].cast<unsigned long>()
+                     : NRLib::Random::DrawUint32();
+    // Same choice of dimension as in SimulateWithAdvancedSettings
+    if (spec.ny <= 1U || spec.dy < 0.0)
+      spec.ny = 1U;
+    if (spec.ny <= 1U || spec.nz <= 1U || spec.dz < 0.0)
+      spec.nz = 1U;
+  }
+
+  std::vector<std::vector<double> > fields;
+  {
+    py::gil_scoped_release release;
+    NRLib::SimulateGaussianFieldJobs(specs, fields, n_threads);
+  }
+
+  NRLib::Profiling::ScopedTimer timer("copy_out");
+  std::vector<py::array_t<double> > result;
+  for (size_t j = 0; j < fields.size(); ++j)
+    result.push_back(py::cast(fields[j]));
+  return result;
+}
+
+/********************************************************************/
+py::array_t<double> GaussFFT::SimulateTraces(NRLib::Variogram * variogram,
+                                             size_t             n_traces,
+                                             size_t             nx,
+                                             double             dx,
+                                             int                padding_x)
+{
+  try {
+    NRLib::Random::GetStartSeed();
+  }
+  catch (NRLib::Exception e) {
+    // NRLib::Random is not initialized yet. Use empty initializer:
+    NRLib::Random::Initialize();
+  }
+  std::vector<py::ssize_t> shape;
+  shape.push_back(static_cast<py::ssize_t>(n_traces));
+  shape.push_back(static_cast<py::ssize_t>(nx));
+  py::array_t<double> traces(shape);
+  NRLib::Simulate1DGaussianTraces(*variogram, nx, dx, n_traces, traces.mutable_data(), padding_x);
+  return traces;
+}
+
+/********************************************************************/
+py::array_t<double> GaussFFT::SimulatePoints(const NRLib::Variogram                                             & variogram,
+                                             const py::array_t<double, py::array::c_style | py::array::forcecast> & points,
+                                             size_t                                                               n_features)
+{
+  if (points.ndim() != 1 && points.ndim() != 2)
+    throw NRLib::Exception("points must have shape (n,) or (n, dim).");
+  size_t n_points = static_cast<size_t>(points.shape(0));
+  size_t dim      = (points.ndim() == 2) ? static_cast<size_t>(points.shape(1)) : 1U;
+  if (dim < 1 || dim > 3)
+    throw NRLib::Exception("points must have 1, 2 or 3 coordinates.");
+  try {
+    NRLib::Random::GetStartSeed();
+  }
+  catch (NRLib::Exception e) {
+    // NRLib::Random is not initialized yet. Use empty initializer:
+    NRLib::Random::Initialize();
+  }
+  std::vector<py::ssize_t> shape;
+  shape.push_back(static_cast<py::ssize_t>(n_points));
+  py::array_t<double> values(shape);
+  const double * points_data = points.data();
+  double       * values_data = values.mutable_data();
+  {
+    py::gil_scoped_release release;
+    NRLib::SimulateGaussianFieldAtPoints(variogram, points_data, n_points, dim, n_features, values_data);
+  }
+  return values;
+}
+
+/********************************************************************/
+py::array_t<double> GaussFFT::SimulateEclipseGrid(const NRLib::Variogram   & variogram,
+                                                  const NRLib::EclipseGrid & grid,
+                                                  double                     dx,
+                                                  double                     dy,
+                                                  double                     dz,
+                                                  size_t                     n_realizations)
+{
+  try {
+    NRLib::Random::GetStartSeed();
+  }
+  catch (NRLib::Exception e) {
+    // NRLib::Random is not initialized yet. Use empty initializer:
+    NRLib::Random::Initialize();
+  }
+  std::shared_ptr<const NRLib::EclipseGridSampling> sampling;
+  {
+    py::gil_scoped_release release;
+    sampling = NRLib::EclipseGridSampling::Get(grid.GetGeometry(), dx, dy, dz);
+  }
+  std::vector<py::ssize_t> shape;
+  if (n_realizations != 1U)
+    shape.push_back(static_cast<py::ssize_t>(n_realizations));
+  shape.push_back(static_cast<py::ssize_t>(sampling->GetN()));
+  py::array_t<double> values(shape);
+  double * values_data = values.mutable_data();
+  if (n_realizations > 0U) {
+    py::gil_scoped_release release;
+    NRLib::SimulateGaussianFieldOnEclipseGrid(variogram, *sampling, static_cast<int>(n_realizations), values_data);
+  }
+  return values;
+}
+
+/********************************************************************/
+py::array_t<size_t> GaussFFT::EclipseGridActiveIndices(const NRLib::EclipseGrid & grid)
+{
+  std::vector<size_t> active;
+  for (size_t index = 0; index < grid.GetN(); index++) {
+    size_t i, j, k;
+    grid.GetIJK(index, i, j, k);
+    if (grid.IsActive(i, j, k))
+      active.push_back(index);
+  }
+  return py::array_t<size_t>(active.size(), active.data());
+}
+
+/********************************************************************/
+void GaussFFT::EclipseGridAddParameter(NRLib::EclipseGrid                                                 & grid,
+                                       const std::string                                                  & name,
+                                       const py::array_t<double, py::array::c_style | py::array::forcecast> & values)
+{
+  if (grid.HasParameter(name))
+    throw NRLib::Exception("The grid already has a parameter " + name + ".");
+  NRLib::Grid<double> parameter(grid.GetNI(), grid.GetNJ(), grid.GetNK(), 0.0);
+  const double * data = values.data();
+  size_t n_values = static_cast<size_t>(values.size());
+  size_t n        = 0;
+  for (size_t index = 0; index < grid.GetN(); index++) {
+    size_t i, j, k;
+    grid.GetIJK(index, i, j, k);
+    if (!grid.IsActive(i, j, k))
+      continue;
+    if (n == n_values)
+      throw NRLib::Exception("values must have one value for each active cell.");
+    parameter(index) = data[n++];
+  }
+  if (n != n_values)
+    throw NRLib::Exception("values must have one value for each active cell.");
+  grid.AddParameter(name, parameter);
+}
+
+/********************************************************************/
+NRLib::GaussianFieldSimulator * GaussFFT::CreateSimulator(NRLib::Variogram * variogram,
+                                                          size_t             nx,
+                                                          double             dx,
+                                                          size_t             ny,
+                                                          double             dy,
+                                                          size_t             nz,
+                                                          double             dz,
+                                                          int                padding_x,
+                                                          int                padding_y,
+                                                          int                padding_z)
+{
+  try {
+    NRLib::Random::GetStartSeed();
+  }
+  catch (NRLib::Exception e) {
+    // NRLib::Random is not initialized yet. Use empty initializer:
+    NRLib::Random::Initialize();
+  }
+  // Same choice of dimension as in SimulateWithAdvancedSettings
+  if (ny <= 1U || dy < 0.0)
+    ny = 1U;
+  if (ny <= 1U || nz <= 1U || dz < 0.0)
+    nz = 1U;
+  return new NRLib::GaussianFieldSimulator(*variogram, nx, dx, ny, dy, nz, dz, padding_x, padding_y, padding_z);
+}
+
+/********************************************************************/
+py::array_t<double> GaussFFT::SimulatorSimulate(NRLib::GaussianFieldSimulator & simulator)
+{
+  std::vector<double> field;
+  simulator.Simulate(field);
+  return py::cast(field);
+}
+
+/********************************************************************/
+py::tuple GaussFFT::SimulatorSimulateWithDerivatives(NRLib::GaussianFieldSimulator & simulator,
+                                                     bool                            laplacian)
+{
+  std::vector<double> field;
+  std::vector<double> derivatives;
+  simulator.SimulateWithDerivatives(field, derivatives, laplacian);
+  size_t n = field.size();
+  size_t n_components = (n > 0) ? derivatives.size() / n : 0;
+  py::array_t<double> derivative_array = OutputArray(py::none(), n_components, n, true);
+  std::copy(derivatives.begin(), derivatives.end(), derivative_array.mutable_data());
+  return py::make_tuple(py::cast(field), derivative_array);
+}
+
+/********************************************************************/
+py::array_t<double> GaussFFT::SimulatorField(NRLib::GaussianFieldSimulator & simulator)
+{
+  std::vector<double> field;
+  simulator.GetField(field);
+  return py::cast(field);
+}
+
+/********************************************************************/
+py::array_t<double> GaussFFT::SimulatorStep(NRLib::GaussianFieldSimulator & simulator,
+                                            double                          rho)
+{
+  std::vector<double> field;
+  simulator.Step(rho, field);
+  return py::cast(field);
+}
+
+/********************************************************************/
+py::array_t<double> GaussFFT::SimulatorDeform(NRLib::GaussianFieldSimulator & simulator,
+                                              double                          theta)
+{
+  std::vector<double> field;
+  simulator.Deform(theta, field);
+  return py::cast(field);
+}
+
+/********************************************************************/
+std::vector<size_t> GaussFFT::SimulatorPaddedSize(const NRLib::GaussianFieldSimulator & simulator)
+{
+  std::vector<size_t> size(1, simulator.GetNXtot());
+  if (simulator.GetNDim() > 1)
+    size.push_back(simulator.GetNYtot());
+  if (simulator.GetNDim() > 2)
+    size.push_back(simulator.GetNZtot());
+  return size;
+}
+
+/********************************************************************/
+py::array_t<double> GaussFFT::SimulatorApply(NRLib::GaussianFieldSimulator                                    & simulator,
+                                             const py::array_t<double, py::array::c_style | py::array::forcecast> & noise,
+                                             py::object                                                         out)
+{
+  size_t n_batch = BatchSize(noise, simulator.GetNoiseSize(), "noise");
+  py::array_t<double> field = OutputArray(out, n_batch, simulator.GetFieldSize(), noise.ndim() == 2);
+  if (n_batch > 0)
+    simulator.Apply(noise.data(), n_batch, field.mutable_data());
+  return field;
+}
+
+/********************************************************************/
+py::array_t<double> GaussFFT::SimulatorApplyAdjoint(NRLib::GaussianFieldSimulator                                    & simulator,
+                                                    const py::array_t<double, py::array::c_style | py::array::forcecast> & field_gradient,
+                                                    py::object                                                         out)
+{
+  size_t n_batch = BatchSize(field_gradient, simulator.GetFieldSize(), "field gradient");
+  py::array_t<double> noise = OutputArray(out, n_batch, simulator.GetNoiseSize(), field_gradient.ndim() == 2);
+  if (n_batch > 0)
+    simulator.ApplyAdjoint(field_gradient.data(), n_batch, noise.mutable_data());
+  return noise;
+}
+
+/********************************************************************/
+GaussFFT::FieldSequence::FieldSequence(NRLib::GaussianFieldSimulator & simulator,
+                                       double                          rho,
+                                       long                            n_fields)
+  : simulator_(simulator),
+    rho_(rho),
+    remaining_(n_fields),
+    first_(true)
+{
+  if (rho < -1.0 || rho > 1.0)
+    throw NRLib::Exception("The correlation between consecutive fields must be in [-1, 1].");
+}
+
+py::array_t<double> GaussFFT::FieldSequence::Next()
+{
+  if (remaining_ == 0)
+    throw py::stop_iteration();
+  if (remaining_ > 0)
+    --remaining_;
+
+  std::vector<double> field;
+  if (first_)
+    simulator_.GetField(field);
+  else
+    simulator_.Step(rho_, field);
+  first_ = false;
+  return py::cast(field);
+}
+
+/********************************************************************/
+NRLib::EmpiricalVariogramMap * GaussFFT::CreateVariogramMap(size_t     nx,
+                                                            double     dx,
+                                                            size_t     ny,
+                                                            double     dy,
+                                                            size_t     nz,
+                                                            double     dz,
+                                                            py::object mask)
+{
+  // Same choice of dimension as in SimulateWithAdvancedSettings
+  if (ny <= 1U || dy < 0.0)
+    ny = 1U;
+  if (ny <= 1U || nz <= 1U || dz < 0.0)
+    nz = 1U;
+
+  py::array_t<bool, py::array::f_style | py::array::forcecast> mask_array;
+  const bool * mask_data = NULL;
+  if (!mask.is_none()) {
+    mask_array = mask.cast<py::array_t<bool, py::array::f_style | py::array::forcecast> >();
+    if (static_cast<size_t>(mask_array.size()) != nx * ny * nz)
+      throw NRLib::Exception("The mask must have nx*ny*nz = " + NRLib::ToString(nx * ny * nz)
+                             + " values, but has " + NRLib::ToString(mask_array.size()) + ".");
+    mask_data = mask_array.data();
+  }
+  return new NRLib::EmpiricalVariogramMap(nx, dx, ny, dy, nz, dz, mask_data);
+}
+
+/********************************************************************/
+void GaussFFT::VariogramMapAdd(NRLib::EmpiricalVariogramMap                                     & estimator,
+                               const py::array_t<double, py::array::f_style | py::array::forcecast> & field)
+{
+  size_t n = estimator.GetNX() * estimator.GetNY() * estimator.GetNZ();
+  if (static_cast<size_t>(field.size()) != n)
+    throw NRLib::Exception("The field must have nx*ny*nz = " + NRLib::ToString(n)
+                           + " values, but has " + NRLib::ToString(field.size()) + ".");
+  py::gil_scoped_release release;
+  estimator.AddField(field.data());
+}
+
+/********************************************************************/
+py::tuple GaussFFT::VariogramMapMap(const NRLib::EmpiricalVariogramMap & estimator)
+{
+  NRLib::Grid<double> gamma;
+  NRLib::Grid<double> pairs;
+  estimator.GetVariogramMap(gamma, pairs);
+
+  std::vector<py::ssize_t> shape;
+  shape.push_back(static_cast<py::ssize_t>(gamma.GetNI()));
+  shape.push_back(static_cast<py::ssize_t>(gamma.GetNJ()));
+  shape.push_back(static_cast<py::ssize_t>(gamma.GetNK()));
+  py::array_t<double, py::array::f_style> gamma_array(shape);
+  py::array_t<double, py::array::f_style> pairs_array(shape);
+  std::copy(gamma.begin(), gamma.end(), gamma_array.mutable_data());
+  std::copy(pairs.begin(), pairs.end(), pairs_array.mutable_data());
+  return py::make_tuple(gamma_array, pairs_array);
+}
+
+/********************************************************************/
+py::tuple GaussFFT::VariogramMapRadial(const NRLib::EmpiricalVariogramMap & estimator,
+                                       double                               bin_width,
+                                       size_t                               n_bins)
+{
+  std::vector<double> distance, gamma, pairs;
+  estimator.GetRadialVariogram(bin_width, n_bins, distance, gamma, pairs);
+  return py::make_tuple(py::array_t<double>(py::cast(distance)),
+                        py::array_t<double>(py::cast(gamma)),
+                        py::array_t<double>(py::cast(pairs)));
+}
+
+/********************************************************************/
+py::tuple GaussFFT::VariogramMapDirectional(const NRLib::EmpiricalVariogramMap & estimator,
+                                            double                               azimuth,
+                                            double                               bin_width,
+                                            double                               tolerance,
+                                            double                               dip,
+                                            size_t                               n_bins)
+{
+  std::vector<double> distance, gamma, pairs;
+  estimator.GetDirectionalVariogram(azimuth * NRLib::Degree, dip * NRLib::Degree, tolerance * NRLib::Degree,
+                                    bin_width, n_bins, distance, gamma, pairs);
+  return py::make_tuple(py::array_t<double>(py::cast(distance)),
+                        py::array_t<double>(py::cast(gamma)),
+                        py::array_t<double>(py::cast(pairs)));
+}
+
+/********************************************************************/
+py::dict GaussFFT::LastRunStats()
+{
+  NRLib::Profiling::RunStats stats = NRLib::Profiling::GetLastRunStats();
+  py::dict out;
+  out["padded_size"]     = stats.padded_size;
+  out["fft_factors"]     = stats.fft_factors;
+  out["n_fields"]        = stats.n_fields;
+  out["seconds"]         = stats.stage_seconds;
+  out["bytes_allocated"] = stats.bytes_allocated;
+  out["peak_bytes"]      = stats.peak_bytes;
+  out["pooled_bytes"]    = stats.pooled_bytes;
+  return out;
+}
+
+/********************************************************************/
+std::vector<NRLib::RandomGenerator> GaussFFT::SeedStreams(unsigned long master_seed,
+                                                          size_t        n_streams)
+{
+  py::gil_scoped_release release;
+  return NRLib::RandomGenerator::CreateStreams(master_seed, n_streams);
+}
+
+/********************************************************************/
+py::tuple GaussFFT::RandomStreamGetState(const NRLib::RandomGenerator & stream)
+{
+  const dsfmt_t & state = stream.GetState();
+  return py::make_tuple(stream.GetStartSeed(),
+                        py::bytes(reinterpret_cast<const char *>(&state), sizeof(state)));
+}
+
+/********************************************************************/
+NRLib::RandomGenerator GaussFFT::RandomStreamSetState(const py::tuple & state)
+{
+  if (state.size() != 2)
+    throw NRLib::Exception("Invalid state of a random stream.");
+  std::string bytes = state[1].cast<std::string>();
+  if (bytes.size() != sizeof(dsfmt_t))
+    throw NRLib::Exception("Invalid state of a random stream.");
+
+  dsfmt_t dsfmt;
+  std::memcpy(&dsfmt, bytes.data(), sizeof(dsfmt));
+  if (dsfmt.idx < 0 || dsfmt.idx > DSFMT_N64)
+    throw NRLib::Exception("Invalid state of a random stream.");
+  NRLib::RandomGenerator stream;
+  stream.SetState(dsfmt, state[0].cast<unsigned long>());
+  return stream;
+}
+
+/********************************************************************/
+std::string GaussFFT::LastRunTrace()
+{
+  return NRLib::Profiling::GetLastRunChromeTrace();
+}
+
+/********************************************************************/
+void GaussFFT::SetCacheDirectory(const std::string & path)
+{
+  NRLib::FilterSpectrum::SetCacheDirectory(path);
+}
+
+/********************************************************************/
+py::object GaussFFT::GetCacheDirectory()
+{
+  std::string path = NRLib::FilterSpectrum::GetCacheDirectory();
+  if (path.empty())
+    return py::none();
+  return py::str(path);
+}
+
+/********************************************************************/
+std::string GaussFFT::GetFFTBackend()
+{
+  return NRLib::FFTBackend::Get().GetName();
+}
+
+/********************************************************************/
+size_t GaussFFT::ReleaseWorkspace()
+{
+  NRLib::FFTBackend::ReleaseAllPlans();
+  return NRLib::WorkspacePool::ReleaseUnused();
+}
+
+/********************************************************************/
+py::dict GaussFFT::FFTBenchmark(const std::vector<int> & shape,
+                                int                      repeats)
+{
+  if (shape.empty() || shape.size() > 3)
+    throw NRLib::Exception("The benchmark shape must have one, two or three dimensions.");
+  for (size_t d = 0; d < shape.size(); d++) {
+    if (shape[d] < 1)
+      throw NRLib::Exception("The benchmark shape must be positive.");
+  }
+  // The backends take the slowest varying dimension first.
+  std::vector<int> n(shape.rbegin(), shape.rend());
+  std::vector<std::string> names = NRLib::FFTBackend::GetNames();
+  py::dict out;
+  for (size_t i = 0; i < names.size(); i++) {
+    double seconds;
+    {
+      py::gil_scoped_release release;
+      seconds = NRLib::FFTBackend::Find(names[i]).Benchmark(n, 1, repeats);
+    }
+    out[py::str(names[i])] = seconds;
+  }
+  return out;
 }
 
 /********************************************************************/
@@ -170,7 +1331,8 @@ std::vector<double> GaussFFT::Simulate2D(NRLib::Variogram * variogram,
                                          int                padding_x,
                                          int                padding_y,
                                          double             scaling_x,
-                                         double             scaling_y)
+                                         double             scaling_y,
+                                         NRLib::GaussianFieldPlan::Strategy strategy)
 {
   std::vector<NRLib::Grid2D<double> > fields;
   NRLib::Simulate2DGaussianField(*variogram,
@@ -184,7 +1346,8 @@ std::vector<double> GaussFFT::Simulate2D(NRLib::Variogram * variogram,
                                  padding_x,
                                  padding_y,
                                  scaling_x,
-                                 scaling_y);
+                                 scaling_y,
+                                 strategy);
   return fields[0].GetStorage();
 }
 
@@ -201,7 +1364,8 @@ std::vector<double> GaussFFT::Simulate3D(NRLib::Variogram * variogram,
                                          int                padding_z,
                                          double             scaling_x,
                                          double             scaling_y,
-                                         double             scaling_z)
+                                         double             scaling_z,
+                                         NRLib::GaussianFieldPlan::Strategy strategy)
 {
   std::vector<NRLib::Grid<double> > fields;
   NRLib::Simulate3DGaussianField(*variogram,
@@ -218,6 +1382,7 @@ std::vector<double> GaussFFT::Simulate3D(NRLib::Variogram * variogram,
                                  padding_z,
                                  scaling_x,
                                  scaling_y,
-                                 scaling_z);
+                                 scaling_z,
+                                 strategy);
   return fields[0].GetStorage();
 }
@@ -1,8 +1,19 @@
 #pragma once
 
 #include <string>
+#include <utility>
+#include <vector>
+#include "nrlib/eclipsegrid/eclipsegrid.hpp"
 #include "nrlib/grid/grid.hpp"
+#include "nrlib/random/randomgenerator.hpp"
 #include "nrlib/variogram/variogram.hpp"
+#include "nrlib/variogram/eclipsegridsampling.hpp"
+#include "nrlib/variogram/empiricalvariogrammap.hpp"
+#include "nrlib/variogram/ensemblepipeline.hpp"
+#include "nrlib/variogram/fieldtransform.hpp"
+#include "nrlib/variogram/filterspectrum.hpp"
+#include "nrlib/variogram/gaussianfieldplan.hpp"
+#include "nrlib/variogram/gaussianfieldsimulator.hpp"
 #include <pybind11/pybind11.h>
 #include <pybind11/numpy.h>
 
@@ -29,27 +40,243 @@ CreateVariogram(const std::string & type,
                 double      dip_angle,
                 double      power);
 
-py::array_t<double>Simulate(NRLib::Variogram * variogram,
-                                       size_t             nx,
-                                       double             dx,
-                                       size_t             ny,
-                                       double             dy,
-                                       size_t             nz,
-                                       double             dz);
-
-py::array_t<double> SimulateWithAdvancedSettings(NRLib::Variogram * variogram,
-                                                           size_t             nx,
-                                                           double             dx,
-                                                           size_t             ny,
-                                                           double             dy,
-                                                           size_t             nz,
-                                                           double             dz,
-                                                           int                padding_x,
-                                                           int                padding_y,
-                                                           int                padding_z,
-                                                           double             scaling_x,
-                                                           double             scaling_y,
-                                                           double             scaling_z);
+NRLib::Variogram *
+CreateNestedVariogram(const std::vector<std::pair<double, NRLib::Variogram *> > & structures,
+                      double                                                      nugget);
+
+py::array_t<double> VariogramCorrArray(const NRLib::Variogram                                             & variogram,
+                                       const py::array_t<double, py::array::c_style | py::array::forcecast> & dx,
+                                       py::object                                                           dy,
+                                       py::object                                                           dz);
+
+py::array_t<double> VariogramCovMatrix(const NRLib::Variogram                                             & variogram,
+                                       const py::array_t<double, py::array::c_style | py::array::forcecast> & points_a,
+                                       py::object                                                           points_b);
+
+py::array Simulate(NRLib::Variogram            * variogram,
+                   size_t                        nx,
+                   double                        dx,
+                   size_t                        ny,
+                   double                        dy,
+                   size_t                        nz,
+                   double                        dz,
+                   const NRLib::FieldTransform * transform,
+                   double                        rotation,
+                   const std::vector<double>   & block);
+
+py::array SimulateActive(NRLib::Variogram            * variogram,
+                         py::array                     active,
+                         size_t                        nx,
+                         double                        dx,
+                         size_t                        ny,
+                         double                        dy,
+                         size_t                        nz,
+                         double                        dz,
+                         const NRLib::FieldTransform * transform);
+
+py::array SimulateWithAdvancedSettings(NRLib::Variogram            * variogram,
+                                       size_t                        nx,
+                                       double                        dx,
+                                       size_t                        ny,
+                                       double                        dy,
+                                       size_t                        nz,
+                                       double                        dz,
+                                       int                           padding_x,
+                                       int                           padding_y,
+                                       int                           padding_z,
+                                       double                        scaling_x,
+                                       double                        scaling_y,
+                                       double                        scaling_z,
+                                       size_t                        max_memory,
+                                       const NRLib::FieldTransform * transform);
+
+void TransformAddTrend(NRLib::FieldTransform                                            & transform,
+                       const py::array_t<double, py::array::f_style | py::array::forcecast> & trend);
+
+py::array TransformApply(const NRLib::FieldTransform                                      & transform,
+                         const py::array_t<double, py::array::f_style | py::array::forcecast> & field);
+
+NRLib::GaussianFieldPlan PlanSimulation(NRLib::Variogram * variogram,
+                                        size_t             nx,
+                                        double             dx,
+                                        size_t             ny,
+                                        double             dy,
+                                        size_t             nz,
+                                        double             dz,
+                                        int                padding_x,
+                                        int                padding_y,
+                                        int                padding_z,
+                                        size_t             max_memory);
+
+py::dict SimulationPlan(NRLib::Variogram * variogram,
+                        size_t             nx,
+                        double             dx,
+                        size_t             ny,
+                        double             dy,
+                        size_t             nz,
+                        double             dz,
+                        int                padding_x,
+                        int                padding_y,
+                        int                padding_z,
+                        size_t             max_memory);
+
+void SimulateToFile(const std::vector<std::string> & filenames,
+                    NRLib::Variogram               * variogram,
+                    size_t                           nx,
+                    double                           dx,
+                    size_t                           ny,
+                    double                           dy,
+                    size_t                           nz,
+                    double                           dz,
+                    py::object                       mask,
+                    float                            missing_code,
+                    double                           x0,
+                    double                           y0,
+                    double                           z0,
+                    double                           rotation);
+
+py::object SimulateSlabs(NRLib::Variogram * variogram,
+                         double             range_z,
+                         size_t             nx,
+                         double             dx,
+                         size_t             ny,
+                         double             dy,
+                         size_t             nz,
+                         double             dz,
+                         py::object         out,
+                         py::object         callback);
+
+std::vector<py::array_t<double> > SimulateMulti(const std::vector<NRLib::Variogram *> & variograms,
+                                                size_t                                 nx,
+                                                double                                 dx,
+                                                size_t                                 ny,
+                                                double                                 dy,
+                                                size_t                                 nz,
+                                                double                                 dz);
+
+std::vector<py::array_t<double> > SimulateJobs(const std::vector<py::dict> & jobs,
+                                               size_t                        n_threads);
+
+py::array_t<double> SimulateTraces(NRLib::Variogram * variogram,
+                                   size_t             n_traces,
+                                   size_t             nx,
+                                   double             dx,
+                                   int                padding_x);
+
+py::array_t<double> SimulatePoints(const NRLib::Variogram                                             & variogram,
+                                   const py::array_t<double, py::array::c_style | py::array::forcecast> & points,
+                                   size_t                                                               n_features);
+
+NRLib::GaussianFieldSimulator * CreateSimulator(NRLib::Variogram * variogram,
+                                                size_t             nx,
+                                                double             dx,
+                                                size_t             ny,
+                                                double             dy,
+                                                size_t             nz,
+                                                double             dz,
+                                                int                padding_x,
+                                                int                padding_y,
+                                                int                padding_z);
+
+py::array_t<double> SimulatorSimulate(NRLib::GaussianFieldSimulator & simulator);
+
+py::array_t<double> SimulatorField(NRLib::GaussianFieldSimulator & simulator);
+
+py::tuple SimulatorSimulateWithDerivatives(NRLib::GaussianFieldSimulator & simulator,
+                                           bool                            laplacian);
+
+py::array_t<double> SimulatorStep(NRLib::GaussianFieldSimulator & simulator,
+                                  double                          rho);
+
+py::array_t<double> SimulatorDeform(NRLib::GaussianFieldSimulator & simulator,
+                                    double                          theta);
+
+std::vector<size_t> SimulatorPaddedSize(const NRLib::GaussianFieldSimulator & simulator);
+
+py::array_t<double> SimulatorApply(NRLib::GaussianFieldSimulator                                    & simulator,
+                                   const py::array_t<double, py::array::c_style | py::array::forcecast> & noise,
+                                   py::object                                                         out);
+
+py::array_t<double> SimulatorApplyAdjoint(NRLib::GaussianFieldSimulator                                    & simulator,
+                                          const py::array_t<double, py::array::c_style | py::array::forcecast> & field_gradient,
+                                          py::object                                                         out);
+
+/// Iterator over a sequence of correlated fields. The first field is the
+/// current state of the simulator, the following are Step(rho).
+class FieldSequence {
+public:
+  FieldSequence(NRLib::GaussianFieldSimulator & simulator,
+                double                          rho,
+                long                            n_fields);
+
+  py::array_t<double> Next();
+
+private:
+  NRLib::GaussianFieldSimulator & simulator_;
+  double                          rho_;
+  /// Negative for an infinite sequence
+  long                            remaining_;
+  bool                            first_;
+};
+
+NRLib::EmpiricalVariogramMap * CreateVariogramMap(size_t     nx,
+                                                  double     dx,
+                                                  size_t     ny,
+                                                  double     dy,
+                                                  size_t     nz,
+                                                  double     dz,
+                                                  py::object mask);
+
+void VariogramMapAdd(NRLib::EmpiricalVariogramMap                                     & estimator,
+                     const py::array_t<double, py::array::f_style | py::array::forcecast> & field);
+
+py::tuple VariogramMapMap(const NRLib::EmpiricalVariogramMap & estimator);
+
+py::tuple VariogramMapRadial(const NRLib::EmpiricalVariogramMap & estimator,
+                             double                               bin_width,
+                             size_t                               n_bins);
+
+py::tuple VariogramMapDirectional(const NRLib::EmpiricalVariogramMap & estimator,
+                                  double                               azimuth,
+                                  double                               bin_width,
+                                  double                               tolerance,
+                                  double                               dip,
+                                  size_t                               n_bins);
+
+py::array_t<double> SimulateEclipseGrid(const NRLib::Variogram   & variogram,
+                                        const NRLib::EclipseGrid & grid,
+                                        double                     dx,
+                                        double                     dy,
+                                        double                     dz,
+                                        size_t                     n_realizations);
+
+py::array_t<size_t> EclipseGridActiveIndices(const NRLib::EclipseGrid & grid);
+
+void EclipseGridAddParameter(NRLib::EclipseGrid                                                 & grid,
+                             const std::string                                                  & name,
+                             const py::array_t<double, py::array::c_style | py::array::forcecast> & values);
+
+std::vector<NRLib::RandomGenerator> SeedStreams(unsigned long master_seed,
+                                                size_t        n_streams);
+
+py::tuple RandomStreamGetState(const NRLib::RandomGenerator & stream);
+
+NRLib::RandomGenerator RandomStreamSetState(const py::tuple & state);
+
+py::dict LastRunStats();
+
+std::string LastRunTrace();
+
+void SetCacheDirectory(const std::string & path);
+
+py::object GetCacheDirectory();
+
+std::string GetFFTBackend();
+
+size_t ReleaseWorkspace();
+
+py::dict FFTBenchmark(const std::vector<int> & shape,
+                      int                      repeats);
 
 std::vector<double> Simulate1D(NRLib::Variogram * variogram,
                                size_t             nx,
@@ -65,7 +292,8 @@ std::vector<double> Simulate2D(NRLib::Variogram * variogram,
                                int                padding_x,
                                int                padding_y,
                                double             scaling_x,
-                               double             scaling_y);
+                               double             scaling_y,
+                               NRLib::GaussianFieldPlan::Strategy strategy);
 
 std::vector<double> Simulate3D(NRLib::Variogram * variogram,
                                size_t             nx,
@@ -79,5 +307,6 @@ std::vector<double> Simulate3D(NRLib::Variogram * variogram,
                                int                padding_z,
                                double             scaling_x,
                                double             scaling_y,
-                               double             scaling_z);
+                               double             scaling_z,
+                               NRLib::GaussianFieldPlan::Strategy strategy);
 }
@@ -4,7 +4,11 @@
 #include "gaussfft.hpp"
 
 #include "nrlib/variogram/variogram.hpp"
+#include "nrlib/variogram/gaussianfield.hpp"
 #include "nrlib/random/random.hpp"
+#include "nrlib/profiling/profiling.hpp"
+#include "nrlib/fft/fftbackend.hpp"
+#include "nrlib/fft/workspacepool.hpp"
 
 namespace py = pybind11;
 
@@ -23,6 +27,45 @@ const std::string set_seed_docstring =
   ">>> gaussianfft.seed(123)\n"
 ;
 
+const std::string set_seed_stream_docstring =
+  ""
+  "Continues the simulations from a random stream made by gaussianfft.seed_streams.\n"
+  "The stream object itself is not advanced.\n"
+  "\n"
+  "Examples\n"
+  "--------\n"
+  ">>> streams = gaussianfft.seed_streams(123, 4)\n"
+  ">>> gaussianfft.seed(streams[2])\n"
+;
+
+const std::string seed_streams_docstring =
+  ""
+  "Makes independent random streams for parallel processes or threads. Stream i\n"
+  "continues i*2^65 numbers after gaussianfft.seed(master_seed), using the jump-ahead\n"
+  "of the dSFMT generator, so the streams never overlap. Each worker activates its\n"
+  "own stream with gaussianfft.seed(stream). The streams may be pickled, and the\n"
+  "results do not depend on when the workers are started.\n"
+  "\n"
+  "Parameters\n"
+  "----------\n"
+  "master_seed: int\n"
+  "    Seed of the first stream.\n"
+  "n_streams: int\n"
+  "    Number of streams.\n"
+  "\n"
+  "Returns\n"
+  "-------\n"
+  "list of gaussianfft.RandomStream\n"
+  "\n"
+  "Examples\n"
+  "--------\n"
+  ">>> def worker(stream):\n"
+  "...     gaussianfft.seed(stream)\n"
+  "...     return gaussianfft.simulate(v, 100, 1.0)\n"
+  ">>> with multiprocessing.Pool(4) as pool:\n"
+  "...     fields = pool.map(worker, gaussianfft.seed_streams(123, 4))\n"
+;
+
 const std::string get_seed_docstring =
   ""
   "Gets the current simulation seed. Throws RunTimeError if the seed has not been set\n"
@@ -35,6 +78,213 @@ const std::string get_seed_docstring =
   "123\n"
 ;
 
+const std::string set_profiling_docstring =
+  ""
+  "Turns collection of timings and memory statistics on or off. Profiling is off by\n"
+  "default, and has no measurable cost then. When on, statistics for the last call to\n"
+  "gaussianfft.simulate are available through gaussianfft.last_run_stats and\n"
+  "gaussianfft.last_run_trace.\n"
+  "\n"
+  "Examples\n"
+  "--------\n"
+  ">>> gaussianfft.profiling(True)\n"
+;
+
+const std::string get_profiling_docstring =
+  ""
+  "Returns True if profiling is turned on.\n"
+;
+
+const std::string set_cache_dir_docstring =
+  ""
+  "Sets the directory where filter spectra are cached between simulations and\n"
+  "processes. A simulation that uses the same variogram, grid size and padding as an\n"
+  "earlier one then maps the spectrum file read-only instead of computing it, and\n"
+  "processes that use the same spectrum share one copy in memory. The directory is\n"
+  "created if it does not exist. None or an empty string turns the cache off, which\n"
+  "is the default unless the environment variable GAUSSIANFFT_CACHE_DIR is set when\n"
+  "gaussianfft is imported. The simulated fields are the same with and without the\n"
+  "cache.\n"
+  "\n"
+  "Examples\n"
+  "--------\n"
+  ">>> gaussianfft.cache_dir('/tmp/gaussianfft-cache')\n"
+;
+
+const std::string get_cache_dir_docstring =
+  ""
+  "Returns the directory where filter spectra are cached, or None if the cache is\n"
+  "turned off.\n"
+;
+
+const std::string set_fft_backend_docstring =
+  ""
+  "Selects the implementation of the FFTs used by all simulations:\n"
+  "\n"
+  "- 'fftw': the FFT library gaussianfft was built with, which is FFTW3, or Intel MKL\n"
+  "  or ARM Performance Libraries through their FFTW3 interface. This is the default.\n"
+  "  Not available if gaussianfft was built with USE_FFTW=OFF.\n"
+  "- 'portable': mixed-radix FFTs without external dependencies. These are slower,\n"
+  "  and are meant for checking results and timings against the default, see\n"
+  "  gaussianfft.last_run_stats and gaussianfft.fft_benchmark. This is the default if\n"
+  "  'fftw' is not available.\n"
+  "\n"
+  "The default may also be set with the environment variable GAUSSIANFFT_FFT_BACKEND\n"
+  "when gaussianfft is imported. The simulated fields are the same with both\n"
+  "backends, up to rounding errors. Raises RuntimeError for an unknown name.\n"
+  "\n"
+  "Examples\n"
+  "--------\n"
+  ">>> gaussianfft.fft_backend('portable')\n"
+;
+
+const std::string get_fft_backend_docstring =
+  ""
+  "Returns the name of the FFT implementation in use, see gaussianfft.fft_backend.\n"
+;
+
+const std::string set_fft_threads_docstring =
+  ""
+  "Sets the number of threads used by each FFT. Only the 'fftw' backend uses more\n"
+  "than one thread, and only if gaussianfft was built with USE_FFTW_THREADS; otherwise\n"
+  "the setting has no effect. The default is 1, as simulations of several fields\n"
+  "already run in parallel. Raises RuntimeError if n is less than 1.\n"
+  "\n"
+  "Examples\n"
+  "--------\n"
+  ">>> gaussianfft.fft_threads(4)\n"
+;
+
+const std::string get_fft_threads_docstring =
+  ""
+  "Returns the number of threads used by each FFT, see gaussianfft.fft_threads.\n"
+;
+
+const std::string fft_benchmark_docstring =
+  ""
+  "Times the FFT backends on a grid of the given shape, and returns a dict from the\n"
+  "name of each available backend to the average number of seconds of one forward\n"
+  "and one inverse transform, see gaussianfft.fft_backend. The shape is (nx,),\n"
+  "(nx, ny) or (nx, ny, nz), and should include the padding, see\n"
+  "gaussianfft.simulation_size. Planning is done before the timing starts.\n"
+  "\n"
+  "Examples\n"
+  "--------\n"
+  ">>> gaussianfft.fft_benchmark((256, 256, 64), repeats=5)\n"
+  "{'fftw': 0.012, 'portable': 0.19}\n"
+;
+
+const std::string release_workspace_docstring =
+  ""
+  "Returns the FFT buffers that are kept between simulations to the operating\n"
+  "system, and returns the number of bytes freed. Simulations keep their buffers in\n"
+  "a pool when they are done, so that the next simulation on a grid of the same\n"
+  "size does not have to allocate and clear them again. The pool is kept within\n"
+  "gaussianfft.workspace_limit. The FFT plans made for each grid size are freed as\n"
+  "well; they are otherwise kept until the process exits.\n"
+  "\n"
+  "Examples\n"
+  "--------\n"
+  ">>> gaussianfft.release_workspace()\n"
+;
+
+const std::string set_workspace_limit_docstring =
+  ""
+  "Sets the largest number of bytes kept in FFT buffers between simulations, see\n"
+  "gaussianfft.release_workspace. When the limit is reached, the buffers that\n"
+  "have been unused the longest are returned to the operating system first. The\n"
+  "default is 1 GB, and 0 turns the pool off.\n"
+  "\n"
+  "Examples\n"
+  "--------\n"
+  ">>> gaussianfft.workspace_limit(4 * 2**30)\n"
+;
+
+const std::string get_workspace_limit_docstring =
+  ""
+  "Returns the largest number of bytes kept in FFT buffers between simulations,\n"
+  "see gaussianfft.workspace_limit.\n"
+;
+
+const std::string set_huge_pages_docstring =
+  ""
+  "Turns transparent huge pages on or off for FFT buffers of 2 MB or more. This\n"
+  "reduces page faults and TLB misses for large grids, but may use more memory. It\n"
+  "only has an effect on Linux, and only for buffers allocated afterwards, see\n"
+  "gaussianfft.release_workspace. Huge pages are off by default.\n"
+  "\n"
+  "Examples\n"
+  "--------\n"
+  ">>> gaussianfft.huge_pages(True)\n"
+;
+
+const std::string get_huge_pages_docstring =
+  ""
+  "Returns True if huge pages are used for large FFT buffers.\n"
+;
+
+const std::string set_legacy_noise_docstring =
+  ""
+  "Turns legacy noise on or off. The simulations make the white noise in blocks,\n"
+  "with the Box-Muller transform of uniforms generated several at a time. With\n"
+  "legacy noise, the noise is drawn one value at a time as in older versions,\n"
+  "which is slower, but gives the same fields from a seed as those versions.\n"
+  "Legacy noise is off by default.\n"
+  "\n"
+  "Examples\n"
+  "--------\n"
+  ">>> gaussianfft.legacy_noise(True)\n"
+  ">>> gaussianfft.seed(1323)\n"
+  ">>> field = gaussianfft.simulate(v, 100, 20.0)\n"
+;
+
+const std::string get_legacy_noise_docstring =
+  ""
+  "Returns True if the noise is drawn as in older versions, see gaussianfft.legacy_noise.\n"
+;
+
+const std::string last_run_stats_docstring =
+  "\n"
+  "Statistics for the last simulation run while profiling was turned on (see\n"
+  "gaussianfft.profiling).\n"
+  "\n"
+  "Returns\n"
+  "-------\n"
+  "out: dict\n"
+  "    padded_size: grid size after padding in each simulated direction.\n"
+  "    fft_factors: prime factors of each padded size. Large factors give slow FFTs.\n"
+  "    n_fields: number of simulated fields.\n"
+  "    seconds: dict with the accumulated wall time in seconds of each stage. The\n"
+  "        transform of the filter is counted both in 'filter' and in 'fft'. With\n"
+  "        several fields, noise generation and extraction run on threads of their\n"
+  "        own while the current field is transformed. Their time is included, so\n"
+  "        the stages may add up to more than the wall time of the run.\n"
+  "    bytes_allocated: total number of bytes allocated for grids and FFT buffers.\n"
+  "    peak_bytes: largest number of those bytes held at the same time.\n"
+  "    pooled_bytes: number of bytes in FFT buffers kept for later simulations\n"
+  "        after the run, see gaussianfft.release_workspace.\n"
+  "\n"
+  "Examples\n"
+  "--------\n"
+  ">>> gaussianfft.profiling(True)\n"
+  ">>> v = gaussianfft.variogram('gaussian', 250.0)\n"
+  ">>> z = gaussianfft.simulate(v, 100, 10.0, 100, 10.0)\n"
+  ">>> stats = gaussianfft.last_run_stats()\n"
+  ">>> stats['padded_size'], stats['fft_factors']\n"
+;
+
+const std::string last_run_trace_docstring =
+  "\n"
+  "The stages of the last simulation run while profiling was turned on, as a JSON\n"
+  "string in the Chrome trace event format. Save it to a file and open it in\n"
+  "chrome://tracing or https://ui.perfetto.dev.\n"
+  "\n"
+  "Examples\n"
+  "--------\n"
+  ">>> with open('trace.json', 'w') as f:\n"
+  "...     f.write(gaussianfft.last_run_trace())\n"
+;
+
 const std::string padding_docstring =
   "\n"
   "Function for determining the grid size after padding in order to assess the\n"
@@ -94,6 +344,48 @@ const std::string variogram_docstring =
   ">>> gaussianfft.variogram('general_exponential', 1000.0, 500.0, 250.0, power=1.8)\n"
 ;
 
+const std::string corr_array_docstring =
+  "\n"
+  "Correlation function for arrays of lags. This is much faster than calling\n"
+  "Variogram.corr in a loop, and the lags are evaluated in parallel.\n"
+  "\n"
+  "Parameters\n"
+  "----------\n"
+  "dx: numpy.ndarray\n"
+  "    Lags in x-direction.\n"
+  "dy, dz: numpy.ndarray, optional\n"
+  "    Lags in y- and z-direction, with the same shape as dx. Leave out dz, or\n"
+  "    both dy and dz, for 2D and 1D lags, as for Variogram.corr.\n"
+  "\n"
+  "Returns\n"
+  "-------\n"
+  "numpy.ndarray with the same shape as dx.\n"
+  "\n"
+  "Examples\n"
+  "--------\n"
+  ">>> v = gaussianfft.variogram('spherical', 100.0, 50.0)\n"
+  ">>> x, y = np.meshgrid(np.linspace(-100, 100, 201), np.linspace(-100, 100, 201))\n"
+  ">>> corr = v.corr_array(x, y)\n"
+;
+
+const std::string cov_matrix_docstring =
+  "\n"
+  "Covariance matrix between two sets of points. The rows are evaluated in\n"
+  "parallel.\n"
+  "\n"
+  "Parameters\n"
+  "----------\n"
+  "points_a: numpy.ndarray\n"
+  "    Points with shape (n_a, dim), where dim is 1, 2 or 3, or shape (n_a,)\n"
+  "    for 1D points.\n"
+  "points_b: numpy.ndarray, optional\n"
+  "    Points with shape (n_b, dim) or (n_b,). Default is points_a.\n"
+  "\n"
+  "Returns\n"
+  "-------\n"
+  "numpy.ndarray with shape (n_a, n_b).\n"
+;
+
 const std::string simulate_docstring =
   "\n"
   "Simulates a Gaussian random field with the corresponding variogram in one, two or\n"
@@ -110,12 +402,29 @@ const std::string simulate_docstring =
   "dx, dy, dz: float\n"
   "    Grid resolution in x, y and z directions. dx is always required. dy and dz are\n"
   "    required if respectively ny and nz are greater than 1.\n"
+  "transform: gaussianfft.Transform, optional\n"
+  "    Post-processing of the standard normal field, applied while the result is\n"
+  "    copied out, so no intermediate arrays are needed.\n"
+  "rotation: float, optional\n"
+  "    Counterclockwise rotation of the grid x-axis in degrees, as in the header of\n"
+  "    a rotated Storm grid or surface. The azimuth of the variogram is then taken\n"
+  "    relative to the unrotated axes and converted to the frame of the grid, so\n"
+  "    the padding follows the grid rather than its axis-aligned bounding box.\n"
+  "    Default is 0.0.\n"
+  "block: tuple of float, optional\n"
+  "    Block sizes (bx, by, bz) along the grid axes, for simulation directly on a\n"
+  "    coarse grid. The values are then averages over blocks of this size around\n"
+  "    each cell center, typically (dx, dy, dz), rather than point values, so they\n"
+  "    have the lower variance and smoother covariance of upscaled values. The box\n"
+  "    average is applied to the spectrum of the filter, so the cost is that of the\n"
+  "    coarse grid. Missing sizes are 0.0, which gives point support along that axis.\n"
+  "    Default is point support.\n"
   "\n"
   "Returns\n"
   "-------\n"
   "out: numpy.ndarray\n"
   "    One-dimensional array with the simulation result. Uses Fortran ordering if the\n"
-  "    simulation is multi-dimensional.\n"
+  "    simulation is multi-dimensional. The type is int8 if transform has thresholds.\n"
   "\n"
   "Examples\n"
   "--------\n"
@@ -136,6 +445,338 @@ const std::string simulate_docstring =
   "(100,200)\n"
 ;
 
+const std::string simulate_active_docstring =
+  "\n"
+  "Simulates a Gaussian random field as gaussianfft.simulate, but only returns the\n"
+  "selected cells, e.g. the active cells of a zone. The selected cells are copied\n"
+  "directly from the Fourier transform buffer, so memory use and copy time of the\n"
+  "output are proportional to the number of selected cells. With the same seed, the\n"
+  "result is the same as from gaussianfft.simulate, indexed by the selection.\n"
+  "\n"
+  "Parameters\n"
+  "----------\n"
+  "variogram: gaussianfft.Variogram\n"
+  "    An instance of gaussianfft.Variogram (see gaussianfft.variogram).\n"
+  "active: numpy.ndarray\n"
+  "    Either a boolean mask with nx*ny*nz values in Fortran order, or an integer\n"
+  "    array of cell indices i + nx*(j + ny*k) in any order, as from\n"
+  "    gaussianfft.EclipseGrid.active_indices. Convert an integer actnum with\n"
+  "    actnum.astype(bool).\n"
+  "nx, dx, ny, dy, nz, dz:\n"
+  "    Grid size and resolution, see gaussianfft.simulate.\n"
+  "transform: gaussianfft.Transform, optional\n"
+  "    Post-processing of the standard normal field, see gaussianfft.simulate. A\n"
+  "    trend must have one value for each selected cell.\n"
+  "\n"
+  "Returns\n"
+  "-------\n"
+  "out: numpy.ndarray\n"
+  "    One-dimensional array with the values of the selected cells, in the order\n"
+  "    of active.\n"
+  "\n"
+  "Examples\n"
+  "--------\n"
+  ">>> v = gaussianfft.variogram('spherical', 1000.0, 500.0, 20.0)\n"
+  ">>> actnum = np.ones((200, 200, 50), dtype=np.int32)\n"
+  ">>> actnum[:, :, 20:30] = 0\n"
+  ">>> z = gaussianfft.simulate_active(v, actnum.astype(bool), 200, 25.0, 200, 25.0, 50, 1.0)\n"
+  ">>> z.shape\n"
+  "(1600000,)\n"
+;
+
+const std::string nested_variogram_docstring =
+  "\n"
+  "Creates a nested variogram, that is, a sum of variogram structures with\n"
+  "different types, ranges and orientations, and an optional nugget effect.\n"
+  "The covariance is the weighted sum of the correlation functions of the\n"
+  "structures, plus the nugget at zero distance. A nested field is simulated with\n"
+  "a single filter and Fourier transform, at the same cost as a single structure.\n"
+  "The padding is chosen from the longest structure in each direction.\n"
+  "\n"
+  "Parameters\n"
+  "----------\n"
+  "structures: list of (float, Variogram)\n"
+  "    Weight (sill) and variogram of each structure. The variograms are copied.\n"
+  "nugget: float, optional\n"
+  "    Sill of the nugget effect. Default is 0.0.\n"
+  "\n"
+  "Returns\n"
+  "-------\n"
+  "out: Variogram\n"
+  "    An instance of gaussianfft.Variogram. The variance of the simulated fields is\n"
+  "    the sum of the weights and the nugget. Variogram.corr is the covariance\n"
+  "    divided by this variance.\n"
+  "\n"
+  "Examples\n"
+  "--------\n"
+  ">>> short = gaussianfft.variogram('spherical', 200.0, 100.0, 5.0)\n"
+  ">>> long = gaussianfft.variogram('gaussian', 2000.0, 1000.0, 20.0, azimuth=30.0)\n"
+  ">>> v = gaussianfft.nested_variogram([(0.5, short), (0.4, long)], nugget=0.1)\n"
+  ">>> field = gaussianfft.simulate(v, 100, 20.0, 100, 20.0, 20, 1.0)\n"
+;
+
+const std::string simulate_multi_docstring =
+  "\n"
+  "Simulates one Gaussian random field for each variogram on the same grid.\n"
+  "This is faster than calling gaussianfft.simulate once for each variogram,\n"
+  "since all fields use one padded grid, large enough for every variogram, and\n"
+  "the filters, noise and Fourier transforms of all fields are computed together.\n"
+  "Note that the fields are not the same as from gaussianfft.simulate with the\n"
+  "same seed. The memory usage is proportional to the number of variograms.\n"
+  "\n"
+  "Parameters\n"
+  "----------\n"
+  "variograms: list of gaussianfft.Variogram\n"
+  "    One field is simulated for each variogram.\n"
+  "nx, dx, ny, dy, nz, dz:\n"
+  "    See gaussianfft.simulate.\n"
+  "\n"
+  "Returns\n"
+  "-------\n"
+  "list of numpy.ndarray\n"
+  "    One flattened (Fortran order) field per variogram.\n"
+  "\n"
+  "Examples\n"
+  "--------\n"
+  ">>> v1 = gaussianfft.variogram('spherical', 1000.0, 500.0, 20.0)\n"
+  ">>> v2 = gaussianfft.variogram('gaussian', 400.0, 400.0, 10.0)\n"
+  ">>> f1, f2 = gaussianfft.simulate_multi([v1, v2], 100, 10.0, 100, 10.0, 20, 1.0)\n"
+;
+
+const std::string simulate_jobs_docstring =
+  "\n"
+  "Simulates one Gaussian random field for each job, for instance one per zone of a\n"
+  "model, with several jobs running at the same time on different cores. The\n"
+  "padded grid of each job is found first, and the largest jobs are started first,\n"
+  "so the total time is close to the time of the largest job when there are enough\n"
+  "cores. Each job is simulated with its own seed, so the results do not depend on\n"
+  "the number of threads, and a job with seed s gives the same field as\n"
+  "gaussianfft.simulate after gaussianfft.seed(s). Memory usage is proportional to\n"
+  "the jobs running at the same time.\n"
+  "\n"
+  "Parameters\n"
+  "----------\n"
+  "jobs: list of dict\n"
+  "    Each job is a dict with the keys 'variogram', 'nx' and 'dx', and optionally\n"
+  "    'ny', 'dy', 'nz', 'dz' (see gaussianfft.simulate) and 'seed'. Jobs without a\n"
+  "    seed get consecutive seeds drawn from the generator set by gaussianfft.seed.\n"
+  "n_threads: int, optional\n"
+  "    Number of jobs to run at the same time. Default is 0, which means one per core.\n"
+  "\n"
+  "Returns\n"
+  "-------\n"
+  "list of numpy.ndarray\n"
+  "    One flattened (Fortran order) field per job, in the order of the jobs.\n"
+  "\n"
+  "Examples\n"
+  "--------\n"
+  ">>> v1 = gaussianfft.variogram('spherical', 1000.0, 500.0, 20.0)\n"
+  ">>> v2 = gaussianfft.variogram('gaussian', 400.0, 400.0, 10.0)\n"
+  ">>> zones = gaussianfft.simulate_jobs([\n"
+  "...     dict(variogram=v1, nx=200, dx=25.0, ny=200, dy=25.0, nz=40, dz=1.0),\n"
+  "...     dict(variogram=v2, nx=100, dx=25.0, ny=100, dy=25.0, nz=10, dz=2.0, seed=42),\n"
+  "... ])\n"
+;
+
+const std::string simulate_traces_docstring =
+  "\n"
+  "Simulates many independent 1D Gaussian random fields (traces), e.g. well logs\n"
+  "or vertical columns. The filter is computed once and the traces are transformed\n"
+  "in batches, so this is much faster than calling gaussianfft.simulate for each\n"
+  "trace. With the same seed, trace number t is the same as the field from the\n"
+  "t'th of n_traces consecutive calls to gaussianfft.simulate(variogram, nx, dx).\n"
+  "\n"
+  "Parameters\n"
+  "----------\n"
+  "variogram: gaussianfft.Variogram\n"
+  "    Variogram of the traces. The x-direction of the variogram is used.\n"
+  "n_traces: int\n"
+  "    Number of traces.\n"
+  "nx, dx:\n"
+  "    See gaussianfft.simulate.\n"
+  "padx: int, optional\n"
+  "    See gaussianfft.advanced.simulate.\n"
+  "\n"
+  "Returns\n"
+  "-------\n"
+  "numpy.ndarray with shape (n_traces, nx)\n"
+  "\n"
+  "Examples\n"
+  "--------\n"
+  ">>> v = gaussianfft.variogram('exponential', 25.0)\n"
+  ">>> logs = gaussianfft.simulate_traces(v, 10000, 400, 0.5)\n"
+;
+
+const std::string simulate_points_docstring =
+  "\n"
+  "Simulates a Gaussian random field at scattered points without a grid, as a sum\n"
+  "of random Fourier features with frequencies drawn from the spectral density of\n"
+  "the variogram. The values are exactly Gaussian, and the covariance approaches the\n"
+  "variogram as n_features grows; the error in the covariance is of the order\n"
+  "1/sqrt(n_features). The cost is proportional to the number of points times\n"
+  "n_features, independent of the extent of the points, so this is suited for few\n"
+  "points spread over a large area, e.g. well locations. The random generator seed\n"
+  "may be set by using gaussianfft.seed.\n"
+  "\n"
+  "Parameters\n"
+  "----------\n"
+  "variogram: gaussianfft.Variogram\n"
+  "    Variogram of the field. The nugget of a nested variogram is added\n"
+  "    independently at each point.\n"
+  "points: array_like\n"
+  "    Coordinates, with shape (n,) for 1D, or (n, dim) with dim 1, 2 or 3.\n"
+  "n_features: int, optional\n"
+  "    Number of random Fourier features. Default is 1000.\n"
+  "\n"
+  "Returns\n"
+  "-------\n"
+  "numpy.ndarray with shape (n,)\n"
+  "\n"
+  "Examples\n"
+  "--------\n"
+  ">>> v = gaussianfft.variogram('spherical', 1000.0, 500.0, azimuth=30.0)\n"
+  ">>> xy = numpy.random.uniform(0.0, 20000.0, size=(500, 2))\n"
+  ">>> values = gaussianfft.simulate_points(v, xy)\n"
+;
+
+const std::string eclipse_grid_docstring =
+  "\n"
+  "Corner-point grid read from an Eclipse grid file (GRDECL) with the keywords\n"
+  "SPECGRID, COORD, ZCORN and, optionally, ACTNUM. Use with\n"
+  "gaussianfft.simulate_eclipse_grid.\n"
+  "\n"
+  "Parameters\n"
+  "----------\n"
+  "filename: str\n"
+  "    Name of the grid file.\n"
+;
+
+const std::string eclipse_grid_active_indices_docstring =
+  "\n"
+  "Index i + j*ni + k*ni*nj of each active cell, in the order of the values from\n"
+  "gaussianfft.simulate_eclipse_grid.\n"
+;
+
+const std::string eclipse_grid_add_parameter_docstring =
+  "\n"
+  "Adds a parameter with one value for each active cell, e.g. a field from\n"
+  "gaussianfft.simulate_eclipse_grid. Inactive cells get the value 0.\n"
+;
+
+const std::string eclipse_grid_write_docstring =
+  "\n"
+  "Writes the grid and its parameters to an Eclipse grid file.\n"
+;
+
+const std::string simulate_eclipse_grid_docstring =
+  "\n"
+  "Simulates a Gaussian random field at the centers of the active cells of a\n"
+  "corner-point grid. The field is simulated on a regular, axis aligned box with\n"
+  "cell size dx, dy, dz that covers the cell centers, and interpolated trilinearly\n"
+  "at the centers. The box is interpolated one layer at a time as it is\n"
+  "simulated, and is never held in memory. The cell centers and the interpolation\n"
+  "weights are computed once and kept for the last few grids, so repeated calls\n"
+  "on the same grid only simulate and interpolate. The random generator seed may\n"
+  "be set by using gaussianfft.seed.\n"
+  "\n"
+  "Parameters\n"
+  "----------\n"
+  "variogram: gaussianfft.Variogram\n"
+  "    Variogram of the field, with ranges and azimuth in the coordinates of the\n"
+  "    grid.\n"
+  "grid: gaussianfft.EclipseGrid\n"
+  "    The corner-point grid.\n"
+  "dx, dy, dz: float\n"
+  "    Cell size of the simulation box. It should be at most the size of the\n"
+  "    grid cells in each direction.\n"
+  "n_realizations: int, optional\n"
+  "    Number of realizations. Default is 1.\n"
+  "\n"
+  "Returns\n"
+  "-------\n"
+  "numpy.ndarray with one value for each active cell, ordered as\n"
+  "grid.active_indices(). With n_realizations other than 1, the shape is\n"
+  "(n_realizations, number of active cells).\n"
+  "\n"
+  "Examples\n"
+  "--------\n"
+  ">>> grid = gaussianfft.EclipseGrid('reservoir.grdecl')\n"
+  ">>> v = gaussianfft.variogram('spherical', 1000.0, 500.0, 10.0, azimuth=30.0)\n"
+  ">>> poro = gaussianfft.simulate_eclipse_grid(v, grid, 50.0, 50.0, 1.0)\n"
+  ">>> grid.add_parameter('PORO', 0.2 + 0.03 * poro)\n"
+  ">>> grid.write('poro.grdecl')\n"
+;
+
+const std::string simulate_to_file_docstring =
+  "\n"
+  "Simulates one realization per file name and writes each of them directly to a\n"
+  "Storm grid file (storm_petro_binary, float32, big endian) as it is simulated.\n"
+  "The realizations are written one layer at a time from the FFT buffer, so no\n"
+  "complete realization is held in memory. The filter is computed only once for all\n"
+  "files. The random generator seed may be set by using gaussianfft.seed.\n"
+  "\n"
+  "Parameters\n"
+  "----------\n"
+  "filenames: str or list of str\n"
+  "    File name(s) to write. One realization is simulated for each file.\n"
+  "variogram, nx, ny, nz, dx, dy, dz:\n"
+  "    See gaussianfft.simulate. All grid sizes and resolutions are required.\n"
+  "mask: numpy.ndarray, optional\n"
+  "    Boolean array with nx*ny*nz values in Fortran ordering. Cells where the mask\n"
+  "    is False are written as missing_code.\n"
+  "missing_code: float, optional\n"
+  "    Value of inactive cells in the file. Default is -999.0.\n"
+  "x0, y0, z0: float, optional\n"
+  "    Origin and top of the grid. Default is 0.0.\n"
+  "rotation: float, optional\n"
+  "    Rotation of the grid in degrees, as written to the Storm header. Default is 0.0.\n"
+  "\n"
+  "Examples\n"
+  "--------\n"
+  ">>> v = gaussianfft.variogram('spherical', 1000.0, 500.0, 20.0)\n"
+  ">>> files = ['real_{}.storm'.format(i) for i in range(10)]\n"
+  ">>> gaussianfft.simulate_to_file(files, v, 200, 25.0, 200, 25.0, 100, 1.0)\n"
+;
+
+const std::string simulate_slabs_docstring =
+  "\n"
+  "Simulates a 3D field one horizontal layer at a time, for the separable covariance\n"
+  "C(dx, dy) exp(-3|dz|/range_z), where C is the horizontal covariance of variogram.\n"
+  "The noise of the layers is a vertical AR(1) sequence, and each layer is filtered\n"
+  "by a 2D FFT. Only one padded layer is kept in memory, and there is no padding\n"
+  "in z, which makes this much leaner than gaussianfft.simulate for grids with many\n"
+  "layers.\n"
+  "The random generator seed may be set by using gaussianfft.seed.\n"
+  "\n"
+  "Parameters\n"
+  "----------\n"
+  "variogram: gaussianfft.Variogram\n"
+  "    Horizontal variogram. Only its horizontal ranges and azimuth are used, and it\n"
+  "    cannot have dip.\n"
+  "range_z: float\n"
+  "    Range of the exponential correlation in z.\n"
+  "nx, ny, nz, dx, dy, dz:\n"
+  "    See gaussianfft.simulate. All grid sizes and resolutions are required, and\n"
+  "    ny may be 1.\n"
+  "out: numpy.ndarray, optional\n"
+  "    C-contiguous float64 array with nx*ny*nz values that the layers are written\n"
+  "    to in Fortran ordering, such as a numpy.memmap of a file.\n"
+  "callback: callable, optional\n"
+  "    Called as callback(k, layer) for each layer k, where layer is a new array with\n"
+  "    nx*ny values in Fortran ordering. Nothing is stored, and None is returned.\n"
+  "\n"
+  "Returns\n"
+  "-------\n"
+  "out: numpy.ndarray or None\n"
+  "    One-dimensional array with the simulation result in Fortran ordering, or\n"
+  "    None if callback is given.\n"
+  "\n"
+  "Examples\n"
+  "--------\n"
+  ">>> v = gaussianfft.variogram('spherical', 1000.0, 500.0)\n"
+  ">>> z = gaussianfft.simulate_slabs(v, 5.0, 200, 25.0, 200, 25.0, 2000, 0.2)\n"
+;
+
 const std::string advanced_simulate_docstring =
   "\n"
   "Same as gaussianfft.simulate, but with a few additional advanced and\n"
@@ -153,6 +794,15 @@ const std::string advanced_simulate_docstring =
   "    values of the smoothing kernel at one variogram range and MUST therefore be\n"
   "    greater than 0 and less than 1. A value close to or greater than 1 means no\n"
   "    smoothing.\n"
+  "max_memory: int\n"
+  "    Memory budget in bytes. If the simulation needs more memory than this, a\n"
+  "    leaner strategy is used (see gaussianfft.advanced.simulation_plan), and if no\n"
+  "    strategy fits, RuntimeError is raised before the simulation starts. FFT\n"
+  "    buffers kept from earlier simulations count against the budget, and are\n"
+  "    released if needed (see gaussianfft.release_workspace). Default is 0, which\n"
+  "    means no limit.\n"
+  "transform: gaussianfft.Transform, optional\n"
+  "    See gaussianfft.simulate.\n"
   "\n"
   "Returns\n"
   "-------\n"
@@ -160,6 +810,329 @@ const std::string advanced_simulate_docstring =
   "    See gaussianfft.simulate.\n"
 ;
 
+const std::string simulation_plan_docstring =
+  "\n"
+  "Estimates the memory and work needed by gaussianfft.advanced.simulate, without\n"
+  "simulating. Strategies are tried in the order 'standard', 'lean' and\n"
+  "'single_precision', and the first one needing at most max_memory bytes is used.\n"
+  "The lean strategy keeps a single FFT grid and gives the same result as the standard\n"
+  "one. The single precision strategy also does the transforms in single precision.\n"
+  "One-dimensional simulations always use the standard strategy.\n"
+  "\n"
+  "Parameters\n"
+  "----------\n"
+  "variogram, nx, ny, nz, dx, dy, dz, padx, pady, padz, max_memory:\n"
+  "    See gaussianfft.advanced.simulate.\n"
+  "\n"
+  "Returns\n"
+  "-------\n"
+  "out: dict\n"
+  "    strategy: name of the selected strategy.\n"
+  "    padded_size: grid size after padding in each simulated direction.\n"
+  "    buffers: dict with the largest number of bytes held by each buffer.\n"
+  "    peak_bytes: largest number of bytes held at the same time.\n"
+  "    flops: approximate number of floating point operations.\n"
+  "\n"
+  "Examples\n"
+  "--------\n"
+  ">>> v = gaussianfft.variogram('gaussian', 250.0)\n"
+  ">>> plan = gaussianfft.advanced.simulation_plan(v, 400, 5.0, 400, 5.0, 100, 1.0, max_memory=2**30)\n"
+  ">>> plan['strategy'], plan['peak_bytes']\n"
+;
+
+const std::string transform_docstring =
+  "\n"
+  "Pipeline of pointwise transforms of a simulated field. The steps are applied in\n"
+  "the order they are added, in a single parallel pass that writes the final values\n"
+  "directly, either when simulating (see gaussianfft.simulate) or with\n"
+  "Transform.apply. Each method returns the transform, so calls can be chained.\n"
+  "\n"
+  "Examples\n"
+  "--------\n"
+  ">>> v = gaussianfft.variogram('spherical', 200.0, 100.0)\n"
+  "\n"
+  "Porosity with mean 0.2, standard deviation 0.03 and a trend\n"
+  "\n"
+  ">>> t = gaussianfft.Transform().affine(0.03, 0.2).trend(porosity_trend)\n"
+  ">>> poro = gaussianfft.simulate(v, 100, 10.0, 100, 10.0, transform=t)\n"
+  "\n"
+  "Three facies with proportions 0.3, 0.5 and 0.2, as an int8 array\n"
+  "\n"
+  ">>> t = gaussianfft.Transform().thresholds([-0.5244, 0.8416])\n"
+  ">>> facies = gaussianfft.simulate(v, 100, 10.0, 100, 10.0, transform=t)\n"
+;
+
+const std::string transform_affine_docstring =
+  "\n"
+  "Adds the step value = scale*value + shift.\n"
+;
+
+const std::string transform_trend_docstring =
+  "\n"
+  "Adds the step value = value + trend, where trend has one value per cell, with the\n"
+  "ordering of the result of gaussianfft.simulate, or the shape (nx, ny, nz) in\n"
+  "Fortran order.\n"
+;
+
+const std::string transform_exp_docstring =
+  "\n"
+  "Adds the step value = exp(value).\n"
+;
+
+const std::string transform_lognormal_docstring =
+  "\n"
+  "Adds steps that transform a standard normal value to a lognormal value with the\n"
+  "given mean and standard deviation.\n"
+;
+
+const std::string transform_table_docstring =
+  "\n"
+  "Adds a piecewise linear mapping given by a table, for instance a normal score\n"
+  "back transform. x must be increasing. Values outside the table are mapped to the\n"
+  "first or last y.\n"
+;
+
+const std::string transform_thresholds_docstring =
+  "\n"
+  "Ends the pipeline by truncating the values into integer codes. The code is the\n"
+  "number of thresholds that are less than or equal to the value, so n thresholds\n"
+  "give the codes 0, ..., n. The thresholds must be increasing, and there can be at\n"
+  "most 127. The result has type int8.\n"
+;
+
+const std::string transform_apply_docstring =
+  "\n"
+  "Applies the transform to a field, and returns a new array with the same shape.\n"
+;
+
+const std::string simulator_docstring =
+  "\n"
+  "Simulator for Gaussian random fields with a fixed variogram and grid. The\n"
+  "filter is computed once, when the simulator is created, so repeated simulations\n"
+  "are faster than calls to gaussianfft.simulate.\n"
+  "\n"
+  "The simulator also keeps a latent noise state in the Fourier domain, which is\n"
+  "used for sequences of correlated fields, z_t = rho z_(t-1) + sqrt(1 - rho^2) e_t,\n"
+  "and for gradual deformation, z(theta) = cos(theta) z + sin(theta) v. Each new\n"
+  "field in a sequence or deformation needs a single inverse Fourier transform.\n"
+  "\n"
+  "Parameters\n"
+  "----------\n"
+  "variogram, nx, dx, ny, dy, nz, dz:\n"
+  "    See gaussianfft.simulate.\n"
+  "padx, pady, padz: int, optional\n"
+  "    See gaussianfft.advanced.simulate.\n"
+  "\n"
+  "Examples\n"
+  "--------\n"
+  ">>> v = gaussianfft.variogram('gaussian', 250.0, 125.0)\n"
+  ">>> sim = gaussianfft.Simulator(v, 100, 10.0, 100, 10.0)\n"
+  ">>> fields = [sim.simulate() for _ in range(10)]\n"
+  "\n"
+  "A sequence of 20 fields where consecutive fields have correlation 0.9\n"
+  "\n"
+  ">>> chain = list(sim.sequence(0.9, 20))\n"
+  "\n"
+  "Gradual deformation\n"
+  "\n"
+  ">>> candidates = [sim.deform(theta) for theta in np.linspace(-0.5, 0.5, 11)]\n"
+  ">>> sim.accept(0.2)\n"
+;
+
+const std::string simulator_simulate_docstring =
+  "\n"
+  "Simulates a new, independent field. Gives the same values as gaussianfft.simulate\n"
+  "with the same seed. The latent state is not changed.\n"
+;
+
+const std::string simulator_simulate_with_derivatives_docstring =
+  "\n"
+  "Simulates a new field as Simulator.simulate, together with its derivatives.\n"
+  "The derivatives are computed from the same spectrum as the field, by one batched\n"
+  "inverse Fourier transform, and are exact for the periodic field on the padded\n"
+  "grid.\n"
+  "\n"
+  "Parameters\n"
+  "----------\n"
+  "laplacian: bool, optional\n"
+  "    Also return the Laplacian of the field. Default is False.\n"
+  "\n"
+  "Returns\n"
+  "-------\n"
+  "Tuple of the field and an np.ndarray with shape (m, n), where n is the size of\n"
+  "the field. The rows are the derivatives with respect to x, y and z, one for each\n"
+  "simulated direction, followed by the Laplacian if it is requested. Units are per\n"
+  "unit of dx, dy and dz.\n"
+;
+
+const std::string simulator_reset_docstring =
+  "\n"
+  "Draws a new, independent latent state.\n"
+;
+
+const std::string simulator_field_docstring =
+  "\n"
+  "Returns the field of the current latent state. A state is drawn if there is none.\n"
+;
+
+const std::string simulator_step_docstring =
+  "\n"
+  "Updates the latent state to rho w + sqrt(1 - rho^2) e, where e is new noise,\n"
+  "and returns its field. The correlation between the field and the previous field\n"
+  "is rho in every cell. If there is no state, a new one is drawn.\n"
+;
+
+const std::string simulator_sequence_docstring =
+  "\n"
+  "Iterator over a sequence of correlated fields. The first field is the current\n"
+  "state (see Simulator.field), and each of the following is Simulator.step(rho).\n"
+  "\n"
+  "Parameters\n"
+  "----------\n"
+  "rho: float\n"
+  "    Correlation between consecutive fields, in [-1, 1].\n"
+  "n: int, optional\n"
+  "    Number of fields. Default is -1, which gives an infinite sequence.\n"
+;
+
+const std::string simulator_deform_docstring =
+  "\n"
+  "Returns the field cos(theta) w + sin(theta) v, where w is the current latent\n"
+  "state and v is an independent proposal state. The state is not changed, so the\n"
+  "deformation parameter theta may be optimized by calling this repeatedly. The\n"
+  "fields have the same variogram for all values of theta.\n"
+;
+
+const std::string simulator_accept_docstring =
+  "\n"
+  "Sets the latent state to the one given by Simulator.deform(theta). The next\n"
+  "call to Simulator.deform uses a new proposal state.\n"
+;
+
+const std::string simulator_apply_docstring =
+  "\n"
+  "Applies the simulation operator to white noise, field = L noise. This is the\n"
+  "operator used by Simulator.simulate, so standard normal noise gives fields with\n"
+  "the variogram of the simulator. The noise is defined on the padded grid.\n"
+  "\n"
+  "Parameters\n"
+  "----------\n"
+  "noise: np.ndarray\n"
+  "    Noise with shape (n,) or (batch, n), where n = Simulator.noise_size. The\n"
+  "    values are ordered as the padded grid (see Simulator.padded_size), with x\n"
+  "    running fastest.\n"
+  "out: np.ndarray, optional\n"
+  "    C-contiguous float64 array for the result, with shape (m,) or (batch, m)\n"
+  "    where m = nx*ny*nz.\n"
+  "\n"
+  "Returns\n"
+  "-------\n"
+  "np.ndarray with the fields, ordered as the result of gaussianfft.simulate.\n"
+;
+
+const std::string simulator_apply_adjoint_docstring =
+  "\n"
+  "Applies the adjoint of the simulation operator, L^T field_gradient. If\n"
+  "field_gradient is the gradient of an objective function with respect to the\n"
+  "field, the result is the gradient with respect to the noise of\n"
+  "Simulator.apply. Each call needs two Fourier transforms per batch item.\n"
+  "\n"
+  "Parameters\n"
+  "----------\n"
+  "field_gradient: np.ndarray\n"
+  "    Values with shape (m,) or (batch, m), where m = nx*ny*nz.\n"
+  "out: np.ndarray, optional\n"
+  "    C-contiguous float64 array for the result, with shape (n,) or (batch, n)\n"
+  "    where n = Simulator.noise_size.\n"
+  "\n"
+  "Returns\n"
+  "-------\n"
+  "np.ndarray with values on the padded grid, ordered as the noise of Simulator.apply.\n"
+;
+
+const std::string variogram_map_docstring =
+  "\n"
+  "Empirical variogram map of gridded fields, accumulated over any number of\n"
+  "realizations. For each lag h = (a dx, b dy, c dz), the estimate is\n"
+  "\n"
+  "    gamma(h) = sum (z(x + h) - z(x))^2 / (2 N(h)),\n"
+  "\n"
+  "where the sum is over the N(h) pairs of active cells separated by h, in all\n"
+  "realizations. The sums for all lags are computed with Fourier transforms of a\n"
+  "zero-padded grid, so adding a field is O(n log n) rather than O(n^2).\n"
+  "\n"
+  "Parameters\n"
+  "----------\n"
+  "nx, dx, ny, dy, nz, dz:\n"
+  "    Grid size and cell size, see gaussianfft.simulate.\n"
+  "mask: np.ndarray, optional\n"
+  "    Boolean array with nx*ny*nz values, ordered as the result of\n"
+  "    gaussianfft.simulate. Only cells where mask is True are used.\n"
+  "\n"
+  "Examples\n"
+  "--------\n"
+  ">>> v = gaussianfft.variogram('spherical', 200.0, 100.0)\n"
+  ">>> vmap = gaussianfft.VariogramMap(100, 10.0, 100, 10.0)\n"
+  ">>> for _ in range(10):\n"
+  "...     vmap.add(gaussianfft.simulate(v, 100, 10.0, 100, 10.0))\n"
+  ">>> distance, gamma, pairs = vmap.radial(20.0)\n"
+  ">>> distance, gamma, pairs = vmap.directional(0.0, 20.0, tolerance=15.0)\n"
+;
+
+const std::string variogram_map_add_docstring =
+  "\n"
+  "Adds a realization with nx*ny*nz values, ordered as the result of\n"
+  "gaussianfft.simulate, or shaped (nx, ny, nz) in Fortran order.\n"
+;
+
+const std::string variogram_map_map_docstring =
+  "\n"
+  "Returns (gamma, pairs), the variogram and the number of pairs for each lag,\n"
+  "as arrays with shape (2nx - 1, 2ny - 1, 2nz - 1). Lag (a, b, c) is at index\n"
+  "(a + nx - 1, b + ny - 1, c + nz - 1), so zero lag is in the center. gamma is\n"
+  "NaN for lags without pairs.\n"
+;
+
+const std::string variogram_map_radial_docstring =
+  "\n"
+  "Omnidirectional variogram, binned by lag distance.\n"
+  "\n"
+  "Parameters\n"
+  "----------\n"
+  "bin_width: float\n"
+  "    Width of the distance bins. Bin i holds lags with distance in\n"
+  "    [i, i + 1)*bin_width, except zero lag.\n"
+  "n_bins: int, optional\n"
+  "    Number of bins. Default is 0, which gives bins for all lags in the grid.\n"
+  "\n"
+  "Returns\n"
+  "-------\n"
+  "(distance, gamma, pairs), where distance is the mean lag distance of the pairs\n"
+  "in each bin and pairs is the number of pairs of cells. Empty bins have NaN\n"
+  "distance and gamma.\n"
+;
+
+const std::string variogram_map_directional_docstring =
+  "\n"
+  "Directional variogram, binned by lag distance. As VariogramMap.radial, but only\n"
+  "lags within the angle tolerance of the direction, in either sense, are used.\n"
+  "\n"
+  "Parameters\n"
+  "----------\n"
+  "azimuth: float\n"
+  "    Azimuth of the direction in degrees, with the same convention as the azimuth\n"
+  "    of gaussianfft.variogram. The direction of a variogram's main range is the\n"
+  "    direction with the same azimuth and dip.\n"
+  "bin_width: float\n"
+  "    Width of the distance bins.\n"
+  "tolerance: float, optional\n"
+  "    Angle tolerance in degrees. Default is 22.5.\n"
+  "dip: float, optional\n"
+  "    Dip of the direction in degrees. Default is 0.\n"
+  "n_bins: int, optional\n"
+  "    Number of bins. Default is 0, which gives bins for all lags in the grid.\n"
+;
+
 /**********************************************/
 /**********************************************/
 /**********************************************/
@@ -179,18 +1152,143 @@ PYBIND11_MODULE(_gaussianfft, m, py::mod_gil_not_used(), py::multiple_interprete
       .def("corr", ptr1)
       .def("corr", ptr2)
       .def("corr", ptr3)
+      .def("corr_array", &GaussFFT::VariogramCorrArray,
+          py::arg("dx"),
+          py::arg("dy")=py::none(),
+          py::arg("dz")=py::none(),
+          corr_array_docstring.c_str()
+      )
+      .def("cov_matrix", &GaussFFT::VariogramCovMatrix,
+          py::arg("points_a"),
+          py::arg("points_b")=py::none(),
+          cov_matrix_docstring.c_str()
+      )
     ;
   }
 
+  //
+  // Post-processing
+  //
+  py::class_<NRLib::FieldTransform>(m, "Transform", transform_docstring.c_str())
+    .def(py::init<>())
+    .def("affine",
+        [](NRLib::FieldTransform & transform, double scale, double shift) -> NRLib::FieldTransform & {
+          transform.AddAffine(scale, shift);
+          return transform;
+        },
+        py::arg("scale")=1.0,
+        py::arg("shift")=0.0,
+        py::return_value_policy::reference_internal,
+        transform_affine_docstring.c_str()
+    )
+    .def("trend",
+        [](NRLib::FieldTransform & transform,
+           const py::array_t<double, py::array::f_style | py::array::forcecast> & trend) -> NRLib::FieldTransform & {
+          GaussFFT::TransformAddTrend(transform, trend);
+          return transform;
+        },
+        py::arg("trend"),
+        py::return_value_policy::reference_internal,
+        transform_trend_docstring.c_str()
+    )
+    .def("exp",
+        [](NRLib::FieldTransform & transform) -> NRLib::FieldTransform & {
+          transform.AddExp();
+          return transform;
+        },
+        py::return_value_policy::reference_internal,
+        transform_exp_docstring.c_str()
+    )
+    .def("lognormal",
+        [](NRLib::FieldTransform & transform, double mean, double std) -> NRLib::FieldTransform & {
+          transform.AddLognormal(mean, std);
+          return transform;
+        },
+        py::arg("mean"),
+        py::arg("std"),
+        py::return_value_policy::reference_internal,
+        transform_lognormal_docstring.c_str()
+    )
+    .def("table",
+        [](NRLib::FieldTransform & transform,
+           const std::vector<double> & x,
+           const std::vector<double> & y) -> NRLib::FieldTransform & {
+          transform.AddTable(x, y);
+          return transform;
+        },
+        py::arg("x"),
+        py::arg("y"),
+        py::return_value_policy::reference_internal,
+        transform_table_docstring.c_str()
+    )
+    .def("thresholds",
+        [](NRLib::FieldTransform & transform, const std::vector<double> & thresholds) -> NRLib::FieldTransform & {
+          transform.SetThresholds(thresholds);
+          return transform;
+        },
+        py::arg("thresholds"),
+        py::return_value_policy::reference_internal,
+        transform_thresholds_docstring.c_str()
+    )
+    .def("apply", &GaussFFT::TransformApply, py::arg("field"), transform_apply_docstring.c_str())
+    .def_property_readonly("has_thresholds", &NRLib::FieldTransform::HasThresholds)
+  ;
+
   //
   // NRLib::Random
   //
   {
+    py::class_<NRLib::RandomGenerator>(m, "RandomStream")
+      .def_property_readonly("seed", &NRLib::RandomGenerator::GetStartSeed)
+      .def(py::pickle(&GaussFFT::RandomStreamGetState, &GaussFFT::RandomStreamSetState))
+    ;
+
     void(*ptr)(unsigned long) = &NRLib::Random::Initialize;
+    void(*stream_ptr)(const NRLib::RandomGenerator &) = &NRLib::Random::Initialize;
     m.def("seed", ptr,                          set_seed_docstring.c_str());
+    m.def("seed", stream_ptr, py::arg("stream"), set_seed_stream_docstring.c_str());
     m.def("seed", &NRLib::Random::GetStartSeed, get_seed_docstring.c_str());
+    m.def("seed_streams", &GaussFFT::SeedStreams,
+        py::arg("master_seed"),
+        py::arg("n_streams"),
+        seed_streams_docstring.c_str()
+    );
   }
 
+  //
+  // Profiling
+  //
+  m.def("profiling", &NRLib::Profiling::SetEnabled, py::arg("enabled"), set_profiling_docstring.c_str());
+  m.def("profiling", &NRLib::Profiling::IsEnabled,                      get_profiling_docstring.c_str());
+  m.def("last_run_stats", &GaussFFT::LastRunStats, last_run_stats_docstring.c_str());
+  m.def("last_run_trace", &GaussFFT::LastRunTrace, last_run_trace_docstring.c_str());
+
+  //
+  // Cache
+  //
+  m.def("cache_dir", &GaussFFT::SetCacheDirectory, py::arg("path"), set_cache_dir_docstring.c_str());
+  m.def("cache_dir", &GaussFFT::GetCacheDirectory,                  get_cache_dir_docstring.c_str());
+
+  //
+  // FFT backend
+  //
+  m.def("fft_backend", &NRLib::FFTBackend::Set, py::arg("name"), set_fft_backend_docstring.c_str());
+  m.def("fft_backend", &GaussFFT::GetFFTBackend,                get_fft_backend_docstring.c_str());
+  m.def("fft_threads", &NRLib::FFTBackend::SetThreads, py::arg("n"), set_fft_threads_docstring.c_str());
+  m.def("fft_threads", &NRLib::FFTBackend::GetThreads,               get_fft_threads_docstring.c_str());
+  m.def("fft_benchmark", &GaussFFT::FFTBenchmark, py::arg("shape"), py::arg("repeats") = 10, fft_benchmark_docstring.c_str());
+
+  //
+  // Workspace
+  //
+  m.def("release_workspace", &GaussFFT::ReleaseWorkspace, release_workspace_docstring.c_str());
+  m.def("workspace_limit", &NRLib::WorkspacePool::SetLimit, py::arg("bytes"), set_workspace_limit_docstring.c_str());
+  m.def("workspace_limit", &NRLib::WorkspacePool::GetLimit,                   get_workspace_limit_docstring.c_str());
+  m.def("huge_pages", &NRLib::WorkspacePool::SetHugePages, py::arg("enabled"), set_huge_pages_docstring.c_str());
+  m.def("huge_pages", &NRLib::WorkspacePool::GetHugePages,                      get_huge_pages_docstring.c_str());
+  m.def("legacy_noise", &NRLib::SetLegacyNoise, py::arg("enabled"), set_legacy_noise_docstring.c_str());
+  m.def("legacy_noise", &NRLib::GetLegacyNoise,                     get_legacy_noise_docstring.c_str());
+
   //
   // Padding
   //
@@ -221,6 +1319,13 @@ PYBIND11_MODULE(_gaussianfft, m, py::mod_gil_not_used(), py::multiple_interprete
     variogram_docstring.c_str()
   );
 
+  m.def("nested_variogram", &GaussFFT::CreateNestedVariogram,
+      py::arg("structures"),
+      py::arg("nugget")=0.0,
+    py::return_value_policy::take_ownership,
+    nested_variogram_docstring.c_str()
+  );
+
   // Simulate core function
   //
   m.def("simulate", &GaussFFT::Simulate,
@@ -231,9 +1336,210 @@ PYBIND11_MODULE(_gaussianfft, m, py::mod_gil_not_used(), py::multiple_interprete
       py::arg("dy")=-1.0,
       py::arg("nz")=1U,
       py::arg("dz")=-1.0,
+      py::arg("transform")=py::none(),
+      py::arg("rotation")=0.0,
+      py::arg("block")=std::vector<double>(),
     simulate_docstring.c_str()
   );
 
+  m.def("simulate_active", &GaussFFT::SimulateActive,
+      py::arg("variogram"),
+      py::arg("active"),
+      py::arg("nx"),
+      py::arg("dx"),
+      py::arg("ny")=1U,
+      py::arg("dy")=-1.0,
+      py::arg("nz")=1U,
+      py::arg("dz")=-1.0,
+      py::arg("transform")=py::none(),
+    simulate_active_docstring.c_str()
+  );
+
+  m.def("simulate_multi", &GaussFFT::SimulateMulti,
+      py::arg("variograms"),
+      py::arg("nx"),
+      py::arg("dx"),
+      py::arg("ny")=1U,
+      py::arg("dy")=-1.0,
+      py::arg("nz")=1U,
+      py::arg("dz")=-1.0,
+    simulate_multi_docstring.c_str()
+  );
+
+  m.def("simulate_jobs", &GaussFFT::SimulateJobs,
+      py::arg("jobs"),
+      py::arg("n_threads")=0U,
+    simulate_jobs_docstring.c_str()
+  );
+
+  m.def("simulate_traces", &GaussFFT::SimulateTraces,
+      py::arg("variogram"),
+      py::arg("n_traces"),
+      py::arg("nx"),
+      py::arg("dx"),
+      py::arg("padx")=-1,
+    simulate_traces_docstring.c_str()
+  );
+
+  m.def("simulate_points", &GaussFFT::SimulatePoints,
+      py::arg("variogram"),
+      py::arg("points"),
+      py::arg("n_features")=1000U,
+    simulate_points_docstring.c_str()
+  );
+
+  //
+  // Reusable simulator
+  //
+  py::class_<NRLib::GaussianFieldSimulator>(m, "Simulator", simulator_docstring.c_str())
+    .def(py::init(&GaussFFT::CreateSimulator),
+        py::arg("variogram"),
+        py::arg("nx"),
+        py::arg("dx"),
+        py::arg("ny")=1U,
+        py::arg("dy")=-1.0,
+        py::arg("nz")=1U,
+        py::arg("dz")=-1.0,
+        py::arg("padx")=-1,
+        py::arg("pady")=-1,
+        py::arg("padz")=-1
+    )
+    .def("simulate", &GaussFFT::SimulatorSimulate, simulator_simulate_docstring.c_str())
+    .def("simulate_with_derivatives", &GaussFFT::SimulatorSimulateWithDerivatives,
+        py::arg("laplacian")=false,
+        simulator_simulate_with_derivatives_docstring.c_str()
+    )
+    .def("reset", &NRLib::GaussianFieldSimulator::ResetState, simulator_reset_docstring.c_str())
+    .def("field", &GaussFFT::SimulatorField, simulator_field_docstring.c_str())
+    .def("step", &GaussFFT::SimulatorStep, py::arg("rho"), simulator_step_docstring.c_str())
+    .def("sequence",
+        [](NRLib::GaussianFieldSimulator & simulator, double rho, long n) {
+          return GaussFFT::FieldSequence(simulator, rho, n);
+        },
+        py::arg("rho"),
+        py::arg("n")=-1,
+        py::keep_alive<0, 1>(),
+        simulator_sequence_docstring.c_str()
+    )
+    .def("deform", &GaussFFT::SimulatorDeform, py::arg("theta"), simulator_deform_docstring.c_str())
+    .def("accept", &NRLib::GaussianFieldSimulator::AcceptDeformation, py::arg("theta"), simulator_accept_docstring.c_str())
+    .def("apply", &GaussFFT::SimulatorApply,
+        py::arg("noise"),
+        py::arg("out")=py::none(),
+        simulator_apply_docstring.c_str()
+    )
+    .def("apply_adjoint", &GaussFFT::SimulatorApplyAdjoint,
+        py::arg("field_gradient"),
+        py::arg("out")=py::none(),
+        simulator_apply_adjoint_docstring.c_str()
+    )
+    .def_property_readonly("padded_size", &GaussFFT::SimulatorPaddedSize)
+    .def_property_readonly("noise_size", &NRLib::GaussianFieldSimulator::GetNoiseSize)
+  ;
+
+  py::class_<GaussFFT::FieldSequence>(m, "FieldSequence")
+    .def("__iter__", [](GaussFFT::FieldSequence & sequence) -> GaussFFT::FieldSequence & { return sequence; },
+        py::return_value_policy::reference_internal)
+    .def("__next__", &GaussFFT::FieldSequence::Next)
+  ;
+
+  //
+  // Empirical variogram map
+  //
+  py::class_<NRLib::EmpiricalVariogramMap>(m, "VariogramMap", variogram_map_docstring.c_str())
+    .def(py::init(&GaussFFT::CreateVariogramMap),
+        py::arg("nx"),
+        py::arg("dx"),
+        py::arg("ny")=1U,
+        py::arg("dy")=-1.0,
+        py::arg("nz")=1U,
+        py::arg("dz")=-1.0,
+        py::arg("mask")=py::none()
+    )
+    .def("add", &GaussFFT::VariogramMapAdd, py::arg("field"), variogram_map_add_docstring.c_str())
+    .def("map", &GaussFFT::VariogramMapMap, variogram_map_map_docstring.c_str())
+    .def("radial", &GaussFFT::VariogramMapRadial,
+        py::arg("bin_width"),
+        py::arg("n_bins")=0U,
+        variogram_map_radial_docstring.c_str()
+    )
+    .def("directional", &GaussFFT::VariogramMapDirectional,
+        py::arg("azimuth"),
+        py::arg("bin_width"),
+        py::arg("tolerance")=22.5,
+        py::arg("dip")=0.0,
+        py::arg("n_bins")=0U,
+        variogram_map_directional_docstring.c_str()
+    )
+    .def_property_readonly("n_realizations", &NRLib::EmpiricalVariogramMap::GetNRealizations)
+  ;
+
+  //
+  // Corner-point grids
+  //
+  py::class_<NRLib::EclipseGrid>(m, "EclipseGrid", eclipse_grid_docstring.c_str())
+    .def(py::init<const std::string &>(), py::arg("filename"))
+    .def_property_readonly("ni", &NRLib::EclipseGrid::GetNI)
+    .def_property_readonly("nj", &NRLib::EclipseGrid::GetNJ)
+    .def_property_readonly("nk", &NRLib::EclipseGrid::GetNK)
+    .def("active_indices", &GaussFFT::EclipseGridActiveIndices, eclipse_grid_active_indices_docstring.c_str())
+    .def("add_parameter", &GaussFFT::EclipseGridAddParameter,
+        py::arg("name"),
+        py::arg("values"),
+        eclipse_grid_add_parameter_docstring.c_str()
+    )
+    .def("write",
+        [](const NRLib::EclipseGrid & grid, const std::string & filename) { grid.WriteToFile(filename); },
+        py::arg("filename"),
+        eclipse_grid_write_docstring.c_str()
+    )
+  ;
+
+  m.def("simulate_eclipse_grid", &GaussFFT::SimulateEclipseGrid,
+      py::arg("variogram"),
+      py::arg("grid"),
+      py::arg("dx"),
+      py::arg("dy"),
+      py::arg("dz"),
+      py::arg("n_realizations")=1U,
+    simulate_eclipse_grid_docstring.c_str()
+  );
+
+  //
+  // Simulate directly to Storm grid files
+  //
+  m.def("simulate_to_file", &GaussFFT::SimulateToFile,
+      py::arg("filenames"),
+      py::arg("variogram"),
+      py::arg("nx"),
+      py::arg("dx"),
+      py::arg("ny"),
+      py::arg("dy"),
+      py::arg("nz"),
+      py::arg("dz"),
+      py::arg("mask") = py::none(),
+      py::arg("missing_code") = -999.0f,
+      py::arg("x0") = 0.0,
+      py::arg("y0") = 0.0,
+      py::arg("z0") = 0.0,
+      py::arg("rotation") = 0.0,
+    simulate_to_file_docstring.c_str()
+  );
+
+  m.def("simulate_slabs", &GaussFFT::SimulateSlabs,
+      py::arg("variogram"),
+      py::arg("range_z"),
+      py::arg("nx"),
+      py::arg("dx"),
+      py::arg("ny"),
+      py::arg("dy"),
+      py::arg("nz"),
+      py::arg("dz"),
+      py::arg("out") = py::none(),
+      py::arg("callback") = py::none(),
+    simulate_slabs_docstring.c_str()
+  );
+
   /******************* Advanced *******************/
   auto advanced = m.def_submodule("advanced");
   //
@@ -253,6 +1559,26 @@ PYBIND11_MODULE(_gaussianfft, m, py::mod_gil_not_used(), py::multiple_interprete
       py::arg("sx") = 1.0,
       py::arg("sy") = 1.0,
       py::arg("sz") = 1.0,
+      py::arg("max_memory") = 0,
+      py::arg("transform") = py::none(),
     advanced_simulate_docstring.c_str()
   );
+
+  //
+  // Resource estimate
+  //
+  advanced.def("simulation_plan", &GaussFFT::SimulationPlan,
+      py::arg("variogram"),
+      py::arg("nx"),
+      py::arg("dx"),
+      py::arg("ny") = 1U,
+      py::arg("dy") = -1.0,
+      py::arg("nz") = 1U,
+      py::arg("dz") = -1.0,
+      py::arg("padx") = -1,
+      py::arg("pady") = -1,
+      py::arg("padz") = -1,
+      py::arg("max_memory") = 0,
+    simulation_plan_docstring.c_str()
+  );
 }
@@ -20,18 +20,236 @@
 // EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "fft.hpp"
+#include "fftbackend.hpp"
+#include "../exception/exception.hpp"
+#include "../profiling/profiling.hpp"
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <type_traits>
+
+#ifndef NRLIB_NO_FFTW
+// Must set MKL's /include/fftw or fftw's include directory as additional include directory.
+#include <fftw3.h>
+
+namespace {
+  // Number of complex values in the output of a real-to-complex transform of size n.
+  int ComplexSize(const std::vector<int> & n)
+  {
+    int size = n.back() / 2 + 1;
+    for (size_t i = 0; i + 1 < n.size(); i++)
+      size *= n[i];
+    return size;
+  }
+
+  int RealSize(const std::vector<int> & n)
+  {
+    int size = 1;
+    for (size_t i = 0; i < n.size(); i++)
+      size *= n[i];
+    return size;
+  }
+
+  // Plans are created once for each transform and reused with the new-array
+  // execute functions, which may be called from several threads. The planner
+  // is not thread safe, so the cache is guarded by a mutex. A plan is only
+  // valid for arrays with the alignment and placement (in-place or not) it
+  // was created for, so these are part of the key.
+  struct PlanKey {
+    std::vector<int> n;
+    int              howmany;
+    bool             inverse;
+    bool             in_place;
+    size_t           in_alignment;
+    size_t           out_alignment;
+    int              n_threads;
+
+    bool operator<(const PlanKey & other) const
+    {
+      if (n != other.n)                         return n < other.n;
+      if (howmany != other.howmany)             return howmany < other.howmany;
+      if (inverse != other.inverse)             return inverse < other.inverse;
+      if (in_place != other.in_place)           return in_place < other.in_place;
+      if (in_alignment != other.in_alignment)   return in_alignment < other.in_alignment;
+      if (out_alignment != other.out_alignment) return out_alignment < other.out_alignment;
+      return n_threads < other.n_threads;
+    }
+  };
+
+  PlanKey MakePlanKey(const std::vector<int> & n, int howmany, bool inverse, const void * in, const void * out)
+  {
+    PlanKey key;
+    key.n             = n;
+    key.howmany       = howmany;
+    key.inverse       = inverse;
+    key.in_place      = (in == out);
+    key.in_alignment  = reinterpret_cast<std::uintptr_t>(in) % 64;
+    key.out_alignment = reinterpret_cast<std::uintptr_t>(out) % 64;
+#ifdef NRLIB_FFTW_THREADS
+    key.n_threads     = NRLib::FFTBackend::GetThreads();
+#else
+    key.n_threads     = 1;
+#endif
+    return key;
+  }
+
+  std::mutex & PlanMutex()
+  {
+    static std::mutex plan_mutex;
+    return plan_mutex;
+  }
+
+#ifdef NRLIB_FFTW_THREADS
+  // Sets the number of threads of the plans made next. Called with the plan
+  // mutex held, as the planner is not thread safe.
+  void PlanWithThreads(int n_threads)
+  {
+    static bool initialized = false;
+    if (!initialized) {
+      fftw_init_threads();
+      fftwf_init_threads();
+      initialized = true;
+    }
+    fftw_plan_with_nthreads(n_threads);
+    fftwf_plan_with_nthreads(n_threads);
+  }
+#endif
+
+  void DestroyPlan(fftw_plan p)  { fftw_destroy_plan(p); }
+  void DestroyPlan(fftwf_plan p) { fftwf_destroy_plan(p); }
+
+  // A cached plan. Transforms hold on to it while executing, so the cache may
+  // be cleared by ReleasePlans while other threads use its plans; the last
+  // owner destroys the plan, with the plan mutex held since fftw_destroy_plan
+  // is not thread safe either.
+  template <typename Plan>
+  using PlanPointer = std::shared_ptr<typename std::remove_pointer<Plan>::type>;
+
+  template <typename Plan>
+  std::map<PlanKey, PlanPointer<Plan> > & CachedPlans()
+  {
+    static std::map<PlanKey, PlanPointer<Plan> > plans;
+    return plans;
+  }
+
+  // The cached plan for key, made with create() if there is none.
+  template <typename Plan, typename Create>
+  PlanPointer<Plan> FindPlan(const PlanKey & key, Create create)
+  {
+    std::lock_guard<std::mutex> lock(PlanMutex());
+    std::map<PlanKey, PlanPointer<Plan> > & plans = CachedPlans<Plan>();
+    typename std::map<PlanKey, PlanPointer<Plan> >::iterator it = plans.find(key);
+    if (it != plans.end())
+      return it->second;
+#ifdef NRLIB_FFTW_THREADS
+    PlanWithThreads(key.n_threads);
+#endif
+    Plan p = create();
+    if (p == 0)
+      throw NRLib::Exception("FFTW could not make a plan for a transform of " + std::to_string(RealSize(key.n))
+                             + " values.");
+    PlanPointer<Plan> plan(p, [](Plan q) {
+      std::lock_guard<std::mutex> lock(PlanMutex());
+      DestroyPlan(q);
+    });
+    plans[key] = plan;
+    return plan;
+  }
+
+  // Empties the cache of plans of type Plan, and returns the number of plans
+  // in it. The plans are destroyed when the cache no longer holds the mutex.
+  template <typename Plan>
+  size_t ReleaseCachedPlans()
+  {
+    std::map<PlanKey, PlanPointer<Plan> > released;
+    {
+      std::lock_guard<std::mutex> lock(PlanMutex());
+      released.swap(CachedPlans<Plan>());
+    }
+    return released.size();
+  }
+
+  // Transforms through the FFTW3 interface, with cached plans.
+  class FFTWBackendImpl : public NRLib::FFTBackend {
+  public:
+    std::string GetName() const { return "fftw"; }
+
+    void Forward(const std::vector<int> & n, int howmany, double * in, std::complex<double> * out)
+    {
+      fftw_complex* out_data = reinterpret_cast<fftw_complex*>(out);
+      PlanKey key = MakePlanKey(n, howmany, false, in, out);
+      PlanPointer<fftw_plan> p = FindPlan<fftw_plan>(key, [&]() {
+        return fftw_plan_many_dft_r2c(static_cast<int>(n.size()), &n[0], howmany,
+                                      in, NULL, 1, RealSize(n),
+                                      out_data, NULL, 1, ComplexSize(n),
+                                      FFTW_ESTIMATE);
+      });
+      fftw_execute_dft_r2c(p.get(), in, out_data);
+    }
+
+    void Forward(const std::vector<int> & n, int howmany, float * in, std::complex<float> * out)
+    {
+      fftwf_complex* out_data = reinterpret_cast<fftwf_complex*>(out);
+      PlanKey key = MakePlanKey(n, howmany, false, in, out);
+      PlanPointer<fftwf_plan> p = FindPlan<fftwf_plan>(key, [&]() {
+        return fftwf_plan_many_dft_r2c(static_cast<int>(n.size()), &n[0], howmany,
+                                       in, NULL, 1, RealSize(n),
+                                       out_data, NULL, 1, ComplexSize(n),
+                                       FFTW_ESTIMATE);
+      });
+      fftwf_execute_dft_r2c(p.get(), in, out_data);
+    }
+
+    void Inverse(const std::vector<int> & n, int howmany, std::complex<double> * in, double * out)
+    {
+      fftw_complex* in_data = reinterpret_cast<fftw_complex*>(in);
+      PlanKey key = MakePlanKey(n, howmany, true, in, out);
+      PlanPointer<fftw_plan> p = FindPlan<fftw_plan>(key, [&]() {
+        return fftw_plan_many_dft_c2r(static_cast<int>(n.size()), &n[0], howmany,
+                                      in_data, NULL, 1, ComplexSize(n),
+                                      out, NULL, 1, RealSize(n),
+                                      FFTW_ESTIMATE);
+      });
+      fftw_execute_dft_c2r(p.get(), in_data, out);
+    }
+
+    void Inverse(const std::vector<int> & n, int howmany, std::complex<float> * in, float * out)
+    {
+      fftwf_complex* in_data = reinterpret_cast<fftwf_complex*>(in);
+      PlanKey key = MakePlanKey(n, howmany, true, in, out);
+      PlanPointer<fftwf_plan> p = FindPlan<fftwf_plan>(key, [&]() {
+        return fftwf_plan_many_dft_c2r(static_cast<int>(n.size()), &n[0], howmany,
+                                       in_data, NULL, 1, ComplexSize(n),
+                                       out, NULL, 1, RealSize(n),
+                                       FFTW_ESTIMATE);
+      });
+      fftwf_execute_dft_c2r(p.get(), in_data, out);
+    }
+
+    size_t ReleasePlans()
+    {
+      return ReleaseCachedPlans<fftw_plan>() + ReleaseCachedPlans<fftwf_plan>();
+    }
+  };
+}
+
+NRLib::FFTBackend & NRLib::NRLibPrivate::FFTWBackend()
+{
+  static FFTWBackendImpl backend;
+  return backend;
+}
+#endif // NRLIB_NO_FFTW
 
 template <>
 void NRLib::NRLibPrivate::ComputeFFT1D<double>(size_t n,
   double* in,
   std::complex<double>* out)
 {
-  fftw_complex* out_data = reinterpret_cast<fftw_complex*>(out);
-  fftw_plan p = fftw_plan_dft_r2c_1d(static_cast<int>(n), in, out_data, FFTW_ESTIMATE);
-  assert(p != 0);
-
-  fftw_execute(p);
-  fftw_destroy_plan(p);
+  Profiling::ScopedTimer timer("fft");
+  ComputeFFTMany(std::vector<int>(1, static_cast<int>(n)), 1, in, out);
 }
 
 template <>
@@ -39,12 +257,44 @@ void NRLib::NRLibPrivate::ComputeFFTInv1D<double>(size_t n,
   std::complex<double>* in,
   double* out)
 {
-  fftw_complex* in_data = reinterpret_cast<fftw_complex*>(in);
-  fftw_plan p = fftw_plan_dft_c2r_1d(static_cast<int>(n), in_data, out, FFTW_ESTIMATE);
-  assert(p != 0);
+  Profiling::ScopedTimer timer("inverse_fft");
+  ComputeFFTManyInverse(std::vector<int>(1, static_cast<int>(n)), 1, in, out);
+}
+
+template <>
+void NRLib::NRLibPrivate::ComputeFFTMany<double>(const std::vector<int> & n,
+  int howmany,
+  double* in,
+  std::complex<double>* out)
+{
+  FFTBackend::Get().Forward(n, howmany, in, out);
+}
 
-  fftw_execute(p);
-  fftw_destroy_plan(p);
+template <>
+void NRLib::NRLibPrivate::ComputeFFTMany<float>(const std::vector<int> & n,
+  int howmany,
+  float* in,
+  std::complex<float>* out)
+{
+  FFTBackend::Get().Forward(n, howmany, in, out);
+}
+
+template <>
+void NRLib::NRLibPrivate::ComputeFFTManyInverse<double>(const std::vector<int> & n,
+  int howmany,
+  std::complex<double>* in,
+  double* out)
+{
+  FFTBackend::Get().Inverse(n, howmany, in, out);
+}
+
+template <>
+void NRLib::NRLibPrivate::ComputeFFTManyInverse<float>(const std::vector<int> & n,
+  int howmany,
+  std::complex<float>* in,
+  float* out)
+{
+  FFTBackend::Get().Inverse(n, howmany, in, out);
 }
 
 size_t
@@ -80,3 +330,17 @@ NRLib::FindNewSizeWithPadding(size_t minSize, bool must_be_even) {
 
   return closestprod;
 }
+
+std::vector<size_t>
+NRLib::FactorizeFFTSize(size_t n) {
+  std::vector<size_t> factors;
+  for (size_t p = 2; p * p <= n; p++) {
+    while (n % p == 0) {
+      factors.push_back(p);
+      n /= p;
+    }
+  }
+  if (n > 1)
+    factors.push_back(n);
+  return factors;
+}
@@ -28,7 +28,7 @@
 #include <iterator>
 #include <vector>
 
-#include <fftw3.h>
+#include "workspacepool.hpp"
 
 // The "public" declarations
 namespace NRLib {
@@ -51,6 +51,10 @@ namespace NRLib {
   void ComputeFFTInv1D(const std::vector<std::complex<double> >& vIn, container& vOut, bool scale_forward);
 
   size_t FindNewSizeWithPadding(size_t minSize, bool must_be_even = false);
+
+  /// Prime factors of n in increasing order. Used to report how favorable
+  /// a grid size is for the FFT implementation.
+  std::vector<size_t> FactorizeFFTSize(size_t n);
 }
 
 // The "private" declarations
@@ -62,6 +66,19 @@ namespace NRLib {
     template <> void ComputeFFT1D(size_t size, double *in, std::complex<double> * out);
     template <> void ComputeFFTInv1D(size_t size, std::complex<double> * in, double *out);
     template<class FI> void AddPadding(FI begin, FI end, double *v, size_t padSize, size_t sizeOrig, double scale_factor);
+
+    /// Computes howmany real-to-complex transforms with the current FFTBackend. n
+    /// holds the transform size with the slowest varying dimension first (FFTW
+    /// ordering). The transforms are stored one after another in in and out. No
+    /// scaling. With the FFTW backend, plans are made once for each size and
+    /// reused. The function may be called from several threads.
+    template <typename T> void ComputeFFTMany(const std::vector<int> & n, int howmany, T * in, std::complex<T> * out);
+    /// Inverse of ComputeFFTMany. Overwrites in. No scaling.
+    template <typename T> void ComputeFFTManyInverse(const std::vector<int> & n, int howmany, std::complex<T> * in, T * out);
+    template <> void ComputeFFTMany(const std::vector<int> & n, int howmany, double * in, std::complex<double> * out);
+    template <> void ComputeFFTMany(const std::vector<int> & n, int howmany, float * in, std::complex<float> * out);
+    template <> void ComputeFFTManyInverse(const std::vector<int> & n, int howmany, std::complex<double> * in, double * out);
+    template <> void ComputeFFTManyInverse(const std::vector<int> & n, int howmany, std::complex<float> * in, float * out);
   }
 }
 
@@ -88,7 +105,7 @@ void NRLib::ComputeFFT1D(FI begin, FI end, std::vector<std::complex<double> >& v
     pad_size = FindNewSizeWithPadding(pad_size + orig_size) - orig_size;
 
   size_t tot_size = orig_size + pad_size;
-  double * real_data = reinterpret_cast<double *> (fftw_malloc(tot_size * sizeof(double)));
+  double * real_data = reinterpret_cast<double *> (WorkspacePool::Acquire(tot_size * sizeof(double)));
 
   FI itLoop = begin;
   double scale_factor(1.0);
@@ -98,7 +115,7 @@ void NRLib::ComputeFFT1D(FI begin, FI end, std::vector<std::complex<double> >& v
     real_data[i] = scale_factor  * (*itLoop++);
 
   size_t complex_size = (tot_size / 2) + 1;
-  std::complex<double> * complex_data = reinterpret_cast<std::complex<double> *> (fftw_malloc(complex_size * sizeof(std::complex<double>)));
+  std::complex<double> * complex_data = reinterpret_cast<std::complex<double> *> (WorkspacePool::Acquire(complex_size * sizeof(std::complex<double>)));
 
   NRLibPrivate::AddPadding(begin, end, real_data, pad_size, orig_size, scale_factor);
   NRLibPrivate::ComputeFFT1D(tot_size, real_data, complex_data);
@@ -111,8 +128,8 @@ void NRLib::ComputeFFT1D(FI begin, FI end, std::vector<std::complex<double> >& v
     vOut[i] = complex_data[i];;
     vOut[tot_size - i] = complex_data[i];
   }
-  fftw_free(real_data);
-  fftw_free(complex_data);
+  WorkspacePool::Release(real_data, tot_size * sizeof(double));
+  WorkspacePool::Release(complex_data, complex_size * sizeof(std::complex<double>));
 }
 
 template<class FI>
@@ -126,11 +143,11 @@ NRLib::ComputeFFTInv1D(const std::vector<std::complex<double> >& vIn, FI begin,
   size_t data_size = distance(begin, end);
 
   //Copy values in vector to the correct internal data structures
-  std::complex<double> * complex_data = reinterpret_cast<std::complex<double> *> (fftw_malloc(tot_size * sizeof(std::complex<double>)));
+  std::complex<double> * complex_data = reinterpret_cast<std::complex<double> *> (WorkspacePool::Acquire(tot_size * sizeof(std::complex<double>)));
   for (size_t i = 0; i < tot_size; i++)
     complex_data[i] = vIn[i];
 
-  double * real_data = reinterpret_cast<double *> (fftw_malloc(tot_size * sizeof(double)));
+  double * real_data = reinterpret_cast<double *> (WorkspacePool::Acquire(tot_size * sizeof(double)));
 
   NRLibPrivate::ComputeFFTInv1D(tot_size, complex_data, real_data);
 
@@ -141,8 +158,8 @@ NRLib::ComputeFFTInv1D(const std::vector<std::complex<double> >& vIn, FI begin,
   for (size_t i = 0; i < data_size; i++) {
     *begin++ = real_data[i] * scale_factor;
   }
-  fftw_free(real_data);
-  fftw_free(complex_data);
+  WorkspacePool::Release(real_data, tot_size * sizeof(double));
+  WorkspacePool::Release(complex_data, tot_size * sizeof(std::complex<double>));
 }
 
 /// Implementation "private"
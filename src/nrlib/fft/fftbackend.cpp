@@ -0,0 +1,466 @@
+// Copyright (c)  2011, Norwegian Computing Center
+// All rights reserved.
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+// •  Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+// •  Redistributions in binary form must reproduce the above copyright notice, this list of
+//    conditions and the following disclaimer in the documentation and/or other materials
+//    provided with the distribution.
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+// OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <map>
+#include <memory>
+#include <mutex>
+
+#include "fftbackend.hpp"
+#include "fft.hpp"
+#include "workspacepool.hpp"
+#include "../exception/exception.hpp"
+
+using namespace NRLib;
+
+namespace {
+  typedef std::complex<double> Complex;
+
+  // Prime factors from this size are transformed by ChirpTransform, and
+  // smaller ones directly, which is faster below about 30.
+  const size_t chirp_min_factor = 29;
+
+  class ChirpTransform;
+
+  // Complex transform of length n by recursive mixed-radix decimation in
+  // time, over the prime factors of n. Made once for each length and shared
+  // by all threads.
+  class ComplexPlan {
+  public:
+    explicit ComplexPlan(size_t n);
+
+    /// Number of values needed in the work buffer of Transform.
+    size_t WorkSize() const { return 2 * n_ + chirp_work_; }
+
+    /// Transforms the n values in data, with exponent sign -1, or +1 if
+    /// inverse is true. work must hold WorkSize() values.
+    void Transform(Complex * data, Complex * work, bool inverse) const
+    {
+      if (n_ <= 1)
+        return;
+      std::copy(data, data + n_, work);
+      Recurse(work, data, n_, 1, 0, inverse, work + n_);
+    }
+
+  private:
+    Complex Twiddle(size_t j, bool inverse) const
+    {
+      return inverse ? std::conj(twiddles_[j]) : twiddles_[j];
+    }
+
+    void Recurse(const Complex * in, Complex * out, size_t n, size_t stride, size_t f, bool inverse, Complex * t) const;
+
+    size_t                                                  n_;
+    std::vector<size_t>                                     factors_;
+    std::vector<Complex>                                    twiddles_;
+    std::map<size_t, std::shared_ptr<const ChirpTransform> > chirps_;
+    size_t                                                  chirp_work_;
+  };
+
+  // Transform of prime length p as a cyclic convolution of length m, the
+  // smallest power of two of at least 2p - 1, by the chirp z-transform
+  // (Bluestein's algorithm). Takes O(m log m) instead of O(p^2) operations.
+  class ChirpTransform {
+  public:
+    explicit ChirpTransform(size_t p)
+      : p_(p),
+        m_(1),
+        chirp_(p)
+    {
+      while (m_ < 2 * p - 1)
+        m_ *= 2;
+      plan_.reset(new ComplexPlan(m_));
+
+      // w^(qr) = c(q) c(r) conj(c(r - q)) with c(j) = exp(-i pi j^2 / p).
+      const double pi = 3.14159265358979323846;
+      for (size_t j = 0; j < p; j++)
+        chirp_[j] = std::polar(1.0, -pi * static_cast<double>((j * j) % (2 * p)) / static_cast<double>(p));
+
+      // Transformed convolution kernels conj(c(j)) for each sign, scaled
+      // by 1/m for the unscaled inverse transform.
+      std::vector<Complex> work(plan_->WorkSize());
+      for (int sign = 0; sign < 2; sign++) {
+        std::vector<Complex> & kernel = (sign == 0) ? kernel_forward_ : kernel_inverse_;
+        kernel.assign(m_, Complex(0.0, 0.0));
+        for (size_t j = 0; j < p; j++) {
+          Complex b = (sign == 0) ? std::conj(chirp_[j]) : chirp_[j];
+          kernel[j] = b / static_cast<double>(m_);
+          if (j > 0)
+            kernel[m_ - j] = kernel[j];
+        }
+        plan_->Transform(&kernel[0], &work[0], false);
+      }
+    }
+
+    /// Number of values needed in the work buffer of Transform.
+    size_t WorkSize() const { return m_ + plan_->WorkSize(); }
+
+    /// Transforms the p values in data as ComplexPlan::Transform. work must
+    /// hold WorkSize() values.
+    void Transform(Complex * data, Complex * work, bool inverse) const
+    {
+      Complex * a = work;
+      for (size_t q = 0; q < p_; q++)
+        a[q] = data[q] * Chirp(q, inverse);
+      std::fill(a + p_, a + m_, Complex(0.0, 0.0));
+      plan_->Transform(a, work + m_, false);
+      const std::vector<Complex> & kernel = inverse ? kernel_inverse_ : kernel_forward_;
+      for (size_t j = 0; j < m_; j++)
+        a[j] *= kernel[j];
+      plan_->Transform(a, work + m_, true);
+      for (size_t r = 0; r < p_; r++)
+        data[r] = a[r] * Chirp(r, inverse);
+    }
+
+  private:
+    Complex Chirp(size_t j, bool inverse) const
+    {
+      return inverse ? std::conj(chirp_[j]) : chirp_[j];
+    }
+
+    size_t                             p_;
+    size_t                             m_;
+    std::vector<Complex>               chirp_;
+    std::vector<Complex>               kernel_forward_;
+    std::vector<Complex>               kernel_inverse_;
+    std::unique_ptr<const ComplexPlan> plan_;
+  };
+
+  ComplexPlan::ComplexPlan(size_t n)
+    : n_(n),
+      factors_(FactorizeFFTSize(n)),
+      twiddles_(n),
+      chirp_work_(0)
+  {
+    const double pi = 3.14159265358979323846;
+    for (size_t j = 0; j < n; j++)
+      twiddles_[j] = std::polar(1.0, -2.0 * pi * static_cast<double>(j) / static_cast<double>(n));
+    for (size_t f = 0; f < factors_.size(); f++) {
+      size_t p = factors_[f];
+      if (p >= chirp_min_factor && chirps_.count(p) == 0) {
+        chirps_[p].reset(new ChirpTransform(p));
+        chirp_work_ = std::max(chirp_work_, chirps_[p]->WorkSize());
+      }
+    }
+  }
+
+  // out gets the transform of the n values in[0], in[stride], ... The
+  // sub-transforms of each residue q modulo the factor p are combined by
+  // X[k + r*m] = sum_q w_p^(q*r) w_n^(q*k) Y_q[k]. t must hold n_ values,
+  // followed by the work buffer of the chirp transforms.
+  void ComplexPlan::Recurse(const Complex * in, Complex * out, size_t n, size_t stride, size_t f, bool inverse, Complex * t) const
+  {
+    if (n == 1) {
+      out[0] = in[0];
+      return;
+    }
+    size_t p = factors_[f];
+    size_t m = n / p;
+    for (size_t q = 0; q < p; q++)
+      Recurse(in + q * stride, out + q * m, m, stride * p, f + 1, inverse, t);
+
+    size_t step   = n_ / n;
+    size_t step_p = n_ / p;
+    if (p == 2) {
+      for (size_t k = 0; k < m; k++) {
+        Complex a = out[k];
+        Complex b = out[k + m] * Twiddle(k * step, inverse);
+        out[k]     = a + b;
+        out[k + m] = a - b;
+      }
+      return;
+    }
+    if (p >= chirp_min_factor) {
+      const ChirpTransform & chirp = *chirps_.find(p)->second;
+      for (size_t k = 0; k < m; k++) {
+        for (size_t q = 0; q < p; q++)
+          t[q] = out[q * m + k] * Twiddle(q * k * step, inverse);
+        chirp.Transform(t, t + n_, inverse);
+        for (size_t r = 0; r < p; r++)
+          out[k + r * m] = t[r];
+      }
+      return;
+    }
+    for (size_t k = 0; k < m; k++) {
+      for (size_t q = 0; q < p; q++)
+        t[q] = out[q * m + k] * Twiddle(q * k * step, inverse);
+      for (size_t r = 0; r < p; r++) {
+        Complex sum = t[0];
+        for (size_t q = 1; q < p; q++)
+          sum += t[q] * Twiddle(((q * r) % p) * step_p, inverse);
+        out[k + r * m] = sum;
+      }
+    }
+  }
+
+  std::mutex & ComplexPlanMutex()
+  {
+    static std::mutex plan_mutex;
+    return plan_mutex;
+  }
+
+  std::map<size_t, std::shared_ptr<const ComplexPlan> > & ComplexPlans()
+  {
+    static std::map<size_t, std::shared_ptr<const ComplexPlan> > plans;
+    return plans;
+  }
+
+  std::shared_ptr<const ComplexPlan> FindComplexPlan(size_t n)
+  {
+    std::lock_guard<std::mutex> lock(ComplexPlanMutex());
+    std::shared_ptr<const ComplexPlan> & plan = ComplexPlans()[n];
+    if (!plan)
+      plan.reset(new ComplexPlan(n));
+    return plan;
+  }
+
+  // Transforms along each of the dimensions but the last of a complex array
+  // with dimensions n, where the last has size nc.
+  template <typename T>
+  void TransformLeadingDimensions(const std::vector<int> & n, size_t nc, std::complex<T> * data, bool inverse)
+  {
+    size_t d = n.size();
+    for (size_t a = 0; a + 1 < d; a++) {
+      size_t length = static_cast<size_t>(n[a]);
+      size_t stride = nc;
+      for (size_t i = a + 1; i + 1 < d; i++)
+        stride *= static_cast<size_t>(n[i]);
+      size_t n_outer = 1;
+      for (size_t i = 0; i < a; i++)
+        n_outer *= static_cast<size_t>(n[i]);
+
+      std::shared_ptr<const ComplexPlan> plan = FindComplexPlan(length);
+      std::vector<Complex> line(length + plan->WorkSize());
+      for (size_t outer = 0; outer < n_outer; outer++) {
+        for (size_t inner = 0; inner < stride; inner++) {
+          std::complex<T> * start = data + outer * length * stride + inner;
+          for (size_t i = 0; i < length; i++)
+            line[i] = Complex(start[i * stride]);
+          plan->Transform(&line[0], &line[length], inverse);
+          for (size_t i = 0; i < length; i++)
+            start[i * stride] = std::complex<T>(line[i]);
+        }
+      }
+    }
+  }
+
+  template <typename T>
+  void PortableForward(const std::vector<int> & n, int howmany, T * in, std::complex<T> * out)
+  {
+    size_t length    = static_cast<size_t>(n.back());
+    size_t nc        = length / 2 + 1;
+    size_t n_rows    = 1;
+    for (size_t i = 0; i + 1 < n.size(); i++)
+      n_rows *= static_cast<size_t>(n[i]);
+
+    std::shared_ptr<const ComplexPlan> plan = FindComplexPlan(length);
+    std::vector<Complex> line(length + plan->WorkSize());
+    for (int b = 0; b < howmany; b++) {
+      const T         * real    = in  + b * n_rows * length;
+      std::complex<T> * complex = out + b * n_rows * nc;
+      for (size_t row = 0; row < n_rows; row++) {
+        for (size_t i = 0; i < length; i++)
+          line[i] = Complex(static_cast<double>(real[row * length + i]), 0.0);
+        plan->Transform(&line[0], &line[length], false);
+        for (size_t i = 0; i < nc; i++)
+          complex[row * nc + i] = std::complex<T>(line[i]);
+      }
+      TransformLeadingDimensions(n, nc, complex, false);
+    }
+  }
+
+  template <typename T>
+  void PortableInverse(const std::vector<int> & n, int howmany, std::complex<T> * in, T * out)
+  {
+    size_t length    = static_cast<size_t>(n.back());
+    size_t nc        = length / 2 + 1;
+    size_t n_rows    = 1;
+    for (size_t i = 0; i + 1 < n.size(); i++)
+      n_rows *= static_cast<size_t>(n[i]);
+
+    std::shared_ptr<const ComplexPlan> plan = FindComplexPlan(length);
+    std::vector<Complex> line(length + plan->WorkSize());
+    for (int b = 0; b < howmany; b++) {
+      std::complex<T> * complex = in  + b * n_rows * nc;
+      T               * real    = out + b * n_rows * length;
+      TransformLeadingDimensions(n, nc, complex, true);
+      // The last dimension is completed by Hermitian symmetry. Imaginary
+      // parts that break the symmetry only affect the imaginary part of the
+      // result, which is dropped, as in FFTW.
+      for (size_t row = 0; row < n_rows; row++) {
+        for (size_t i = 0; i < nc; i++)
+          line[i] = Complex(complex[row * nc + i]);
+        for (size_t i = nc; i < length; i++)
+          line[i] = std::conj(line[length - i]);
+        plan->Transform(&line[0], &line[length], true);
+        for (size_t i = 0; i < length; i++)
+          real[row * length + i] = static_cast<T>(line[i].real());
+      }
+    }
+  }
+
+  class PortableBackend : public FFTBackend {
+  public:
+    std::string GetName() const { return "portable"; }
+
+    void Forward(const std::vector<int> & n, int howmany, double * in, std::complex<double> * out)
+    {
+      PortableForward(n, howmany, in, out);
+    }
+
+    void Forward(const std::vector<int> & n, int howmany, float * in, std::complex<float> * out)
+    {
+      PortableForward(n, howmany, in, out);
+    }
+
+    void Inverse(const std::vector<int> & n, int howmany, std::complex<double> * in, double * out)
+    {
+      PortableInverse(n, howmany, in, out);
+    }
+
+    void Inverse(const std::vector<int> & n, int howmany, std::complex<float> * in, float * out)
+    {
+      PortableInverse(n, howmany, in, out);
+    }
+
+    size_t ReleasePlans()
+    {
+      std::map<size_t, std::shared_ptr<const ComplexPlan> > released;
+      {
+        std::lock_guard<std::mutex> lock(ComplexPlanMutex());
+        released.swap(ComplexPlans());
+      }
+      return released.size();
+    }
+  };
+
+  FFTBackend & Portable()
+  {
+    static PortableBackend backend;
+    return backend;
+  }
+
+  // The available backends, the default first.
+  const std::vector<FFTBackend *> & Backends()
+  {
+    static const std::vector<FFTBackend *> backends = {
+#ifndef NRLIB_NO_FFTW
+      &NRLibPrivate::FFTWBackend(),
+#endif
+      &Portable()
+    };
+    return backends;
+  }
+
+  std::atomic<FFTBackend *> & CurrentBackend()
+  {
+    static std::atomic<FFTBackend *> current(Backends().front());
+    return current;
+  }
+
+  std::atomic<int> n_threads(1);
+}
+
+FFTBackend & FFTBackend::Get()
+{
+  return *CurrentBackend().load();
+}
+
+void FFTBackend::Set(const std::string & name)
+{
+  CurrentBackend().store(&Find(name));
+}
+
+std::vector<std::string> FFTBackend::GetNames()
+{
+  std::vector<std::string> names;
+  for (size_t i = 0; i < Backends().size(); i++)
+    names.push_back(Backends()[i]->GetName());
+  return names;
+}
+
+FFTBackend & FFTBackend::Find(const std::string & name)
+{
+  std::string available;
+  for (size_t i = 0; i < Backends().size(); i++) {
+    if (Backends()[i]->GetName() == name)
+      return *Backends()[i];
+    available += (i == 0 ? "'" : ", '") + Backends()[i]->GetName() + "'";
+  }
+  throw Exception("Unknown FFT backend '" + name + "'. The available backends are " + available + ".");
+}
+
+size_t FFTBackend::ReleaseAllPlans()
+{
+  size_t released = 0;
+  for (size_t i = 0; i < Backends().size(); i++)
+    released += Backends()[i]->ReleasePlans();
+  return released;
+}
+
+void FFTBackend::SetThreads(int n)
+{
+  if (n < 1)
+    throw Exception("The number of FFT threads must be at least 1.");
+  n_threads.store(n);
+}
+
+int FFTBackend::GetThreads()
+{
+  return n_threads.load();
+}
+
+double FFTBackend::Benchmark(const std::vector<int> & n, int howmany, int repeats)
+{
+  if (n.empty() || howmany < 1 || repeats < 1)
+    throw Exception("Invalid FFT benchmark size.");
+  size_t n_real    = 1;
+  for (size_t d = 0; d < n.size(); d++)
+    n_real *= static_cast<size_t>(n[d]);
+  size_t n_complex = n_real / static_cast<size_t>(n.back()) * (static_cast<size_t>(n.back()) / 2 + 1);
+  n_real    *= static_cast<size_t>(howmany);
+  n_complex *= static_cast<size_t>(howmany);
+
+  size_t    real_bytes    = n_real * sizeof(double);
+  size_t    complex_bytes = n_complex * sizeof(Complex);
+  double  * input   = static_cast<double *>(WorkspacePool::Acquire(real_bytes));
+  double  * real    = static_cast<double *>(WorkspacePool::Acquire(real_bytes));
+  Complex * complex = static_cast<Complex *>(WorkspacePool::Acquire(complex_bytes));
+  for (size_t i = 0; i < n_real; i++)
+    input[i] = std::sin(0.37 * static_cast<double>(i));
+
+  double seconds = 0.0;
+  for (int r = 0; r <= repeats; r++) {
+    std::copy(input, input + n_real, real);
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    Forward(n, howmany, real, complex);
+    Inverse(n, howmany, complex, real);
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    if (r > 0)
+      seconds += elapsed.count();
+  }
+
+  WorkspacePool::Release(complex, complex_bytes);
+  WorkspacePool::Release(real, real_bytes);
+  WorkspacePool::Release(input, real_bytes);
+  return seconds / repeats;
+}
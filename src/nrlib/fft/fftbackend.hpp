@@ -0,0 +1,100 @@
+// Copyright (c)  2011, Norwegian Computing Center
+// All rights reserved.
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+// •  Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+// •  Redistributions in binary form must reproduce the above copyright notice, this list of
+//    conditions and the following disclaimer in the documentation and/or other materials
+//    provided with the distribution.
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+// OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef NRLIB_FFT_FFTBACKEND_HPP
+#define NRLIB_FFT_FFTBACKEND_HPP
+
+#include <complex>
+#include <string>
+#include <vector>
+
+namespace NRLib {
+  /// Implementation of the batched real transforms that all FFTs in NRLib go
+  /// through, see NRLibPrivate::ComputeFFTMany. The backend is selected at
+  /// runtime for the whole process, by name:
+  ///
+  ///  - "fftw": the FFTW3 interface of the library linked at build time, that
+  ///    is FFTW3, Intel MKL or ARM Performance Libraries. This is the default.
+  ///    Not available if built with NRLIB_NO_FFTW.
+  ///  - "portable": mixed-radix transforms without external dependencies,
+  ///    with the chirp z-transform (Bluestein) for prime factors of 29 or more.
+  ///    Slower, but useful for comparison and as a fallback. This is the
+  ///    default if built with NRLIB_NO_FFTW.
+  ///
+  /// All backends give unscaled transforms with the data layout of FFTW, and
+  /// may be called from several threads.
+  class FFTBackend {
+  public:
+    virtual ~FFTBackend() {}
+
+    virtual std::string GetName() const = 0;
+
+    /// howmany real-to-complex transforms of size n, slowest varying
+    /// dimension first, stored one after another in in and out.
+    virtual void Forward(const std::vector<int> & n, int howmany, double * in, std::complex<double> * out) = 0;
+    virtual void Forward(const std::vector<int> & n, int howmany, float  * in, std::complex<float>  * out) = 0;
+
+    /// Inverse of Forward. May overwrite in.
+    virtual void Inverse(const std::vector<int> & n, int howmany, std::complex<double> * in, double * out) = 0;
+    virtual void Inverse(const std::vector<int> & n, int howmany, std::complex<float>  * in, float  * out) = 0;
+
+    /// Frees the plans cached for the transforms done so far, and returns how
+    /// many there were. Plans are otherwise kept for the life of the process,
+    /// one for each size, alignment and thread count in use. Safe to call
+    /// while other threads transform; their plans are freed when they finish.
+    virtual size_t ReleasePlans() = 0;
+
+    /// Calls ReleasePlans on all the backends, and returns the total.
+    static size_t ReleaseAllPlans();
+
+    /// The backend in use.
+    static FFTBackend & Get();
+
+    /// Selects the backend. Throws NRLib::Exception if there is no backend
+    /// with this name.
+    static void Set(const std::string & name);
+
+    /// Names of the available backends, the default first.
+    static std::vector<std::string> GetNames();
+
+    /// The backend with this name. Throws NRLib::Exception if there is none.
+    static FFTBackend & Find(const std::string & name);
+
+    /// Sets the number of threads used by each transform. Only the "fftw"
+    /// backend built with NRLIB_FFTW_THREADS uses more than one; the others
+    /// ignore it. Plans are made for the number of threads in use when they
+    /// are first needed. Throws NRLib::Exception if n is less than 1.
+    static void SetThreads(int n);
+    static int  GetThreads();
+
+    /// Average wall time in seconds of one Forward and one Inverse of
+    /// howmany double precision transforms of size n, over repeats runs.
+    /// Plans are made in a warm-up run that is not timed.
+    double Benchmark(const std::vector<int> & n, int howmany, int repeats);
+  };
+
+#ifndef NRLIB_NO_FFTW
+  namespace NRLibPrivate {
+    /// The backend using the FFTW3 interface. Defined in fft.cpp.
+    FFTBackend & FFTWBackend();
+  }
+#endif
+}
+
+#endif // NRLIB_FFT_FFTBACKEND_HPP
@@ -27,13 +27,10 @@ namespace NRLib {
   void NRLibPrivate::ComputeFFT2D<double>(size_t ni, size_t nj,
     double* in, std::complex<double>* out)
   {
-    fftw_complex* out_data = reinterpret_cast<fftw_complex*>(out);
-    fftw_plan p = fftw_plan_dft_r2c_2d(static_cast<int>(nj), static_cast<int>(ni),
-      in, out_data, FFTW_ESTIMATE);
-    assert(p != 0);
-
-    fftw_execute(p);
-    fftw_destroy_plan(p);
+    std::vector<int> n(2);
+    n[0] = static_cast<int>(nj);
+    n[1] = static_cast<int>(ni);
+    ComputeFFTMany(n, 1, in, out);
   }
 
 
@@ -41,13 +38,10 @@ namespace NRLib {
   void NRLibPrivate::ComputeFFT2DInverse<double>(size_t ni, size_t nj,
     std::complex<double>* in, double* out)
   {
-    fftw_complex* in_data = reinterpret_cast<fftw_complex*>(in);
-    fftw_plan p = fftw_plan_dft_c2r_2d(static_cast<int>(nj), static_cast<int>(ni),
-      in_data, out, FFTW_ESTIMATE);
-    assert(p != 0);
-
-    fftw_execute(p);
-    fftw_destroy_plan(p);
+    std::vector<int> n(2);
+    n[0] = static_cast<int>(nj);
+    n[1] = static_cast<int>(ni);
+    ComputeFFTManyInverse(n, 1, in, out);
   }
 
 
@@ -55,13 +49,10 @@ namespace NRLib {
   void NRLibPrivate::ComputeFFT2D<float>(size_t ni, size_t nj,
     float* in, std::complex<float>* out)
   {
-    fftwf_complex* out_data = reinterpret_cast<fftwf_complex*>(out);
-    fftwf_plan p = fftwf_plan_dft_r2c_2d(static_cast<int>(nj), static_cast<int>(ni),
-      in, out_data, FFTW_ESTIMATE);
-    assert(p != 0);
-
-    fftwf_execute(p);
-    fftwf_destroy_plan(p);
+    std::vector<int> n(2);
+    n[0] = static_cast<int>(nj);
+    n[1] = static_cast<int>(ni);
+    ComputeFFTMany(n, 1, in, out);
   }
 
 
@@ -69,13 +60,10 @@ namespace NRLib {
   void NRLibPrivate::ComputeFFT2DInverse<float>(size_t ni, size_t nj,
     std::complex<float>* in, float* out)
   {
-    fftwf_complex* in_data = reinterpret_cast<fftwf_complex*>(in);
-    fftwf_plan p = fftwf_plan_dft_c2r_2d(static_cast<int>(nj), static_cast<int>(ni),
-      in_data, out, FFTW_ESTIMATE);
-    assert(p != 0);
-
-    fftwf_execute(p);
-    fftwf_destroy_plan(p);
+    std::vector<int> n(2);
+    n[0] = static_cast<int>(nj);
+    n[1] = static_cast<int>(ni);
+    ComputeFFTManyInverse(n, 1, in, out);
   }
 
 } // namespace NRLib
@@ -26,11 +26,10 @@
 #include <complex>
 #include <iostream>
 
-// Must set MKL's /include/fftw or fftw's include directory as additional include directory.
-#include <fftw3.h>
-
 #include "../grid/grid2d.hpp"
 #include "fft.hpp"
+#include "../profiling/profiling.hpp"
+#include "workspacepool.hpp"
 
 #ifdef FFTW_DEBUG
 // Debugging
@@ -48,7 +47,10 @@ public:
   /// \param padding_ni    Suggested padding in i dimension.
   /// \param padding_nj    Suggested padding in j dimension.
   /// \param scale_forward If true scale both in forward and inverse transform.
-  FFTGrid2D(size_t ni, size_t nj,  size_t padding_ni, size_t padding_nj, bool scale_forward);
+  /// \param clear         If false, the buffers, which are taken from WorkspacePool,
+  ///                      are not set to zero. Only use this when the real grid is
+  ///                      initialized before it is used. See WorkspacePool::Acquire.
+  FFTGrid2D(size_t ni, size_t nj,  size_t padding_ni, size_t padding_nj, bool scale_forward, bool clear = true);
 
   // Don't need this one yet. We'll have to worry about tapering later....
   //FFTGrid2D(const Grid2D<T>& grid, size_t padding_ni, size_t padding_nj, bool scale_forward);
@@ -172,41 +174,38 @@ namespace NRLibPrivate {
 
 template <typename T>
 FFTGrid2D<T>::FFTGrid2D(size_t ni, size_t nj,  size_t padding_ni,
-                        size_t padding_nj, bool scale_forward)
+                        size_t padding_nj, bool scale_forward, bool clear)
   : scale_forward_(scale_forward), ni_(ni), nj_(nj)
 {
+  Profiling::ScopedTimer timer("allocate");
   // Find total sizes.
   ni_tot_ = FindNewSizeWithPadding(ni + padding_ni, true);
   nj_tot_ = FindNewSizeWithPadding(nj + padding_nj);
 
   // Allocate aligned data for efficiency.
-  // Add padding for use in inplace transform.
-  real_data_ = reinterpret_cast<T*>(fftw_malloc((1 + ni_tot_ * nj_tot_) * sizeof(T))); //Add 1 to avoid problems with MKL
-
-  size_t n_complex = GetComplexNI() * GetComplexNJ();
-  size_t complex_datalen = n_complex * sizeof(std::complex<T>);
-  complex_data_ = reinterpret_cast<std::complex<T>*>(fftw_malloc(complex_datalen));
+  size_t real_datalen    = (1 + ni_tot_ * nj_tot_) * sizeof(T); //Add 1 to avoid problems with MKL
+  size_t complex_datalen = GetComplexNI() * GetComplexNJ() * sizeof(std::complex<T>);
+  real_data_    = reinterpret_cast<T*>(WorkspacePool::Acquire(real_datalen, clear));
+  complex_data_ = reinterpret_cast<std::complex<T>*>(WorkspacePool::Acquire(complex_datalen, clear));
 
-  for (size_t i = 0; i < ni_tot_*nj_tot_; ++i) {
-    real_data_[i] = 0;
-  }
-
-  for (size_t i = 0; i < n_complex; ++i) {
-    complex_data_[i] = 0;
-  }
+  Profiling::RecordAllocation(real_datalen + complex_datalen);
 }
 
 
 template <typename T>
 FFTGrid2D<T>::~FFTGrid2D()
 {
-  fftw_free(real_data_);
-  fftw_free(complex_data_);
+  size_t real_datalen    = (1 + ni_tot_ * nj_tot_) * sizeof(T);
+  size_t complex_datalen = GetComplexNI() * GetComplexNJ() * sizeof(std::complex<T>);
+  Profiling::RecordDeallocation(real_datalen + complex_datalen);
+  WorkspacePool::Release(real_data_, real_datalen);
+  WorkspacePool::Release(complex_data_, complex_datalen);
 }
 
 
 template <typename T>
 void FFTGrid2D<T>::DoFFT() {
+  Profiling::ScopedTimer timer("fft");
   if (scale_forward_) {
     size_t n = ni_tot_ * nj_tot_;
     double scale = 1.0 / std::sqrt(1.0*n);
@@ -219,6 +218,7 @@ void FFTGrid2D<T>::DoFFT() {
 
 template <typename T>
 void FFTGrid2D<T>::DoInverseFFT() {
+  Profiling::ScopedTimer timer("inverse_fft");
   NRLibPrivate::ComputeFFT2DInverse(ni_tot_, nj_tot_, complex_data_, real_data_);
   double scale;
   size_t n = ni_tot_ * nj_tot_;
@@ -27,13 +27,11 @@ namespace NRLib {
   void NRLibPrivate::ComputeFFT3D<double>(size_t ni, size_t nj, size_t nk,
     double* in, std::complex<double>* out)
   {
-    fftw_complex* out_data = reinterpret_cast<fftw_complex*>(out);
-    fftw_plan p = fftw_plan_dft_r2c_3d(static_cast<int>(nk), static_cast<int>(nj), static_cast<int>(ni),
-      in, out_data, FFTW_ESTIMATE);
-    assert(p != 0);
-
-    fftw_execute(p);
-    fftw_destroy_plan(p);
+    std::vector<int> n(3);
+    n[0] = static_cast<int>(nk);
+    n[1] = static_cast<int>(nj);
+    n[2] = static_cast<int>(ni);
+    ComputeFFTMany(n, 1, in, out);
   }
 
 
@@ -41,13 +39,11 @@ namespace NRLib {
   void NRLibPrivate::ComputeFFT3DInverse<double>(size_t ni, size_t nj, size_t nk,
     std::complex<double>* in, double* out)
   {
-    fftw_complex* in_data = reinterpret_cast<fftw_complex*>(in);
-    fftw_plan p = fftw_plan_dft_c2r_3d(static_cast<int>(nk), static_cast<int>(nj), static_cast<int>(ni),
-      in_data, out, FFTW_ESTIMATE);
-    assert(p != 0);
-
-    fftw_execute(p);
-    fftw_destroy_plan(p);
+    std::vector<int> n(3);
+    n[0] = static_cast<int>(nk);
+    n[1] = static_cast<int>(nj);
+    n[2] = static_cast<int>(ni);
+    ComputeFFTManyInverse(n, 1, in, out);
   }
 
 
@@ -55,13 +51,11 @@ namespace NRLib {
   void NRLibPrivate::ComputeFFT3D<float>(size_t ni, size_t nj, size_t nk,
     float* in, std::complex<float>* out)
   {
-    fftwf_complex* out_data = reinterpret_cast<fftwf_complex*>(out);
-    fftwf_plan p = fftwf_plan_dft_r2c_3d(static_cast<int>(nk), static_cast<int>(nj), static_cast<int>(ni),
-      in, out_data, FFTW_ESTIMATE);
-    assert(p != 0);
-
-    fftwf_execute(p);
-    fftwf_destroy_plan(p);
+    std::vector<int> n(3);
+    n[0] = static_cast<int>(nk);
+    n[1] = static_cast<int>(nj);
+    n[2] = static_cast<int>(ni);
+    ComputeFFTMany(n, 1, in, out);
   }
 
 
@@ -69,13 +63,11 @@ namespace NRLib {
   void NRLibPrivate::ComputeFFT3DInverse<float>(size_t ni, size_t nj, size_t nk,
     std::complex<float>* in, float* out)
   {
-    fftwf_complex* in_data = reinterpret_cast<fftwf_complex*>(in);
-    fftwf_plan p = fftwf_plan_dft_c2r_3d(static_cast<int>(nk), static_cast<int>(nj), static_cast<int>(ni),
-      in_data, out, FFTW_ESTIMATE);
-    assert(p != 0);
-
-    fftwf_execute(p);
-    fftwf_destroy_plan(p);
+    std::vector<int> n(3);
+    n[0] = static_cast<int>(nk);
+    n[1] = static_cast<int>(nj);
+    n[2] = static_cast<int>(ni);
+    ComputeFFTManyInverse(n, 1, in, out);
   }
 
 } // namespace NRLib
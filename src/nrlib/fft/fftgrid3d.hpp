@@ -25,10 +25,6 @@
 #include <cassert>
 #include <complex>
 
-// Must set MKL's /include/fftw or fftw's include directory as additional include directory.
-#include <fftw3.h>
-
-
 // TODO: Consider removing FFTW_DEBUG
 // that way, we can simplify _a lot_ of logic
 
@@ -42,6 +38,8 @@
 
 #include "../grid/grid.hpp"
 #include "fft.hpp"
+#include "../profiling/profiling.hpp"
+#include "workspacepool.hpp"
 
 namespace NRLib {
 
@@ -53,7 +51,11 @@ public:
   /// \param padding_nj    Suggested padding in j dimension.
   /// \param padding_nk    Suggested padding in k dimension.
   /// \param scale_forward If true scale both in forward and inverse transform.
-  FFTGrid3D(size_t ni, size_t nj, size_t nk, size_t padding_ni, size_t padding_nj, size_t padding_nk, bool scale_forward);
+  /// \param clear         If false, the buffers, which are taken from WorkspacePool,
+  ///                      are not set to zero. Only use this when the real grid is
+  ///                      initialized before it is used. See WorkspacePool::Acquire.
+  FFTGrid3D(size_t ni, size_t nj, size_t nk, size_t padding_ni, size_t padding_nj, size_t padding_nk, bool scale_forward,
+            bool clear = true);
 
   virtual ~FFTGrid3D();
 
@@ -195,40 +197,39 @@ namespace NRLibPrivate {
 
 template <typename T>
 FFTGrid3D<T>::FFTGrid3D(size_t ni, size_t nj,  size_t nk, size_t padding_ni,
-                        size_t padding_nj, size_t padding_nk, bool scale_forward)
+                        size_t padding_nj, size_t padding_nk, bool scale_forward, bool clear)
   : scale_forward_(scale_forward), ni_(ni), nj_(nj), nk_(nk)
 {
+  Profiling::ScopedTimer timer("allocate");
   // Find total sizes.
   ni_tot_ = FindNewSizeWithPadding(ni + padding_ni, true);
   nj_tot_ = FindNewSizeWithPadding(nj + padding_nj);
   nk_tot_ = FindNewSizeWithPadding(nk + padding_nk);
 
   // Allocate aligned data for efficiency.
-  // Add padding for use in inplace transform.
-  real_data_ = reinterpret_cast<T*>(fftw_malloc(ni_tot_ * nj_tot_ * nk_tot_ * sizeof(T)));
-
-  size_t n_complex = GetComplexNI() * GetComplexNJ() * GetComplexNK();
-  size_t complex_datalen = n_complex * sizeof(std::complex<T>);
-  complex_data_ = reinterpret_cast<std::complex<T>*>(fftw_malloc(complex_datalen));
-
-  for (size_t i = 0; i < ni_tot_*nj_tot_*nk_tot_; ++i)
-    real_data_[i] = 0;
+  size_t real_datalen    = ni_tot_ * nj_tot_ * nk_tot_ * sizeof(T);
+  size_t complex_datalen = GetComplexNI() * GetComplexNJ() * GetComplexNK() * sizeof(std::complex<T>);
+  real_data_    = reinterpret_cast<T*>(WorkspacePool::Acquire(real_datalen, clear));
+  complex_data_ = reinterpret_cast<std::complex<T>*>(WorkspacePool::Acquire(complex_datalen, clear));
 
-  for (size_t i = 0; i < n_complex; ++i)
-    complex_data_[i] = 0;
+  Profiling::RecordAllocation(real_datalen + complex_datalen);
 }
 
 
 template <typename T>
 FFTGrid3D<T>::~FFTGrid3D()
 {
-  fftw_free(real_data_);
-  fftw_free(complex_data_);
+  size_t real_datalen    = ni_tot_ * nj_tot_ * nk_tot_ * sizeof(T);
+  size_t complex_datalen = GetComplexNI() * GetComplexNJ() * GetComplexNK() * sizeof(std::complex<T>);
+  Profiling::RecordDeallocation(real_datalen + complex_datalen);
+  WorkspacePool::Release(real_data_, real_datalen);
+  WorkspacePool::Release(complex_data_, complex_datalen);
 }
 
 
 template <typename T>
 void FFTGrid3D<T>::DoFFT() {
+  Profiling::ScopedTimer timer("fft");
   if (scale_forward_) {
     size_t n = ni_tot_ * nj_tot_ * nk_tot_;
     double scale = 1.0 / sqrt(1.0*n);
@@ -241,6 +242,7 @@ void FFTGrid3D<T>::DoFFT() {
 template <typename T>
 void FFTGrid3D<T>::DoInverseFFT()
 {
+  Profiling::ScopedTimer timer("inverse_fft");
   NRLibPrivate::ComputeFFT3DInverse(ni_tot_, nj_tot_, nk_tot_, complex_data_, real_data_);
   double scale;
   size_t n = ni_tot_ * nj_tot_ * nk_tot_;
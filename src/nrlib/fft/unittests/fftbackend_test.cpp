@@ -0,0 +1,215 @@
+/// Unit tests for the FFT backends
+
+#include <nrlib/exception/exception.hpp>
+#include <nrlib/fft/fft.hpp>
+#include <nrlib/fft/fftbackend.hpp>
+#include <nrlib/random/random.hpp>
+#include <nrlib/variogram/gaussianfieldsimulator.hpp>
+#include <nrlib/variogram/variogram.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <complex>
+#include <thread>
+#include <vector>
+
+using namespace NRLib;
+
+namespace {
+  size_t Product(const std::vector<int> & n)
+  {
+    size_t size = 1;
+    for (size_t i = 0; i < n.size(); i++)
+      size *= static_cast<size_t>(n[i]);
+    return size;
+  }
+
+  // Forward and inverse transforms of two batches with the given backend.
+  template <typename T>
+  void Transform(const std::string & backend, const std::vector<int> & n, const std::vector<T> & real,
+                 std::vector<std::complex<T> > & complex, std::vector<T> & back)
+  {
+    size_t n_complex = Product(n) / static_cast<size_t>(n.back()) * static_cast<size_t>(n.back() / 2 + 1);
+    std::vector<T> in(real);
+    complex.resize(2 * n_complex);
+    back.resize(real.size());
+    FFTBackend::Set(backend);
+    NRLibPrivate::ComputeFFTMany(n, 2, &in[0], &complex[0]);
+    std::vector<std::complex<T> > spectrum(complex);
+    NRLibPrivate::ComputeFFTManyInverse(n, 2, &spectrum[0], &back[0]);
+    FFTBackend::Set(FFTBackend::GetNames().front());
+  }
+
+  template <typename T>
+  void CheckBackendsAgree(const std::vector<int> & n, double tolerance)
+  {
+    size_t size = Product(n);
+    std::vector<T> real(2 * size);
+    for (size_t i = 0; i < real.size(); i++)
+      real[i] = static_cast<T>(Random::Norm01());
+
+    std::vector<std::complex<T> > complex_fftw, complex_portable;
+    std::vector<T>                back_fftw, back_portable;
+    Transform("fftw",     n, real, complex_fftw,     back_fftw);
+    Transform("portable", n, real, complex_portable, back_portable);
+    for (size_t i = 0; i < complex_fftw.size(); i++)
+      BOOST_CHECK_SMALL(static_cast<double>(std::abs(complex_fftw[i] - complex_portable[i])), tolerance * size);
+    for (size_t i = 0; i < real.size(); i++) {
+      BOOST_CHECK_SMALL(static_cast<double>(back_portable[i]) - back_fftw[i], tolerance * size);
+      BOOST_CHECK_SMALL(static_cast<double>(back_portable[i]) / size - real[i], tolerance);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_SUITE( TestFFTBackend )
+
+#ifndef NRLIB_NO_FFTW
+BOOST_AUTO_TEST_CASE( PortableMatchesFFTW )
+{
+  Random::Initialize(5L);
+  CheckBackendsAgree<double>(std::vector<int>(1, 1), 1e-12);
+  CheckBackendsAgree<double>(std::vector<int>(1, 60), 1e-12);
+  CheckBackendsAgree<double>(std::vector<int>(1, 77), 1e-12);
+  CheckBackendsAgree<double>(std::vector<int>{15, 8}, 1e-12);
+  CheckBackendsAgree<double>(std::vector<int>{6, 10, 7}, 1e-12);
+  CheckBackendsAgree<double>(std::vector<int>{19, 1031}, 1e-12);
+  CheckBackendsAgree<float>(std::vector<int>{9, 12}, 1e-5);
+}
+#endif
+
+BOOST_AUTO_TEST_CASE( PortableLargePrimes )
+{
+  // Lengths with prime factors that are transformed as convolutions.
+  const double pi = 3.14159265358979323846;
+  int lengths[] = {29, 2 * 3 * 101, 1009};
+  for (size_t l = 0; l < 3; l++) {
+    std::vector<int> n(1, lengths[l]);
+    size_t size = static_cast<size_t>(lengths[l]);
+    std::vector<double> real(2 * size);
+    for (size_t i = 0; i < real.size(); i++)
+      real[i] = std::sin(0.37 * static_cast<double>(i)) + 0.1 * static_cast<double>(i % 7);
+
+    std::vector<std::complex<double> > complex;
+    std::vector<double>                back;
+    Transform("portable", n, real, complex, back);
+    size_t nc = size / 2 + 1;
+    for (size_t b = 0; b < 2; b++) {
+      for (size_t k = 0; k < nc; k++) {
+        std::complex<double> expected(0.0, 0.0);
+        for (size_t j = 0; j < size; j++)
+          expected += real[b * size + j] * std::polar(1.0, -2.0 * pi * static_cast<double>((j * k) % size) / static_cast<double>(size));
+        BOOST_CHECK_SMALL(std::abs(complex[b * nc + k] - expected), 1e-9 * static_cast<double>(size));
+      }
+    }
+    for (size_t i = 0; i < real.size(); i++)
+      BOOST_CHECK_SMALL(back[i] / static_cast<double>(size) - real[i], 1e-11);
+  }
+}
+
+BOOST_AUTO_TEST_CASE( SelectBackend )
+{
+  std::vector<std::string> names = FFTBackend::GetNames();
+#ifdef NRLIB_NO_FFTW
+  BOOST_REQUIRE(names.size() == 1U);
+  BOOST_TEST(names[0] == "portable");
+#else
+  BOOST_REQUIRE(names.size() == 2U);
+  BOOST_TEST(names[0] == "fftw");
+#endif
+  const std::string default_name = names[0];
+  BOOST_TEST(FFTBackend::Get().GetName() == default_name);
+  BOOST_CHECK_THROW(FFTBackend::Set("no such backend"), Exception);
+  BOOST_TEST(FFTBackend::Get().GetName() == default_name);
+
+  // Simulations give the same fields with both backends.
+  Variogram * v = Variogram::Create(Variogram::SPHERICAL, 1.5, 200.0, 100.0, 50.0);
+  GaussianFieldSimulator sim(*v, 30, 20.0, 20, 20.0, 10, 10.0);
+  std::vector<double> expected, field;
+  Random::Initialize(9L);
+  sim.Simulate(expected);
+  FFTBackend::Set("portable");
+  BOOST_TEST(FFTBackend::Get().GetName() == "portable");
+  Random::Initialize(9L);
+  sim.Simulate(field);
+  FFTBackend::Set(default_name);
+  BOOST_REQUIRE(field.size() == expected.size());
+  for (size_t i = 0; i < field.size(); i++)
+    BOOST_CHECK_SMALL(field[i] - expected[i], 1e-10);
+  delete v;
+}
+
+BOOST_AUTO_TEST_CASE( ThreadsAndBenchmark )
+{
+  BOOST_TEST(FFTBackend::GetThreads() == 1);
+  BOOST_CHECK_THROW(FFTBackend::SetThreads(0), Exception);
+
+  // Transforms are the same with more threads.
+  std::vector<int> n{16, 24};
+  std::vector<double> real(2 * Product(n));
+  for (size_t i = 0; i < real.size(); i++)
+    real[i] = std::sin(0.1 * static_cast<double>(i));
+  std::vector<std::complex<double> > complex_one, complex_two;
+  std::vector<double>                back_one, back_two;
+  const std::string default_name = FFTBackend::GetNames().front();
+  Transform(default_name, n, real, complex_one, back_one);
+  FFTBackend::SetThreads(2);
+  BOOST_TEST(FFTBackend::GetThreads() == 2);
+  Transform(default_name, n, real, complex_two, back_two);
+  FFTBackend::SetThreads(1);
+  for (size_t i = 0; i < complex_one.size(); i++)
+    BOOST_CHECK_SMALL(std::abs(complex_one[i] - complex_two[i]), 1e-9);
+
+  std::vector<std::string> names = FFTBackend::GetNames();
+  for (size_t i = 0; i < names.size(); i++) {
+    double seconds = FFTBackend::Find(names[i]).Benchmark(n, 2, 3);
+    BOOST_TEST(seconds >= 0.0);
+  }
+  BOOST_CHECK_THROW(FFTBackend::Find("no such backend"), Exception);
+  BOOST_CHECK_THROW(FFTBackend::Get().Benchmark(n, 2, 0), Exception);
+}
+
+BOOST_AUTO_TEST_CASE( ReleasePlans )
+{
+  std::vector<int> n{12, 10};
+  std::vector<double> real(2 * Product(n));
+  for (size_t i = 0; i < real.size(); i++)
+    real[i] = std::cos(0.2 * static_cast<double>(i));
+  std::vector<std::string> names = FFTBackend::GetNames();
+  for (size_t b = 0; b < names.size(); b++) {
+    std::vector<std::complex<double> > complex_before, complex_after;
+    std::vector<double>                back_before, back_after;
+    Transform(names[b], n, real, complex_before, back_before);
+    BOOST_TEST(FFTBackend::Find(names[b]).ReleasePlans() > 0U);
+    BOOST_TEST(FFTBackend::Find(names[b]).ReleasePlans() == 0U);
+    Transform(names[b], n, real, complex_after, back_after);
+    for (size_t i = 0; i < complex_before.size(); i++)
+      BOOST_TEST(complex_before[i] == complex_after[i]);
+  }
+  BOOST_TEST(FFTBackend::ReleaseAllPlans() > 0U);
+  BOOST_TEST(FFTBackend::ReleaseAllPlans() == 0U);
+
+  // Plans may be released while other threads transform.
+  std::vector<std::thread> threads;
+  std::vector<double> errors(2, 0.0);
+  for (size_t t = 0; t < errors.size(); t++) {
+    threads.push_back(std::thread([&, t]() {
+      for (int r = 0; r < 50; r++) {
+        std::vector<double> in(real), back(real.size());
+        std::vector<std::complex<double> > complex(2 * 12 * 6);
+        NRLibPrivate::ComputeFFTMany(n, 2, &in[0], &complex[0]);
+        NRLibPrivate::ComputeFFTManyInverse(n, 2, &complex[0], &back[0]);
+        for (size_t i = 0; i < real.size(); i++)
+          errors[t] = std::max(errors[t], std::abs(back[i] / static_cast<double>(Product(n)) - real[i]));
+      }
+    }));
+  }
+  for (int r = 0; r < 50; r++)
+    FFTBackend::ReleaseAllPlans();
+  for (size_t t = 0; t < threads.size(); t++) {
+    threads[t].join();
+    BOOST_CHECK_SMALL(errors[t], 1e-12);
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,118 @@
+/// Unit tests for the pool of FFT buffers
+
+#include <nrlib/fft/fftgrid3d.hpp>
+#include <nrlib/fft/workspacepool.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <cstdint>
+#include <vector>
+
+using namespace NRLib;
+
+BOOST_AUTO_TEST_SUITE( TestWorkspacePool )
+
+BOOST_AUTO_TEST_CASE( BuffersAreReused )
+{
+  WorkspacePool::ReleaseUnused();
+  void * a = WorkspacePool::Acquire(1000000);
+  BOOST_TEST(reinterpret_cast<std::uintptr_t>(a) % 64 == 0U);
+  WorkspacePool::Release(a, 1000000);
+  BOOST_TEST(WorkspacePool::GetPooledBytes() >= 1000000U);
+
+  // Same size class
+  void * b = WorkspacePool::Acquire(1010000);
+  BOOST_TEST(b == a);
+  BOOST_TEST(WorkspacePool::GetPooledBytes() == 0U);
+
+  // Different size class
+  void * c = WorkspacePool::Acquire(3000000);
+  BOOST_TEST(c != a);
+  WorkspacePool::Release(b, 1010000);
+  WorkspacePool::Release(c, 3000000);
+  BOOST_TEST(WorkspacePool::ReleaseUnused() >= 4000000U);
+  BOOST_TEST(WorkspacePool::GetPooledBytes() == 0U);
+}
+
+BOOST_AUTO_TEST_CASE( LimitFreesOldestBuffers )
+{
+  WorkspacePool::ReleaseUnused();
+  size_t limit = WorkspacePool::GetLimit();
+  WorkspacePool::SetLimit(5000000);
+
+  void * a = WorkspacePool::Acquire(2000000);
+  void * b = WorkspacePool::Acquire(1000000);
+  void * c = WorkspacePool::Acquire(2500000);
+  WorkspacePool::Release(a, 2000000);
+  WorkspacePool::Release(b, 1000000);
+  size_t pooled = WorkspacePool::GetPooledBytes();
+  BOOST_TEST(pooled >= 3000000U);
+
+  // a is the oldest, and is freed to make room for c.
+  WorkspacePool::Release(c, 2500000);
+  BOOST_TEST(WorkspacePool::GetPooledBytes() <= 5000000U);
+  BOOST_TEST(WorkspacePool::GetPooledBytes() >= 3500000U);
+  void * d = WorkspacePool::Acquire(1000000);
+  BOOST_TEST(d == b);
+  WorkspacePool::Release(d, 1000000);
+
+  // Buffers larger than the limit are not kept.
+  WorkspacePool::SetLimit(1500000);
+  BOOST_TEST(WorkspacePool::GetPooledBytes() <= 1500000U);
+  WorkspacePool::Release(WorkspacePool::Acquire(2000000), 2000000);
+  BOOST_TEST(WorkspacePool::GetPooledBytes() <= 1500000U);
+
+  WorkspacePool::SetLimit(0);
+  BOOST_TEST(WorkspacePool::GetPooledBytes() == 0U);
+  WorkspacePool::SetLimit(limit);
+}
+
+BOOST_AUTO_TEST_CASE( AcquireClears )
+{
+  WorkspacePool::ReleaseUnused();
+  size_t n = 20000000;
+  // New buffers of this size are cleared when they are first touched.
+  char * a = static_cast<char *>(WorkspacePool::Acquire(n));
+  size_t n_nonzero = 0;
+  for (size_t i = 0; i < n; i++)
+    n_nonzero += (a[i] != 0);
+  BOOST_TEST(n_nonzero == 0U);
+
+  for (size_t i = 0; i < n; i++)
+    a[i] = 1;
+  WorkspacePool::Release(a, n);
+  char * b = static_cast<char *>(WorkspacePool::Acquire(n, true));
+  BOOST_REQUIRE(b == a);
+  for (size_t i = 0; i < n; i++)
+    n_nonzero += (b[i] != 0);
+  BOOST_TEST(n_nonzero == 0U);
+  WorkspacePool::Release(b, n);
+  WorkspacePool::ReleaseUnused();
+}
+
+BOOST_AUTO_TEST_CASE( ClearSetsAllBytes )
+{
+  size_t n = 40000000;
+  std::vector<char> buffer(n, 1);
+  WorkspacePool::Clear(&buffer[0], n - 3);
+  size_t n_nonzero = 0;
+  for (size_t i = 0; i < n - 3; i++)
+    n_nonzero += (buffer[i] != 0);
+  BOOST_TEST(n_nonzero == 0U);
+  BOOST_TEST(buffer[n - 3] == 1);
+}
+
+BOOST_AUTO_TEST_CASE( FFTGridIsClearedWhenReused )
+{
+  {
+    FFTGrid3D<double> grid(10, 8, 6, 4, 4, 4, true);
+    for (size_t i = 0; i < grid.GetNItot() * grid.GetNJtot() * grid.GetNKtot(); i++)
+      grid.RealData()[i] = 1.0;
+  }
+  FFTGrid3D<double> grid(10, 8, 6, 4, 4, 4, true);
+  for (size_t i = 0; i < grid.GetNItot() * grid.GetNJtot() * grid.GetNKtot(); i++)
+    BOOST_REQUIRE(grid.RealData()[i] == 0.0);
+  WorkspacePool::ReleaseUnused();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
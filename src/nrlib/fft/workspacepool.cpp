@@ -0,0 +1,268 @@
+// Copyright (c)  2011, Norwegian Computing Center
+// All rights reserved.
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+// •  Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+// •  Redistributions in binary form must reproduce the above copyright notice, this list of
+//    conditions and the following disclaimer in the documentation and/or other materials
+//    provided with the distribution.
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+// OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <list>
+#include <map>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <malloc.h>
+#else
+#include <stdlib.h>
+#endif
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+#include "workspacepool.hpp"
+
+using namespace NRLib;
+
+namespace {
+  const size_t alignment           = 64;
+  const size_t huge_page_size      = 2097152;
+  // Buffers smaller than this are cleared by a single thread
+  const size_t parallel_clear_size = 16777216;
+
+  std::mutex & PoolMutex()
+  {
+    static std::mutex pool_mutex;
+    return pool_mutex;
+  }
+
+  // Free buffers with their size class, the most recently released last.
+  typedef std::list<std::pair<size_t, void *> > BufferList;
+
+  BufferList & FreeBuffers()
+  {
+    static BufferList free_buffers;
+    return free_buffers;
+  }
+
+  // The free buffers of each size class, in the order they were released.
+  std::map<size_t, std::vector<BufferList::iterator> > & SizeClasses()
+  {
+    static std::map<size_t, std::vector<BufferList::iterator> > size_classes;
+    return size_classes;
+  }
+
+  size_t              pooled_bytes = 0;
+  std::atomic<size_t> pool_limit(1073741824);
+  std::atomic<bool>   huge_pages(false);
+
+  void * AlignedAllocate(size_t bytes)
+  {
+    bool   huge       = huge_pages && bytes >= huge_page_size;
+    size_t align_with = huge ? huge_page_size : alignment;
+    void * buffer     = NULL;
+#ifdef _WIN32
+    buffer = _aligned_malloc(bytes, align_with);
+#else
+    if (posix_memalign(&buffer, align_with, bytes) != 0)
+      buffer = NULL;
+#endif
+#ifdef MADV_HUGEPAGE
+    if (buffer != NULL && huge)
+      madvise(buffer, bytes, MADV_HUGEPAGE);
+#endif
+    return buffer;
+  }
+
+  void AlignedFree(void * buffer)
+  {
+#ifdef _WIN32
+    _aligned_free(buffer);
+#else
+    free(buffer);
+#endif
+  }
+
+  // Removes the oldest free buffers until the pool holds at most limit
+  // bytes, and adds them to evicted. Called with the pool mutex held.
+  void EvictOldest(size_t limit, std::vector<void *> & evicted)
+  {
+    while (pooled_bytes > limit) {
+      std::pair<size_t, void *> oldest = FreeBuffers().front();
+      std::vector<BufferList::iterator> & size_class = SizeClasses()[oldest.first];
+      size_class.erase(size_class.begin());
+      if (size_class.empty())
+        SizeClasses().erase(oldest.first);
+      FreeBuffers().pop_front();
+      pooled_bytes -= oldest.first;
+      evicted.push_back(oldest.second);
+    }
+  }
+}
+
+
+size_t WorkspacePool::SizeClass(size_t bytes)
+{
+  // Multiples of 4096 bytes up to 64 kB, and then 8 classes per power of two.
+  if (bytes <= 65536)
+    return std::max<size_t>((bytes + 4095) / 4096 * 4096, 4096);
+  size_t power = 65536;
+  while (power * 2 < bytes)
+    power *= 2;
+  size_t step = power / 8;
+  return (bytes + step - 1) / step * step;
+}
+
+
+void * WorkspacePool::Acquire(size_t bytes, bool clear)
+{
+  size_t size = SizeClass(bytes);
+  void * buffer = NULL;
+  {
+    std::lock_guard<std::mutex> lock(PoolMutex());
+    std::map<size_t, std::vector<BufferList::iterator> >::iterator it = SizeClasses().find(size);
+    if (it != SizeClasses().end()) {
+      buffer = it->second.back()->second;
+      FreeBuffers().erase(it->second.back());
+      it->second.pop_back();
+      if (it->second.empty())
+        SizeClasses().erase(it);
+      pooled_bytes -= size;
+    }
+  }
+  if (buffer != NULL) {
+    if (clear)
+      Clear(buffer, bytes);
+    return buffer;
+  }
+
+  buffer = AlignedAllocate(size);
+  if (buffer == NULL) {
+    // The pool may hold memory that is not used. With overcommit, as is the
+    // default on Linux, allocation rarely fails here, which is why the pool
+    // is kept within GetLimit().
+    ReleaseUnused();
+    buffer = AlignedAllocate(size);
+    if (buffer == NULL)
+      throw std::bad_alloc();
+  }
+  // The first touch decides where the pages are placed.
+  if (clear || size >= parallel_clear_size)
+    Clear(buffer, size);
+  return buffer;
+}
+
+
+void WorkspacePool::Release(void * buffer, size_t bytes)
+{
+  if (buffer == NULL)
+    return;
+  size_t              size  = SizeClass(bytes);
+  size_t              limit = pool_limit;
+  std::vector<void *> evicted;
+  if (size > limit) {
+    evicted.push_back(buffer);
+  }
+  else {
+    std::lock_guard<std::mutex> lock(PoolMutex());
+    EvictOldest(limit - size, evicted);
+    FreeBuffers().push_back(std::make_pair(size, buffer));
+    SizeClasses()[size].push_back(--FreeBuffers().end());
+    pooled_bytes += size;
+  }
+  for (size_t i = 0; i < evicted.size(); i++)
+    AlignedFree(evicted[i]);
+}
+
+
+size_t WorkspacePool::ReleaseUnused()
+{
+  BufferList buffers;
+  size_t     bytes;
+  {
+    std::lock_guard<std::mutex> lock(PoolMutex());
+    buffers.swap(FreeBuffers());
+    SizeClasses().clear();
+    bytes        = pooled_bytes;
+    pooled_bytes = 0;
+  }
+  for (BufferList::iterator it = buffers.begin(); it != buffers.end(); ++it)
+    AlignedFree(it->second);
+  return bytes;
+}
+
+
+void WorkspacePool::SetLimit(size_t bytes)
+{
+  pool_limit = bytes;
+  std::vector<void *> evicted;
+  {
+    std::lock_guard<std::mutex> lock(PoolMutex());
+    EvictOldest(bytes, evicted);
+  }
+  for (size_t i = 0; i < evicted.size(); i++)
+    AlignedFree(evicted[i]);
+}
+
+
+size_t WorkspacePool::GetLimit()
+{
+  return pool_limit;
+}
+
+
+size_t WorkspacePool::GetPooledBytes()
+{
+  std::lock_guard<std::mutex> lock(PoolMutex());
+  return pooled_bytes;
+}
+
+
+void WorkspacePool::SetHugePages(bool enabled)
+{
+  huge_pages = enabled;
+}
+
+
+bool WorkspacePool::GetHugePages()
+{
+  return huge_pages;
+}
+
+
+void WorkspacePool::Clear(void * buffer, size_t bytes)
+{
+  char * data      = static_cast<char *>(buffer);
+  size_t n_threads = std::max(1U, std::thread::hardware_concurrency());
+  if (bytes < parallel_clear_size || n_threads == 1) {
+    std::memset(data, 0, bytes);
+    return;
+  }
+  n_threads    = std::min(n_threads, bytes / (parallel_clear_size / 4));
+  size_t chunk = (bytes / n_threads + alignment - 1) / alignment * alignment;
+  std::vector<std::thread> threads;
+  for (size_t t = 1; t < n_threads; t++) {
+    size_t begin = std::min(t * chunk, bytes);
+    size_t end   = std::min(begin + chunk, bytes);
+    threads.push_back(std::thread([=]() { std::memset(data + begin, 0, end - begin); }));
+  }
+  std::memset(data, 0, std::min(chunk, bytes));
+  for (size_t t = 0; t < threads.size(); t++)
+    threads[t].join();
+}
@@ -0,0 +1,77 @@
+// Copyright (c)  2011, Norwegian Computing Center
+// All rights reserved.
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+// •  Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+// •  Redistributions in binary form must reproduce the above copyright notice, this list of
+//    conditions and the following disclaimer in the documentation and/or other materials
+//    provided with the distribution.
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+// OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef NRLIB_FFT_WORKSPACEPOOL_HPP
+#define NRLIB_FFT_WORKSPACEPOOL_HPP
+
+#include <cstdlib>
+
+namespace NRLib {
+  /// Pool of aligned buffers for the FFT grids. Buffers are returned to the
+  /// pool instead of being freed, so that repeated simulations on the same
+  /// grid size do not allocate, page fault and clear the memory again. The
+  /// pool groups buffers in size classes that are at most 1/8 larger than
+  /// the requested size. Free buffers are kept until ReleaseUnused is called,
+  /// or until they are the oldest in a pool that would otherwise hold more
+  /// than GetLimit() bytes. All functions are thread safe.
+  class WorkspacePool {
+  public:
+    /// Buffer of at least bytes bytes, aligned to 64 bytes. The contents are
+    /// zero if clear is true, and undefined otherwise. New buffers of 16 MB
+    /// and more are always cleared as in Clear, so that their pages are
+    /// first touched by several threads.
+    static void * Acquire(size_t bytes, bool clear = false);
+
+    /// Returns a buffer from Acquire, with the same number of bytes, to the
+    /// pool. The oldest free buffers are freed if the pool would hold more
+    /// than GetLimit() bytes, and the buffer itself if it is larger than that.
+    static void   Release(void * buffer, size_t bytes);
+
+    /// Sets the largest number of bytes kept in free buffers. Buffers above
+    /// the limit are freed at once. The default is 1 GB.
+    static void   SetLimit(size_t bytes);
+
+    static size_t GetLimit();
+
+    /// Frees the buffers in the pool that are not in use. Returns the number
+    /// of bytes freed.
+    static size_t ReleaseUnused();
+
+    /// Number of bytes in free buffers in the pool.
+    static size_t GetPooledBytes();
+
+    /// Turns transparent huge pages for buffers of 2 MB and more on or off.
+    /// Only has an effect on Linux, and only for buffers allocated afterwards.
+    /// Off by default.
+    static void   SetHugePages(bool enabled);
+
+    static bool   GetHugePages();
+
+    /// Sets bytes bytes of buffer to zero. Large buffers are cleared by
+    /// several threads, so that the first touch of new pages is spread over
+    /// the threads (and NUMA nodes) that use the buffer.
+    static void   Clear(void * buffer, size_t bytes);
+
+  private:
+    /// Size class of a buffer of bytes bytes.
+    static size_t SizeClass(size_t bytes);
+  };
+}
+
+#endif // NRLIB_FFT_WORKSPACEPOOL_HPP
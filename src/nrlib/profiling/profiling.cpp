@@ -0,0 +1,213 @@
+// Copyright (c)  2011, Norwegian Computing Center
+// All rights reserved.
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+// •  Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+// •  Redistributions in binary form must reproduce the above copyright notice, this list of
+//    conditions and the following disclaimer in the documentation and/or other materials
+//    provided with the distribution.
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+// OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "profiling.hpp"
+
+#include <algorithm>
+#include <mutex>
+#include <sstream>
+
+#include "../fft/fft.hpp"
+#include "../fft/workspacepool.hpp"
+
+using namespace NRLib;
+
+namespace NRLib { namespace Profiling {
+
+std::atomic<bool> NRLibPrivate::enabled(false);
+
+struct NRLibPrivate::RunContext {
+  std::mutex mutex;
+  RunStats   stats;
+};
+
+namespace {
+  // The run being recorded on this thread, and how deeply RunScopes are nested.
+  thread_local RunHandle current_run;
+  thread_local int       run_depth = 0;
+
+  // Number of this thread in the trace events.
+  std::atomic<size_t> n_threads(0);
+  thread_local size_t thread_number = n_threads++;
+
+  std::mutex last_run_mutex;
+  RunStats   last_run;
+
+  const std::chrono::steady_clock::time_point & Epoch()
+  {
+    static const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+    return epoch;
+  }
+}
+
+}}
+
+
+void Profiling::SetEnabled(bool enabled)
+{
+  Epoch();
+  NRLibPrivate::enabled.store(enabled);
+}
+
+
+Profiling::RunStats Profiling::GetLastRunStats()
+{
+  std::lock_guard<std::mutex> lock(last_run_mutex);
+  return last_run;
+}
+
+
+std::string Profiling::GetLastRunChromeTrace()
+{
+  RunStats stats = GetLastRunStats();
+  std::ostringstream out;
+  out << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [";
+  for (size_t i = 0; i < stats.events.size(); ++i) {
+    const StageEvent & event = stats.events[i];
+    if (i > 0)
+      out << ", ";
+    out << "{\"name\": \"" << event.name << "\", \"cat\": \"gaussianfft\", \"ph\": \"X\""
+        << ", \"ts\": "  << 1e6 * event.start
+        << ", \"dur\": " << 1e6 * event.seconds
+        << ", \"pid\": 1, \"tid\": " << event.thread + 1 << "}";
+  }
+  out << "]}";
+  return out.str();
+}
+
+
+void Profiling::RecordPaddedSize(size_t nx, size_t ny, size_t nz)
+{
+  if (!IsEnabled() || !current_run)
+    return;
+  std::lock_guard<std::mutex> lock(current_run->mutex);
+  RunStats & stats = current_run->stats;
+  stats.padded_size.clear();
+  stats.fft_factors.clear();
+  size_t sizes[3] = {nx, ny, nz};
+  for (size_t i = 0; i < 3; ++i) {
+    if (i > 0 && sizes[i] <= 1)
+      break;
+    stats.padded_size.push_back(sizes[i]);
+    stats.fft_factors.push_back(FactorizeFFTSize(sizes[i]));
+  }
+}
+
+
+void Profiling::RecordFields(size_t n_fields)
+{
+  if (!IsEnabled() || !current_run)
+    return;
+  std::lock_guard<std::mutex> lock(current_run->mutex);
+  current_run->stats.n_fields += n_fields;
+}
+
+
+void Profiling::RecordAllocation(size_t bytes)
+{
+  if (!IsEnabled() || !current_run)
+    return;
+  std::lock_guard<std::mutex> lock(current_run->mutex);
+  RunStats & stats = current_run->stats;
+  stats.bytes_allocated += bytes;
+  stats.current_bytes   += bytes;
+  if (stats.current_bytes > stats.peak_bytes)
+    stats.peak_bytes = stats.current_bytes;
+}
+
+
+void Profiling::RecordDeallocation(size_t bytes)
+{
+  if (!IsEnabled() || !current_run)
+    return;
+  std::lock_guard<std::mutex> lock(current_run->mutex);
+  RunStats & stats = current_run->stats;
+  // Buffers allocated before profiling was enabled are not counted
+  stats.current_bytes -= std::min(bytes, stats.current_bytes);
+}
+
+
+Profiling::RunScope::RunScope()
+  : active_(IsEnabled())
+{
+  if (!active_)
+    return;
+  if (run_depth == 0)
+    current_run = std::make_shared<NRLibPrivate::RunContext>();
+  ++run_depth;
+}
+
+
+Profiling::RunScope::~RunScope()
+{
+  if (!active_)
+    return;
+  --run_depth;
+  if (run_depth == 0) {
+    RunStats stats;
+    {
+      std::lock_guard<std::mutex> lock(current_run->mutex);
+      stats = current_run->stats;
+    }
+    current_run.reset();
+    stats.pooled_bytes = WorkspacePool::GetPooledBytes();
+    std::lock_guard<std::mutex> lock(last_run_mutex);
+    last_run = stats;
+  }
+}
+
+
+Profiling::RunHandle Profiling::CurrentRun()
+{
+  return current_run;
+}
+
+
+Profiling::AttachRun::AttachRun(const RunHandle & run)
+  : previous_run_(current_run),
+    previous_depth_(run_depth)
+{
+  if (!run)
+    return;
+  current_run = run;
+  run_depth   = 1;
+}
+
+
+Profiling::AttachRun::~AttachRun()
+{
+  current_run = previous_run_;
+  run_depth   = previous_depth_;
+}
+
+
+void Profiling::ScopedTimer::Finish()
+{
+  std::chrono::steady_clock::time_point end = std::chrono::steady_clock::now();
+  StageEvent event;
+  event.name    = name_;
+  event.start   = std::chrono::duration<double>(start_ - Epoch()).count();
+  event.seconds = std::chrono::duration<double>(end - start_).count();
+  event.thread  = thread_number;
+  if (!current_run)
+    return;
+  std::lock_guard<std::mutex> lock(current_run->mutex);
+  current_run->stats.stage_seconds[event.name] += event.seconds;
+  current_run->stats.events.push_back(event);
+}
@@ -0,0 +1,190 @@
+// Copyright (c)  2011, Norwegian Computing Center
+// All rights reserved.
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+// •  Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+// •  Redistributions in binary form must reproduce the above copyright notice, this list of
+//    conditions and the following disclaimer in the documentation and/or other materials
+//    provided with the distribution.
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+// OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef NRLIB_PROFILING_PROFILING_HPP
+#define NRLIB_PROFILING_PROFILING_HPP
+
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace NRLib {
+namespace Profiling {
+
+/// One timed stage of a simulation. Times are in seconds, and start is
+/// measured from the first time profiling was used in the process. thread
+/// numbers the threads in the order they first recorded a stage.
+struct StageEvent {
+  std::string name;
+  double      start;
+  double      seconds;
+  size_t      thread;
+};
+
+/// Statistics collected for one simulation run (one call to one of the
+/// Simulate*GaussianField functions, or an enclosing RunScope).
+struct RunStats {
+  /// Size of the FFT grid in each direction after padding.
+  std::vector<size_t>              padded_size;
+  /// Prime factors of each of the padded sizes.
+  std::vector<std::vector<size_t> > fft_factors;
+  /// Number of realizations simulated.
+  size_t                           n_fields;
+  /// Accumulated time per stage, in seconds, summed over the threads of the
+  /// run. Stages that overlap in time may therefore add up to more than the
+  /// wall time of the run.
+  std::map<std::string, double>    stage_seconds;
+  /// Every timed stage in the order they were started.
+  std::vector<StageEvent>          events;
+  /// Total number of bytes allocated for grids and FFT buffers.
+  size_t                           bytes_allocated;
+  /// Largest number of bytes held at the same time.
+  size_t                           peak_bytes;
+  /// Number of bytes currently held (used to find peak_bytes).
+  size_t                           current_bytes;
+  /// Number of bytes in free buffers kept by WorkspacePool after the run.
+  size_t                           pooled_bytes;
+
+  RunStats() : n_fields(0), bytes_allocated(0), peak_bytes(0), current_bytes(0), pooled_bytes(0) {}
+};
+
+namespace NRLibPrivate {
+  /// Read by worker threads while Python may toggle it.
+  extern std::atomic<bool> enabled;
+
+  /// The statistics of a run, shared by the threads that record into it.
+  struct RunContext;
+}
+
+/// The run recorded on a thread, see CurrentRun and AttachRun.
+typedef std::shared_ptr<NRLibPrivate::RunContext> RunHandle;
+
+/// Turn instrumentation on or off. It is off by default, in which case
+/// every hook below reduces to a single test of a global flag.
+void SetEnabled(bool enabled);
+
+inline bool IsEnabled() { return NRLibPrivate::enabled.load(std::memory_order_relaxed); }
+
+/// Statistics for the last completed run. Empty if profiling was disabled.
+RunStats GetLastRunStats();
+
+/// The events of the last completed run in the Chrome trace event format
+/// (chrome://tracing, Perfetto).
+std::string GetLastRunChromeTrace();
+
+/// Records the (padded) grid size used by the FFTs of the current run.
+void RecordPaddedSize(size_t nx, size_t ny = 1, size_t nz = 1);
+
+void RecordFields(size_t n_fields);
+
+void RecordAllocation(size_t bytes);
+
+void RecordDeallocation(size_t bytes);
+
+/// Marks the extent of one run. Runs may be nested, in which case only the
+/// outermost scope starts and completes the run. Statistics are collected
+/// for the thread that started the run and the threads attached to it (see
+/// AttachRun), and published when the outermost scope is left.
+class RunScope {
+public:
+  RunScope();
+  ~RunScope();
+private:
+  bool active_;
+  RunScope(const RunScope &);
+  RunScope & operator=(const RunScope &);
+};
+
+/// The run being recorded on the calling thread. Empty if there is none.
+RunHandle CurrentRun();
+
+/// Makes the stages and allocations of the calling thread count in the given
+/// run, for as long as the scope lives. For threads started during a run;
+/// they must be joined before the RunScope that started the run is left.
+/// RunScopes inside an AttachRun are nested in the attached run.
+class AttachRun {
+public:
+  explicit AttachRun(const RunHandle & run);
+  ~AttachRun();
+private:
+  RunHandle previous_run_;
+  int       previous_depth_;
+  AttachRun(const AttachRun &);
+  AttachRun & operator=(const AttachRun &);
+};
+
+/// Adds the time spent in the enclosing scope to the given stage.
+/// name must be a string literal, or otherwise outlive the timer.
+class ScopedTimer {
+public:
+  explicit ScopedTimer(const char * name)
+    : name_(name), active_(IsEnabled())
+  {
+    if (active_)
+      start_ = std::chrono::steady_clock::now();
+  }
+
+  ~ScopedTimer()
+  {
+    if (active_)
+      Finish();
+  }
+
+private:
+  void Finish();
+
+  const char *                          name_;
+  bool                                  active_;
+  std::chrono::steady_clock::time_point start_;
+
+  ScopedTimer(const ScopedTimer &);
+  ScopedTimer & operator=(const ScopedTimer &);
+};
+
+/// Counts a buffer that is not allocated through FFTGrid2D/FFTGrid3D,
+/// such as a Grid, for as long as the scope lives.
+class ScopedAllocation {
+public:
+  explicit ScopedAllocation(size_t bytes)
+    : bytes_(IsEnabled() ? bytes : 0)
+  {
+    if (bytes_ > 0)
+      RecordAllocation(bytes_);
+  }
+
+  ~ScopedAllocation()
+  {
+    if (bytes_ > 0)
+      RecordDeallocation(bytes_);
+  }
+
+private:
+  size_t bytes_;
+
+  ScopedAllocation(const ScopedAllocation &);
+  ScopedAllocation & operator=(const ScopedAllocation &);
+};
+
+} // namespace Profiling
+} // namespace NRLib
+
+#endif // NRLIB_PROFILING_PROFILING_HPP
@@ -0,0 +1,135 @@
+/// Unit tests for profiling of gaussian field simulation
+
+#include <nrlib/fft/fft.hpp>
+#include <nrlib/grid/grid.hpp>
+#include <nrlib/profiling/profiling.hpp>
+#include <nrlib/random/random.hpp>
+#include <nrlib/variogram/gaussianfield.hpp>
+#include <nrlib/variogram/variogram.hpp>
+
+#include <boost/test/unit_test.hpp>
+#include <map>
+#include <set>
+#include <thread>
+
+using namespace NRLib;
+
+BOOST_AUTO_TEST_SUITE( TestProfiling )
+
+BOOST_AUTO_TEST_CASE( FactorizeSizes )
+{
+  std::vector<size_t> f = FactorizeFFTSize(2 * 2 * 3 * 7 * 7);
+  BOOST_TEST(f.size() == 5U);
+  BOOST_TEST(f[0] == 2U);
+  BOOST_TEST(f[2] == 3U);
+  BOOST_TEST(f[4] == 7U);
+  BOOST_TEST(FactorizeFFTSize(13).size() == 1U);
+}
+
+BOOST_AUTO_TEST_CASE( DisabledRecordsNothing )
+{
+  Profiling::SetEnabled(false);
+  {
+    Profiling::RunScope run;
+    Profiling::ScopedTimer timer("stage");
+    Profiling::RecordAllocation(100);
+  }
+  BOOST_TEST(Profiling::GetLastRunStats().events.empty());
+}
+
+BOOST_AUTO_TEST_CASE( Sim3dStats )
+{
+  Variogram * v = Variogram::Create(Variogram::SPHERICAL, 1.5, 1000.0, 500.0, 250.0);
+  std::vector<Grid<double> > fields;
+  Random::Initialize(123L);
+  Profiling::SetEnabled(true);
+  Simulate3DGaussianField(*v, 20, 50.0, 16, 50.0, 8, 50.0, 2, fields);
+  Profiling::SetEnabled(false);
+  delete v;
+
+  Profiling::RunStats stats = Profiling::GetLastRunStats();
+  BOOST_TEST(stats.n_fields == 2U);
+  BOOST_REQUIRE(stats.padded_size.size() == 3U);
+  size_t n = 1;
+  for (size_t i = 0; i < 3; ++i) {
+    size_t product = 1;
+    for (size_t j = 0; j < stats.fft_factors[i].size(); ++j)
+      product *= stats.fft_factors[i][j];
+    BOOST_TEST(product == stats.padded_size[i]);
+    n *= stats.padded_size[i];
+  }
+  // Two forward transforms of noise, one of the filter
+  BOOST_TEST(stats.stage_seconds.count("fft") == 1U);
+  size_t n_fft = 0;
+  for (size_t i = 0; i < stats.events.size(); ++i)
+    if (stats.events[i].name == "fft")
+      ++n_fft;
+  BOOST_TEST(n_fft == 3U);
+  // Real and complex FFT buffers, and the covariance and noise grids
+  BOOST_TEST(stats.peak_bytes >= 4 * n * sizeof(double));
+  BOOST_TEST(stats.bytes_allocated >= stats.peak_bytes);
+  BOOST_TEST(stats.current_bytes == 0U);
+
+  std::string trace = Profiling::GetLastRunChromeTrace();
+  BOOST_TEST(trace.find("\"name\": \"inverse_fft\"") != std::string::npos);
+}
+
+BOOST_AUTO_TEST_CASE( Sim3dStatsOfPipelineThreads )
+{
+  // Noise and extraction run on threads of their own with several fields.
+  Variogram * v = Variogram::Create(Variogram::SPHERICAL, 1.5, 1000.0, 500.0, 250.0);
+  std::vector<Grid<double> > fields;
+  Random::Initialize(123L);
+  Profiling::SetEnabled(true);
+  Simulate3DGaussianField(*v, 20, 50.0, 16, 50.0, 8, 50.0, 3, fields);
+  Profiling::SetEnabled(false);
+  delete v;
+
+  Profiling::RunStats stats = Profiling::GetLastRunStats();
+  BOOST_TEST(stats.n_fields == 3U);
+  std::map<std::string, size_t> n_events;
+  std::set<size_t>              threads;
+  for (size_t i = 0; i < stats.events.size(); ++i) {
+    ++n_events[stats.events[i].name];
+    threads.insert(stats.events[i].thread);
+  }
+  BOOST_TEST(n_events["noise"] == 3U);
+  BOOST_TEST(n_events["initialize"] == 3U);
+  BOOST_TEST(n_events["extract"] == 3U);
+  BOOST_TEST(stats.stage_seconds["noise"] > 0.0);
+  BOOST_TEST(stats.stage_seconds["extract"] > 0.0);
+  BOOST_TEST(threads.size() == 3U);
+}
+
+BOOST_AUTO_TEST_CASE( AttachRun )
+{
+  Profiling::SetEnabled(true);
+  {
+    Profiling::RunScope run;
+    Profiling::RunHandle handle = Profiling::CurrentRun();
+    BOOST_REQUIRE(handle);
+    std::thread worker([&]() {
+      Profiling::AttachRun attach(handle);
+      Profiling::RunScope nested;
+      Profiling::ScopedTimer timer("worker");
+      Profiling::RecordAllocation(100);
+      Profiling::RecordDeallocation(100);
+    });
+    worker.join();
+    // Without AttachRun, stages on other threads are not counted.
+    std::thread other([]() {
+      BOOST_CHECK(!Profiling::CurrentRun());
+      Profiling::ScopedTimer timer("other");
+    });
+    other.join();
+  }
+  Profiling::SetEnabled(false);
+  BOOST_TEST(!Profiling::CurrentRun());
+
+  Profiling::RunStats stats = Profiling::GetLastRunStats();
+  BOOST_TEST(stats.stage_seconds.count("worker") == 1U);
+  BOOST_TEST(stats.stage_seconds.count("other") == 0U);
+  BOOST_TEST(stats.bytes_allocated == 100U);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
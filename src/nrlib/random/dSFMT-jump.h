@@ -0,0 +1,37 @@
+#pragma once
+#ifndef DSFMT_JUMP_H
+#define DSFMT_JUMP_H
+/**
+ * @file dSFMT-jump.h
+ *
+ * @brief jump header file.
+ *
+ * @author Mutsuo Saito (Hiroshima University)
+ * @author Makoto Matsumoto (The University of Tokyo)
+ *
+ * Copyright (C) 2012 Mutsuo Saito, Makoto Matsumoto,
+ * Hiroshima University and The University of Tokyo.
+ * All rights reserved.
+ *
+ * The 3-clause BSD License is applied to this software, see
+ * LICENSE.txt
+ */
+#if defined(__cplusplus)
+extern "C" {
+#endif
+
+#include "dSFMT.h"
+
+/**
+ * Jumps ahead in the sequence of dsfmt. jump_str is the jump polynomial
+ * in hexadecimal, with the coefficient of x^0 in the lowest bit of the
+ * first digit. The polynomial x^n mod the minimal polynomial of the
+ * generator gives a jump of n steps of the recursion.
+ */
+void dSFMT_jump(dsfmt_t * dsfmt, const char * jump_str);
+
+#if defined(__cplusplus)
+}
+#endif
+
+#endif
@@ -4,6 +4,7 @@ SRC +=  $(NRLIB_BASE_DIR)random/beta.cpp \
 	$(NRLIB_BASE_DIR)random/chisquared.cpp \
 	$(NRLIB_BASE_DIR)random/delta.cpp \
 	$(NRLIB_BASE_DIR)random/dSFMT.cpp \
+	$(NRLIB_BASE_DIR)random/dSFMT-jump.cpp \
     $(NRLIB_BASE_DIR)random/fractal.cpp \
 	$(NRLIB_BASE_DIR)random/functions.cpp \
 	$(NRLIB_BASE_DIR)random/gamma.cpp \
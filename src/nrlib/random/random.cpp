@@ -20,6 +20,7 @@
 // EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "random.hpp"
+#include "randomgenerator.hpp"
 #include "../exception/exception.hpp"
 
 #include <ctime>
@@ -61,6 +62,22 @@ void Random::Initialize(const std::string& filename) {
   InitializeMT(start_seed_);
 }
 
+void Random::Initialize(const RandomGenerator& generator) {
+  start_seed_     = generator.GetStartSeed();
+  is_initialized_ = true;
+  dsfmt_global_data = generator.GetState();
+}
+
+void Random::FillNorm01(double * out, size_t n)
+{
+  NRLib::FillNorm01(&dsfmt_global_data, out, n);
+}
+
+void Random::FillNorm01(float * out, size_t n)
+{
+  NRLib::FillNorm01(&dsfmt_global_data, out, n);
+}
+
 double Random::Norm01()
 {
   double u, u1, u2, u3;
@@ -28,6 +28,8 @@
 
 namespace NRLib {
 
+class RandomGenerator;
+
 /// Random generator class based on the Mersenne-Twister random
 /// number generator.
 /// Always initialize before use!
@@ -40,6 +42,9 @@ public:
 
   static void Initialize(const std::string& seed_file_);
 
+  /// Continues from the state of generator, e.g. one of RandomGenerator::CreateStreams.
+  static void Initialize(const RandomGenerator& generator);
+
   /// \return uniform number in [0,1)
   static double Unif01()             { return dsfmt_gv_genrand_close_open(); }
 
@@ -52,6 +57,10 @@ public:
   /// Marsaglia-Bray's method, see Ripley, p. 84.
   static double Norm01();
 
+  /// n standard normal numbers, see RandomGenerator::FillNorm01.
+  static void FillNorm01(double * out, size_t n);
+  static void FillNorm01(float  * out, size_t n);
+
   /// Get start seed.
   static unsigned long GetStartSeed();
 
@@ -21,14 +21,313 @@
 
 
 #include "randomgenerator.hpp"
+#include "dSFMT-jump.h"
 #include "../exception/exception.hpp"
 
+#include <algorithm>
 #include <ctime>
 #include <cmath>
+#include <cstdint>
+#include <cstring>
 #include <fstream>
+#include <map>
+#include <mutex>
+#include <string>
 
 using namespace NRLib;
 
+namespace {
+  // Polynomial over GF(2), with the coefficient of x^i in bit i % 64 of word i / 64.
+  typedef std::vector<std::uint64_t> Polynomial;
+
+  bool GetBit(const Polynomial & p, size_t i)
+  {
+    return ((p[i / 64] >> (i % 64)) & 1U) != 0;
+  }
+
+  // a += b * x^shift, for the first n_words words of b. a must be large enough.
+  void AddShifted(Polynomial & a, const Polynomial & b, size_t n_words, size_t shift)
+  {
+    size_t word = shift / 64;
+    size_t bit  = shift % 64;
+    if (bit == 0) {
+      for (size_t i = 0; i < n_words; i++)
+        a[word + i] ^= b[i];
+    }
+    else {
+      for (size_t i = 0; i < n_words; i++) {
+        a[word + i]     ^= b[i] << bit;
+        a[word + i + 1] ^= b[i] >> (64 - bit);
+      }
+    }
+  }
+
+  // Minimal polynomial of the dSFMT recursion, found by the Berlekamp-Massey
+  // algorithm from the lowest bit of the first number of each step. The
+  // sequence has twice as many steps as the state has bits.
+  struct MinimalPolynomial {
+    MinimalPolynomial()
+    {
+      const size_t n       = 2 * 128 * (DSFMT_N + 1);
+      const size_t n_words = n / 64 + 2;
+
+      // The sequence backwards, so that the discrepancy is a dot product.
+      Polynomial reversed(n_words + 1, 0);
+      dsfmt_t generator;
+      dsfmt_init_gen_rand(&generator, 4357);
+      for (size_t k = 0; k < n; k++) {
+        double value = dsfmt_genrand_close1_open2(&generator);
+        dsfmt_genrand_close1_open2(&generator);
+        std::uint64_t bits;
+        std::memcpy(&bits, &value, sizeof(bits));
+        size_t j = n - 1 - k;
+        reversed[j / 64] |= (bits & 1U) << (j % 64);
+      }
+
+      Polynomial c(n_words + 1, 0);
+      Polynomial b(n_words + 1, 0);
+      c[0] = 1;
+      b[0] = 1;
+      size_t length   = 0;
+      size_t length_b = 0;
+      size_t m        = 1;
+      for (size_t k = 0; k < n; k++) {
+        // sum_i c_i s_(k-i), where s_(k-i) is bit n-1-k+i of reversed
+        size_t        offset = n - 1 - k;
+        size_t        word   = offset / 64;
+        size_t        bit    = offset % 64;
+        std::uint64_t sum    = 0;
+        for (size_t i = 0; i <= length / 64; i++) {
+          std::uint64_t s = reversed[word + i] >> bit;
+          if (bit > 0)
+            s |= reversed[word + i + 1] << (64 - bit);
+          sum ^= c[i] & s;
+        }
+        for (size_t shift = 32; shift > 0; shift /= 2)
+          sum ^= sum >> shift;
+
+        if ((sum & 1U) == 0) {
+          m++;
+        }
+        else if (2 * length <= k) {
+          Polynomial t(c);
+          AddShifted(c, b, length_b / 64 + 1, m);
+          length_b = length;
+          length   = k + 1 - length;
+          b.swap(t);
+          m = 1;
+        }
+        else {
+          AddShifted(c, b, length_b / 64 + 1, m);
+          m++;
+        }
+      }
+
+      // The minimal polynomial is the reverse of the connection polynomial.
+      degree = length;
+      coefficients.assign(degree / 64 + 1, 0);
+      for (size_t i = 0; i <= degree; i++) {
+        if (GetBit(c, i))
+          coefficients[(degree - i) / 64] |= std::uint64_t(1) << ((degree - i) % 64);
+      }
+    }
+
+    // Reduces p, with n_bits bits, modulo the minimal polynomial.
+    void Reduce(Polynomial & p, size_t n_bits) const
+    {
+      for (size_t i = n_bits; i-- > degree;) {
+        if (GetBit(p, i))
+          AddShifted(p, coefficients, coefficients.size(), i - degree);
+      }
+      p.resize(degree / 64 + 1);
+      if (degree % 64 != 0)
+        p.back() &= (std::uint64_t(1) << (degree % 64)) - 1;
+      else
+        p.back() = 0;
+    }
+
+    // p^2 mod the minimal polynomial. Squaring spreads the bits.
+    Polynomial SquareMod(const Polynomial & p) const
+    {
+      Polynomial q(2 * p.size() + 2, 0);
+      for (size_t i = 0; i < p.size(); i++) {
+        for (size_t half = 0; half < 2; half++) {
+          std::uint64_t x = (p[i] >> (32 * half)) & 0xffffffffU;
+          x = (x | (x << 16)) & 0x0000ffff0000ffffULL;
+          x = (x | (x << 8))  & 0x00ff00ff00ff00ffULL;
+          x = (x | (x << 4))  & 0x0f0f0f0f0f0f0f0fULL;
+          x = (x | (x << 2))  & 0x3333333333333333ULL;
+          x = (x | (x << 1))  & 0x5555555555555555ULL;
+          q[2 * i + half] = x;
+        }
+      }
+      Reduce(q, 128 * p.size());
+      return q;
+    }
+
+    // x*p mod the minimal polynomial
+    Polynomial TimesXMod(const Polynomial & p) const
+    {
+      Polynomial q(p.size() + 2, 0);
+      AddShifted(q, p, p.size(), 1);
+      Reduce(q, 64 * (p.size() + 1));
+      return q;
+    }
+
+    size_t     degree;
+    Polynomial coefficients;
+  };
+
+  // x^(steps*2^log2_scale) mod the minimal polynomial, in the format of dSFMT_jump.
+  std::string JumpString(unsigned long long steps, unsigned int log2_scale)
+  {
+    static const MinimalPolynomial minimal;
+
+    Polynomial p(minimal.degree / 64 + 1, 0);
+    p[0] = 1;
+    for (int i = 63; i >= 0; i--) {
+      p = minimal.SquareMod(p);
+      if (((steps >> i) & 1U) != 0)
+        p = minimal.TimesXMod(p);
+    }
+    for (unsigned int i = 0; i < log2_scale; i++)
+      p = minimal.SquareMod(p);
+
+    const char * digits = "0123456789abcdef";
+    std::string jump((minimal.degree + 3) / 4, '0');
+    for (size_t i = 0; i < jump.size(); i++)
+      jump[i] = digits[(p[i / 16] >> (4 * (i % 16))) & 0xfU];
+    return jump;
+  }
+
+  // Tables of the 256-layer ziggurat for the standard normal density, see
+  // Marsaglia and Tsang (2000), for 43-bit uniforms. Layer i covers [0, x_i)
+  // with x_255 = r, and k[i] = 2^43 x_(i-1)/x_i is the fraction of the layer
+  // inside the density.
+  struct Ziggurat {
+    Ziggurat()
+    {
+      const double v     = 4.92867323399e-3;  // area of each layer
+      const double scale = 8796093022208.0;   // 2^43
+      double x      = r;
+      double x_next = r;
+      double q      = v / std::exp(-0.5 * r * r);
+      k[0]   = static_cast<std::uint64_t>((r / q) * scale);
+      k[1]   = 0;
+      w[0]   = q / scale;
+      w[255] = r / scale;
+      f[0]   = 1.0;
+      f[255] = std::exp(-0.5 * r * r);
+      for (int i = 254; i >= 1; i--) {
+        x        = std::sqrt(-2.0 * std::log(v / x + std::exp(-0.5 * x * x)));
+        k[i + 1] = static_cast<std::uint64_t>((x / x_next) * scale);
+        x_next   = x;
+        f[i]     = std::exp(-0.5 * x * x);
+        w[i]     = x / scale;
+      }
+    }
+
+    static constexpr double r = 3.6541528853610088;
+
+    std::uint64_t k[256];
+    double        w[256];
+    double        f[256];
+  };
+
+  // Uniforms from dsfmt, generated in blocks with dsfmt_fill_array. A block
+  // never holds more numbers than are certain to be used, so the numbers are
+  // the same as from scalar draws, and the generator continues after the
+  // last number used.
+  class UniformBlocks {
+  public:
+    explicit UniformBlocks(dsfmt_t * dsfmt)
+      : dsfmt_(dsfmt),
+        buffer_(4 * DSFMT_N),
+        first_(0),
+        last_(0)
+    {}
+
+    /// The 52 random mantissa bits of the next number. At least n_left
+    /// numbers, including this, must be used before the generator is.
+    std::uint64_t NextBits(size_t n_left)
+    {
+      if (first_ == last_)
+        Refill(n_left);
+      std::uint64_t bits;
+      std::memcpy(&bits, &buffer_[0].d[0] + first_++, sizeof(bits));
+      return bits & 0x000fffffffffffffULL;
+    }
+
+    /// The next number, in [0,1).
+    double NextUnif01(size_t n_left)
+    {
+      if (first_ == last_)
+        Refill(n_left);
+      return (&buffer_[0].d[0])[first_++] - 1.0;
+    }
+
+  private:
+    void Refill(size_t n_left)
+    {
+      // dsfmt_fill_array needs an even number of at least DSFMT_N64 numbers,
+      // and can not continue a block started by scalar draws.
+      size_t n = std::min(2 * (n_left / 2), 2 * buffer_.size());
+      if (dsfmt_->idx == DSFMT_N64 && n >= DSFMT_N64) {
+        dsfmt_fill_array_close1_open2(dsfmt_, &buffer_[0].d[0], static_cast<ptrdiff_t>(n));
+      }
+      else {
+        buffer_[0].d[0] = dsfmt_genrand_close1_open2(dsfmt_);
+        n = 1;
+      }
+      first_ = 0;
+      last_  = n;
+    }
+
+    dsfmt_t             * dsfmt_;
+    std::vector<w128_t>   buffer_;  // aligned for SSE2
+    size_t                first_;
+    size_t                last_;
+  };
+
+  template <typename T>
+  void FillNorm01Blocks(dsfmt_t * dsfmt, T * out, size_t n)
+  {
+    static const Ziggurat zig;
+    const double          r = Ziggurat::r;
+    UniformBlocks         uniforms(dsfmt);
+
+    for (size_t i = 0; i < n; i++) {
+      size_t n_left = n - i;
+      for (;;) {
+        // 8 bits for the layer, 1 for the sign and 43 for the position.
+        std::uint64_t bits  = uniforms.NextBits(n_left);
+        size_t        layer = static_cast<size_t>(bits & 0xff);
+        double        sign  = 1.0 - 2.0 * static_cast<double>((bits >> 8) & 1U);
+        std::uint64_t u     = bits >> 9;
+        double        x     = sign * static_cast<double>(u) * zig.w[layer];
+        if (u < zig.k[layer]) {
+          out[i] = static_cast<T>(x);
+          break;
+        }
+        if (layer == 0) {
+          // The tail beyond r.
+          double xx, yy;
+          do {
+            xx = -std::log1p(-uniforms.NextUnif01(n_left)) / r;
+            yy = -std::log1p(-uniforms.NextUnif01(n_left));
+          } while (yy + yy <= xx * xx);
+          out[i] = static_cast<T>(sign * (r + xx));
+          break;
+        }
+        if ((zig.f[layer - 1] - zig.f[layer]) * uniforms.NextUnif01(n_left) + zig.f[layer] < std::exp(-0.5 * x * x)) {
+          out[i] = static_cast<T>(x);
+          break;
+        }
+      }
+    }
+  }
+}
+
 RandomGenerator::RandomGenerator()
 {
   is_initialized_ = false;
@@ -126,8 +425,36 @@ RandomGenerator::Norm01()
 }
 
 
+void
+RandomGenerator::FillNorm01(double * out, size_t n)
+{
+  NRLib::FillNorm01(&dsfmt, out, n);
+}
+
+
+void
+RandomGenerator::FillNorm01(float * out, size_t n)
+{
+  NRLib::FillNorm01(&dsfmt, out, n);
+}
+
+
+void
+NRLib::FillNorm01(dsfmt_t * dsfmt, double * out, size_t n)
+{
+  FillNorm01Blocks(dsfmt, out, n);
+}
+
+
+void
+NRLib::FillNorm01(dsfmt_t * dsfmt, float * out, size_t n)
+{
+  FillNorm01Blocks(dsfmt, out, n);
+}
+
+
 unsigned long
-RandomGenerator::GetStartSeed()
+RandomGenerator::GetStartSeed() const
 {
   if (!is_initialized_) {
     throw Exception("Random number generator is not initalized.");
@@ -137,6 +464,57 @@ RandomGenerator::GetStartSeed()
 
 
 
+void
+RandomGenerator::Jump(unsigned long long steps, unsigned int log2_scale)
+{
+  if (!is_initialized_) {
+    throw Exception("Random number generator is not initalized.");
+  }
+  if (steps == 0)
+    return;
+
+  typedef std::pair<unsigned long long, unsigned int> Key;
+  static std::mutex                  mutex;
+  static std::map<Key, std::string>  jump_strings;
+
+  std::string jump;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::map<Key, std::string>::iterator it = jump_strings.find(Key(steps, log2_scale));
+    if (it == jump_strings.end())
+      it = jump_strings.insert(std::make_pair(Key(steps, log2_scale), JumpString(steps, log2_scale))).first;
+    jump = it->second;
+  }
+  dsfmt.idx = DSFMT_N64;
+  dSFMT_jump(&dsfmt, jump.c_str());
+}
+
+
+std::vector<RandomGenerator>
+RandomGenerator::CreateStreams(unsigned long seed, size_t n)
+{
+  std::vector<RandomGenerator> streams;
+  if (n == 0)
+    return streams;
+  streams.reserve(n);
+  streams.push_back(RandomGenerator(seed));
+  for (size_t i = 1; i < n; i++) {
+    streams.push_back(streams.back());
+    streams.back().Jump(1, 64);
+  }
+  return streams;
+}
+
+
+void
+RandomGenerator::SetState(const dsfmt_t & state, unsigned long start_seed)
+{
+  dsfmt           = state;
+  start_seed_     = start_seed;
+  is_initialized_ = true;
+}
+
+
 double
 RandomGenerator::g(double x)
 {
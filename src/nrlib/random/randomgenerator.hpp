@@ -22,6 +22,8 @@
 #ifndef NRLIB_RANDOMGENERATOR_H
 #define NRLIB_RANDOMGENERATOR_H
 
+#include <vector>
+
 #include "dSFMT.h"
 
 namespace NRLib {
@@ -50,8 +52,32 @@ public:
   /// Marsaglia-Bray's method, see Ripley, p. 84.
   double Norm01();
 
+  /// Fills out with n standard normal numbers by the ziggurat method. The
+  /// uniforms are generated in blocks with dsfmt_fill_array, and about 99%
+  /// of the numbers need only one uniform, a table lookup and a comparison.
+  /// Faster than n calls to Norm01, but gives other numbers.
+  void FillNorm01(double * out, size_t n);
+  void FillNorm01(float  * out, size_t n);
+
   /// Get start seed.
-  unsigned long GetStartSeed();
+  unsigned long GetStartSeed() const;
+
+  /// Jumps steps*2^log2_scale steps ahead in the sequence, where each step
+  /// of the dSFMT recursion gives two uniform numbers. Numbers left in the
+  /// current block of DSFMT_N steps are skipped first. A jump costs about as
+  /// much as drawing 50000 numbers, after a setup of the jump polynomial the
+  /// first time a jump length is used.
+  void Jump(unsigned long long steps, unsigned int log2_scale = 0);
+
+  /// n generators with non-overlapping sequences. Generator i starts
+  /// i*2^64 steps after RandomGenerator(seed), so that each of them has
+  /// 2^65 numbers before it reaches the start of the next one.
+  static std::vector<RandomGenerator> CreateStreams(unsigned long seed, size_t n);
+
+  /// The state of the generator, e.g. for storing it.
+  const dsfmt_t & GetState() const { return dsfmt; }
+
+  void SetState(const dsfmt_t & state, unsigned long start_seed);
 
 private:
   /// Support function for Norm01
@@ -66,6 +92,12 @@ private:
   bool          is_initialized_;
 };
 
+/// Standard normal numbers from dsfmt, as RandomGenerator::FillNorm01. The
+/// uniforms used are the same as from scalar draws, so the state may be
+/// shared with them, and filling in parts gives the same numbers.
+void FillNorm01(dsfmt_t * dsfmt, double * out, size_t n);
+void FillNorm01(dsfmt_t * dsfmt, float  * out, size_t n);
+
 }
 
 #endif // NRLIB_RANDOMGENERATOR_H
@@ -0,0 +1,137 @@
+/// Unit tests for jumps, streams and normal numbers of RandomGenerator
+
+#include <nrlib/random/random.hpp>
+#include <nrlib/random/randomgenerator.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <cmath>
+#include <vector>
+
+using namespace NRLib;
+
+BOOST_AUTO_TEST_SUITE( TestRandomGenerator )
+
+BOOST_AUTO_TEST_CASE( JumpMatchesDrawing )
+{
+  const unsigned long long steps[] = { 1, 1000, 2 * DSFMT_N + 5 };
+  const unsigned long      seeds[] = { 1, 4357, 123456789 };
+  for (unsigned long seed : seeds) {
+    for (unsigned long long n_steps : steps) {
+      RandomGenerator drawn(seed);
+      RandomGenerator jumped(seed);
+      for (unsigned long long i = 0; i < 2 * n_steps; i++)
+        drawn.Unif01();
+      jumped.Jump(n_steps);
+      for (int i = 0; i < 100; i++)
+        BOOST_TEST(jumped.Unif01() == drawn.Unif01());
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE( JumpSkipsRestOfBlock )
+{
+  RandomGenerator drawn(17);
+  RandomGenerator jumped(17);
+  for (int i = 0; i < 2 * DSFMT_N + 2 * 50; i++)
+    drawn.Unif01();
+  for (int i = 0; i < 7; i++)
+    jumped.Unif01();
+  jumped.Jump(50);
+  BOOST_TEST(jumped.Unif01() == drawn.Unif01());
+}
+
+BOOST_AUTO_TEST_CASE( JumpsAdd )
+{
+  RandomGenerator a(99);
+  RandomGenerator b(99);
+  a.Jump(3, 62);
+  b.Jump(1, 63);
+  b.Jump(1, 62);
+  for (int i = 0; i < 100; i++)
+    BOOST_TEST(a.Unif01() == b.Unif01());
+}
+
+BOOST_AUTO_TEST_CASE( StreamsAreDistinctAndReproducible )
+{
+  std::vector<RandomGenerator> streams = RandomGenerator::CreateStreams(42, 4);
+  std::vector<RandomGenerator> again   = RandomGenerator::CreateStreams(42, 4);
+  BOOST_TEST(streams.size() == 4U);
+  std::vector<double> first;
+  for (size_t i = 0; i < streams.size(); i++) {
+    BOOST_TEST(streams[i].GetStartSeed() == 42U);
+    double u = streams[i].Unif01();
+    BOOST_TEST(again[i].Unif01() == u);
+    for (double v : first)
+      BOOST_TEST(v != u);
+    first.push_back(u);
+  }
+  BOOST_TEST(first[0] == RandomGenerator(42).Unif01());
+
+  Random::Initialize(again[2]);
+  for (int i = 0; i < 10; i++)
+    BOOST_TEST(Random::Unif01() == streams[2].Unif01());
+}
+
+BOOST_AUTO_TEST_CASE( FillNorm01Moments )
+{
+  RandomGenerator rg(2024);
+  std::vector<double> z(1000001);
+  rg.FillNorm01(&z[0], z.size());
+  double sum   = 0.0;
+  double sum2  = 0.0;
+  double sum4  = 0.0;
+  size_t above = 0;
+  size_t tail  = 0;
+  for (double x : z) {
+    sum  += x;
+    sum2 += x * x;
+    sum4 += x * x * x * x;
+    above += (x > 1.0) ? 1 : 0;
+    tail  += (std::abs(x) > 3.7) ? 1 : 0;
+  }
+  double n = static_cast<double>(z.size());
+  BOOST_TEST(std::abs(sum / n) < 0.005);
+  BOOST_TEST(std::abs(sum2 / n - 1.0) < 0.005);
+  BOOST_TEST(std::abs(sum4 / n - 3.0) < 0.03);
+  // P(x > 1) = 0.158655 and P(|x| > 3.7) = 2.157e-4, beyond the base layer.
+  BOOST_TEST(std::abs(above / n - 0.158655) < 0.002);
+  BOOST_TEST(tail > 160U);
+  BOOST_TEST(tail < 270U);
+}
+
+BOOST_AUTO_TEST_CASE( FillNorm01FollowsUniforms )
+{
+  // After scalar draws, in even chunks, the numbers only depend on the
+  // sequence of uniforms, and the generator continues after them.
+  RandomGenerator a(5);
+  RandomGenerator b(5);
+  a.Unif01();
+  b.Unif01();
+  std::vector<double> whole(5000);
+  std::vector<double> parts(5000);
+  a.FillNorm01(&whole[0], 5000);
+  b.FillNorm01(&parts[0], 1000);
+  b.FillNorm01(&parts[1000], 4000);
+  for (size_t i = 0; i < whole.size(); i++)
+    BOOST_TEST(whole[i] == parts[i]);
+  BOOST_TEST(a.Unif01() == b.Unif01());
+
+  // The same numbers one at a time, from scalar draws only.
+  RandomGenerator c(5);
+  c.Unif01();
+  for (size_t i = 0; i < 5000; i++) {
+    double z;
+    c.FillNorm01(&z, 1);
+    BOOST_TEST(z == whole[i]);
+  }
+
+  std::vector<float> single(5000);
+  RandomGenerator d(5);
+  d.Unif01();
+  d.FillNorm01(&single[0], single.size());
+  for (size_t i = 0; i < whole.size(); i++)
+    BOOST_TEST(single[i] == static_cast<float>(whole[i]));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
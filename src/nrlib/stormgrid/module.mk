@@ -1,2 +1,3 @@
 SRC += $(NRLIB_BASE_DIR)stormgrid/stormfaciesgrid.cpp \
-       $(NRLIB_BASE_DIR)stormgrid/stormcontgrid.cpp
\ No newline at end of file
+       $(NRLIB_BASE_DIR)stormgrid/stormcontgrid.cpp \
+       $(NRLIB_BASE_DIR)stormgrid/stormcontgridwriter.cpp
\ No newline at end of file
@@ -185,15 +185,8 @@ void StormContGrid::WriteToFile(const std::string& filename, const std::string&
   file.precision(4);
 
   // Header
-  if (predefinedHeader == "" && plainAscii==false) {
-    file << format_desc[file_format_] << "\n\n"
-         << zone_number_ << " " << model_file_name_ << " "
-         << missing_code_ << "\n\n" << variable_name_ << "\n\n" ;
-
-    WriteVolumeToFile(file, filename, remove_path);
-    file << "\n";
-    file << GetNI() << " " << GetNJ() << " " << GetNK() << "\n";
-  }
+  if (predefinedHeader == "" && plainAscii==false)
+    WriteHeader(file, filename, GetNI(), GetNJ(), GetNK(), remove_path);
   else
     file << predefinedHeader;
   // Data
@@ -220,6 +213,22 @@ void StormContGrid::WriteToFile(const std::string& filename, const std::string&
     file << 0;
 }
 
+void StormContGrid::WriteHeader(std::ofstream     & file,
+                                const std::string & filename,
+                                size_t              ni,
+                                size_t              nj,
+                                size_t              nk,
+                                bool                remove_path) const
+{
+  file << format_desc[file_format_] << "\n\n"
+       << zone_number_ << " " << model_file_name_ << " "
+       << missing_code_ << "\n\n" << variable_name_ << "\n\n" ;
+
+  WriteVolumeToFile(file, filename, remove_path);
+  file << "\n";
+  file << ni << " " << nj << " " << nk << "\n";
+}
+
 void StormContGrid::WriteToSgriFile(const std::string & file_name,
                                     const std::string & file_name_header,
                                     const std::string & label,
@@ -80,6 +80,15 @@ namespace NRLib {
                      Endianess file_format = END_BIG_ENDIAN,
                      bool remove_path = true) const;
 
+    /// Write the header of a grid with ni x nj x nk cells, taking volume, missing
+    /// code etc. from this grid. Used by StormContGridWriter.
+    void WriteHeader(std::ofstream     & file,
+                     const std::string & filename,
+                     size_t              ni,
+                     size_t              nj,
+                     size_t              nk,
+                     bool                remove_path = true) const;
+
     void WriteToSgriFile(const std::string & file_name,
                          const std::string & file_name_header,
                          const std::string & label,
@@ -0,0 +1,105 @@
+// Copyright (c)  2011, Norwegian Computing Center
+// All rights reserved.
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+// •  Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+// •  Redistributions in binary form must reproduce the above copyright notice, this list of
+//    conditions and the following disclaimer in the documentation and/or other materials
+//    provided with the distribution.
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+// OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include "stormcontgridwriter.hpp"
+
+#include "../exception/exception.hpp"
+#include "../iotools/fileio.hpp"
+#include "../iotools/stringtools.hpp"
+
+using namespace NRLib;
+
+StormContGridWriter::StormContGridWriter(const std::string   & filename,
+                                         const StormContGrid & header,
+                                         size_t                ni,
+                                         size_t                nj,
+                                         size_t                nk,
+                                         Endianess             file_format,
+                                         bool                  remove_path)
+  : format_(header.GetFormat()),
+    endianess_(file_format),
+    ni_(ni),
+    nj_(nj),
+    nk_(nk),
+    layers_written_(0),
+    n_data_(0),
+    closed_(false)
+{
+  OpenWrite(file_, filename, std::ios::out | std::ios::binary);
+  // Same as StormContGrid::WriteToFile
+  file_.precision(4);
+  header.WriteHeader(file_, filename, ni, nj, nk, remove_path);
+}
+
+
+StormContGridWriter::~StormContGridWriter()
+{
+  // Do not throw from the destructor. An incomplete file is left as it is.
+  if (!closed_ && layers_written_ == nk_) {
+    try {
+      Close();
+    }
+    catch (...) {}
+  }
+}
+
+
+void StormContGridWriter::WriteLayer(const std::vector<float> & values)
+{
+  if (closed_)
+    throw Exception("Can not write to a closed Storm grid file.");
+  if (layers_written_ >= nk_)
+    throw Exception("All " + ToString(nk_) + " layers of the Storm grid have already been written.");
+  if (values.size() != ni_ * nj_)
+    throw Exception("A layer of the Storm grid must have " + ToString(ni_ * nj_) + " values, got "
+                    + ToString(values.size()) + ".");
+
+  switch (format_) {
+  case StormContGrid::STORM_BINARY:
+    if (!values.empty())
+      WriteBinaryFloatArray(file_, values.begin(), values.end(), endianess_);
+    break;
+  case StormContGrid::STORM_ASCII:
+    for (size_t i = 0; i < values.size(); ++i) {
+      file_ << values[i] << " ";
+      ++n_data_;
+      if (n_data_ % 10 == 0) {
+        file_ << "\n";
+      }
+    }
+    break;
+  default:
+    throw Exception("Unknown fileformat");
+  }
+  ++layers_written_;
+}
+
+
+void StormContGridWriter::Close()
+{
+  if (closed_)
+    return;
+  if (layers_written_ != nk_)
+    throw Exception("Only " + ToString(layers_written_) + " of " + ToString(nk_)
+                    + " layers of the Storm grid have been written.");
+  // Final 0 (Number of barriers)
+  file_ << 0;
+  file_.close();
+  closed_ = true;
+}
@@ -0,0 +1,76 @@
+// Copyright (c)  2011, Norwegian Computing Center
+// All rights reserved.
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+// •  Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+// •  Redistributions in binary form must reproduce the above copyright notice, this list of
+//    conditions and the following disclaimer in the documentation and/or other materials
+//    provided with the distribution.
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+// OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef NRLIB_STORMCONTGRIDWRITER_HPP
+#define NRLIB_STORMCONTGRIDWRITER_HPP
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "stormcontgrid.hpp"
+
+namespace NRLib {
+  /// Writes a StormContGrid file one layer (fixed k) at a time, so that the
+  /// complete grid never has to be held in memory. The file is identical to
+  /// the one written by StormContGrid::WriteToFile.
+  class StormContGridWriter {
+  public:
+    /// \param header Grid with the volume, missing code, format, variable name
+    ///               etc. of the file. Its values are not used, so it may be empty.
+    /// \throw IOError if the file can not be opened.
+    StormContGridWriter(const std::string   & filename,
+                        const StormContGrid & header,
+                        size_t                ni,
+                        size_t                nj,
+                        size_t                nk,
+                        Endianess             file_format = END_BIG_ENDIAN,
+                        bool                  remove_path = true);
+
+    ~StormContGridWriter();
+
+    /// Write the next layer. value (i, j) is values[i + j*ni].
+    void WriteLayer(const std::vector<float> & values);
+
+    /// Write the end of the file and close it.
+    /// \throw Exception if not all layers have been written.
+    void Close();
+
+    size_t GetNI() const { return ni_; }
+    size_t GetNJ() const { return nj_; }
+    size_t GetNK() const { return nk_; }
+
+  private:
+    std::ofstream             file_;
+    StormContGrid::FileFormat format_;
+    Endianess                 endianess_;
+    size_t                    ni_;
+    size_t                    nj_;
+    size_t                    nk_;
+    size_t                    layers_written_;
+    size_t                    n_data_;
+    bool                      closed_;
+
+    // Make copying illegal.
+    StormContGridWriter(const StormContGridWriter &);
+    StormContGridWriter & operator=(const StormContGridWriter &);
+  };
+}
+
+#endif // NRLIB_STORMCONTGRIDWRITER_HPP
@@ -0,0 +1,110 @@
+/// \file Unit tests for writing StormContGrid files layer by layer
+///       using StormContGridWriter.
+
+#include <nrlib/stormgrid/stormcontgrid.hpp>
+#include <nrlib/stormgrid/stormcontgridwriter.hpp>
+#include <nrlib/exception/exception.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/test/unit_test.hpp>
+
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+using namespace NRLib;
+using namespace boost::filesystem;
+
+namespace {
+  std::string ReadAll(const path& filepath)
+  {
+    std::ifstream file(filepath.c_str(), std::ios::binary | std::ios::in);
+    return std::string(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+  }
+
+  void WriteLayered(const path& filepath, const StormContGrid& grid)
+  {
+    size_t ni = grid.GetNI();
+    size_t nj = grid.GetNJ();
+    size_t nk = grid.GetNK();
+    StormContGridWriter writer(filepath.string(), grid, ni, nj, nk);
+    std::vector<float> layer(ni*nj);
+    for (size_t k = 0; k < nk; ++k) {
+      for (size_t j = 0; j < nj; ++j)
+        for (size_t i = 0; i < ni; ++i)
+          layer[i + j*ni] = grid(i, j, k);
+      writer.WriteLayer(layer);
+    }
+    writer.Close();
+  }
+}
+
+BOOST_AUTO_TEST_SUITE(StormContGridWriterTest)
+
+BOOST_AUTO_TEST_CASE(LayeredFileEqualsWriteToFile)
+{
+  path reference = temp_directory_path() / "test_stormcontgrid_reference.storm";
+  path layered   = temp_directory_path() / "test_stormcontgrid_layered.storm";
+
+  Volume volume(10.0, 20.0, 5.0, 40.0, 30.0, 6.0, 0.3);
+  StormContGrid grid(volume, 4, 3, 2);
+  for (size_t k = 0; k < 2; ++k)
+    for (size_t j = 0; j < 3; ++j)
+      for (size_t i = 0; i < 4; ++i)
+        grid(i, j, k) = static_cast<float>(i + 10*j + 100*k) + 0.25f;
+  grid.SetMissingCode(-999.0f);
+
+  grid.WriteToFile(reference.string());
+  WriteLayered(layered, grid);
+
+  BOOST_CHECK(ReadAll(reference) == ReadAll(layered));
+
+  StormContGrid read_back(layered.string());
+  BOOST_CHECK_EQUAL(read_back.GetNI(), 4u);
+  BOOST_CHECK_EQUAL(read_back.GetNJ(), 3u);
+  BOOST_CHECK_EQUAL(read_back.GetNK(), 2u);
+  BOOST_CHECK_EQUAL(read_back(3, 2, 1), grid(3, 2, 1));
+  BOOST_CHECK_EQUAL(read_back(1, 0, 0), grid(1, 0, 0));
+
+  remove(reference);
+  remove(layered);
+}
+
+BOOST_AUTO_TEST_CASE(LayeredAsciiFileEqualsWriteToFile)
+{
+  path reference = temp_directory_path() / "test_stormcontgrid_reference_ascii.storm";
+  path layered   = temp_directory_path() / "test_stormcontgrid_layered_ascii.storm";
+
+  Volume volume(0.0, 0.0, 0.0, 12.0, 8.0, 3.0, 0.0);
+  StormContGrid grid(volume, 6, 4, 3);
+  for (size_t k = 0; k < 3; ++k)
+    for (size_t j = 0; j < 4; ++j)
+      for (size_t i = 0; i < 6; ++i)
+        grid(i, j, k) = 0.5f * static_cast<float>(i + 6*j + 24*k);
+  grid.SetFormat(StormContGrid::STORM_ASCII);
+
+  grid.WriteToFile(reference.string());
+  WriteLayered(layered, grid);
+
+  BOOST_CHECK(ReadAll(reference) == ReadAll(layered));
+
+  remove(reference);
+  remove(layered);
+}
+
+BOOST_AUTO_TEST_CASE(WrongLayerSizeThrows)
+{
+  path filepath = temp_directory_path() / "test_stormcontgrid_wrong_size.storm";
+  StormContGrid header(Volume(0.0, 0.0, 0.0, 1.0, 1.0, 1.0, 0.0), 0, 0, 0);
+  {
+    StormContGridWriter writer(filepath.string(), header, 2, 2, 1);
+    BOOST_CHECK_THROW(writer.WriteLayer(std::vector<float>(3)), Exception);
+    BOOST_CHECK_THROW(writer.Close(), Exception);
+    writer.WriteLayer(std::vector<float>(4));
+    BOOST_CHECK_THROW(writer.WriteLayer(std::vector<float>(4)), Exception);
+    writer.Close();
+  }
+  remove(filepath);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,307 @@
+// Copyright (c)  2011, Norwegian Computing Center
+// All rights reserved.
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+// •  Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+// •  Redistributions in binary form must reproduce the above copyright notice, this list of
+//    conditions and the following disclaimer in the documentation and/or other materials
+//    provided with the distribution.
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+// OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <list>
+#include <mutex>
+#include <thread>
+
+#include "eclipsegridsampling.hpp"
+#include "gaussianfield.hpp"
+#include "variogram.hpp"
+
+#include "../eclipsegrid/eclipsegeometry.hpp"
+#include "../exception/exception.hpp"
+#include "../geometry/point.hpp"
+#include "../profiling/profiling.hpp"
+
+using namespace NRLib;
+
+namespace {
+  // 64-bit FNV-1a hash of the geometry and box increments
+  class GeometryHash {
+  public:
+    GeometryHash() : hash_(14695981039346656037ULL) {}
+
+    void Add(const void * data, size_t size)
+    {
+      const unsigned char * bytes = static_cast<const unsigned char *>(data);
+      for (size_t i = 0; i < size; i++) {
+        hash_ ^= bytes[i];
+        hash_ *= 1099511628211ULL;
+      }
+    }
+
+    void Add(double value)  { Add(&value, sizeof(value)); }
+    void Add(size_t value)  { Add(&value, sizeof(value)); }
+
+    std::uint64_t Get() const { return hash_; }
+
+  private:
+    std::uint64_t hash_;
+  };
+
+  std::uint64_t HashGeometry(const EclipseGeometry & geometry, double dx, double dy, double dz)
+  {
+    GeometryHash hash;
+    size_t ni = geometry.GetNI();
+    size_t nj = geometry.GetNJ();
+    size_t nk = geometry.GetNK();
+    hash.Add(ni);
+    hash.Add(nj);
+    hash.Add(nk);
+    hash.Add(dx);
+    hash.Add(dy);
+    hash.Add(dz);
+    for (size_t j = 0; j <= nj; j++) {
+      for (size_t i = 0; i <= ni; i++) {
+        const Point & p1 = geometry.GetPillar(i, j).GetPt1();
+        const Point & p2 = geometry.GetPillar(i, j).GetPt2();
+        double coords[6] = { p1.x, p1.y, p1.z, p2.x, p2.y, p2.z };
+        hash.Add(coords, sizeof(coords));
+      }
+    }
+    for (size_t k = 0; k < nk; k++) {
+      for (size_t j = 0; j < nj; j++) {
+        for (size_t i = 0; i < ni; i++) {
+          unsigned char active = geometry.IsActive(i, j, k) ? 1 : 0;
+          hash.Add(&active, 1);
+          if (!active)
+            continue;
+          double z[8];
+          for (size_t c = 0; c < 8; c++)
+            z[c] = geometry.GetZCorner(i, j, k, c % 2, (c / 2) % 2, c / 4);
+          hash.Add(z, sizeof(z));
+        }
+      }
+    }
+    return hash.Get();
+  }
+
+  // Number of nodes needed to cover [min, max] with spacing d, at least 2
+  // so that every point has a node on each side.
+  size_t CoveringNodes(double min, double max, double d)
+  {
+    return static_cast<size_t>(std::floor((max - min) / d)) + 2;
+  }
+
+  // Lower node and weight of the upper node of x in a grid with n nodes.
+  void FindNode(double x, double x0, double d, size_t n, size_t & node, double & w)
+  {
+    double t = (x - x0) / d;
+    node = std::min(static_cast<size_t>(std::max(std::floor(t), 0.0)), n - 2);
+    w    = std::min(std::max(t - static_cast<double>(node), 0.0), 1.0);
+  }
+
+  // Interpolates the active cells of sampling in one layer of a streamed field.
+  class SamplingSink : public GaussianFieldSink {
+  public:
+    SamplingSink(const EclipseGridSampling & sampling, double * values_out)
+      : sampling_(sampling), values_out_(values_out), values_(NULL) {}
+
+    void BeginField(int m)
+    {
+      values_ = values_out_ + static_cast<size_t>(m) * sampling_.GetN();
+      std::fill(values_, values_ + sampling_.GetN(), 0.0);
+    }
+
+    void AddLayer(size_t k, size_t /*ni*/, size_t /*nj*/, const double * values, size_t stride)
+    {
+      sampling_.AddLayer(k, values, stride, values_);
+    }
+
+    void AddLayer(size_t k, size_t /*ni*/, size_t /*nj*/, const float * values, size_t stride)
+    {
+      sampling_.AddLayer(k, values, stride, values_);
+    }
+
+  private:
+    const EclipseGridSampling & sampling_;
+    double                    * values_out_;
+    double                    * values_;
+  };
+}
+
+EclipseGridSampling::EclipseGridSampling(const EclipseGeometry & geometry, double dx, double dy, double dz)
+{
+  if (dx <= 0.0 || dy <= 0.0 || dz <= 0.0)
+    throw Exception("The increments of the simulation box must be positive.");
+
+  for (size_t index = 0; index < geometry.GetN(); index++) {
+    if (geometry.IsActive(index))
+      active_.push_back(index);
+  }
+  if (active_.empty())
+    throw Exception("The grid has no active cells.");
+
+  {
+    Profiling::ScopedTimer timer("cell_centers");
+    size_t n         = active_.size();
+    centers_.resize(3 * n);
+    size_t n_threads = std::min<size_t>(std::max(1U, std::thread::hardware_concurrency()), (n + 4095) / 4096);
+    auto find_centers = [&](size_t begin, size_t end) {
+      for (size_t c = begin; c < end; c++) {
+        size_t i, j, k;
+        geometry.GetIJK(active_[c], i, j, k);
+        Point p = geometry.FindCellCenterPoint(i, j, k);
+        centers_[3 * c]     = p.x;
+        centers_[3 * c + 1] = p.y;
+        centers_[3 * c + 2] = p.z;
+      }
+    };
+    if (n_threads <= 1) {
+      find_centers(0, n);
+    }
+    else {
+      size_t size = (n + n_threads - 1) / n_threads;
+      std::vector<std::thread> threads;
+      for (size_t begin = 0; begin < n; begin += size)
+        threads.push_back(std::thread(find_centers, begin, std::min(n, begin + size)));
+      for (size_t t = 0; t < threads.size(); t++)
+        threads[t].join();
+    }
+  }
+  SetupBox(dx, dy, dz);
+}
+
+std::shared_ptr<const EclipseGridSampling>
+EclipseGridSampling::Get(const EclipseGeometry & geometry, double dx, double dy, double dz)
+{
+  typedef std::pair<std::uint64_t, std::shared_ptr<const EclipseGridSampling> > Entry;
+  static std::mutex       mutex;
+  static std::list<Entry> cache;
+  const size_t            max_entries = 4;
+
+  std::uint64_t key = HashGeometry(geometry, dx, dy, dz);
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (std::list<Entry>::iterator it = cache.begin(); it != cache.end(); ++it) {
+      if (it->first == key) {
+        cache.splice(cache.begin(), cache, it);
+        return cache.front().second;
+      }
+    }
+  }
+  std::shared_ptr<const EclipseGridSampling> sampling(new EclipseGridSampling(geometry, dx, dy, dz));
+  std::lock_guard<std::mutex> lock(mutex);
+  cache.push_front(Entry(key, sampling));
+  if (cache.size() > max_entries)
+    cache.pop_back();
+  return sampling;
+}
+
+void EclipseGridSampling::SetupBox(double dx, double dy, double dz)
+{
+  size_t n = active_.size();
+  double min[3], max[3];
+  for (size_t d = 0; d < 3; d++)
+    min[d] = max[d] = centers_[d];
+  for (size_t c = 0; c < n; c++) {
+    for (size_t d = 0; d < 3; d++) {
+      min[d] = std::min(min[d], centers_[3 * c + d]);
+      max[d] = std::max(max[d], centers_[3 * c + d]);
+    }
+  }
+  dx_ = dx;
+  dy_ = dy;
+  dz_ = dz;
+  x0_ = min[0];
+  y0_ = min[1];
+  z0_ = min[2];
+  nx_ = CoveringNodes(min[0], max[0], dx);
+  ny_ = CoveringNodes(min[1], max[1], dy);
+  nz_ = CoveringNodes(min[2], max[2], dz);
+
+  node_.resize(n);
+  wx_.resize(n);
+  wy_.resize(n);
+  wz_.resize(n);
+  std::vector<size_t> layer(n);
+  layer_start_.assign(nz_ + 1, 0);
+  for (size_t c = 0; c < n; c++) {
+    size_t i, j;
+    FindNode(centers_[3 * c],     x0_, dx_, nx_, i,        wx_[c]);
+    FindNode(centers_[3 * c + 1], y0_, dy_, ny_, j,        wy_[c]);
+    FindNode(centers_[3 * c + 2], z0_, dz_, nz_, layer[c], wz_[c]);
+    node_[c] = i + j * nx_;
+    layer_start_[layer[c] + 1]++;
+  }
+  for (size_t k = 0; k < nz_; k++)
+    layer_start_[k + 1] += layer_start_[k];
+
+  // Counting sort on the layer, keeping the order of the cells in each layer.
+  by_layer_.resize(n);
+  std::vector<size_t> next(layer_start_.begin(), layer_start_.end() - 1);
+  for (size_t c = 0; c < n; c++)
+    by_layer_[next[layer[c]]++] = c;
+}
+
+template <typename T>
+void EclipseGridSampling::AddLayer(size_t k, const T * layer, size_t stride, double * values_out) const
+{
+  // Cells below layer k get weight wz, and cells above get 1 - wz.
+  for (size_t side = 0; side < 2; side++) {
+    if (side == 1 && k == 0)
+      break;
+    size_t lower = (side == 0) ? k : k - 1;
+    if (lower + 1 >= layer_start_.size())
+      continue;
+    for (size_t n = layer_start_[lower]; n < layer_start_[lower + 1]; n++) {
+      size_t c  = by_layer_[n];
+      size_t i  = node_[c] % nx_;
+      size_t j  = node_[c] / nx_;
+      double wx = wx_[c];
+      double wy = wy_[c];
+      const T * row0 = layer + i + j * stride;
+      const T * row1 = row0 + stride;
+      double value = (1.0 - wy) * ((1.0 - wx) * row0[0] + wx * row0[1])
+                   + wy         * ((1.0 - wx) * row1[0] + wx * row1[1]);
+      values_out[c] += ((side == 0) ? 1.0 - wz_[c] : wz_[c]) * value;
+    }
+  }
+}
+
+template void EclipseGridSampling::AddLayer<double>(size_t k, const double * layer, size_t stride, double * values_out) const;
+template void EclipseGridSampling::AddLayer<float>(size_t k, const float * layer, size_t stride, double * values_out) const;
+
+void EclipseGridSampling::Sample(const double * box, double * values_out) const
+{
+  std::fill(values_out, values_out + GetN(), 0.0);
+  for (size_t k = 0; k < nz_; k++)
+    AddLayer(k, box + k * nx_ * ny_, nx_, values_out);
+}
+
+void NRLib::SimulateGaussianFieldOnEclipseGrid(const Variogram             & variogram,
+                                               const EclipseGridSampling   & sampling,
+                                               int                           n_fields,
+                                               double                      * values_out,
+                                               GaussianFieldPlan::Strategy   strategy)
+{
+  SamplingSink sink(sampling, values_out);
+  Simulate3DGaussianField(variogram,
+                          sampling.GetNX(), sampling.GetDX(),
+                          sampling.GetNY(), sampling.GetDY(),
+                          sampling.GetNZ(), sampling.GetDZ(),
+                          n_fields, sink,
+                          -1, -1, -1, 1.0, 1.0, 1.0,
+                          strategy);
+}
@@ -0,0 +1,118 @@
+// Copyright (c)  2011, Norwegian Computing Center
+// All rights reserved.
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+// •  Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+// •  Redistributions in binary form must reproduce the above copyright notice, this list of
+//    conditions and the following disclaimer in the documentation and/or other materials
+//    provided with the distribution.
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+// OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef NRLIB_VARIOGRAM_ECLIPSEGRIDSAMPLING_HPP
+#define NRLIB_VARIOGRAM_ECLIPSEGRIDSAMPLING_HPP
+
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+#include "gaussianfieldplan.hpp"
+
+namespace NRLib {
+  class EclipseGeometry;
+  class Variogram;
+
+  /// Sampling of a regular simulation box at the active cell centers of a
+  /// corner-point grid. The box is axis aligned, with node (i, j, k) at
+  /// (x0 + i*dx, y0 + j*dy, z0 + k*dz), and just covers the centers. Each
+  /// active cell stores the box node below its center and the trilinear
+  /// weights, so that a realization is sampled without searching the box.
+  class EclipseGridSampling {
+  public:
+    /// Finds the centers of the active cells, in parallel, and the box.
+    EclipseGridSampling(const EclipseGeometry & geometry, double dx, double dy, double dz);
+
+    /// As the constructor, but the last few samplings are kept, keyed on
+    /// the pillars, z-corners and active cells of the geometry, so that
+    /// repeated simulations on the same grid do not find the centers again.
+    static std::shared_ptr<const EclipseGridSampling> Get(const EclipseGeometry & geometry,
+                                                          double                  dx,
+                                                          double                  dy,
+                                                          double                  dz);
+
+    /// Number of active cells.
+    size_t GetN()  const { return active_.size(); }
+    size_t GetNX() const { return nx_; }
+    size_t GetNY() const { return ny_; }
+    size_t GetNZ() const { return nz_; }
+    double GetDX() const { return dx_; }
+    double GetDY() const { return dy_; }
+    double GetDZ() const { return dz_; }
+    double GetX0() const { return x0_; }
+    double GetY0() const { return y0_; }
+    double GetZ0() const { return z0_; }
+
+    /// Geometry index (i + j*ni + k*ni*nj) of each active cell.
+    const std::vector<size_t> & GetActiveIndices() const { return active_; }
+    /// x, y and z of the center of each active cell.
+    const std::vector<double> & GetCellCenters()   const { return centers_; }
+
+    /// Interpolates box, with value (i, j, k) at i + j*nx + k*nx*ny, at the
+    /// active cells. values_out must hold GetN() values.
+    void Sample(const double * box, double * values_out) const;
+
+    /// Adds the contribution of layer k of the box to the active cells,
+    /// where value (i, j) of the layer is layer[i + j*stride]. Adding all
+    /// layers to values_out, starting with zeros, is the same as Sample.
+    template <typename T>
+    void AddLayer(size_t k, const T * layer, size_t stride, double * values_out) const;
+
+  private:
+    /// Finds the box and the interpolation weights from the centers.
+    void SetupBox(double dx, double dy, double dz);
+
+    std::vector<size_t> active_;
+    std::vector<double> centers_;
+
+    size_t nx_;
+    size_t ny_;
+    size_t nz_;
+    double dx_;
+    double dy_;
+    double dz_;
+    double x0_;
+    double y0_;
+    double z0_;
+
+    /// Index i + j*nx of the box node below each active cell, and weights
+    /// of the nodes above in each direction.
+    std::vector<size_t> node_;
+    std::vector<double> wx_;
+    std::vector<double> wy_;
+    std::vector<double> wz_;
+    /// Active cells ordered by the layer of the node below them, with the
+    /// cells of layer k from layer_start_[k] to layer_start_[k + 1].
+    std::vector<size_t> by_layer_;
+    std::vector<size_t> layer_start_;
+  };
+
+  /// Simulate n_fields fields on the box of sampling, and interpolate them
+  /// at the active cells. Field m is written to values_out + m*sampling.GetN().
+  /// The box is passed one layer at a time from the FFT grid, so it is never
+  /// stored. The padding is found as for Simulate3DGaussianField.
+  void SimulateGaussianFieldOnEclipseGrid(const Variogram             & variogram,
+                                          const EclipseGridSampling   & sampling,
+                                          int                           n_fields,
+                                          double                      * values_out,
+                                          GaussianFieldPlan::Strategy   strategy = GaussianFieldPlan::LEAN);
+}
+
+#endif // NRLIB_VARIOGRAM_ECLIPSEGRIDSAMPLING_HPP
@@ -0,0 +1,264 @@
+// Copyright (c)  2011, Norwegian Computing Center
+// All rights reserved.
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+// •  Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+// •  Redistributions in binary form must reproduce the above copyright notice, this list of
+//    conditions and the following disclaimer in the documentation and/or other materials
+//    provided with the distribution.
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+// OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "empiricalvariogrammap.hpp"
+
+#include "../exception/exception.hpp"
+
+using namespace NRLib;
+
+EmpiricalVariogramMap::EmpiricalVariogramMap(size_t       nx,
+                                             double       dx,
+                                             size_t       ny,
+                                             double       dy,
+                                             size_t       nz,
+                                             double       dz,
+                                             const bool * mask)
+  : nx_(nx),
+    ny_(std::max<size_t>(ny, 1)),
+    nz_(std::max<size_t>(nz, 1)),
+    dx_(dx),
+    dy_(dy),
+    dz_(dz),
+    mask_(nx * std::max<size_t>(ny, 1) * std::max<size_t>(nz, 1), 1.0),
+    // Padding of n - 1 gives room for all lags without wrapping around.
+    mz_grid_(nx, std::max<size_t>(ny, 1), std::max<size_t>(nz, 1),
+             nx - 1, std::max<size_t>(ny, 1) - 1, std::max<size_t>(nz, 1) - 1, false),
+    mz2_grid_(nx, std::max<size_t>(ny, 1), std::max<size_t>(nz, 1),
+              nx - 1, std::max<size_t>(ny, 1) - 1, std::max<size_t>(nz, 1) - 1, false),
+    n_realizations_(0)
+{
+  if (nx == 0)
+    throw Exception("The grid of an empirical variogram map must have at least one cell.");
+  if (mask != NULL) {
+    for (size_t i = 0; i < mask_.size(); i++)
+      mask_[i] = mask[i] ? 1.0 : 0.0;
+  }
+
+  size_t nxt = mz_grid_.GetNItot();
+  size_t nyt = mz_grid_.GetNJtot();
+  size_t nzt = mz_grid_.GetNKtot();
+  size_t n_tot = nxt * nyt * nzt;
+  size_t n_complex = mz_grid_.GetComplexNI() * mz_grid_.GetComplexNJ() * mz_grid_.GetComplexNK();
+
+  // Number of pairs, the autocorrelation of the mask.
+  double * real = mz_grid_.RealData();
+  std::fill(real, real + n_tot, 0.0);
+  for (size_t k = 0; k < nz_; k++)
+    for (size_t j = 0; j < ny_; j++)
+      for (size_t i = 0; i < nx_; i++)
+        real[i + nxt * (j + nyt * k)] = mask_[i + nx_ * (j + ny_ * k)];
+  mz_grid_.DoFFT();
+  mask_fft_.assign(mz_grid_.ComplexData(), mz_grid_.ComplexData() + n_complex);
+  for (size_t c = 0; c < n_complex; c++)
+    mz_grid_.ComplexData()[c] = std::norm(mask_fft_[c]);
+  mz_grid_.DoInverseFFT();
+  pair_count_.resize(n_tot);
+  for (size_t i = 0; i < n_tot; i++)
+    pair_count_[i] = std::max(0.0, std::floor(real[i] + 0.5));
+
+  squared_diff_sum_.assign(n_tot, 0.0);
+}
+
+
+void EmpiricalVariogramMap::AddField(const double * field)
+{
+  size_t nxt = mz_grid_.GetNItot();
+  size_t nyt = mz_grid_.GetNJtot();
+  size_t nzt = mz_grid_.GetNKtot();
+  size_t n_tot = nxt * nyt * nzt;
+  size_t n_complex = mz_grid_.GetComplexNI() * mz_grid_.GetComplexNJ() * mz_grid_.GetComplexNK();
+
+  // The variogram does not depend on the mean. Subtracting it reduces the
+  // cancellation in the sums of squares.
+  double sum   = 0.0;
+  double count = 0.0;
+  for (size_t i = 0; i < mask_.size(); i++) {
+    if (mask_[i] != 0.0) {
+      sum   += field[i];
+      count += 1.0;
+    }
+  }
+  double mean = (count > 0.0) ? sum / count : 0.0;
+
+  double * mz  = mz_grid_.RealData();
+  double * mz2 = mz2_grid_.RealData();
+  std::fill(mz,  mz  + n_tot, 0.0);
+  std::fill(mz2, mz2 + n_tot, 0.0);
+  for (size_t k = 0; k < nz_; k++) {
+    for (size_t j = 0; j < ny_; j++) {
+      for (size_t i = 0; i < nx_; i++) {
+        size_t index = i + nx_ * (j + ny_ * k);
+        // Masked cells are skipped rather than multiplied by zero, as they
+        // often hold undefined values.
+        double z     = (mask_[index] != 0.0) ? field[index] - mean : 0.0;
+        mz [i + nxt * (j + nyt * k)] = z;
+        mz2[i + nxt * (j + nyt * k)] = z * z;
+      }
+    }
+  }
+  mz_grid_.DoFFT();
+  mz2_grid_.DoFFT();
+
+  // sum m(x)m(x+h)(z(x+h) - z(x))^2 = corr(m, mz^2) + corr(mz^2, m) - 2 corr(mz, mz),
+  // where corr(a, b)(h) = sum a(x) b(x+h) has the transform conj(A) B.
+  std::complex<double> * p = mz_grid_.ComplexData();
+  std::complex<double> * q = mz2_grid_.ComplexData();
+  for (size_t c = 0; c < n_complex; c++)
+    p[c] = 2.0 * (std::real(std::conj(mask_fft_[c]) * q[c]) - std::norm(p[c]));
+  mz_grid_.DoInverseFFT();
+
+  for (size_t i = 0; i < n_tot; i++)
+    squared_diff_sum_[i] += mz[i];
+  n_realizations_++;
+}
+
+
+size_t EmpiricalVariogramMap::LagIndex(int a, int b, int c) const
+{
+  int nxt = static_cast<int>(mz_grid_.GetNItot());
+  int nyt = static_cast<int>(mz_grid_.GetNJtot());
+  int nzt = static_cast<int>(mz_grid_.GetNKtot());
+  return static_cast<size_t>((a + nxt) % nxt + nxt * ((b + nyt) % nyt + nyt * ((c + nzt) % nzt)));
+}
+
+
+void EmpiricalVariogramMap::GetVariogramMap(Grid<double> & gamma, Grid<double> & pairs) const
+{
+  int nx = static_cast<int>(nx_);
+  int ny = static_cast<int>(ny_);
+  int nz = static_cast<int>(nz_);
+  gamma.Resize(2 * nx_ - 1, 2 * ny_ - 1, 2 * nz_ - 1);
+  pairs.Resize(2 * nx_ - 1, 2 * ny_ - 1, 2 * nz_ - 1);
+  double n_real = static_cast<double>(n_realizations_);
+  for (int c = 1 - nz; c < nz; c++) {
+    for (int b = 1 - ny; b < ny; b++) {
+      for (int a = 1 - nx; a < nx; a++) {
+        size_t index = LagIndex(a, b, c);
+        double n     = n_real * pair_count_[index];
+        pairs(a + nx - 1, b + ny - 1, c + nz - 1) = n;
+        gamma(a + nx - 1, b + ny - 1, c + nz - 1) = (n > 0.0)
+                                                    ? squared_diff_sum_[index] / (2.0 * n)
+                                                    : std::numeric_limits<double>::quiet_NaN();
+      }
+    }
+  }
+}
+
+
+void EmpiricalVariogramMap::GetRadialVariogram(double                bin_width,
+                                               size_t                n_bins,
+                                               std::vector<double> & distance,
+                                               std::vector<double> & gamma,
+                                               std::vector<double> & pairs) const
+{
+  BinLags(bin_width, n_bins, NULL, 0.0, distance, gamma, pairs);
+}
+
+
+void EmpiricalVariogramMap::GetDirectionalVariogram(double                azimuth,
+                                                    double                dip,
+                                                    double                tolerance,
+                                                    double                bin_width,
+                                                    size_t                n_bins,
+                                                    std::vector<double> & distance,
+                                                    std::vector<double> & gamma,
+                                                    std::vector<double> & pairs) const
+{
+  if (tolerance < 0.0)
+    throw Exception("The angle tolerance of a directional variogram can not be negative.");
+  double direction[3] = { std::cos(azimuth) * std::cos(dip),
+                          std::sin(azimuth) * std::cos(dip),
+                          std::sin(dip) };
+  double min_cos = std::cos(std::min(tolerance, 0.5 * std::acos(-1.0)));
+  BinLags(bin_width, n_bins, direction, min_cos, distance, gamma, pairs);
+}
+
+
+void EmpiricalVariogramMap::BinLags(double                bin_width,
+                                    size_t                n_bins,
+                                    const double        * direction,
+                                    double                min_cos,
+                                    std::vector<double> & distance,
+                                    std::vector<double> & gamma,
+                                    std::vector<double> & pairs) const
+{
+  if (bin_width <= 0.0)
+    throw Exception("The bin width of an empirical variogram must be positive.");
+
+  int nx = static_cast<int>(nx_);
+  int ny = static_cast<int>(ny_);
+  int nz = static_cast<int>(nz_);
+  double hx = (nx - 1) * dx_;
+  double hy = (ny - 1) * dy_;
+  double hz = (nz - 1) * dz_;
+  if (n_bins == 0)
+    n_bins = static_cast<size_t>(std::sqrt(hx * hx + hy * hy + hz * hz) / bin_width) + 1;
+
+  std::vector<double> diff_sum(n_bins, 0.0);
+  std::vector<double> distance_sum(n_bins, 0.0);
+  std::vector<double> pair_sum(n_bins, 0.0);
+  // Tolerance for the angle test, for lags exactly on the edge.
+  const double eps = 1e-12;
+  for (int c = 1 - nz; c < nz; c++) {
+    for (int b = 1 - ny; b < ny; b++) {
+      for (int a = 1 - nx; a < nx; a++) {
+        size_t index = LagIndex(a, b, c);
+        double n     = pair_count_[index];
+        if (n <= 0.0 || (a == 0 && b == 0 && c == 0))
+          continue;
+        double x    = a * dx_;
+        double y    = b * dy_;
+        double z    = c * dz_;
+        double dist = std::sqrt(x * x + y * y + z * z);
+        size_t bin  = static_cast<size_t>(dist / bin_width);
+        if (bin >= n_bins)
+          continue;
+        if (direction != NULL
+            && std::abs(x * direction[0] + y * direction[1] + z * direction[2]) < (min_cos - eps) * dist)
+          continue;
+        diff_sum[bin]     += squared_diff_sum_[index];
+        distance_sum[bin] += n * dist;
+        pair_sum[bin]     += n;
+      }
+    }
+  }
+
+  // Each pair of cells is counted for both h and -h.
+  double n_real = static_cast<double>(n_realizations_);
+  distance.resize(n_bins);
+  gamma.resize(n_bins);
+  pairs.resize(n_bins);
+  for (size_t bin = 0; bin < n_bins; bin++) {
+    pairs[bin] = 0.5 * n_real * pair_sum[bin];
+    if (pair_sum[bin] > 0.0) {
+      distance[bin] = distance_sum[bin] / pair_sum[bin];
+      gamma[bin]    = (n_real > 0.0) ? diff_sum[bin] / (2.0 * n_real * pair_sum[bin])
+                                     : std::numeric_limits<double>::quiet_NaN();
+    }
+    else {
+      distance[bin] = std::numeric_limits<double>::quiet_NaN();
+      gamma[bin]    = std::numeric_limits<double>::quiet_NaN();
+    }
+  }
+}
@@ -0,0 +1,129 @@
+// Copyright (c)  2011, Norwegian Computing Center
+// All rights reserved.
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+// •  Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+// •  Redistributions in binary form must reproduce the above copyright notice, this list of
+//    conditions and the following disclaimer in the documentation and/or other materials
+//    provided with the distribution.
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+// OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef NRLIB_VARIOGRAM_EMPIRICALVARIOGRAMMAP_HPP
+#define NRLIB_VARIOGRAM_EMPIRICALVARIOGRAMMAP_HPP
+
+#include <cstdlib>
+#include <vector>
+
+#include "../fft/fftgrid3d.hpp"
+#include "../grid/grid.hpp"
+
+namespace NRLib {
+  /// Empirical variogram map of gridded fields, accumulated over a stream of
+  /// realizations. For each lag h, the map is
+  ///
+  ///   gamma(h) = sum (z(x + h) - z(x))^2 / (2 N(h)),
+  ///
+  /// summed over all pairs of active cells and all realizations, where N(h)
+  /// is the number of pairs. The sums are computed from zero-padded FFT
+  /// autocorrelations of the mask, m*z and m*z^2, so that each realization
+  /// costs two forward and one inverse transform of a grid of about twice
+  /// the size in each direction, instead of a loop over all pairs.
+  class EmpiricalVariogramMap {
+  public:
+    /// ny and/or nz may be 1. mask, if given, has nx*ny*nz values with i
+    /// running fastest, and only cells where it is true are used.
+    EmpiricalVariogramMap(size_t       nx,
+                          double       dx,
+                          size_t       ny   = 1,
+                          double       dy   = 1.0,
+                          size_t       nz   = 1,
+                          double       dz   = 1.0,
+                          const bool * mask = NULL);
+
+    /// Adds a realization with nx*ny*nz values, i running fastest.
+    void   AddField(const double * field);
+
+    size_t GetNRealizations() const { return n_realizations_; }
+    size_t GetNX()            const { return nx_; }
+    size_t GetNY()            const { return ny_; }
+    size_t GetNZ()            const { return nz_; }
+
+    /// Variogram and number of pairs for lags (a, b, c) with |a| < nx,
+    /// |b| < ny and |c| < nz, for all realizations. Lag (a, b, c) is stored
+    /// in cell (a + nx - 1, b + ny - 1, c + nz - 1). Lags without pairs get NaN.
+    void   GetVariogramMap(Grid<double> & gamma, Grid<double> & pairs) const;
+
+    /// Omnidirectional variogram in bins of bin_width by lag distance. Bin
+    /// b holds lags with distance in [b, b+1)*bin_width, except zero. With
+    /// n_bins = 0, the bins cover all lags. The variogram of a bin is the
+    /// pair-weighted mean over its lags, and distance is the pair-weighted
+    /// mean distance. Empty bins get NaN. pairs counts each pair of cells
+    /// once per realization.
+    void   GetRadialVariogram(double                bin_width,
+                              size_t                n_bins,
+                              std::vector<double> & distance,
+                              std::vector<double> & gamma,
+                              std::vector<double> & pairs) const;
+
+    /// As GetRadialVariogram, for lags within tolerance (radians) of the
+    /// direction given by azimuth and dip (radians), in either sense. The
+    /// direction is the main range direction of a Variogram with the same
+    /// angles.
+    void   GetDirectionalVariogram(double                azimuth,
+                                   double                dip,
+                                   double                tolerance,
+                                   double                bin_width,
+                                   size_t                n_bins,
+                                   std::vector<double> & distance,
+                                   std::vector<double> & gamma,
+                                   std::vector<double> & pairs) const;
+
+  private:
+    /// Bins the lags. If direction is not NULL, only lags with
+    /// |cos(angle to direction)| >= min_cos are used.
+    void   BinLags(double                bin_width,
+                   size_t                n_bins,
+                   const double        * direction,
+                   double                min_cos,
+                   std::vector<double> & distance,
+                   std::vector<double> & gamma,
+                   std::vector<double> & pairs) const;
+
+    /// Index of lag (a, b, c) in the padded grids, |a| < nx etc.
+    size_t LagIndex(int a, int b, int c) const;
+
+    size_t nx_;
+    size_t ny_;
+    size_t nz_;
+    double dx_;
+    double dy_;
+    double dz_;
+    std::vector<double> mask_;
+
+    /// Work grids for m*z and m*z^2, large enough to avoid circular effects.
+    FFTGrid3D<double>   mz_grid_;
+    FFTGrid3D<double>   mz2_grid_;
+    /// Transform of the mask
+    std::vector<std::complex<double> > mask_fft_;
+    /// Number of pairs for each lag, in the padded layout.
+    std::vector<double> pair_count_;
+    /// Sum over realizations of sum (z(x + h) - z(x))^2, in the padded layout.
+    std::vector<double> squared_diff_sum_;
+    size_t              n_realizations_;
+
+    // Make copying illegal.
+    EmpiricalVariogramMap(const EmpiricalVariogramMap &);
+    EmpiricalVariogramMap & operator=(const EmpiricalVariogramMap &);
+  };
+}
+
+#endif // NRLIB_VARIOGRAM_EMPIRICALVARIOGRAMMAP_HPP
@@ -0,0 +1,148 @@
+// Copyright (c)  2011, Norwegian Computing Center
+// All rights reserved.
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+// •  Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+// •  Redistributions in binary form must reproduce the above copyright notice, this list of
+//    conditions and the following disclaimer in the documentation and/or other materials
+//    provided with the distribution.
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+// OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+
+#include "ensemblepipeline.hpp"
+#include "../profiling/profiling.hpp"
+
+using namespace NRLib;
+
+namespace {
+  // Progress of the stages, as the number of realizations each has finished.
+  class PipelineState {
+  public:
+    PipelineState() : generated_(0), transformed_(0), output_(0), aborted_(false) {}
+
+    // Waits until pred holds. Returns false if the pipeline was aborted.
+    template <typename Predicate>
+    bool WaitUntil(Predicate pred)
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      changed_.wait(lock, [&]() { return aborted_ || pred(); });
+      return !aborted_;
+    }
+
+    void Finish(size_t & counter)
+    {
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        counter++;
+      }
+      changed_.notify_all();
+    }
+
+    void Abort(std::exception_ptr error)
+    {
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!error_)
+          error_ = error;
+        aborted_ = true;
+      }
+      changed_.notify_all();
+    }
+
+    std::exception_ptr Error() const { return error_; }
+
+    size_t generated_;
+    size_t transformed_;
+    size_t output_;
+
+  private:
+    bool                    aborted_;
+    std::exception_ptr      error_;
+    std::mutex              mutex_;
+    std::condition_variable changed_;
+  };
+}
+
+
+void NRLib::RunEnsemblePipeline(size_t                                                        n_items,
+                                size_t                                                        n_buffers,
+                                const std::function<void(size_t item, size_t noise)>             & generate,
+                                const std::function<void(size_t item, size_t noise, size_t work)> & transform,
+                                const std::function<void(size_t item, size_t work)>              & output)
+{
+  if (n_items <= 1 || n_buffers <= 1) {
+    for (size_t r = 0; r < n_items; r++) {
+      generate(r, 0);
+      transform(r, 0, 0);
+      output(r, 0);
+    }
+    return;
+  }
+
+  PipelineState state;
+
+  // The stages on the other threads count in the run of the calling thread.
+  Profiling::RunHandle run = Profiling::CurrentRun();
+
+  // The noise buffer of realization r is free when r - n_buffers is transformed.
+  std::thread generator([&]() {
+    Profiling::AttachRun attach(run);
+    try {
+      for (size_t r = 0; r < n_items; r++) {
+        if (!state.WaitUntil([&]() { return state.transformed_ + n_buffers > r; }))
+          return;
+        generate(r, r % n_buffers);
+        state.Finish(state.generated_);
+      }
+    }
+    catch (...) {
+      state.Abort(std::current_exception());
+    }
+  });
+
+  // The workspace of realization r is free when r - n_buffers is output.
+  std::thread writer([&]() {
+    Profiling::AttachRun attach(run);
+    try {
+      for (size_t r = 0; r < n_items; r++) {
+        if (!state.WaitUntil([&]() { return state.transformed_ > r; }))
+          return;
+        output(r, r % n_buffers);
+        state.Finish(state.output_);
+      }
+    }
+    catch (...) {
+      state.Abort(std::current_exception());
+    }
+  });
+
+  try {
+    for (size_t r = 0; r < n_items; r++) {
+      if (!state.WaitUntil([&]() { return state.generated_ > r && state.output_ + n_buffers > r; }))
+        break;
+      transform(r, r % n_buffers, r % n_buffers);
+      state.Finish(state.transformed_);
+    }
+  }
+  catch (...) {
+    state.Abort(std::current_exception());
+  }
+
+  generator.join();
+  writer.join();
+  if (state.Error())
+    std::rethrow_exception(state.Error());
+}
@@ -0,0 +1,50 @@
+// Copyright (c)  2011, Norwegian Computing Center
+// All rights reserved.
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+// •  Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+// •  Redistributions in binary form must reproduce the above copyright notice, this list of
+//    conditions and the following disclaimer in the documentation and/or other materials
+//    provided with the distribution.
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+// OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef NRLIB_VARIOGRAM_ENSEMBLEPIPELINE_HPP
+#define NRLIB_VARIOGRAM_ENSEMBLEPIPELINE_HPP
+
+#include <cstdlib>
+#include <functional>
+
+namespace NRLib {
+  /// Runs the realizations of an ensemble through three stages that overlap
+  /// in time: noise for realization r+1 is generated while r is transformed
+  /// and r-1 is output. Each stage handles the realizations in order, the
+  /// first and last on a thread of their own, the transform on the calling
+  /// thread. There are n_buffers noise buffers and n_buffers workspaces,
+  /// which are reused round robin: realization r uses noise buffer and
+  /// workspace r % n_buffers. A stage is only called when the buffer it
+  /// writes to is no longer used by a later stage, so the buffers need no
+  /// further synchronization.
+  ///
+  /// Profiling statistics of all the stages count in the run of the calling
+  /// thread, see Profiling::AttachRun.
+  ///
+  /// Without overlap, for n_items <= 1 or n_buffers <= 1, the stages are
+  /// called in sequence on the calling thread. If a stage throws, the
+  /// others stop, and the first exception is rethrown.
+  void RunEnsemblePipeline(size_t                                                        n_items,
+                           size_t                                                        n_buffers,
+                           const std::function<void(size_t item, size_t noise)>             & generate,
+                           const std::function<void(size_t item, size_t noise, size_t work)> & transform,
+                           const std::function<void(size_t item, size_t work)>              & output);
+}
+
+#endif // NRLIB_VARIOGRAM_ENSEMBLEPIPELINE_HPP
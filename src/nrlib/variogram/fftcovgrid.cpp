@@ -19,8 +19,11 @@
 
 #include "fftcovgrid.hpp"
 #include "variogram.hpp"
+#include "../fft/fft.hpp"
+#include "../math/constants.hpp"
 
 #include <algorithm>
+#include <complex>
 
 using namespace NRLib;
 
@@ -93,6 +96,62 @@ namespace NRLib { namespace FFTCovGridUtilities
 
     return scaling_factors;
   }
+
+  // sin(x)/x
+  double Sinc(double x)
+  {
+    return (std::abs(x) < 1e-8) ? 1.0 : std::sin(x) / x;
+  }
+
+  // Replaces the periodic covariance grid cov, of size nx*ny*nz with x
+  // fastest, by the covariance of block averages, by multiplying its
+  // spectrum by the squared transfer function of the box average. n_dim is
+  // the number of dimensions of the grid.
+  void ApplyBlockSupport(const Variogram & variogram,
+                         double          * cov,
+                         size_t            n_dim,
+                         size_t            nx,
+                         double            dx,
+                         size_t            ny = 1,
+                         double            dy = 1.0,
+                         size_t            nz = 1,
+                         double            dz = 1.0)
+  {
+    std::vector<int> fft_size;
+    if (n_dim > 2)
+      fft_size.push_back(static_cast<int>(nz));
+    if (n_dim > 1)
+      fft_size.push_back(static_cast<int>(ny));
+    fft_size.push_back(static_cast<int>(nx));
+
+    size_t nxc = nx / 2 + 1;
+    std::vector<std::complex<double> > spectrum(nxc * ny * nz);
+    NRLibPrivate::ComputeFFTMany(fft_size, 1, cov, &spectrum[0]);
+
+    // Transfer function along each axis, of the frequency of each index.
+    size_t n[3]     = { nx, ny, nz };
+    double d[3]     = { dx, dy, dz };
+    double block[3] = { variogram.GetBlockX(), variogram.GetBlockY(), variogram.GetBlockZ() };
+    std::vector<double> transfer[3];
+    for (size_t dim = 0; dim < 3; dim++) {
+      size_t n_freq = (dim == 0) ? nxc : n[dim];
+      transfer[dim].resize(n_freq, 1.0);
+      if (dim >= n_dim)
+        continue;
+      for (size_t i = 0; i < n_freq; i++) {
+        double f = (i <= n[dim] / 2) ? static_cast<double>(i) : static_cast<double>(i) - static_cast<double>(n[dim]);
+        double s = Sinc(NRLib::Pi * f * block[dim] / (static_cast<double>(n[dim]) * d[dim]));
+        transfer[dim][i] = s * s;
+      }
+    }
+
+    double scale = 1.0 / static_cast<double>(nx * ny * nz);
+    for (size_t k = 0; k < nz; k++)
+      for (size_t j = 0; j < ny; j++)
+        for (size_t i = 0; i < nxc; i++)
+          spectrum[i + nxc * (j + ny * k)] *= scale * transfer[0][i] * transfer[1][j] * transfer[2][k];
+    NRLibPrivate::ComputeFFTManyInverse(fft_size, 1, &spectrum[0], cov);
+  }
 }
 }
 
@@ -119,6 +178,8 @@ FFTCovGrid1D::FFTCovGrid1D(const Variogram & variogram,
     cov_[i] = variogram.GetCov(ddx);
     if (apply_scaling_x) cov_[i] *= FindSmoothingFactorX(ddx);
   }
+  if (variogram.HasBlockSupport())
+    FFTCovGridUtilities::ApplyBlockSupport(variogram, &cov_[0], 1, nx, dx);
 }
 
 void FFTCovGrid1D::InitializeSmoothingFactors(const Variogram & variogram,
@@ -188,6 +249,8 @@ cov_(nx, ny)
       if (apply_scaling_y) cov_(i, j) *= FindSmoothingFactorY(ddy);
     }
   }
+  if (variogram.HasBlockSupport())
+    FFTCovGridUtilities::ApplyBlockSupport(variogram, &cov_(0, 0), 2, nx, dx, ny, dy);
 }
 
 void FFTCovGrid2D::InitializeSmoothingFactors(const Variogram & variogram,
@@ -319,6 +382,8 @@ cov_(nx, ny, nz)
       }
     }
   }
+  if (variogram.HasBlockSupport())
+    FFTCovGridUtilities::ApplyBlockSupport(variogram, &cov_(0, 0, 0), 3, nx, dx, ny, dy, nz, dz);
 }
 
 
@@ -33,6 +33,12 @@ class Variogram;
 /// are set to something between 0.0 and 1.0. Scaling is how much the
 /// correlation function is scaled at 1 range (after projecting the directions
 /// of the variogram)
+///
+/// If the variogram has block support (see Variogram::SetBlockSupport), the
+/// grid holds the covariance of block averages instead: the spectrum of the
+/// point covariance grid is multiplied by the transfer function of the box
+/// average, a product of sinc^2 in each direction, and transformed back.
+/// Aliasing of the point spectrum on the grid is not corrected for.
 class FFTCovGrid1D {
 public:
   FFTCovGrid1D(const Variogram & vario,
@@ -40,7 +46,7 @@ public:
                double            dx,
                double            scaling_x = 1.0);
 
-  const std::vector<double> GetCov() const { return cov_; }
+  const std::vector<double> & GetCov() const { return cov_; }
 private:
   std::vector<double> cov_;
 
@@ -63,7 +69,7 @@ public:
                double            scaling_x = 1.0,
                double            scaling_y = 1.0);
 
-  const NRLib::Grid2D<double> GetCov() const { return cov_; }
+  const NRLib::Grid2D<double> & GetCov() const { return cov_; }
 private:
   NRLib::Grid2D<double> cov_;
 
@@ -93,7 +99,7 @@ public:
                double            scaling_y = 1.0,
                double            scaling_z = 1.0);
 
-  const NRLib::Grid<double> GetCov() const { return cov_; }
+  const NRLib::Grid<double> & GetCov() const { return cov_; }
 private:
   Grid<double> cov_;
 
@@ -0,0 +1,233 @@
+// Copyright (c)  2011, Norwegian Computing Center
+// All rights reserved.
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+// •  Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+// •  Redistributions in binary form must reproduce the above copyright notice, this list of
+//    conditions and the following disclaimer in the documentation and/or other materials
+//    provided with the distribution.
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+// OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+#include "fieldtransform.hpp"
+
+#include "../exception/exception.hpp"
+#include "../iotools/stringtools.hpp"
+
+using namespace NRLib;
+
+namespace {
+  // Values are transformed in blocks that fit in the cache, one step at a time.
+  const size_t transform_block_size = 1024;
+}
+
+FieldTransform::FieldTransform()
+  : has_thresholds_(false),
+    trend_size_(0)
+{
+}
+
+
+void FieldTransform::AddAffine(double scale, double shift)
+{
+  Step step;
+  step.type  = AFFINE;
+  step.scale = scale;
+  step.shift = shift;
+  steps_.push_back(step);
+}
+
+
+void FieldTransform::AddTrend(const std::vector<double> & trend)
+{
+  if (trend_size_ > 0 && trend.size() != trend_size_)
+    throw Exception("All trends of a transform must have the same size.");
+  Step step;
+  step.type  = TREND;
+  step.scale = 1.0;
+  step.shift = 0.0;
+  step.x     = trend;
+  steps_.push_back(step);
+  trend_size_ = trend.size();
+}
+
+
+void FieldTransform::AddExp()
+{
+  Step step;
+  step.type  = EXP;
+  step.scale = 1.0;
+  step.shift = 0.0;
+  steps_.push_back(step);
+}
+
+
+void FieldTransform::AddLognormal(double mean, double std_dev)
+{
+  if (mean <= 0.0 || std_dev < 0.0)
+    throw Exception("A lognormal transform needs a positive mean and a non-negative standard deviation.");
+  double sigma2 = std::log(1.0 + (std_dev * std_dev) / (mean * mean));
+  AddAffine(std::sqrt(sigma2), std::log(mean) - 0.5 * sigma2);
+  AddExp();
+}
+
+
+void FieldTransform::AddTable(const std::vector<double> & x, const std::vector<double> & y)
+{
+  if (x.empty() || x.size() != y.size())
+    throw Exception("The table of a transform must have the same, non-zero number of x and y values.");
+  for (size_t i = 1; i < x.size(); i++) {
+    if (!(x[i] > x[i - 1]))
+      throw Exception("The x values of the table of a transform must be increasing.");
+  }
+  Step step;
+  step.type  = TABLE;
+  step.scale = 1.0;
+  step.shift = 0.0;
+  step.x     = x;
+  step.y     = y;
+  steps_.push_back(step);
+}
+
+
+void FieldTransform::SetThresholds(const std::vector<double> & thresholds)
+{
+  if (thresholds.size() > 127)
+    throw Exception("There can be at most 127 thresholds, but " + NRLib::ToString(thresholds.size())
+                    + " were given.");
+  for (size_t i = 1; i < thresholds.size(); i++) {
+    if (!(thresholds[i] > thresholds[i - 1]))
+      throw Exception("The thresholds of a transform must be increasing.");
+  }
+  thresholds_     = thresholds;
+  has_thresholds_ = true;
+}
+
+
+void FieldTransform::ApplySteps(size_t begin, size_t n, double * work) const
+{
+  for (size_t s = 0; s < steps_.size(); s++) {
+    const Step & step = steps_[s];
+    switch (step.type) {
+    case AFFINE:
+      for (size_t i = 0; i < n; i++)
+        work[i] = step.scale * work[i] + step.shift;
+      break;
+    case TREND: {
+      const double * trend = &step.x[begin];
+      for (size_t i = 0; i < n; i++)
+        work[i] += trend[i];
+      break;
+    }
+    case EXP:
+      for (size_t i = 0; i < n; i++)
+        work[i] = std::exp(work[i]);
+      break;
+    case TABLE: {
+      const std::vector<double> & x = step.x;
+      const std::vector<double> & y = step.y;
+      for (size_t i = 0; i < n; i++) {
+        size_t k = std::upper_bound(x.begin(), x.end(), work[i]) - x.begin();
+        if (k == 0)
+          work[i] = y.front();
+        else if (k == x.size())
+          work[i] = y.back();
+        else
+          work[i] = y[k - 1] + (y[k] - y[k - 1]) * (work[i] - x[k - 1]) / (x[k] - x[k - 1]);
+      }
+      break;
+    }
+    }
+  }
+}
+
+
+void FieldTransform::Convert(const double * work, size_t n, double * out) const
+{
+  std::copy(work, work + n, out);
+}
+
+
+void FieldTransform::Convert(const double * work, size_t n, signed char * codes) const
+{
+  for (size_t i = 0; i < n; i++)
+    codes[i] = static_cast<signed char>(std::upper_bound(thresholds_.begin(), thresholds_.end(), work[i])
+                                        - thresholds_.begin());
+}
+
+
+template <typename T>
+void FieldTransform::ApplyAll(const double * values, size_t begin, size_t n, size_t field_size, T * out) const
+{
+  if (trend_size_ > 0 && field_size != trend_size_)
+    throw Exception("The field has " + NRLib::ToString(field_size) + " values, but the trend of the transform has "
+                    + NRLib::ToString(trend_size_) + ".");
+  if (begin + n > field_size)
+    throw Exception("Values " + NRLib::ToString(begin) + " to " + NRLib::ToString(begin + n)
+                    + " are outside the field of " + NRLib::ToString(field_size) + " values.");
+
+  // first and last are relative to values, and begin is added for the trends
+  auto transform_range = [&](size_t first, size_t last) {
+    double work[transform_block_size];
+    for (size_t i = first; i < last; i += transform_block_size) {
+      size_t m = std::min(transform_block_size, last - i);
+      std::copy(values + i, values + i + m, work);
+      ApplySteps(begin + i, m, work);
+      Convert(work, m, out + i);
+    }
+  };
+
+  size_t n_blocks  = (n + transform_block_size - 1) / transform_block_size;
+  size_t n_threads = std::min<size_t>(std::max(1U, std::thread::hardware_concurrency()), n_blocks / 64);
+  if (n_threads <= 1) {
+    transform_range(0, n);
+    return;
+  }
+  // Whole blocks for each thread
+  size_t size = ((n_blocks + n_threads - 1) / n_threads) * transform_block_size;
+  std::vector<std::thread> threads;
+  for (size_t first = 0; first < n; first += size)
+    threads.push_back(std::thread(transform_range, first, std::min(n, first + size)));
+  for (size_t t = 0; t < threads.size(); t++)
+    threads[t].join();
+}
+
+
+void FieldTransform::Apply(const double * values, size_t n, double * out) const
+{
+  Apply(values, 0, n, n, out);
+}
+
+
+void FieldTransform::Apply(const double * values, size_t n, signed char * codes) const
+{
+  Apply(values, 0, n, n, codes);
+}
+
+
+void FieldTransform::Apply(const double * values, size_t begin, size_t n, size_t field_size, double * out) const
+{
+  if (has_thresholds_)
+    throw Exception("A transform with thresholds gives integer codes.");
+  ApplyAll(values, begin, n, field_size, out);
+}
+
+
+void FieldTransform::Apply(const double * values, size_t begin, size_t n, size_t field_size, signed char * codes) const
+{
+  if (!has_thresholds_)
+    throw Exception("A transform without thresholds gives real values.");
+  ApplyAll(values, begin, n, field_size, codes);
+}
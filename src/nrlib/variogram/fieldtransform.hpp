@@ -0,0 +1,108 @@
+// Copyright (c)  2011, Norwegian Computing Center
+// All rights reserved.
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+// •  Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+// •  Redistributions in binary form must reproduce the above copyright notice, this list of
+//    conditions and the following disclaimer in the documentation and/or other materials
+//    provided with the distribution.
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+// OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef NRLIB_VARIOGRAM_FIELDTRANSFORM_HPP
+#define NRLIB_VARIOGRAM_FIELDTRANSFORM_HPP
+
+#include <cstdlib>
+#include <vector>
+
+namespace NRLib {
+  /// Pipeline of pointwise transforms of a simulated field, such as
+  /// rescaling, adding a trend, a lognormal transform or truncation into
+  /// facies codes. The steps are applied in the order they are added, in
+  /// a single pass over the field, so no intermediate fields are stored.
+  class FieldTransform {
+  public:
+    FieldTransform();
+
+    /// value = scale*value + shift
+    void   AddAffine(double scale, double shift);
+
+    /// value = value + trend[index], where index is the position in the
+    /// field. The trend is copied.
+    void   AddTrend(const std::vector<double> & trend);
+
+    /// value = exp(value)
+    void   AddExp();
+
+    /// Transforms a standard normal value to a lognormal value with the
+    /// given mean and standard deviation. Same as an affine step and exp.
+    void   AddLognormal(double mean, double std_dev);
+
+    /// Piecewise linear interpolation in the table (x, y), for instance a
+    /// normal score back transform. x must be increasing. Values outside
+    /// the table get the first or last y.
+    void   AddTable(const std::vector<double> & x, const std::vector<double> & y);
+
+    /// Final step, giving the number of thresholds that are less than or
+    /// equal to the value, that is, codes from 0 to thresholds.size(). The
+    /// thresholds must be increasing, and there can be at most 127.
+    void   SetThresholds(const std::vector<double> & thresholds);
+
+    bool   HasThresholds() const { return has_thresholds_; }
+
+    bool   IsEmpty() const { return steps_.empty() && !has_thresholds_; }
+
+    /// Number of values in the trends, or 0 if there are no trends.
+    size_t GetTrendSize() const { return trend_size_; }
+
+    /// Transforms a field of n values. With trends, n must be the trend
+    /// size. Runs in parallel for large n.
+    void   Apply(const double * values, size_t n, double * out) const;
+
+    /// As above, with thresholds.
+    void   Apply(const double * values, size_t n, signed char * codes) const;
+
+    /// Transforms values begin to begin + n of a field of field_size values,
+    /// e.g. one layer at a time. values and out point to value begin.
+    void   Apply(const double * values, size_t begin, size_t n, size_t field_size, double * out) const;
+
+    void   Apply(const double * values, size_t begin, size_t n, size_t field_size, signed char * codes) const;
+
+  private:
+    enum StepType { AFFINE, TREND, EXP, TABLE };
+
+    struct Step {
+      StepType            type;
+      double              scale;
+      double              shift;
+      /// Trend values, or the x values of the table
+      std::vector<double> x;
+      std::vector<double> y;
+    };
+
+    /// Applies the steps to values [begin, begin + n) of the field, in place in work.
+    void   ApplySteps(size_t begin, size_t n, double * work) const;
+
+    template <typename T>
+    void   ApplyAll(const double * values, size_t begin, size_t n, size_t field_size, T * out) const;
+
+    void   Convert(const double * work, size_t n, double * out) const;
+
+    void   Convert(const double * work, size_t n, signed char * codes) const;
+
+    std::vector<Step>   steps_;
+    std::vector<double> thresholds_;
+    bool                has_thresholds_;
+    size_t              trend_size_;
+  };
+}
+
+#endif // NRLIB_VARIOGRAM_FIELDTRANSFORM_HPP
@@ -0,0 +1,314 @@
+// Copyright (c)  2011, Norwegian Computing Center
+// All rights reserved.
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+// •  Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+// •  Redistributions in binary form must reproduce the above copyright notice, this list of
+//    conditions and the following disclaimer in the documentation and/or other materials
+//    provided with the distribution.
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+// OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <stdio.h>
+#include <thread>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "filterspectrum.hpp"
+#include "variogram.hpp"
+
+#include "../exception/exception.hpp"
+#include "../profiling/profiling.hpp"
+
+using namespace NRLib;
+
+namespace {
+  // File layout: magic, key size and number of values (8 bytes each), the
+  // key padded to a multiple of 8 bytes, and the values.
+  const char     spectrum_magic[8] = { 'N', 'R', 'F', 'I', 'L', 'T', 'S', '1' };
+  const size_t   header_size       = 24;
+
+  size_t PaddedKeySize(size_t key_size)
+  {
+    return (key_size + 7) / 8 * 8;
+  }
+
+  // 64-bit FNV-1a hash
+  std::uint64_t HashKey(const std::string & key)
+  {
+    std::uint64_t hash = 14695981039346656037ULL;
+    for (size_t i = 0; i < key.size(); i++) {
+      hash ^= static_cast<unsigned char>(key[i]);
+      hash *= 1099511628211ULL;
+    }
+    return hash;
+  }
+
+  std::string FileName(const std::string & directory, const std::string & key)
+  {
+    char name[64];
+    snprintf(name, sizeof(name), "spectrum-%016llx.bin", static_cast<unsigned long long>(HashKey(key)));
+    return (std::filesystem::path(directory) / name).string();
+  }
+
+  std::mutex & CacheMutex()
+  {
+    static std::mutex cache_mutex;
+    return cache_mutex;
+  }
+
+  std::string & CacheDirectory()
+  {
+    static std::string cache_directory;
+    return cache_directory;
+  }
+}
+
+FilterSpectrum::FilterSpectrum()
+  : data_(NULL),
+    n_(0),
+    mapping_(NULL),
+    mapping_size_(0)
+#ifdef _WIN32
+  , file_handle_(NULL),
+    mapping_handle_(NULL)
+#endif
+{
+}
+
+
+FilterSpectrum::~FilterSpectrum()
+{
+  if (mapping_ == NULL)
+    return;
+#ifdef _WIN32
+  UnmapViewOfFile(mapping_);
+  CloseHandle(mapping_handle_);
+  CloseHandle(file_handle_);
+#else
+  munmap(mapping_, mapping_size_);
+#endif
+}
+
+
+void FilterSpectrum::SetCacheDirectory(const std::string & directory)
+{
+  if (!directory.empty()) {
+    std::error_code error;
+    std::filesystem::create_directories(directory, error);
+    if (!std::filesystem::is_directory(directory))
+      throw Exception("Could not create the cache directory " + directory + ".");
+  }
+  std::lock_guard<std::mutex> lock(CacheMutex());
+  CacheDirectory() = directory;
+}
+
+
+std::string FilterSpectrum::GetCacheDirectory()
+{
+  std::lock_guard<std::mutex> lock(CacheMutex());
+  return CacheDirectory();
+}
+
+
+std::string FilterSpectrum::MakeKey(const Variogram   & variogram,
+                                    const std::string & precision,
+                                    size_t              nx_tot,
+                                    double              dx,
+                                    size_t              ny_tot,
+                                    double              dy,
+                                    size_t              nz_tot,
+                                    double              dz,
+                                    double              scaling_x,
+                                    double              scaling_y,
+                                    double              scaling_z)
+{
+  char buffer[256];
+  snprintf(buffer, sizeof(buffer), "|%s|%llu,%llu,%llu|%.17g,%.17g,%.17g|%.17g,%.17g,%.17g",
+           precision.c_str(),
+           static_cast<unsigned long long>(nx_tot),
+           static_cast<unsigned long long>(ny_tot),
+           static_cast<unsigned long long>(nz_tot),
+           dx, dy, dz, scaling_x, scaling_y, scaling_z);
+  std::string key = variogram.GetDescription() + buffer;
+  if (variogram.HasBlockSupport()) {
+    snprintf(buffer, sizeof(buffer), "|block%.17g,%.17g,%.17g",
+             variogram.GetBlockX(), variogram.GetBlockY(), variogram.GetBlockZ());
+    key += buffer;
+  }
+  return key;
+}
+
+
+std::shared_ptr<const FilterSpectrum> FilterSpectrum::Get(const std::string                                & key,
+                                                          size_t                                             n,
+                                                          const std::function<void(std::vector<double> &)> & compute)
+{
+  std::shared_ptr<FilterSpectrum> spectrum(new FilterSpectrum());
+  std::string directory = GetCacheDirectory();
+  std::string filename  = directory.empty() ? std::string() : FileName(directory, key);
+  if (!filename.empty()) {
+    Profiling::ScopedTimer timer("cache");
+    if (spectrum->Map(filename, key, n))
+      return spectrum;
+  }
+
+  compute(spectrum->values_);
+  if (spectrum->values_.size() != n)
+    throw Exception("The filter spectrum has the wrong size.");
+  spectrum->data_ = spectrum->values_.data();
+  spectrum->n_    = n;
+
+  if (!filename.empty()) {
+    Profiling::ScopedTimer timer("cache");
+    Store(filename, key, spectrum->values_);
+    // Use the file, so that the memory is shared with other processes
+    std::shared_ptr<FilterSpectrum> mapped(new FilterSpectrum());
+    if (mapped->Map(filename, key, n))
+      return mapped;
+  }
+  return spectrum;
+}
+
+
+bool FilterSpectrum::Map(const std::string & filename, const std::string & key, size_t n)
+{
+  // The members are only set when the file is valid, so that a failed
+  // attempt leaves the object unmapped.
+#ifdef _WIN32
+  HANDLE file = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL,
+                            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+  if (file == INVALID_HANDLE_VALUE)
+    return false;
+  LARGE_INTEGER file_size;
+  if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart < static_cast<LONGLONG>(header_size)) {
+    CloseHandle(file);
+    return false;
+  }
+  HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+  if (mapping == NULL) {
+    CloseHandle(file);
+    return false;
+  }
+  void * view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  if (view == NULL) {
+    CloseHandle(mapping);
+    CloseHandle(file);
+    return false;
+  }
+  size_t size = static_cast<size_t>(file_size.QuadPart);
+#else
+  int fd = open(filename.c_str(), O_RDONLY);
+  if (fd < 0)
+    return false;
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) != 0 || file_stat.st_size < static_cast<off_t>(header_size)) {
+    close(fd);
+    return false;
+  }
+  size_t size = static_cast<size_t>(file_stat.st_size);
+  void * view = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (view == MAP_FAILED)
+    return false;
+#endif
+  const char * base = static_cast<const char *>(view);
+
+  std::uint64_t key_size;
+  std::uint64_t n_values;
+  std::memcpy(&key_size, base + 8,  sizeof(key_size));
+  std::memcpy(&n_values, base + 16, sizeof(n_values));
+  size_t offset = header_size + PaddedKeySize(key.size());
+  // The key is compared in full, in case two keys have the same hash.
+  if (std::memcmp(base, spectrum_magic, 8) != 0
+      || key_size != key.size()
+      || n_values != n
+      || size != offset + n * sizeof(double)
+      || std::memcmp(base + header_size, key.data(), key.size()) != 0) {
+#ifdef _WIN32
+    UnmapViewOfFile(view);
+    CloseHandle(mapping);
+    CloseHandle(file);
+#else
+    munmap(view, size);
+#endif
+    return false;
+  }
+
+#ifdef _WIN32
+  file_handle_    = file;
+  mapping_handle_ = mapping;
+#endif
+  mapping_      = view;
+  mapping_size_ = size;
+  data_         = reinterpret_cast<const double *>(base + offset);
+  n_            = n;
+  return true;
+}
+
+
+void FilterSpectrum::Store(const std::string & filename, const std::string & key, const std::vector<double> & values)
+{
+  // Written to a temporary file and renamed, so other processes never see
+  // a partial file.
+  static std::atomic<unsigned long> counter(0);
+  char suffix[96];
+  snprintf(suffix, sizeof(suffix), ".%llx.%llx.%lu.tmp",
+           static_cast<unsigned long long>(std::chrono::steady_clock::now().time_since_epoch().count()),
+           static_cast<unsigned long long>(std::hash<std::thread::id>()(std::this_thread::get_id())),
+           counter++);
+  std::string temporary = filename + suffix;
+
+  std::uint64_t key_size = key.size();
+  std::uint64_t n_values = values.size();
+  std::vector<char> padding(PaddedKeySize(key.size()) - key.size(), 0);
+  {
+    std::ofstream file(temporary.c_str(), std::ios::out | std::ios::binary);
+    if (!file)
+      return;
+    file.write(spectrum_magic, 8);
+    file.write(reinterpret_cast<const char *>(&key_size), sizeof(key_size));
+    file.write(reinterpret_cast<const char *>(&n_values), sizeof(n_values));
+    file.write(key.data(), key.size());
+    if (!padding.empty())
+      file.write(padding.data(), padding.size());
+    file.write(reinterpret_cast<const char *>(values.data()), values.size() * sizeof(double));
+    if (!file) {
+      file.close();
+      std::remove(temporary.c_str());
+      return;
+    }
+  }
+  std::error_code error;
+  std::filesystem::rename(temporary, filename, error);
+  if (error)
+    std::filesystem::remove(temporary, error);
+}
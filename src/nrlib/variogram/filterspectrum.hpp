@@ -0,0 +1,102 @@
+// Copyright (c)  2011, Norwegian Computing Center
+// All rights reserved.
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+// •  Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+// •  Redistributions in binary form must reproduce the above copyright notice, this list of
+//    conditions and the following disclaimer in the documentation and/or other materials
+//    provided with the distribution.
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+// OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef NRLIB_VARIOGRAM_FILTERSPECTRUM_HPP
+#define NRLIB_VARIOGRAM_FILTERSPECTRUM_HPP
+
+#include <cstdlib>
+#include <functional>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace NRLib {
+  class Variogram;
+
+  /// Square root of the filter spectrum of a Gaussian field simulation,
+  /// that is, of the real part of the transform of the covariance grid.
+  ///
+  /// If a cache directory is set, spectra are stored there, and later
+  /// simulations on the same grid with the same variogram map the file
+  /// read-only instead of computing the spectrum. Processes that map the
+  /// same file share a single copy in memory.
+  class FilterSpectrum {
+  public:
+    ~FilterSpectrum();
+
+    /// Spectrum with n values for key. It is read from the cache directory
+    /// if possible, and otherwise computed by compute, which must resize
+    /// its argument to n values, and stored in the cache directory if one
+    /// is set. Problems with the cache files are ignored.
+    static std::shared_ptr<const FilterSpectrum> Get(const std::string                                & key,
+                                                     size_t                                             n,
+                                                     const std::function<void(std::vector<double> &)> & compute);
+
+    /// Key of the spectrum of a simulation on a padded grid of size
+    /// nx_tot*ny_tot*nz_tot. precision distinguishes spectra computed in
+    /// different ways. The block support of variogram is part of the key.
+    static std::string MakeKey(const Variogram   & variogram,
+                               const std::string & precision,
+                               size_t              nx_tot,
+                               double              dx,
+                               size_t              ny_tot    = 1,
+                               double              dy        = 1.0,
+                               size_t              nz_tot    = 1,
+                               double              dz        = 1.0,
+                               double              scaling_x = 1.0,
+                               double              scaling_y = 1.0,
+                               double              scaling_z = 1.0);
+
+    /// Sets the cache directory, and creates it if it does not exist. An
+    /// empty string turns off the cache, which is the default.
+    static void        SetCacheDirectory(const std::string & directory);
+
+    static std::string GetCacheDirectory();
+
+    const double * Data()     const { return data_; }
+    size_t         Size()     const { return n_; }
+    /// True if the values are mapped from a cache file.
+    bool           IsMapped() const { return mapping_ != NULL; }
+
+  private:
+    FilterSpectrum();
+
+    /// Maps the file, and checks that it holds n values for key.
+    bool Map(const std::string & filename, const std::string & key, size_t n);
+
+    static void Store(const std::string & filename, const std::string & key, const std::vector<double> & values);
+
+    /// Values when the spectrum is not mapped
+    std::vector<double>  values_;
+    const double       * data_;
+    size_t               n_;
+    void               * mapping_;
+    size_t               mapping_size_;
+#ifdef _WIN32
+    void               * file_handle_;
+    void               * mapping_handle_;
+#endif
+
+    // Make copying illegal.
+    FilterSpectrum(const FilterSpectrum &);
+    FilterSpectrum & operator=(const FilterSpectrum &);
+  };
+}
+
+#endif // NRLIB_VARIOGRAM_FILTERSPECTRUM_HPP
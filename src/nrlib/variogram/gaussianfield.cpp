@@ -20,19 +20,31 @@
 // EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include <cmath>
+#include <complex>
+#include <memory>
 #include <algorithm>
+#include <atomic>
+#include <thread>
 #include "gaussianfield.hpp"
 
 #include "variogram.hpp"
+#include "variogramtypes.hpp"
 #include "../grid/grid2d.hpp"
 #include "../grid/grid.hpp"
 #include "../random/random.hpp"
+#include "../volume/volume.hpp"
+#include "../exception/exception.hpp"
+#include "../iotools/stringtools.hpp"
 
 #include "../fft/fftgrid2d.hpp"
 #include "../fft/fftgrid3d.hpp"
 #include "../fft/fft.hpp"
+#include "../fft/workspacepool.hpp"
+#include "../profiling/profiling.hpp"
 
+#include "ensemblepipeline.hpp"
 #include "fftcovgrid.hpp"
+#include "filterspectrum.hpp"
 
 using namespace NRLib;
 
@@ -58,6 +70,19 @@ std::vector<size_t> NRLib::FindNDimPadding(const Variogram & variogram,
                                            size_t            nz,
                                            double            dz)
 {
+  const NestedVario * nested = dynamic_cast<const NestedVario *>(&variogram);
+  if (nested != NULL) {
+    // Enough padding for the longest structure in each direction.
+    size_t n_dim = (ny <= 1) ? 1 : ((nz <= 1) ? 2 : 3);
+    std::vector<size_t> pad(n_dim, 0);
+    for (size_t i = 0; i < nested->GetNStructures(); i++) {
+      std::vector<size_t> structure_pad = FindNDimPadding(nested->GetStructure(i), nx, dx, ny, dy, nz, dz);
+      for (size_t d = 0; d < n_dim; d++)
+        pad[d] = std::max(pad[d], structure_pad[d]);
+    }
+    return pad;
+  }
+
   std::vector<size_t> pad;
   if (ny <= 1) {
     double range = variogram.GetRangeX();
@@ -87,6 +112,263 @@ std::vector<size_t> NRLib::FindNDimPadding(const Variogram & variogram,
   return pad;
 }
 
+namespace {
+  std::atomic<bool> legacy_noise(false);
+
+  template <typename T>
+  void FillNoise(T * data, size_t nx, size_t ny, size_t nz, RandomGenerator * rg)
+  {
+    if (legacy_noise) {
+      for (size_t i = 0; i < nx; i++)
+        for (size_t j = 0; j < ny; j++)
+          for (size_t k = 0; k < nz; k++)
+            data[i + nx * (j + ny * k)] = static_cast<T>((rg != NULL) ? rg->Norm01() : NRLib::Random::Norm01());
+    }
+    else if (rg != NULL) {
+      rg->FillNorm01(data, nx * ny * nz);
+    }
+    else {
+      NRLib::Random::FillNorm01(data, nx * ny * nz);
+    }
+  }
+}
+
+void NRLib::FillGaussianNoise(double * data, size_t nx, size_t ny, size_t nz, RandomGenerator * rg)
+{
+  FillNoise(data, nx, ny, nz, rg);
+}
+
+void NRLib::FillGaussianNoise(float * data, size_t nx, size_t ny, size_t nz, RandomGenerator * rg)
+{
+  FillNoise(data, nx, ny, nz, rg);
+}
+
+void NRLib::SetLegacyNoise(bool legacy)
+{
+  legacy_noise = legacy;
+}
+
+bool NRLib::GetLegacyNoise()
+{
+  return legacy_noise;
+}
+
+void NRLib::GaussianFieldSink::AddLayer(size_t k, size_t ni, size_t nj, const float * values, size_t stride)
+{
+  std::vector<double> layer(ni * nj);
+  for (size_t j = 0; j < nj; j++)
+    for (size_t i = 0; i < ni; i++)
+      layer[i + j * ni] = values[i + j * stride];
+  AddLayer(k, ni, nj, &layer[0], ni);
+}
+
+namespace {
+
+  // Stores the fields as grids.
+  class GridCollector : public GaussianFieldSink {
+  public:
+    GridCollector(std::vector<Grid<double> > & grids, size_t nx, size_t ny, size_t nz)
+      : grids_(grids), nx_(nx), ny_(ny), nz_(nz) {}
+
+    void BeginField(int /*m*/)
+    {
+      grids_.push_back(Grid<double>(nx_, ny_, nz_));
+    }
+
+    void AddLayer(size_t k, size_t ni, size_t nj, const double * values, size_t stride)
+    {
+      Grid<double> & grid = grids_.back();
+      for (size_t j = 0; j < nj; j++)
+        for (size_t i = 0; i < ni; i++)
+          grid(i, j, k) = values[i + j * stride];
+    }
+
+    void AddLayer(size_t k, size_t ni, size_t nj, const float * values, size_t stride)
+    {
+      Grid<double> & grid = grids_.back();
+      for (size_t j = 0; j < nj; j++)
+        for (size_t i = 0; i < ni; i++)
+          grid(i, j, k) = values[i + j * stride];
+    }
+
+  private:
+    std::vector<Grid<double> > & grids_;
+    size_t nx_;
+    size_t ny_;
+    size_t nz_;
+  };
+
+  // Stores the fields as 2D grids.
+  class Grid2DCollector : public GaussianFieldSink {
+  public:
+    explicit Grid2DCollector(std::vector<Grid2D<double> > & grids)
+      : grids_(grids) {}
+
+    void AddLayer(size_t /*k*/, size_t ni, size_t nj, const double * values, size_t stride)
+    {
+      Grid2D<double> field(ni, nj);
+      for (size_t j = 0; j < nj; j++)
+        for (size_t i = 0; i < ni; i++)
+          field(i, j) = values[i + j * stride];
+      grids_.push_back(field);
+    }
+
+    void AddLayer(size_t /*k*/, size_t ni, size_t nj, const float * values, size_t stride)
+    {
+      Grid2D<double> field(ni, nj);
+      for (size_t j = 0; j < nj; j++)
+        for (size_t i = 0; i < ni; i++)
+          field(i, j) = values[i + j * stride];
+      grids_.push_back(field);
+    }
+
+  private:
+    std::vector<Grid2D<double> > & grids_;
+  };
+
+  // Simulation with GaussianFieldPlan::LEAN or SINGLE_PRECISION. Uses the same
+  // transforms and random draws as the standard simulation, but keeps only
+  // one FFT grid and the square root of the (real) filter spectrum.
+  template <typename T>
+  void Simulate3DGaussianFieldLean(const Variogram            & variogram,
+                                   size_t                       nx,
+                                   double                       dx,
+                                   size_t                       ny,
+                                   double                       dy,
+                                   size_t                       nz,
+                                   double                       dz,
+                                   int                          n_fields,
+                                   GaussianFieldSink          & sink,
+                                   size_t                       padding_x,
+                                   size_t                       padding_y,
+                                   size_t                       padding_z,
+                                   double                       scaling_x,
+                                   double                       scaling_y,
+                                   double                       scaling_z)
+  {
+    FFTGrid3D<T> fftgrid(nx, ny, nz, padding_x, padding_y, padding_z, true, false);
+    size_t nx_tot    = fftgrid.GetNItot();
+    size_t ny_tot    = fftgrid.GetNJtot();
+    size_t nz_tot    = fftgrid.GetNKtot();
+    size_t n_complex = fftgrid.GetComplexNI() * fftgrid.GetComplexNJ() * fftgrid.GetComplexNK();
+    Profiling::RecordPaddedSize(nx_tot, ny_tot, nz_tot);
+
+    Profiling::ScopedAllocation spectrum_allocation(n_complex * sizeof(T));
+    std::vector<T> spectrum(n_complex);
+    {
+      Profiling::ScopedAllocation cov_allocation(nx_tot * ny_tot * nz_tot * sizeof(double));
+      Profiling::ScopedTimer timer("covariance");
+      FFTCovGrid3D cov_grid(variogram,
+                            static_cast<int>(nx_tot),
+                            dx,
+                            static_cast<int>(ny_tot),
+                            dy,
+                            static_cast<int>(nz_tot),
+                            dz,
+                            scaling_x,
+                            scaling_y,
+                            scaling_z);
+      const std::vector<double> & cov = cov_grid.GetCov().GetStorage();
+      for (size_t i = 0; i < cov.size(); i++)
+        fftgrid.RealData()[i] = static_cast<T>(cov[i]);
+    }
+    {
+      // Unscaled transform, as for the filter grid in the standard simulation.
+      Profiling::ScopedTimer timer("filter");
+      NRLibPrivate::ComputeFFT3D(nx_tot, ny_tot, nz_tot, fftgrid.RealData(), fftgrid.ComplexData());
+      for (size_t i = 0; i < n_complex; i++)
+        spectrum[i] = std::sqrt(std::max(fftgrid.ComplexData()[i].real(), static_cast<T>(0)));
+    }
+
+    for (int m = 0; m < n_fields; m++) {
+      {
+        Profiling::ScopedTimer timer("noise");
+        FillGaussianNoise(fftgrid.RealData(), nx_tot, ny_tot, nz_tot, NULL);
+      }
+
+      fftgrid.DoFFT();
+      {
+        Profiling::ScopedTimer timer("convolve");
+        for (size_t i = 0; i < n_complex; i++)
+          fftgrid.ComplexData()[i] *= spectrum[i];
+      }
+
+      fftgrid.DoInverseFFT();
+      Profiling::ScopedTimer timer("extract");
+      sink.BeginField(m);
+      for (size_t k = 0; k < nz; k++)
+        sink.AddLayer(k, nx, ny, fftgrid.RealData() + k * nx_tot * ny_tot, nx_tot);
+      sink.EndField(m);
+    }
+  }
+
+  // As Simulate3DGaussianFieldLean, in two dimensions.
+  template <typename T>
+  void Simulate2DGaussianFieldLean(const Variogram              & variogram,
+                                   size_t                         nx,
+                                   double                         dx,
+                                   size_t                         ny,
+                                   double                         dy,
+                                   int                            n_fields,
+                                   GaussianFieldSink            & sink,
+                                   NRLib::RandomGenerator       * rg,
+                                   size_t                         padding_x,
+                                   size_t                         padding_y,
+                                   double                         scaling_x,
+                                   double                         scaling_y)
+  {
+    FFTGrid2D<T> fftgrid(nx, ny, padding_x, padding_y, true, false);
+    size_t nx_tot    = fftgrid.GetNItot();
+    size_t ny_tot    = fftgrid.GetNJtot();
+    size_t n_complex = fftgrid.GetComplexNI() * fftgrid.GetComplexNJ();
+    Profiling::RecordPaddedSize(nx_tot, ny_tot);
+
+    Profiling::ScopedAllocation spectrum_allocation(n_complex * sizeof(T));
+    std::vector<T> spectrum(n_complex);
+    {
+      Profiling::ScopedAllocation cov_allocation(nx_tot * ny_tot * sizeof(double));
+      Profiling::ScopedTimer timer("covariance");
+      FFTCovGrid2D cov_grid(variogram,
+                            static_cast<int>(nx_tot),
+                            dx,
+                            static_cast<int>(ny_tot),
+                            dy,
+                            scaling_x,
+                            scaling_y);
+      const std::vector<double> & cov = cov_grid.GetCov().GetStorage();
+      for (size_t i = 0; i < cov.size(); i++)
+        fftgrid.RealData()[i] = static_cast<T>(cov[i]);
+    }
+    {
+      Profiling::ScopedTimer timer("filter");
+      NRLibPrivate::ComputeFFT2D(nx_tot, ny_tot, fftgrid.RealData(), fftgrid.ComplexData());
+      for (size_t i = 0; i < n_complex; i++)
+        spectrum[i] = std::sqrt(std::max(fftgrid.ComplexData()[i].real(), static_cast<T>(0)));
+    }
+
+    for (int k = 0; k < n_fields; k++) {
+      {
+        Profiling::ScopedTimer timer("noise");
+        FillGaussianNoise(fftgrid.RealData(), nx_tot, ny_tot, 1, rg);
+      }
+
+      fftgrid.DoFFT();
+      {
+        Profiling::ScopedTimer timer("convolve");
+        for (size_t i = 0; i < n_complex; i++)
+          fftgrid.ComplexData()[i] *= spectrum[i];
+      }
+
+      fftgrid.DoInverseFFT();
+      Profiling::ScopedTimer timer("extract");
+      sink.BeginField(k);
+      sink.AddLayer(0, nx, ny, fftgrid.RealData(), nx_tot);
+      sink.EndField(k);
+    }
+  }
+
+}
+
 
 /****************************************************************************************/
 /* Implementations                                                                      */
@@ -107,22 +389,45 @@ void NRLib::Simulate3DGaussianField(const Variogram              & variogram,
                                     int                            padding_z,
                                     double                         scaling_x,
                                     double                         scaling_y,
-                                    double                         scaling_z)
+                                    double                         scaling_z,
+                                    GaussianFieldPlan::Strategy    strategy)
 {
-  std::vector<size_t> default_padding = FindNDimPadding(variogram,
-                                                        nx,
-                                                        dx,
-                                                        ny,
-                                                        dy,
-                                                        nz,
-                                                        dz);
+  Profiling::RunScope run;
+  Profiling::RecordFields(n_fields);
+
+  std::vector<size_t> default_padding;
+  {
+    Profiling::ScopedTimer timer("padding");
+    default_padding = FindNDimPadding(variogram,
+                                      nx,
+                                      dx,
+                                      ny,
+                                      dy,
+                                      nz,
+                                      dz);
+  }
   // This is the desired padding, but may not be the actual of the
   // FFT grid. See below.
   size_t desired_padding_x = (padding_x < 0) ? default_padding[0] : padding_x;
   size_t desired_padding_y = (padding_y < 0) ? default_padding[1] : padding_y;
   size_t desired_padding_z = (padding_z < 0) ? default_padding[2] : padding_z;
 
-  FFTGrid3D<double> fftgrid(nx, ny, nz, desired_padding_x, desired_padding_y, desired_padding_z, true);
+  if (strategy == GaussianFieldPlan::LEAN) {
+    GridCollector collector(grid_out, nx, ny, nz);
+    Simulate3DGaussianFieldLean<double>(variogram, nx, dx, ny, dy, nz, dz, n_fields, collector,
+                                        desired_padding_x, desired_padding_y, desired_padding_z,
+                                        scaling_x, scaling_y, scaling_z);
+    return;
+  }
+  if (strategy == GaussianFieldPlan::SINGLE_PRECISION) {
+    GridCollector collector(grid_out, nx, ny, nz);
+    Simulate3DGaussianFieldLean<float>(variogram, nx, dx, ny, dy, nz, dz, n_fields, collector,
+                                       desired_padding_x, desired_padding_y, desired_padding_z,
+                                       scaling_x, scaling_y, scaling_z);
+    return;
+  }
+
+  FFTGrid3D<double> fftgrid(nx, ny, nz, desired_padding_x, desired_padding_y, desired_padding_z, true, false);
 
   // Get the total grid size after the grid is created. This is not necessarily the
   // same as nx + desired_padding_x. FFTGrid3D may add even more padding so that the
@@ -130,63 +435,507 @@ void NRLib::Simulate3DGaussianField(const Variogram              & variogram,
   size_t nx_tot = fftgrid.GetNItot();
   size_t ny_tot = fftgrid.GetNJtot();
   size_t nz_tot = fftgrid.GetNKtot();
+  Profiling::RecordPaddedSize(nx_tot, ny_tot, nz_tot);
+
+  // Filter, read from the cache if possible.
+  size_t n_complex = fftgrid.GetComplexNI()*fftgrid.GetComplexNJ()*fftgrid.GetComplexNK();
+  std::string key  = FilterSpectrum::MakeKey(variogram, "complex", nx_tot, dx, ny_tot, dy, nz_tot, dz,
+                                             scaling_x, scaling_y, scaling_z);
+  std::shared_ptr<const FilterSpectrum> filter = FilterSpectrum::Get(key, n_complex, [&](std::vector<double> & spectrum) {
+    // Covariance grid.
+    Profiling::ScopedAllocation cov_allocation(nx_tot * ny_tot * nz_tot * sizeof(double));
+    Grid<double> cov;
+    {
+      Profiling::ScopedTimer timer("covariance");
+      cov = FFTCovGrid3D(variogram,
+                         static_cast<int>(nx_tot),
+                         dx,
+                         static_cast<int>(ny_tot),
+                         dy,
+                         static_cast<int>(nz_tot),
+                         dz,
+                         scaling_x,
+                         scaling_y,
+                         scaling_z).GetCov();
+    }
+
+    FFTGrid3D<double> filter_grid(nx,
+                                  ny,
+                                  nz,
+                                  desired_padding_x,
+                                  desired_padding_y,
+                                  desired_padding_z,
+                                  false,
+                                  false);
+
+    Profiling::ScopedTimer timer("filter");
+    filter_grid.Initialize(cov);
+    filter_grid.DoFFT();
+    spectrum.resize(n_complex);
+    for (size_t i = 0; i < n_complex; i++) {
+      std::complex<double> value(std::max(filter_grid.ComplexData()[i].real(), 0.0), 0.0);
+      spectrum[i] = std::sqrt(value).real();
+    }
+  });
+  const double * spectrum = filter->Data();
+
+  // Grids with white noise, and FFT grids. With more than one field, noise is
+  // generated for the next field and the previous field is extracted while
+  // the current field is transformed.
+  size_t n_buffers = std::min(static_cast<size_t>(std::max(n_fields, 1)), static_cast<size_t>(2));
+  Profiling::ScopedAllocation noise_allocation(n_buffers * nx_tot * ny_tot * nz_tot * sizeof(double));
+  std::vector<Grid<double> > noise(n_buffers, Grid<double>(nx_tot, ny_tot, nz_tot));
+  std::vector<FFTGrid3D<double> *>                  workspaces(1, &fftgrid);
+  std::vector<std::unique_ptr<FFTGrid3D<double> > > extra_workspaces;
+  for (size_t b = 1; b < n_buffers; b++) {
+    extra_workspaces.push_back(std::unique_ptr<FFTGrid3D<double> >(
+      new FFTGrid3D<double>(nx, ny, nz, desired_padding_x, desired_padding_y, desired_padding_z, true, false)));
+    workspaces.push_back(extra_workspaces.back().get());
+  }
+
+  RunEnsemblePipeline(static_cast<size_t>(std::max(n_fields, 0)), n_buffers,
+    [&](size_t /*m*/, size_t b) {
+      Profiling::ScopedTimer timer("noise");
+      FillGaussianNoise(&noise[b](0, 0, 0), nx_tot, ny_tot, nz_tot, NULL);
+    },
+    [&](size_t /*m*/, size_t b, size_t w) {
+      FFTGrid3D<double> & work = *workspaces[w];
+      {
+        Profiling::ScopedTimer timer("initialize");
+        work.Initialize(noise[b]);
+      }
+      work.DoFFT();
+      {
+        Profiling::ScopedTimer timer("convolve");
+        for (size_t i = 0; i < n_complex; i++)
+          work.ComplexData()[i] *= spectrum[i];
+      }
+      work.DoInverseFFT();
+    },
+    [&](size_t /*m*/, size_t w) {
+      Profiling::ScopedTimer timer("extract");
+      grid_out.push_back(workspaces[w]->GetRealGrid());
+    });
+}
+
+
+void NRLib::Simulate3DGaussianField(const Variogram              & variogram,
+                                    const Volume                 & volume,
+                                    size_t                         nx,
+                                    size_t                         ny,
+                                    size_t                         nz,
+                                    int                            n_fields,
+                                    std::vector<Grid<double> > &   grid_out,
+                                    GaussianFieldPlan::Strategy    strategy)
+{
+  std::unique_ptr<Variogram> local(variogram.CloneInFrame(volume.GetAngle()));
+  Simulate3DGaussianField(*local,
+                          nx, volume.GetLX() / nx,
+                          ny, volume.GetLY() / ny,
+                          nz, volume.GetLZ() / nz,
+                          n_fields, grid_out,
+                          -1, -1, -1, 1.0, 1.0, 1.0,
+                          strategy);
+}
+
+
+void NRLib::Simulate3DGaussianField(const Variogram              & variogram,
+                                    size_t                         nx,
+                                    double                         dx,
+                                    size_t                         ny,
+                                    double                         dy,
+                                    size_t                         nz,
+                                    double                         dz,
+                                    int                            n_fields,
+                                    GaussianFieldSink            & sink,
+                                    int                            padding_x,
+                                    int                            padding_y,
+                                    int                            padding_z,
+                                    double                         scaling_x,
+                                    double                         scaling_y,
+                                    double                         scaling_z,
+                                    GaussianFieldPlan::Strategy    strategy)
+{
+  Profiling::RunScope run;
+  Profiling::RecordFields(n_fields);
+
+  std::vector<size_t> default_padding;
+  {
+    Profiling::ScopedTimer timer("padding");
+    default_padding = FindNDimPadding(variogram,
+                                      nx,
+                                      dx,
+                                      ny,
+                                      dy,
+                                      nz,
+                                      dz);
+  }
+  // FindNDimPadding gives fewer directions when ny or nz is 1. No padding is
+  // needed in a direction with a single cell.
+  size_t desired_padding_x = (padding_x < 0) ? default_padding[0] : padding_x;
+  size_t desired_padding_y = (padding_y < 0) ? (default_padding.size() > 1 ? default_padding[1] : 0) : padding_y;
+  size_t desired_padding_z = (padding_z < 0) ? (default_padding.size() > 2 ? default_padding[2] : 0) : padding_z;
+
+  if (strategy == GaussianFieldPlan::SINGLE_PRECISION)
+    Simulate3DGaussianFieldLean<float>(variogram, nx, dx, ny, dy, nz, dz, n_fields, sink,
+                                       desired_padding_x, desired_padding_y, desired_padding_z,
+                                       scaling_x, scaling_y, scaling_z);
+  else
+    Simulate3DGaussianFieldLean<double>(variogram, nx, dx, ny, dy, nz, dz, n_fields, sink,
+                                        desired_padding_x, desired_padding_y, desired_padding_z,
+                                        scaling_x, scaling_y, scaling_z);
+}
+
+
+namespace {
+  // Copies the selected cells of each layer to the output. The cells are
+  // sorted by layer once, so each layer only visits its own cells.
+  class CellSink : public GaussianFieldSink {
+  public:
+    CellSink(const std::vector<size_t> & cells, size_t nx, size_t ny, size_t nz, double * values_out)
+      : n_cells_(cells.size()),
+        layer_start_(nz + 1, 0),
+        i_(cells.size()),
+        j_(cells.size()),
+        position_(cells.size()),
+        values_out_(values_out),
+        values_(NULL)
+    {
+      for (size_t c = 0; c < cells.size(); c++) {
+        if (cells[c] >= nx * ny * nz)
+          throw Exception("Cell index " + ToString(cells[c]) + " is outside the grid of "
+                          + ToString(nx * ny * nz) + " cells.");
+        layer_start_[cells[c] / (nx * ny) + 1]++;
+      }
+      for (size_t k = 0; k < nz; k++)
+        layer_start_[k + 1] += layer_start_[k];
+      std::vector<size_t> next(layer_start_.begin(), layer_start_.end() - 1);
+      for (size_t c = 0; c < cells.size(); c++) {
+        size_t ij    = cells[c] % (nx * ny);
+        size_t p     = next[cells[c] / (nx * ny)]++;
+        i_[p]        = ij % nx;
+        j_[p]        = ij / nx;
+        position_[p] = c;
+      }
+      n_threads_ = std::max(1U, std::thread::hardware_concurrency());
+    }
+
+    void BeginField(int m)
+    {
+      values_ = values_out_ + static_cast<size_t>(m) * n_cells_;
+    }
+
+    void AddLayer(size_t k, size_t /*ni*/, size_t /*nj*/, const double * values, size_t stride)
+    {
+      CopyLayer(k, values, stride);
+    }
+
+    void AddLayer(size_t k, size_t /*ni*/, size_t /*nj*/, const float * values, size_t stride)
+    {
+      CopyLayer(k, values, stride);
+    }
+
+  private:
+    template <typename T>
+    void CopyLayer(size_t k, const T * values, size_t stride)
+    {
+      size_t first = layer_start_[k];
+      size_t n     = layer_start_[k + 1] - first;
+      auto copy = [&](size_t begin, size_t end) {
+        for (size_t p = first + begin; p < first + end; p++)
+          values_[position_[p]] = values[i_[p] + j_[p] * stride];
+      };
+      // Threads only pay off for large layers.
+      size_t n_threads = std::min<size_t>(n_threads_, n / 65536 + 1);
+      if (n_threads <= 1) {
+        copy(0, n);
+        return;
+      }
+      std::vector<std::thread> threads;
+      for (size_t t = 0; t < n_threads; t++)
+        threads.push_back(std::thread(copy, t * n / n_threads, (t + 1) * n / n_threads));
+      for (size_t t = 0; t < threads.size(); t++)
+        threads[t].join();
+    }
 
-  // Covariance grid.
-  Grid<double> cov = FFTCovGrid3D(variogram,
-                                  static_cast<int>(nx_tot),
-                                  dx,
-                                  static_cast<int>(ny_tot),
-                                  dy,
-                                  static_cast<int>(nz_tot),
-                                  dz,
-                                  scaling_x,
-                                  scaling_y,
-                                  scaling_z).GetCov();
-
-  FFTGrid3D<double> filter(nx,
-                           ny,
-                           nz,
-                           desired_padding_x,
-                           desired_padding_y,
-                           desired_padding_z,
-                           false);
-
-
-  filter.Initialize(cov);
-  filter.DoFFT();
-  // Convolve with covariance grid.
-  for (size_t i = 0; i < filter.GetComplexNI()*filter.GetComplexNJ()*filter.GetComplexNK(); i++) {
-    filter.ComplexData()[i].real(std::max(filter.ComplexData()[i].real(), 0.0));
-    filter.ComplexData()[i].imag(0.0);
-    filter.ComplexData()[i] = std::sqrt(filter.ComplexData()[i]);
-  }
-
-  // Grid with white noice.
-  Grid<double> noise(nx_tot, ny_tot, nz_tot);
-
-  ////if (seed == -999)
-  ////  seed = NRLib::Random::DrawUint32();
-  //// This is done to be able to do multithreading
-  ////NRLib::RandomGenerator random;
-  //// random.Initialize(seed);
-  //if (rg == NULL) {
-  //  rg = new RandomGenerator();
-  //  rg->Initialize(NRLib::Random::DrawUint32());
-  //}
+    size_t              n_cells_;
+    std::vector<size_t> layer_start_;
+    std::vector<size_t> i_;
+    std::vector<size_t> j_;
+    std::vector<size_t> position_;
+    double            * values_out_;
+    double            * values_;
+    size_t              n_threads_;
+  };
+}
+
+void NRLib::SimulateGaussianFieldAtCells(const Variogram             & variogram,
+                                         size_t                        nx,
+                                         double                        dx,
+                                         size_t                        ny,
+                                         double                        dy,
+                                         size_t                        nz,
+                                         double                        dz,
+                                         const std::vector<size_t>   & cells,
+                                         int                           n_fields,
+                                         double                      * values_out,
+                                         GaussianFieldPlan::Strategy   strategy)
+{
+  CellSink sink(cells, nx, ny, nz, values_out);
+  Simulate3DGaussianField(variogram, nx, dx, ny, dy, nz, dz, n_fields, sink, -1, -1, -1, 1.0, 1.0, 1.0, strategy);
+}
+
+void NRLib::Simulate3DGaussianFieldSlabs(const Variogram        & variogram,
+                                         double                   range_z,
+                                         size_t                   nx,
+                                         double                   dx,
+                                         size_t                   ny,
+                                         double                   dy,
+                                         size_t                   nz,
+                                         double                   dz,
+                                         int                      n_fields,
+                                         GaussianFieldSink      & sink,
+                                         NRLib::RandomGenerator * rg,
+                                         int                      padding_x,
+                                         int                      padding_y)
+{
+  if (variogram.GetDipAngle() != 0.0)
+    throw Exception("The horizontal variogram of a slab simulation cannot have dip.");
+  if (range_z <= 0.0)
+    throw Exception("Slab simulation needs a positive vertical range.");
+
+  Profiling::RunScope run;
+  Profiling::RecordFields(n_fields);
+
+  std::vector<size_t> default_padding;
+  {
+    Profiling::ScopedTimer timer("padding");
+    default_padding = FindNDimPadding(variogram, nx, dx, ny, dy);
+  }
+  // FindNDimPadding gives only the x direction when ny is 1.
+  size_t desired_padding_x = (padding_x < 0) ? default_padding[0] : padding_x;
+  size_t desired_padding_y = (padding_y < 0) ? (default_padding.size() > 1 ? default_padding[1] : 0) : padding_y;
+
+  FFTGrid2D<double> fftgrid(nx, ny, desired_padding_x, desired_padding_y, true, false);
+  size_t nx_tot    = fftgrid.GetNItot();
+  size_t ny_tot    = fftgrid.GetNJtot();
+  size_t n_real    = nx_tot * ny_tot;
+  size_t n_complex = fftgrid.GetComplexNI() * fftgrid.GetComplexNJ();
+  Profiling::RecordPaddedSize(nx_tot, ny_tot);
+
+  // Filter of the horizontal covariance, as in the lean 2D simulation.
+  Profiling::ScopedAllocation spectrum_allocation(n_complex * sizeof(double) + n_real * sizeof(double));
+  std::vector<double> spectrum(n_complex);
+  {
+    Profiling::ScopedTimer timer("covariance");
+    FFTCovGrid2D cov_grid(variogram, static_cast<int>(nx_tot), dx, static_cast<int>(ny_tot), dy);
+    const std::vector<double> & cov = cov_grid.GetCov().GetStorage();
+    std::copy(cov.begin(), cov.end(), fftgrid.RealData());
+  }
+  {
+    Profiling::ScopedTimer timer("filter");
+    NRLibPrivate::ComputeFFT2D(nx_tot, ny_tot, fftgrid.RealData(), fftgrid.ComplexData());
+    for (size_t i = 0; i < n_complex; i++)
+      spectrum[i] = std::sqrt(std::max(fftgrid.ComplexData()[i].real(), 0.0));
+  }
+
+  // The noise of layer k is rho times the noise of layer k - 1 plus
+  // independent noise, which gives the correlation exp(-3|dz|/range_z)
+  // between the layers, since the filter is linear.
+  double rho        = std::exp(-3.0 * dz / range_z);
+  double innovation = std::sqrt(1.0 - rho * rho);
+  std::vector<double> noise(n_real);
   for (int m = 0; m < n_fields; m++) {
-    for (size_t i = 0; i < nx_tot; i++)
-      for (size_t j = 0; j < ny_tot; j++)
-        for (size_t k = 0; k < nz_tot; k++)
-          noise(i, j, k) = NRLib::Random::Norm01();
+    sink.BeginField(m);
+    for (size_t k = 0; k < nz; k++) {
+      {
+        Profiling::ScopedTimer timer("noise");
+        double * data = fftgrid.RealData();
+        FillGaussianNoise(data, nx_tot, ny_tot, 1, rg);
+        if (k == 0) {
+          std::copy(data, data + n_real, noise.begin());
+        }
+        else {
+          for (size_t i = 0; i < n_real; i++) {
+            noise[i] = rho * noise[i] + innovation * data[i];
+            data[i]  = noise[i];
+          }
+        }
+      }
+
+      fftgrid.DoFFT();
+      {
+        Profiling::ScopedTimer timer("convolve");
+        for (size_t i = 0; i < n_complex; i++)
+          fftgrid.ComplexData()[i] *= spectrum[i];
+      }
+      fftgrid.DoInverseFFT();
+
+      Profiling::ScopedTimer timer("extract");
+      sink.AddLayer(k, nx, ny, fftgrid.RealData(), nx_tot);
+    }
+    sink.EndField(m);
+  }
+}
+
+namespace {
+  // Aligned buffer for FFTW from the workspace pool, released on scope exit.
+  template <typename T>
+  class FFTWBuffer {
+  public:
+    explicit FFTWBuffer(size_t n) : data_(reinterpret_cast<T*>(WorkspacePool::Acquire(n * sizeof(T)))), n_(n) {}
+    ~FFTWBuffer() { WorkspacePool::Release(data_, n_ * sizeof(T)); }
+    T * Data() { return data_; }
+  private:
+    T *    data_;
+    size_t n_;
+    FFTWBuffer(const FFTWBuffer &);
+    FFTWBuffer & operator=(const FFTWBuffer &);
+  };
+}
+
+void NRLib::SimulateMultipleGaussianFields(const std::vector<const Variogram *> & variograms,
+                                           size_t                                 nx,
+                                           double                                 dx,
+                                           size_t                                 ny,
+                                           double                                 dy,
+                                           size_t                                 nz,
+                                           double                                 dz,
+                                           std::vector<Grid<double> >           & grid_out,
+                                           int                                    padding_x,
+                                           int                                    padding_y,
+                                           int                                    padding_z)
+{
+  Profiling::RunScope run;
+  size_t n_fields = variograms.size();
+  Profiling::RecordFields(static_cast<int>(n_fields));
+  if (n_fields == 0)
+    return;
+
+  size_t n_dim = (ny <= 1) ? 1 : ((nz <= 1) ? 2 : 3);
+  if (n_dim < 3)
+    nz = 1;
+  if (n_dim < 2)
+    ny = 1;
+
+  // Common padding, large enough for all variograms.
+  size_t nx_tot, ny_tot, nz_tot;
+  {
+    Profiling::ScopedTimer timer("padding");
+    std::vector<size_t> padding(3, 0);
+    for (size_t m = 0; m < n_fields; m++) {
+      std::vector<size_t> pad = FindNDimPadding(*variograms[m], nx, dx, ny, dy, nz, dz);
+      for (size_t d = 0; d < pad.size(); d++)
+        padding[d] = std::max(padding[d], pad[d]);
+    }
+    if (padding_x >= 0)
+      padding[0] = padding_x;
+    if (padding_y >= 0 && n_dim > 1)
+      padding[1] = padding_y;
+    if (padding_z >= 0 && n_dim > 2)
+      padding[2] = padding_z;
+    // Same sizes as FFTGrid3D.
+    nx_tot = FindNewSizeWithPadding(nx + padding[0], true);
+    ny_tot = FindNewSizeWithPadding(ny + padding[1]);
+    nz_tot = FindNewSizeWithPadding(nz + padding[2]);
+  }
+  Profiling::RecordPaddedSize(nx_tot, ny_tot, nz_tot);
+
+  std::vector<int> n;  // FFTW ordering, slowest varying dimension first
+  if (n_dim > 2)
+    n.push_back(static_cast<int>(nz_tot));
+  if (n_dim > 1)
+    n.push_back(static_cast<int>(ny_tot));
+  n.push_back(static_cast<int>(nx_tot));
 
-    fftgrid.Initialize(noise);
+  size_t n_real    = nx_tot * ny_tot * nz_tot;
+  size_t n_complex = (nx_tot / 2 + 1) * ny_tot * nz_tot;
+  int    howmany   = static_cast<int>(n_fields);
 
-    fftgrid.DoFFT();
-    for (size_t i = 0; i < filter.GetComplexNI()*filter.GetComplexNJ()*filter.GetComplexNK(); i++)
-      fftgrid.ComplexData()[i] *= filter.ComplexData()[i];
+  Profiling::ScopedAllocation buffer_allocation(n_fields * (n_real * sizeof(double)
+                                                            + n_complex * (sizeof(std::complex<double>) + sizeof(double))));
+  FFTWBuffer<double>               real(n_fields * n_real);
+  FFTWBuffer<std::complex<double> > complex(n_fields * n_complex);
+  std::vector<double>              spectra(n_fields * n_complex);
 
-    fftgrid.DoInverseFFT();
-    grid_out.push_back(fftgrid.GetRealGrid());
+  {
+    Profiling::ScopedTimer timer("covariance");
+    for (size_t m = 0; m < n_fields; m++) {
+      double * cov = real.Data() + m * n_real;
+      if (n_dim == 1) {
+        FFTCovGrid1D cov_grid(*variograms[m], static_cast<int>(nx_tot), dx);
+        std::copy(cov_grid.GetCov().begin(), cov_grid.GetCov().end(), cov);
+      }
+      else if (n_dim == 2) {
+        FFTCovGrid2D cov_grid(*variograms[m], static_cast<int>(nx_tot), dx, static_cast<int>(ny_tot), dy);
+        std::copy(cov_grid.GetCov().GetStorage().begin(), cov_grid.GetCov().GetStorage().end(), cov);
+      }
+      else {
+        FFTCovGrid3D cov_grid(*variograms[m], static_cast<int>(nx_tot), dx, static_cast<int>(ny_tot), dy,
+                              static_cast<int>(nz_tot), dz);
+        std::copy(cov_grid.GetCov().GetStorage().begin(), cov_grid.GetCov().GetStorage().end(), cov);
+      }
+    }
+  }
+  {
+    // All filter spectra in one transform. Unscaled, as in the single field simulation.
+    Profiling::ScopedTimer timer("filter");
+    NRLibPrivate::ComputeFFTMany(n, howmany, real.Data(), complex.Data());
+    for (size_t i = 0; i < n_fields * n_complex; i++)
+      spectra[i] = std::sqrt(std::max(complex.Data()[i].real(), 0.0));
+  }
+
+  {
+    // One generator per field, so that the values do not depend on the
+    // number of threads.
+    Profiling::ScopedTimer timer("noise");
+    std::vector<unsigned long> seeds(n_fields);
+    for (size_t m = 0; m < n_fields; m++)
+      seeds[m] = NRLib::Random::DrawUint32();
+
+    double scale   = 1.0 / std::sqrt(static_cast<double>(n_real));
+    double * noise = real.Data();
+    size_t n_threads = std::min<size_t>(n_fields, std::max(1U, std::thread::hardware_concurrency()));
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < n_threads; t++) {
+      threads.push_back(std::thread([&, t]() {
+        for (size_t m = t; m < n_fields; m += n_threads) {
+          RandomGenerator rg(seeds[m]);
+          double * field = noise + m * n_real;
+          FillGaussianNoise(field, n_real, 1, 1, &rg);
+          for (size_t i = 0; i < n_real; i++)
+            field[i] *= scale;
+        }
+      }));
+    }
+    for (size_t t = 0; t < threads.size(); t++)
+      threads[t].join();
+  }
+
+  {
+    Profiling::ScopedTimer timer("fft");
+    NRLibPrivate::ComputeFFTMany(n, howmany, real.Data(), complex.Data());
+  }
+  {
+    Profiling::ScopedTimer timer("convolve");
+    for (size_t i = 0; i < n_fields * n_complex; i++)
+      complex.Data()[i] *= spectra[i];
+  }
+  {
+    Profiling::ScopedTimer timer("inverse_fft");
+    NRLibPrivate::ComputeFFTManyInverse(n, howmany, complex.Data(), real.Data());
+  }
+
+  Profiling::ScopedTimer timer("extract");
+  double scale = 1.0 / std::sqrt(static_cast<double>(n_real));
+  for (size_t m = 0; m < n_fields; m++) {
+    const double * field = real.Data() + m * n_real;
+    Grid<double> grid(nx, ny, nz);
+    for (size_t k = 0; k < nz; k++)
+      for (size_t j = 0; j < ny; j++)
+        for (size_t i = 0; i < nx; i++)
+          grid(i, j, k) = scale * field[i + nx_tot * (j + ny_tot * k)];
+    grid_out.push_back(grid);
   }
 }
 
@@ -198,10 +947,12 @@ void NRLib::Simulate2DGaussianField(const Variogram& variogram,
                                     // bool   user_defined_padding,
                                     Grid2D<double> & grid_out)
 {
+  RandomGenerator   local_rg;
   RandomGenerator * rg = NULL;
   try {
     unsigned long seed = Random::GetStartSeed();
-    rg = new RandomGenerator(seed);
+    local_rg.Initialize(seed);
+    rg = &local_rg;
   }
   catch (std::exception) {
     // This will occur if NRLib::Random is not initilized. In this case,
@@ -232,70 +983,199 @@ void NRLib::Simulate2DGaussianField(const Variogram              & variogram,
                                     int                            padding_x,
                                     int                            padding_y,
                                     double                         scaling_x,
-                                    double                         scaling_y)
+                                    double                         scaling_y,
+                                    GaussianFieldPlan::Strategy    strategy)
 {
-  std::vector<size_t> default_padding = FindNDimPadding(variogram,
-                                                        nx,
-                                                        dx,
-                                                        ny,
-                                                        dy);
+  Profiling::RunScope run;
+  Profiling::RecordFields(n_fields);
+
+  std::vector<size_t> default_padding;
+  {
+    Profiling::ScopedTimer timer("padding");
+    default_padding = FindNDimPadding(variogram,
+                                      nx,
+                                      dx,
+                                      ny,
+                                      dy);
+  }
   // This is the desired padding, but may not be the actual of the
   // FFT grid. See below.
   size_t desired_padding_x = (padding_x < 0) ? default_padding[0] : padding_x;
   size_t desired_padding_y = (padding_y < 0) ? default_padding[1] : padding_y;
-  FFTGrid2D<double> fftgrid(nx, ny, desired_padding_x, desired_padding_y, true);
+
+  if (strategy != GaussianFieldPlan::STANDARD) {
+    RandomGenerator local_rg;
+    if (rg == NULL) {
+      local_rg.Initialize(NRLib::Random::DrawUint32());
+      rg = &local_rg;
+    }
+    Grid2DCollector collector(grid_out);
+    if (strategy == GaussianFieldPlan::LEAN)
+      Simulate2DGaussianFieldLean<double>(variogram, nx, dx, ny, dy, n_fields, collector, rg,
+                                          desired_padding_x, desired_padding_y, scaling_x, scaling_y);
+    else
+      Simulate2DGaussianFieldLean<float>(variogram, nx, dx, ny, dy, n_fields, collector, rg,
+                                         desired_padding_x, desired_padding_y, scaling_x, scaling_y);
+    return;
+  }
+
+  FFTGrid2D<double> fftgrid(nx, ny, desired_padding_x, desired_padding_y, true, false);
 
   // Get the total grid size after the grid is created. This is not necessarily the
   // same as nx + desired_padding_x. FFTGrid2D may add even more padding so that the
   // total grid size is more favorable for the FFT implementation.
   size_t nx_tot = fftgrid.GetNItot();
   size_t ny_tot = fftgrid.GetNJtot();
+  Profiling::RecordPaddedSize(nx_tot, ny_tot);
+
+  // Filter, read from the cache if possible.
+  size_t n_complex = fftgrid.GetComplexNI()*fftgrid.GetComplexNJ();
+  std::string key  = FilterSpectrum::MakeKey(variogram, "complex", nx_tot, dx, ny_tot, dy, 1, 1.0,
+                                             scaling_x, scaling_y);
+  std::shared_ptr<const FilterSpectrum> filter = FilterSpectrum::Get(key, n_complex, [&](std::vector<double> & spectrum) {
+    // Covariance grid.
+    Profiling::ScopedAllocation cov_allocation(nx_tot * ny_tot * sizeof(double));
+    Grid2D<double> cov;
+    {
+      Profiling::ScopedTimer timer("covariance");
+      cov = FFTCovGrid2D(variogram,
+                         static_cast<int>(nx_tot),
+                         dx,
+                         static_cast<int>(ny_tot),
+                         dy,
+                         scaling_x,
+                         scaling_y).GetCov();
+    }
+
+    FFTGrid2D<double> filter_grid(nx, ny, desired_padding_x, desired_padding_y, false, false);
+    Profiling::ScopedTimer timer("filter");
+    filter_grid.Initialize(cov);
+    filter_grid.DoFFT();
+    spectrum.resize(n_complex);
+    for (size_t i = 0; i < n_complex; i++) {
+      std::complex<double> value(std::max(filter_grid.ComplexData()[i].real(), 0.0), 0.0);
+      spectrum[i] = std::sqrt(value).real();
+    }
+  });
+  const double * spectrum = filter->Data();
 
-  // Covariance grid.
-  Grid2D<double> cov = FFTCovGrid2D(variogram,
-                                    static_cast<int>(nx_tot),
-                                    dx,
-                                    static_cast<int>(ny_tot),
-                                    dy,
-                                    scaling_x,
-                                    scaling_y).GetCov();
-
-
-  FFTGrid2D<double> filter(nx, ny, desired_padding_x, desired_padding_y, false);
-  filter.Initialize(cov);
-  filter.DoFFT();
-  // Convolve with covariance grid.
-  for (size_t i = 0; i < filter.GetComplexNI()*filter.GetComplexNJ(); i++) {
-    filter.ComplexData()[i].real(std::max(filter.ComplexData()[i].real(), 0.0));
-    filter.ComplexData()[i].imag(0.0);
-    filter.ComplexData()[i] = std::sqrt(filter.ComplexData()[i]);
-  }
-
-  // Grid with white noice.
-  Grid2D<double> noise(nx_tot,ny_tot);
-
-  //if (seed == -999)
-  //  seed = NRLib::Random::DrawUint32();
-  // This is done to be able to do multithreading
-  //NRLib::RandomGenerator random;
- // random.Initialize(seed);
+  // A local generator is used to be able to do multithreading
+  RandomGenerator local_rg;
   if(rg == NULL) {
-    rg = new RandomGenerator();
-    rg->Initialize(NRLib::Random::DrawUint32());
+    local_rg.Initialize(NRLib::Random::DrawUint32());
+    rg = &local_rg;
   }
-  for (int k = 0; k < n_fields; k++) {
-    for (size_t i = 0; i < nx_tot; i++)
-      for (size_t j = 0; j < ny_tot; j++)
-        noise(i,j) = rg->Norm01();
 
-    fftgrid.Initialize(noise);
+  // Grids with white noise, and FFT grids, as in Simulate3DGaussianField.
+  size_t n_buffers = std::min(static_cast<size_t>(std::max(n_fields, 1)), static_cast<size_t>(2));
+  Profiling::ScopedAllocation noise_allocation(n_buffers * nx_tot * ny_tot * sizeof(double));
+  std::vector<Grid2D<double> > noise(n_buffers, Grid2D<double>(nx_tot, ny_tot));
+  std::vector<FFTGrid2D<double> *>                  workspaces(1, &fftgrid);
+  std::vector<std::unique_ptr<FFTGrid2D<double> > > extra_workspaces;
+  for (size_t b = 1; b < n_buffers; b++) {
+    extra_workspaces.push_back(std::unique_ptr<FFTGrid2D<double> >(
+      new FFTGrid2D<double>(nx, ny, desired_padding_x, desired_padding_y, true, false)));
+    workspaces.push_back(extra_workspaces.back().get());
+  }
 
-    fftgrid.DoFFT();
-    for(size_t i = 0; i < filter.GetComplexNI()*filter.GetComplexNJ(); i++)
-      fftgrid.ComplexData()[i] *= filter.ComplexData()[i];
+  RunEnsemblePipeline(static_cast<size_t>(std::max(n_fields, 0)), n_buffers,
+    [&](size_t /*k*/, size_t b) {
+      Profiling::ScopedTimer timer("noise");
+      FillGaussianNoise(&noise[b](0, 0), nx_tot, ny_tot, 1, rg);
+    },
+    [&](size_t /*k*/, size_t b, size_t w) {
+      FFTGrid2D<double> & work = *workspaces[w];
+      {
+        Profiling::ScopedTimer timer("initialize");
+        work.Initialize(noise[b]);
+      }
+      work.DoFFT();
+      {
+        Profiling::ScopedTimer timer("convolve");
+        for (size_t i = 0; i < n_complex; i++)
+          work.ComplexData()[i] *= spectrum[i];
+      }
+      work.DoInverseFFT();
+    },
+    [&](size_t /*k*/, size_t w) {
+      Profiling::ScopedTimer timer("extract");
+      grid_out.push_back(workspaces[w]->GetRealGrid());
+    });
+}
 
-    fftgrid.DoInverseFFT();
-    grid_out.push_back(fftgrid.GetRealGrid());
+void NRLib::Simulate2DGaussianField(const Variogram              & variogram,
+                                    size_t                         nx,
+                                    double                         dx,
+                                    size_t                         ny,
+                                    double                         dy,
+                                    int                            n_fields,
+                                    GaussianFieldSink            & sink,
+                                    NRLib::RandomGenerator       * rg,
+                                    int                            padding_x,
+                                    int                            padding_y,
+                                    double                         scaling_x,
+                                    double                         scaling_y,
+                                    GaussianFieldPlan::Strategy    strategy)
+{
+  Profiling::RunScope run;
+  Profiling::RecordFields(n_fields);
+
+  std::vector<size_t> default_padding;
+  {
+    Profiling::ScopedTimer timer("padding");
+    default_padding = FindNDimPadding(variogram,
+                                      nx,
+                                      dx,
+                                      ny,
+                                      dy);
+  }
+  size_t desired_padding_x = (padding_x < 0) ? default_padding[0] : padding_x;
+  size_t desired_padding_y = (padding_y < 0) ? default_padding[1] : padding_y;
+
+  // Same generator as in the standard simulation, so the fields are the same
+  RandomGenerator local_rg;
+  if (rg == NULL) {
+    local_rg.Initialize(NRLib::Random::DrawUint32());
+    rg = &local_rg;
+  }
+  if (strategy == GaussianFieldPlan::SINGLE_PRECISION)
+    Simulate2DGaussianFieldLean<float>(variogram, nx, dx, ny, dy, n_fields, sink, rg,
+                                       desired_padding_x, desired_padding_y, scaling_x, scaling_y);
+  else
+    Simulate2DGaussianFieldLean<double>(variogram, nx, dx, ny, dy, n_fields, sink, rg,
+                                        desired_padding_x, desired_padding_y, scaling_x, scaling_y);
+}
+
+namespace {
+  // Padded size of a 1D grid, chosen as in FFTGrid2D but not necessarily even.
+  size_t Find1DPaddedSize(const NRLib::Variogram & variogram, size_t nx, double dx, int padding)
+  {
+    NRLib::Profiling::ScopedTimer timer("padding");
+    size_t nx_pad = (padding < 0) ? NRLib::FindNDimPadding(variogram, nx, dx)[0] : padding;
+    return NRLib::FindNewSizeWithPadding(nx + nx_pad);
+  }
+
+  // Half-complex filter spectrum for 1D simulation, using real and complex
+  // as work space. The filter includes the scaling of both transforms, so
+  // that unscaled noise gives the field directly.
+  void Compute1DFilter(const NRLib::Variogram & variogram,
+                       size_t                   nxp,
+                       double                   dx,
+                       double                   scaling_x,
+                       double                 * real,
+                       std::complex<double>   * complex,
+                       std::vector<double>    & filter)
+  {
+    {
+      NRLib::Profiling::ScopedTimer timer("covariance");
+      std::vector<double> cov = NRLib::FFTCovGrid1D(variogram, static_cast<int>(nxp), dx, scaling_x).GetCov();
+      std::copy(cov.begin(), cov.end(), real);
+    }
+    NRLib::Profiling::ScopedTimer timer("filter");
+    NRLib::NRLibPrivate::ComputeFFTMany(std::vector<int>(1, static_cast<int>(nxp)), 1, real, complex);
+    filter.resize(nxp / 2 + 1);
+    for (size_t i = 0; i < filter.size(); i++)
+      filter[i] = std::sqrt(std::max(complex[i].real(), 0.0)) / static_cast<double>(nxp);
   }
 }
 
@@ -308,47 +1188,227 @@ NRLib::Simulate1DGaussianField(const Variogram       & variogram,
                                int                     padding,
                                double                  scaling_x)
 {
-  std::vector<size_t> default_padding = FindNDimPadding(variogram,
-                                                        nx,
-                                                        dx);
-  size_t nx_pad = (padding < 0) ? default_padding[0] : padding;
+  Profiling::RunScope run;
+  Profiling::RecordFields(1);
 
-  // Find a favorable grid size (nx + padding) for the FFT implementation
-  size_t nxp = NRLib::FindNewSizeWithPadding(nx + nx_pad);
+  size_t nxp = Find1DPaddedSize(variogram, nx, dx, padding);
+  size_t nxc = nxp / 2 + 1;
+  Profiling::RecordPaddedSize(nxp);
+  // Noise and spectrum buffers, and the filter
+  Profiling::ScopedAllocation buffer_allocation(nxp * sizeof(double) + nxc * (sizeof(std::complex<double>) + sizeof(double)));
+  FFTWBuffer<double>                real(nxp);
+  FFTWBuffer<std::complex<double> > complex(nxc);
 
-  std::vector<double> cov = FFTCovGrid1D(variogram, static_cast<int>(nxp), dx, scaling_x).GetCov();
+  std::vector<double> filter;
+  Compute1DFilter(variogram, nxp, dx, scaling_x, real.Data(), complex.Data(), filter);
 
+  RandomGenerator local_rg;
   if(rg == NULL) {
-    rg = new RandomGenerator();
-    rg->Initialize(NRLib::Random::DrawUint32());
+    local_rg.Initialize(NRLib::Random::DrawUint32());
+    rg = &local_rg;
   }
-  std::vector<double> noise(nxp);
-  for(size_t i = 0; i < nxp; i++)
-    noise[i] = rg->Norm01();
-  std::vector<std::complex<double> > cov_fft;
-  std::vector<std::complex<double> > noise_fft;
-  NRLib::ComputeFFT1D(cov, cov_fft, false,0);
-  NRLib::ComputeFFT1D(noise, noise_fft, true,0);
-  std::vector<std::complex<double> > convolve(cov_fft.size());
-
-  for(size_t i = 0; i < cov_fft.size(); i++){
-    cov_fft[i].real(std::max(cov_fft[i].real(), 0.0));
-    cov_fft[i].imag(0.0);
-    cov_fft[i] = std::sqrt(cov_fft[i]);
+  {
+    Profiling::ScopedTimer timer("noise");
+    FillGaussianNoise(real.Data(), nxp, 1, 1, rg);
+  }
+  std::vector<int> n(1, static_cast<int>(nxp));
+  {
+    Profiling::ScopedTimer timer("fft");
+    NRLibPrivate::ComputeFFTMany(n, 1, real.Data(), complex.Data());
+  }
+  {
+    Profiling::ScopedTimer timer("convolve");
+    for(size_t i = 0; i < nxc; i++)
+      complex.Data()[i] *= filter[i];
+  }
+  {
+    Profiling::ScopedTimer timer("inverse_fft");
+    NRLibPrivate::ComputeFFTManyInverse(n, 1, complex.Data(), real.Data());
   }
 
-  for(size_t i = 0; i < cov_fft.size(); i++)
-    convolve[i] = cov_fft[i]*noise_fft[i];
+  Profiling::ScopedTimer timer("extract");
+  for(size_t i = 0; i < grid_out.size() && i < nxp; i++)
+    grid_out[i] = real.Data()[i];
+}
 
-  std::vector<double> tmp(nxp);
 
-  NRLib::ComputeFFTInv1D(convolve, tmp, true);
+void
+NRLib::Simulate1DGaussianTraces(const Variogram & variogram,
+                                size_t            nx,
+                                double            dx,
+                                size_t            n_traces,
+                                double          * traces_out,
+                                int               padding,
+                                double            scaling_x)
+{
+  Profiling::RunScope run;
+  Profiling::RecordFields(static_cast<int>(n_traces));
+  if (n_traces == 0)
+    return;
+
+  size_t nxp = Find1DPaddedSize(variogram, nx, dx, padding);
+  size_t nxc = nxp / 2 + 1;
+  Profiling::RecordPaddedSize(nxp);
+
+  // The traces are simulated in chunks, each with one batched transform, so
+  // that the work space does not grow with the number of traces.
+  const size_t max_chunk = 1024;
+  size_t chunk = std::min(n_traces, max_chunk);
+  Profiling::ScopedAllocation buffer_allocation(chunk * (nxp * sizeof(double) + nxc * sizeof(std::complex<double>))
+                                                + nxc * sizeof(double));
+  FFTWBuffer<double>                real(chunk * nxp);
+  FFTWBuffer<std::complex<double> > complex(chunk * nxc);
+
+  std::vector<double> filter;
+  Compute1DFilter(variogram, nxp, dx, scaling_x, real.Data(), complex.Data(), filter);
 
-  for(size_t i = 0; i < grid_out.size(); i++)
-    grid_out[i] = tmp[i];
+  // One generator per trace, seeded as Simulate1DGaussianField with rg = NULL,
+  // so that the values do not depend on the chunk size or number of threads.
+  std::vector<unsigned long> seeds(n_traces);
+  for (size_t t = 0; t < n_traces; t++)
+    seeds[t] = NRLib::Random::DrawUint32();
+
+  size_t n_threads = std::min<size_t>(chunk, std::max(1U, std::thread::hardware_concurrency()));
+  std::vector<int> n(1, static_cast<int>(nxp));
+  for (size_t first = 0; first < n_traces; first += chunk) {
+    size_t n_chunk = std::min(chunk, n_traces - first);
+    {
+      Profiling::ScopedTimer timer("noise");
+      std::vector<std::thread> threads;
+      for (size_t thread = 0; thread < n_threads; thread++) {
+        threads.push_back(std::thread([&, thread]() {
+          for (size_t t = thread; t < n_chunk; t += n_threads) {
+            RandomGenerator rg(seeds[first + t]);
+            FillGaussianNoise(real.Data() + t * nxp, nxp, 1, 1, &rg);
+          }
+        }));
+      }
+      for (size_t thread = 0; thread < threads.size(); thread++)
+        threads[thread].join();
+    }
+    {
+      Profiling::ScopedTimer timer("fft");
+      NRLibPrivate::ComputeFFTMany(n, static_cast<int>(n_chunk), real.Data(), complex.Data());
+    }
+    {
+      Profiling::ScopedTimer timer("convolve");
+      for (size_t t = 0; t < n_chunk; t++) {
+        std::complex<double> * spectrum = complex.Data() + t * nxc;
+        for (size_t i = 0; i < nxc; i++)
+          spectrum[i] *= filter[i];
+      }
+    }
+    {
+      Profiling::ScopedTimer timer("inverse_fft");
+      NRLibPrivate::ComputeFFTManyInverse(n, static_cast<int>(n_chunk), complex.Data(), real.Data());
+    }
+    Profiling::ScopedTimer timer("extract");
+    for (size_t t = 0; t < n_chunk; t++)
+      std::copy(real.Data() + t * nxp, real.Data() + t * nxp + nx, traces_out + (first + t) * nx);
+  }
 }
 
 
+void
+NRLib::SimulateGaussianFieldAtPoints(const Variogram        & variogram,
+                                     const double           * points,
+                                     size_t                   n_points,
+                                     size_t                   dim,
+                                     size_t                   n_features,
+                                     double                 * values_out,
+                                     NRLib::RandomGenerator * rg)
+{
+  if (dim < 1 || dim > 3)
+    throw Exception("The points must have 1, 2 or 3 coordinates.");
+  if (n_features == 0)
+    throw Exception("At least one spectral feature is needed.");
+  if (n_points == 0)
+    return;
+
+  std::unique_ptr<RandomGenerator> local_rg;
+  if (rg == NULL) {
+    local_rg.reset(new RandomGenerator(NRLib::Random::DrawUint32()));
+    rg = local_rg.get();
+  }
+
+  double variance = variogram.GetStdDev() * variogram.GetStdDev();
+  double nugget_variance = 0.0;
+  const NestedVario * nested = dynamic_cast<const NestedVario *>(&variogram);
+  if (nested != NULL) {
+    double sill = nested->GetNugget();
+    for (size_t i = 0; i < nested->GetNStructures(); i++)
+      sill += nested->GetWeight(i);
+    if (sill > 0.0)
+      nugget_variance = variance * nested->GetNugget() / sill;
+  }
+
+  // Feature f is a_f cos(w_f x) + b_f sin(w_f x), where a_f and b_f are
+  // independent N(0, s^2/n_features), which makes each value Gaussian.
+  std::vector<double> wx(n_features), wy(n_features), wz(n_features);
+  std::vector<double> a(n_features), b(n_features);
+  double scale = std::sqrt((variance - nugget_variance) / static_cast<double>(n_features));
+  {
+    Profiling::ScopedTimer timer("noise");
+    for (size_t f = 0; f < n_features; f++) {
+      double w[3];
+      variogram.DrawSpectralFrequency(*rg, w);
+      wx[f] = w[0];
+      wy[f] = w[1];
+      wz[f] = w[2];
+      a[f]  = scale * rg->Norm01();
+      b[f]  = scale * rg->Norm01();
+    }
+  }
+
+  // Coordinates relative to the first point, to keep the phases small.
+  double origin[3] = {0.0, 0.0, 0.0};
+  for (size_t d = 0; d < dim; d++)
+    origin[d] = points[d];
+
+  Profiling::ScopedTimer timer("convolve");
+  const size_t block_size = 256;
+  size_t n_blocks  = (n_points + block_size - 1) / block_size;
+  size_t n_threads = std::min<size_t>(n_blocks, std::max(1U, std::thread::hardware_concurrency()));
+  auto simulate_blocks = [&](size_t thread) {
+    std::vector<double> x(block_size), y(block_size), z(block_size), sum(block_size);
+    for (size_t block = thread; block < n_blocks; block += n_threads) {
+      size_t first = block * block_size;
+      size_t n     = std::min(block_size, n_points - first);
+      for (size_t i = 0; i < n; i++) {
+        const double * p = points + (first + i) * dim;
+        x[i]   = p[0] - origin[0];
+        y[i]   = (dim > 1) ? p[1] - origin[1] : 0.0;
+        z[i]   = (dim > 2) ? p[2] - origin[2] : 0.0;
+        sum[i] = 0.0;
+      }
+      for (size_t f = 0; f < n_features; f++) {
+        const double fx = wx[f], fy = wy[f], fz = wz[f];
+        const double fa = a[f],  fb = b[f];
+        for (size_t i = 0; i < n; i++) {
+          double phase = fx * x[i] + fy * y[i] + fz * z[i];
+          sum[i] += fa * std::cos(phase) + fb * std::sin(phase);
+        }
+      }
+      std::copy(sum.begin(), sum.begin() + n, values_out + first);
+    }
+  };
+  if (n_threads <= 1) {
+    simulate_blocks(0);
+  }
+  else {
+    std::vector<std::thread> threads;
+    for (size_t thread = 0; thread < n_threads; thread++)
+      threads.push_back(std::thread(simulate_blocks, thread));
+    for (size_t thread = 0; thread < threads.size(); thread++)
+      threads[thread].join();
+  }
+
+  if (nugget_variance > 0.0) {
+    double nugget_std = std::sqrt(nugget_variance);
+    for (size_t i = 0; i < n_points; i++)
+      values_out[i] += nugget_std * rg->Norm01();
+  }
+}
 /*
 void
 NRLib::Simulate1DGaussianField(NRLib::Matrix cov_in,
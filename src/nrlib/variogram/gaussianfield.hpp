@@ -25,9 +25,11 @@
 #include <cstdlib>
 #include <vector>
 #include "../random/randomgenerator.hpp"
+#include "gaussianfieldplan.hpp"
 
 namespace NRLib {
   class Variogram;
+  class Volume;
   template <typename T> class Grid2D;
   template <typename T> class Grid;
   size_t              FindGaussianFieldPadding(const Variogram & variogram, size_t grid_size, double range, double step);
@@ -39,6 +41,40 @@ namespace NRLib {
                                                size_t            nz = 1,
                                                double            dz = -1);
 
+  /// Fills the nx*ny*nz noise values of a simulation grid, stored with x
+  /// fastest, with standard normal numbers from rg, or from NRLib::Random if
+  /// rg is NULL. The numbers are made by FillNorm01 in storage order, unless
+  /// legacy noise is on, see SetLegacyNoise.
+  void FillGaussianNoise(double * data, size_t nx, size_t ny, size_t nz, RandomGenerator * rg);
+  void FillGaussianNoise(float  * data, size_t nx, size_t ny, size_t nz, RandomGenerator * rg);
+
+  /// With legacy noise, the simulations draw the noise one value at a time
+  /// with Norm01, with z fastest, as before FillNorm01 was used. This gives
+  /// the same fields from a seed as older versions, at the old speed. Off by
+  /// default. Applies to the whole process.
+  void SetLegacyNoise(bool legacy);
+  bool GetLegacyNoise();
+
+  /// Receives the fields simulated by Simulate3DGaussianField or
+  /// Simulate2DGaussianField one layer (fixed k) at a time, directly from the
+  /// FFT buffer, so that a complete realization never has to be stored.
+  class GaussianFieldSink {
+  public:
+    virtual ~GaussianFieldSink() {}
+
+    /// Called before the first layer of realization m.
+    virtual void BeginField(int /*m*/) {}
+
+    /// Layer k of the current realization. Value (i, j) is values[i + j*stride].
+    virtual void AddLayer(size_t k, size_t ni, size_t nj, const double * values, size_t stride) = 0;
+
+    /// Used with GaussianFieldPlan::SINGLE_PRECISION. Converts to double by default.
+    virtual void AddLayer(size_t k, size_t ni, size_t nj, const float * values, size_t stride);
+
+    /// Called after the last layer of realization m.
+    virtual void EndField(int /*m*/) {}
+  };
+
   void Simulate3DGaussianField(const Variogram              & variogram,
                                size_t                         nx,
                                double                         dx,
@@ -53,14 +89,106 @@ namespace NRLib {
                                int                            padding_z = -1,
                                double                         scaling_x = 1.0,
                                double                         scaling_y = 1.0,
-                               double                         scaling_z = 1.0);
+                               double                         scaling_z = 1.0,
+                               GaussianFieldPlan::Strategy    strategy  = GaussianFieldPlan::STANDARD);
+
+  /// Simulate on the grid of volume, with nx*ny*nz cells of size lx/nx,
+  /// ly/ny and lz/nz, in the local frame of the volume. The variogram is
+  /// given in the global frame, and is converted with CloneInFrame, so the
+  /// padding follows the rotated grid rather than its bounding box. Only the
+  /// thickness lz of the volume is used in the vertical direction.
+  void Simulate3DGaussianField(const Variogram              & variogram,
+                               const Volume                 & volume,
+                               size_t                         nx,
+                               size_t                         ny,
+                               size_t                         nz,
+                               int                            n_fields,
+                               std::vector<Grid<double> > &   grid_out,
+                               GaussianFieldPlan::Strategy    strategy  = GaussianFieldPlan::STANDARD);
+
+  /// As above, but passes the fields to sink instead of storing them. Always
+  /// keeps a single FFT grid, as with GaussianFieldPlan::LEAN, unless
+  /// strategy is SINGLE_PRECISION. ny and/or nz may be 1.
+  void Simulate3DGaussianField(const Variogram              & variogram,
+                               size_t                         nx,
+                               double                         dx,
+                               size_t                         ny,
+                               double                         dy,
+                               size_t                         nz,
+                               double                         dz,
+                               int                            n_fields,
+                               GaussianFieldSink            & sink,
+                               int                            padding_x = -1,
+                               int                            padding_y = -1,
+                               int                            padding_z = -1,
+                               double                         scaling_x = 1.0,
+                               double                         scaling_y = 1.0,
+                               double                         scaling_z = 1.0,
+                               GaussianFieldPlan::Strategy    strategy  = GaussianFieldPlan::LEAN);
+
+  /// As above, but only keeps the cells with index i + nx*(j + ny*k) in
+  /// cells, which may come in any order. Field m is written to
+  /// values_out[m*cells.size() + c] for cell c. The cells are copied directly
+  /// from the FFT buffer, by several threads for large layers, so the other
+  /// cells are never extracted.
+  void SimulateGaussianFieldAtCells(const Variogram             & variogram,
+                                    size_t                        nx,
+                                    double                        dx,
+                                    size_t                        ny,
+                                    double                        dy,
+                                    size_t                        nz,
+                                    double                        dz,
+                                    const std::vector<size_t>   & cells,
+                                    int                           n_fields,
+                                    double                      * values_out,
+                                    GaussianFieldPlan::Strategy   strategy = GaussianFieldPlan::LEAN);
+
+  /// Simulate 3D fields one layer at a time, with the separable covariance
+  /// C(dx, dy) exp(-3|dz|/range_z), where C is the horizontal covariance of
+  /// variogram. Only the horizontal ranges and azimuth of variogram are used,
+  /// and it cannot have dip. The noise of the layers is a vertical AR(1)
+  /// sequence, and each layer is filtered by a 2D FFT, so only one padded
+  /// layer is kept and there is no padding in z. The layers are passed to
+  /// sink. ny may be 1.
+  void Simulate3DGaussianFieldSlabs(const Variogram        & variogram,
+                                    double                   range_z,
+                                    size_t                   nx,
+                                    double                   dx,
+                                    size_t                   ny,
+                                    double                   dy,
+                                    size_t                   nz,
+                                    double                   dz,
+                                    int                      n_fields,
+                                    GaussianFieldSink      & sink,
+                                    NRLib::RandomGenerator * rg        = NULL,
+                                    int                      padding_x = -1,
+                                    int                      padding_y = -1);
+
+  /// Simulate one field for each variogram on the same grid. All fields use
+  /// the same padded grid, large enough for every variogram, so that the
+  /// filter spectra, noise and inverse transforms can be computed in batched
+  /// FFTs. ny and/or nz may be 1. Field m uses a random generator seeded
+  /// with the m'th draw from NRLib::Random, and the noise of the fields is
+  /// generated in parallel.
+  void SimulateMultipleGaussianFields(const std::vector<const Variogram *> & variograms,
+                                      size_t                                 nx,
+                                      double                                 dx,
+                                      size_t                                 ny,
+                                      double                                 dy,
+                                      size_t                                 nz,
+                                      double                                 dz,
+                                      std::vector<Grid<double> >           & grid_out,
+                                      int                                    padding_x = -1,
+                                      int                                    padding_y = -1,
+                                      int                                    padding_z = -1);
 
   /// Simulate 2D Gaussian fields. variogram specifies the variogram and
   /// nx/y, dx/y specify the size. n_fields is the number of realizations
   /// rg can be used to control the RNG. padding_x/y can be used to
   /// provide a custom padding (advanced functionality). padding_x/y
   /// values that are negative will be set to a size that is large enough
-  /// to avoid circular effects and ringing effects.
+  /// to avoid circular effects and ringing effects. strategy trades
+  /// memory for precision, see PlanGaussianFieldSimulation.
   void Simulate2DGaussianField(const Variogram &              variogram,
                                size_t                         nx,
                                double                         dx,
@@ -72,7 +200,26 @@ namespace NRLib {
                                int                            padding_x = -1,
                                int                            padding_y = -1,
                                double                         scaling_x = 1.0,
-                               double                         scaling_y = 1.0);
+                               double                         scaling_y = 1.0,
+                               GaussianFieldPlan::Strategy    strategy  = GaussianFieldPlan::STANDARD);
+
+  /// As above, but passes each field to sink as a single layer (k = 0)
+  /// instead of storing it. Always keeps a single FFT grid, as with
+  /// GaussianFieldPlan::LEAN, unless strategy is SINGLE_PRECISION. The fields
+  /// are the same as from the standard simulation.
+  void Simulate2DGaussianField(const Variogram              & variogram,
+                               size_t                         nx,
+                               double                         dx,
+                               size_t                         ny,
+                               double                         dy,
+                               int                            n_fields,
+                               GaussianFieldSink            & sink,
+                               NRLib::RandomGenerator        *rg = NULL,
+                               int                            padding_x = -1,
+                               int                            padding_y = -1,
+                               double                         scaling_x = 1.0,
+                               double                         scaling_y = 1.0,
+                               GaussianFieldPlan::Strategy    strategy  = GaussianFieldPlan::LEAN);
 
   void Simulate2DGaussianField(const Variogram& variogram,
                                size_t nx, double dx,
@@ -89,6 +236,34 @@ namespace NRLib {
                                int                      padding = -1,
                                double                   scaling_x = 1.0);
 
+  /// Simulate n_traces independent 1D fields with nx values each, written
+  /// one trace after the other to traces_out, which must hold n_traces*nx
+  /// values. The filter is computed once, and the traces are transformed in
+  /// batches. Trace t uses a random generator seeded with the t'th draw from
+  /// NRLib::Random, so the traces are the same as from n_traces calls to
+  /// Simulate1DGaussianField with rg = NULL. The noise is generated in parallel.
+  void Simulate1DGaussianTraces(const Variogram & variogram,
+                                size_t            nx,
+                                double            dx,
+                                size_t            n_traces,
+                                double          * traces_out,
+                                int               padding   = -1,
+                                double            scaling_x = 1.0);
+
+  /// Simulate a field at n_points scattered points without a grid, by a sum
+  /// of n_features random Fourier features with frequencies drawn from the
+  /// spectral measure of the variogram. points holds dim coordinates per
+  /// point, with dim from 1 to 3. The marginals are exactly Gaussian, while the
+  /// covariance converges to the variogram as n_features grows. A nugget effect
+  /// is added independently at each point. values_out must hold n_points values.
+  void SimulateGaussianFieldAtPoints(const Variogram        & variogram,
+                                     const double           * points,
+                                     size_t                   n_points,
+                                     size_t                   dim,
+                                     size_t                   n_features,
+                                     double                 * values_out,
+                                     NRLib::RandomGenerator * rg = NULL);
+
  // void Simulate1DGaussianField(NRLib::Matrix cov_in,
  //                              size_t nx,
 //                               std::vector<double> & grid_out);
@@ -0,0 +1,208 @@
+// Copyright (c)  2011, Norwegian Computing Center
+// All rights reserved.
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+// •  Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+// •  Redistributions in binary form must reproduce the above copyright notice, this list of
+//    conditions and the following disclaimer in the documentation and/or other materials
+//    provided with the distribution.
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+// OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <algorithm>
+#include <cmath>
+
+#include "gaussianfieldplan.hpp"
+#include "gaussianfield.hpp"
+
+#include "../exception/exception.hpp"
+#include "../fft/fft.hpp"
+#include "../fft/workspacepool.hpp"
+#include "../iotools/stringtools.hpp"
+
+using namespace NRLib;
+
+namespace {
+  /// Operations in a real-to-complex or complex-to-real transform of n points.
+  double RealFFTFlops(size_t n)
+  {
+    return n > 1 ? 2.5 * n * std::log2(static_cast<double>(n)) : 0.0;
+  }
+
+  void AddBuffer(GaussianFieldPlan & plan, const std::string & name, size_t bytes)
+  {
+    GaussianFieldPlan::Buffer buffer;
+    buffer.name  = name;
+    buffer.bytes = bytes;
+    plan.buffers.push_back(buffer);
+  }
+}
+
+
+std::string GaussianFieldPlan::StrategyName(Strategy strategy)
+{
+  switch (strategy) {
+    case STANDARD:         return "standard";
+    case LEAN:             return "lean";
+    case SINGLE_PRECISION: return "single_precision";
+  }
+  return "unknown";
+}
+
+
+GaussianFieldPlan NRLib::EstimateGaussianFieldResources(GaussianFieldPlan::Strategy strategy,
+                                                        const Variogram           & variogram,
+                                                        size_t                      nx,
+                                                        double                      dx,
+                                                        size_t                      ny,
+                                                        double                      dy,
+                                                        size_t                      nz,
+                                                        double                      dz,
+                                                        int                         n_fields,
+                                                        int                         padding_x,
+                                                        int                         padding_y,
+                                                        int                         padding_z)
+{
+  std::vector<size_t> default_padding = FindNDimPadding(variogram, nx, dx, ny, dy, nz, dz);
+  size_t n_dim  = default_padding.size();
+  size_t fields = static_cast<size_t>(std::max(n_fields, 0));
+
+  GaussianFieldPlan plan;
+  plan.strategy = strategy;
+
+  if (n_dim == 1) {
+    // Simulate1DGaussianField works on std::vectors with a mirrored complex spectrum.
+    plan.strategy = GaussianFieldPlan::STANDARD;
+    size_t nxp = FindNewSizeWithPadding(nx + ((padding_x < 0) ? default_padding[0] : padding_x));
+    plan.padded_size.push_back(nxp);
+
+    AddBuffer(plan, "covariance", nxp * sizeof(double));
+    AddBuffer(plan, "noise",      nxp * sizeof(double));
+    AddBuffer(plan, "spectra",    3 * nxp * sizeof(std::complex<double>));
+    AddBuffer(plan, "fft_work",   nxp * (sizeof(double) + sizeof(std::complex<double>)));
+    AddBuffer(plan, "result",     nxp * sizeof(double));
+    AddBuffer(plan, "output",     nx * sizeof(double));
+
+    plan.peak_bytes = 0;
+    for (size_t i = 0; i < plan.buffers.size(); ++i)
+      plan.peak_bytes += plan.buffers[i].bytes;
+
+    plan.flops = 3 * RealFFTFlops(nxp) + nxp + 8.0 * nxp;
+    return plan;
+  }
+
+  // Same sizes as FFTGrid2D/FFTGrid3D.
+  size_t ni = FindNewSizeWithPadding(nx + ((padding_x < 0) ? default_padding[0] : padding_x), true);
+  size_t nj = FindNewSizeWithPadding(ny + ((padding_y < 0) ? default_padding[1] : padding_y));
+  size_t nk = 1;
+  plan.padded_size.push_back(ni);
+  plan.padded_size.push_back(nj);
+  if (n_dim == 3) {
+    nk = FindNewSizeWithPadding(nz + ((padding_z < 0) ? default_padding[2] : padding_z));
+    plan.padded_size.push_back(nk);
+  }
+  else {
+    nz = 1;
+  }
+
+  size_t n          = ni * nj * nk;
+  size_t n_complex  = (ni / 2 + 1) * nj * nk;
+  size_t extra_real = (n_dim == 2) ? 1 : 0; // FFTGrid2D allocates one extra value
+  size_t t_size     = (strategy == GaussianFieldPlan::SINGLE_PRECISION) ? sizeof(float) : sizeof(double);
+
+  size_t fft_real    = (n + extra_real) * t_size;
+  size_t fft_complex = n_complex * 2 * t_size;
+  size_t covariance  = n * sizeof(double);
+  size_t output      = fields * nx * ny * nz * sizeof(double);
+
+  AddBuffer(plan, "fft_real",    fft_real);
+  AddBuffer(plan, "fft_complex", fft_complex);
+
+  size_t covariance_stage;
+  size_t field_stage;
+  if (strategy == GaussianFieldPlan::STANDARD) {
+    // The covariance and filter grids are freed when the spectrum is computed.
+    // With more than one field, the noise and FFT grids are double buffered,
+    // see RunEnsemblePipeline.
+    size_t n_buffers      = std::min(std::max(fields, static_cast<size_t>(1)), static_cast<size_t>(2));
+    size_t filter_real    = (n + extra_real) * sizeof(double);
+    size_t filter_complex = n_complex * sizeof(std::complex<double>);
+    size_t spectrum       = n_complex * sizeof(double);
+    size_t noise          = n_buffers * n * sizeof(double);
+    size_t workspaces     = (n_buffers - 1) * (fft_real + fft_complex);
+    AddBuffer(plan, "covariance",     covariance);
+    AddBuffer(plan, "filter_real",    filter_real);
+    AddBuffer(plan, "filter_complex", filter_complex);
+    AddBuffer(plan, "spectrum",       spectrum);
+    AddBuffer(plan, "noise",          noise);
+    if (workspaces > 0)
+      AddBuffer(plan, "fft_workspaces", workspaces);
+    // The covariance grid is copied out of FFTCovGrid2D/3D
+    covariance_stage = fft_real + fft_complex + covariance + std::max(covariance, filter_real + filter_complex + spectrum);
+    field_stage      = fft_real + fft_complex + workspaces + spectrum + noise + output;
+  }
+  else {
+    size_t spectrum = n_complex * t_size;
+    AddBuffer(plan, "covariance", covariance);
+    AddBuffer(plan, "spectrum",   spectrum);
+    covariance_stage = fft_real + fft_complex + covariance + spectrum;
+    field_stage      = fft_real + fft_complex + spectrum + output;
+  }
+  AddBuffer(plan, "output", output);
+  plan.peak_bytes = std::max(covariance_stage, field_stage);
+
+  // Filter transform and square root, then per field: forward and inverse
+  // transform, scaling, and the product with the filter.
+  double product = (strategy == GaussianFieldPlan::STANDARD) ? 6.0 : 2.0;
+  plan.flops = RealFFTFlops(n) + n_complex
+             + fields * (2 * RealFFTFlops(n) + 2.0 * n + product * n_complex);
+  return plan;
+}
+
+
+GaussianFieldPlan NRLib::PlanGaussianFieldSimulation(const Variogram & variogram,
+                                                     size_t            nx,
+                                                     double            dx,
+                                                     size_t            ny,
+                                                     double            dy,
+                                                     size_t            nz,
+                                                     double            dz,
+                                                     int               n_fields,
+                                                     size_t            max_memory,
+                                                     int               padding_x,
+                                                     int               padding_y,
+                                                     int               padding_z)
+{
+  GaussianFieldPlan::Strategy strategies[] = {GaussianFieldPlan::STANDARD,
+                                              GaussianFieldPlan::LEAN,
+                                              GaussianFieldPlan::SINGLE_PRECISION};
+  size_t n_strategies = (ny <= 1) ? 1 : 3;
+
+  GaussianFieldPlan plan;
+  for (size_t i = 0; i < n_strategies; ++i) {
+    plan = EstimateGaussianFieldResources(strategies[i], variogram, nx, dx, ny, dy, nz, dz,
+                                          n_fields, padding_x, padding_y, padding_z);
+    if (max_memory == 0)
+      return plan;
+    if (plan.peak_bytes <= max_memory) {
+      // Free buffers kept by WorkspacePool count against the budget. They
+      // are released rather than changing the strategy, which would change
+      // the result with SINGLE_PRECISION.
+      if (plan.peak_bytes + WorkspacePool::GetPooledBytes() > max_memory)
+        WorkspacePool::ReleaseUnused();
+      return plan;
+    }
+  }
+
+  throw Exception("The simulation needs at least " + ToString(plan.peak_bytes / 1048576.0, 1)
+                  + " MB of memory, but max_memory is " + ToString(max_memory / 1048576.0, 1)
+                  + " MB. Reduce the grid size or the padding.");
+}
@@ -0,0 +1,100 @@
+// Copyright (c)  2011, Norwegian Computing Center
+// All rights reserved.
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+// •  Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+// •  Redistributions in binary form must reproduce the above copyright notice, this list of
+//    conditions and the following disclaimer in the documentation and/or other materials
+//    provided with the distribution.
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+// OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef NRLIB_VARIOGRAM_GAUSSIANFIELDPLAN_HPP
+#define NRLIB_VARIOGRAM_GAUSSIANFIELDPLAN_HPP
+
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace NRLib {
+  class Variogram;
+
+  /// Memory and work estimate for Simulate1D/2D/3DGaussianField, and the
+  /// strategy used to keep a simulation within a memory budget.
+  struct GaussianFieldPlan {
+    enum Strategy {
+      /// Separate covariance, filter and noise grids.
+      STANDARD,
+      /// The covariance grid is released once the filter is computed, the
+      /// filter is kept as a real spectrum, and noise is drawn directly into
+      /// the FFT buffer. Gives the same result as STANDARD.
+      LEAN,
+      /// As LEAN, with the transforms in single precision.
+      SINGLE_PRECISION
+    };
+
+    static std::string StrategyName(Strategy strategy);
+
+    /// Largest number of bytes held by one buffer during the simulation.
+    struct Buffer {
+      std::string name;
+      size_t      bytes;
+    };
+
+    Strategy            strategy;
+    /// Size of the FFT grid in each simulated direction.
+    std::vector<size_t> padded_size;
+    std::vector<Buffer> buffers;
+    /// Largest number of bytes held at the same time.
+    size_t              peak_bytes;
+    /// Approximate number of floating point operations in the transforms and
+    /// the pointwise products. A real transform of N points is counted as
+    /// 2.5 N log2(N).
+    double              flops;
+  };
+
+  /// Estimates memory and work of simulating n_fields fields with the given
+  /// strategy. Arguments are as for Simulate3DGaussianField; ny <= 1 gives a
+  /// 1D and nz <= 1 a 2D simulation. 1D simulations only use STANDARD.
+  GaussianFieldPlan EstimateGaussianFieldResources(GaussianFieldPlan::Strategy strategy,
+                                                   const Variogram           & variogram,
+                                                   size_t                      nx,
+                                                   double                      dx,
+                                                   size_t                      ny,
+                                                   double                      dy,
+                                                   size_t                      nz,
+                                                   double                      dz,
+                                                   int                         n_fields,
+                                                   int                         padding_x = -1,
+                                                   int                         padding_y = -1,
+                                                   int                         padding_z = -1);
+
+  /// Selects the first of STANDARD, LEAN and SINGLE_PRECISION that needs at
+  /// most max_memory bytes. The free buffers kept by WorkspacePool are
+  /// released if the selected strategy does not fit together with them.
+  /// max_memory = 0 means no limit. Throws Exception if no strategy fits, so
+  /// that the simulation fails before any memory is allocated.
+  GaussianFieldPlan PlanGaussianFieldSimulation(const Variogram & variogram,
+                                                size_t            nx,
+                                                double            dx,
+                                                size_t            ny,
+                                                double            dy,
+                                                size_t            nz,
+                                                double            dz,
+                                                int               n_fields,
+                                                size_t            max_memory,
+                                                int               padding_x = -1,
+                                                int               padding_y = -1,
+                                                int               padding_z = -1);
+
+} // namespace NRLib
+
+#endif // NRLIB_VARIOGRAM_GAUSSIANFIELDPLAN_HPP
@@ -0,0 +1,540 @@
+// Copyright (c)  2011, Norwegian Computing Center
+// All rights reserved.
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+// •  Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+// •  Redistributions in binary form must reproduce the above copyright notice, this list of
+//    conditions and the following disclaimer in the documentation and/or other materials
+//    provided with the distribution.
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+// OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <exception>
+#include <thread>
+
+#include "gaussianfieldsimulator.hpp"
+#include "gaussianfield.hpp"
+#include "fftcovgrid.hpp"
+#include "filterspectrum.hpp"
+
+#include "../exception/exception.hpp"
+#include "../fft/fft.hpp"
+#include "../fft/workspacepool.hpp"
+#include "../iotools/stringtools.hpp"
+#include "../math/constants.hpp"
+#include "../profiling/profiling.hpp"
+#include "../random/random.hpp"
+
+using namespace NRLib;
+
+GaussianFieldSimulator::GaussianFieldSimulator(const Variogram & variogram,
+                                               size_t            nx,
+                                               double            dx,
+                                               size_t            ny,
+                                               double            dy,
+                                               size_t            nz,
+                                               double            dz,
+                                               int               padding_x,
+                                               int               padding_y,
+                                               int               padding_z,
+                                               double            scaling_x,
+                                               double            scaling_y,
+                                               double            scaling_z)
+  : nx_(nx),
+    dx_(dx),
+    dy_(dy),
+    dz_(dz),
+    real_data_(NULL),
+    complex_data_(NULL),
+    spectral_random_initialized_(false)
+{
+  Profiling::RunScope run;
+  n_dim_ = (ny <= 1) ? 1 : ((nz <= 1) ? 2 : 3);
+  ny_    = (n_dim_ > 1) ? ny : 1;
+  nz_    = (n_dim_ > 2) ? nz : 1;
+
+  {
+    Profiling::ScopedTimer timer("padding");
+    std::vector<size_t> padding = FindNDimPadding(variogram, nx_, dx, ny_, dy, nz_, dz);
+    if (padding_x >= 0)
+      padding[0] = padding_x;
+    if (n_dim_ > 1 && padding_y >= 0)
+      padding[1] = padding_y;
+    if (n_dim_ > 2 && padding_z >= 0)
+      padding[2] = padding_z;
+    // Same sizes as Simulate1DGaussianField and FFTGrid2D/3D.
+    nx_tot_ = FindNewSizeWithPadding(nx_ + padding[0], n_dim_ > 1);
+    ny_tot_ = (n_dim_ > 1) ? FindNewSizeWithPadding(ny_ + padding[1]) : 1;
+    nz_tot_ = (n_dim_ > 2) ? FindNewSizeWithPadding(nz_ + padding[2]) : 1;
+  }
+  Profiling::RecordPaddedSize(nx_tot_, ny_tot_, nz_tot_);
+
+  if (n_dim_ > 2)
+    fft_size_.push_back(static_cast<int>(nz_tot_));
+  if (n_dim_ > 1)
+    fft_size_.push_back(static_cast<int>(ny_tot_));
+  fft_size_.push_back(static_cast<int>(nx_tot_));
+
+  n_real_    = nx_tot_ * ny_tot_ * nz_tot_;
+  n_complex_ = (nx_tot_ / 2 + 1) * ny_tot_ * nz_tot_;
+  {
+    Profiling::ScopedTimer timer("allocate");
+    real_data_    = reinterpret_cast<double *>(WorkspacePool::Acquire(n_real_ * sizeof(double)));
+    complex_data_ = reinterpret_cast<std::complex<double> *>(WorkspacePool::Acquire(n_complex_ * sizeof(std::complex<double>)));
+    Profiling::RecordAllocation(n_real_ * sizeof(double) + n_complex_ * sizeof(std::complex<double>));
+  }
+
+  std::string key = FilterSpectrum::MakeKey(variogram, "real", nx_tot_, dx, ny_tot_, dy, nz_tot_, dz,
+                                            scaling_x, scaling_y, scaling_z);
+  sqrt_spectrum_ = FilterSpectrum::Get(key, n_complex_, [&](std::vector<double> & spectrum) {
+    {
+      Profiling::ScopedAllocation cov_allocation(n_real_ * sizeof(double));
+      Profiling::ScopedTimer timer("covariance");
+      if (n_dim_ == 1) {
+        FFTCovGrid1D cov_grid(variogram, static_cast<int>(nx_tot_), dx, scaling_x);
+        std::copy(cov_grid.GetCov().begin(), cov_grid.GetCov().end(), real_data_);
+      }
+      else if (n_dim_ == 2) {
+        FFTCovGrid2D cov_grid(variogram, static_cast<int>(nx_tot_), dx, static_cast<int>(ny_tot_), dy,
+                              scaling_x, scaling_y);
+        std::copy(cov_grid.GetCov().GetStorage().begin(), cov_grid.GetCov().GetStorage().end(), real_data_);
+      }
+      else {
+        FFTCovGrid3D cov_grid(variogram, static_cast<int>(nx_tot_), dx, static_cast<int>(ny_tot_), dy,
+                              static_cast<int>(nz_tot_), dz, scaling_x, scaling_y, scaling_z);
+        std::copy(cov_grid.GetCov().GetStorage().begin(), cov_grid.GetCov().GetStorage().end(), real_data_);
+      }
+    }
+    // Unscaled transform, as for the filter grid in the standard simulation.
+    Profiling::ScopedTimer timer("filter");
+    NRLibPrivate::ComputeFFTMany(fft_size_, 1, real_data_, complex_data_);
+    spectrum.resize(n_complex_);
+    for (size_t i = 0; i < n_complex_; i++)
+      spectrum[i] = std::sqrt(std::max(complex_data_[i].real(), 0.0));
+  });
+}
+
+
+GaussianFieldSimulator::~GaussianFieldSimulator()
+{
+  Profiling::RecordDeallocation(n_real_ * sizeof(double) + n_complex_ * sizeof(std::complex<double>));
+  WorkspacePool::Release(real_data_, n_real_ * sizeof(double));
+  WorkspacePool::Release(complex_data_, n_complex_ * sizeof(std::complex<double>));
+}
+
+
+void GaussianFieldSimulator::Simulate(std::vector<double> & field)
+{
+  SimulateField(field, NULL);
+}
+
+
+void GaussianFieldSimulator::Simulate(std::vector<double> & field, RandomGenerator & rg)
+{
+  SimulateField(field, &rg);
+}
+
+
+void GaussianFieldSimulator::SimulateWithDerivatives(std::vector<double> & field,
+                                                     std::vector<double> & derivatives,
+                                                     bool                  laplacian)
+{
+  SimulateFieldWithDerivatives(field, derivatives, laplacian, NULL);
+}
+
+
+void GaussianFieldSimulator::SimulateWithDerivatives(std::vector<double> & field,
+                                                     std::vector<double> & derivatives,
+                                                     bool                  laplacian,
+                                                     RandomGenerator     & rg)
+{
+  SimulateFieldWithDerivatives(field, derivatives, laplacian, &rg);
+}
+
+
+void GaussianFieldSimulator::SimulateField(std::vector<double> & field, RandomGenerator * rg)
+{
+  Profiling::RunScope run;
+  Profiling::RecordFields(1);
+  Profiling::RecordPaddedSize(nx_tot_, ny_tot_, nz_tot_);
+  FilterNoise(rg);
+  InverseToField(field);
+}
+
+
+void GaussianFieldSimulator::SimulateFieldWithDerivatives(std::vector<double> & field,
+                                                          std::vector<double> & derivatives,
+                                                          bool                  laplacian,
+                                                          RandomGenerator     * rg)
+{
+  Profiling::RunScope run;
+  Profiling::RecordFields(1);
+  Profiling::RecordPaddedSize(nx_tot_, ny_tot_, nz_tot_);
+  FilterNoise(rg);
+
+  size_t n_components = 1 + n_dim_ + (laplacian ? 1 : 0);
+  size_t complex_bytes = n_components * n_complex_ * sizeof(std::complex<double>);
+  size_t real_bytes    = n_components * n_real_ * sizeof(double);
+  std::complex<double> * spectra = reinterpret_cast<std::complex<double> *>(WorkspacePool::Acquire(complex_bytes));
+  double               * values  = reinterpret_cast<double *>(WorkspacePool::Acquire(real_bytes));
+  Profiling::RecordAllocation(complex_bytes + real_bytes);
+  {
+    Profiling::ScopedTimer timer("derivatives");
+    // Wave numbers of each direction. The Nyquist frequency of an even size
+    // has no sign, so the odd derivatives are zero there.
+    size_t nxc = nx_tot_ / 2 + 1;
+    size_t n_tot[3]  = { nx_tot_, ny_tot_, nz_tot_ };
+    double d[3]      = { dx_, dy_, dz_ };
+    std::vector<double> k[3];
+    std::vector<double> k_odd[3];
+    for (size_t dim = 0; dim < 3; dim++) {
+      size_t n = (dim == 0) ? nxc : n_tot[dim];
+      k[dim].resize(n);
+      k_odd[dim].resize(n);
+      for (size_t i = 0; i < n; i++) {
+        double f = (i <= n_tot[dim] / 2) ? static_cast<double>(i) : static_cast<double>(i) - static_cast<double>(n_tot[dim]);
+        k[dim][i]     = (dim < n_dim_) ? 2.0 * NRLib::Pi * f / (static_cast<double>(n_tot[dim]) * d[dim]) : 0.0;
+        k_odd[dim][i] = (n_tot[dim] % 2 == 0 && 2 * i == n_tot[dim]) ? 0.0 : k[dim][i];
+      }
+    }
+    const std::complex<double> imag(0.0, 1.0);
+    for (size_t kk = 0; kk < nz_tot_; kk++) {
+      for (size_t j = 0; j < ny_tot_; j++) {
+        for (size_t i = 0; i < nxc; i++) {
+          size_t index = i + nxc * (j + ny_tot_ * kk);
+          std::complex<double> value = complex_data_[index];
+          spectra[index] = value;
+          spectra[index + n_complex_] = imag * k_odd[0][i] * value;
+          if (n_dim_ > 1)
+            spectra[index + 2 * n_complex_] = imag * k_odd[1][j] * value;
+          if (n_dim_ > 2)
+            spectra[index + 3 * n_complex_] = imag * k_odd[2][kk] * value;
+          if (laplacian)
+            spectra[index + (1 + n_dim_) * n_complex_] =
+              -(k[0][i] * k[0][i] + k[1][j] * k[1][j] + k[2][kk] * k[2][kk]) * value;
+        }
+      }
+    }
+  }
+  {
+    Profiling::ScopedTimer timer("inverse_fft");
+    NRLibPrivate::ComputeFFTManyInverse(fft_size_, static_cast<int>(n_components), spectra, values);
+  }
+  {
+    Profiling::ScopedTimer timer("extract");
+    double scale = 1.0 / std::sqrt(static_cast<double>(n_real_));
+    size_t n_field = GetFieldSize();
+    field.resize(n_field);
+    derivatives.resize((n_components - 1) * n_field);
+    for (size_t c = 0; c < n_components; c++) {
+      const double * in  = values + c * n_real_;
+      double       * out = (c == 0) ? &field[0] : &derivatives[(c - 1) * n_field];
+      for (size_t k = 0; k < nz_; k++)
+        for (size_t j = 0; j < ny_; j++)
+          for (size_t i = 0; i < nx_; i++)
+            out[i + nx_ * (j + ny_ * k)] = scale * in[i + nx_tot_ * (j + ny_tot_ * k)];
+    }
+  }
+  Profiling::RecordDeallocation(complex_bytes + real_bytes);
+  WorkspacePool::Release(spectra, complex_bytes);
+  WorkspacePool::Release(values, real_bytes);
+}
+
+
+void GaussianFieldSimulator::FilterNoise(RandomGenerator * rg)
+{
+  {
+    // Same draw order as Simulate1D/2D/3DGaussianField
+    Profiling::ScopedTimer timer("noise");
+    if (n_dim_ == 3) {
+      FillGaussianNoise(real_data_, nx_tot_, ny_tot_, nz_tot_, rg);
+    }
+    else {
+      RandomGenerator local_rg((rg != NULL) ? rg->DrawUint32() : NRLib::Random::DrawUint32());
+      FillGaussianNoise(real_data_, nx_tot_, ny_tot_, 1, &local_rg);
+    }
+    double scale = 1.0 / std::sqrt(static_cast<double>(n_real_));
+    for (size_t i = 0; i < n_real_; i++)
+      real_data_[i] *= scale;
+  }
+  {
+    Profiling::ScopedTimer timer("fft");
+    NRLibPrivate::ComputeFFTMany(fft_size_, 1, real_data_, complex_data_);
+  }
+  {
+    Profiling::ScopedTimer timer("convolve");
+    const double * sqrt_spectrum = sqrt_spectrum_->Data();
+    for (size_t i = 0; i < n_complex_; i++)
+      complex_data_[i] *= sqrt_spectrum[i];
+  }
+}
+
+
+void GaussianFieldSimulator::ResetState()
+{
+  Profiling::RunScope run;
+  state_.assign(n_complex_, 0.0);
+  proposal_.clear();
+  UpdateState(state_, 0.0, false);
+}
+
+
+void GaussianFieldSimulator::GetField(std::vector<double> & field)
+{
+  Profiling::RunScope run;
+  if (state_.empty())
+    ResetState();
+  {
+    Profiling::ScopedTimer timer("convolve");
+    const double * sqrt_spectrum = sqrt_spectrum_->Data();
+    for (size_t i = 0; i < n_complex_; i++)
+      complex_data_[i] = sqrt_spectrum[i] * state_[i];
+  }
+  InverseToField(field);
+}
+
+
+void GaussianFieldSimulator::Step(double rho, std::vector<double> & field)
+{
+  Profiling::RunScope run;
+  if (rho < -1.0 || rho > 1.0)
+    throw Exception("The correlation between consecutive fields must be in [-1, 1].");
+  if (state_.empty()) {
+    state_.assign(n_complex_, 0.0);
+    rho = 0.0;
+  }
+  UpdateState(state_, rho, true);
+  InverseToField(field);
+}
+
+
+void GaussianFieldSimulator::Deform(double theta, std::vector<double> & field)
+{
+  Profiling::RunScope run;
+  if (state_.empty())
+    ResetState();
+  if (proposal_.empty()) {
+    proposal_.assign(n_complex_, 0.0);
+    UpdateState(proposal_, 0.0, false);
+  }
+  double c = std::cos(theta);
+  double s = std::sin(theta);
+  {
+    Profiling::ScopedTimer timer("convolve");
+    const double * sqrt_spectrum = sqrt_spectrum_->Data();
+    for (size_t i = 0; i < n_complex_; i++)
+      complex_data_[i] = sqrt_spectrum[i] * (c * state_[i] + s * proposal_[i]);
+  }
+  InverseToField(field);
+}
+
+
+void GaussianFieldSimulator::AcceptDeformation(double theta)
+{
+  if (state_.empty() || proposal_.empty())
+    throw Exception("There is no deformation to accept. Call Deform first.");
+  double c = std::cos(theta);
+  double s = std::sin(theta);
+  for (size_t i = 0; i < n_complex_; i++)
+    state_[i] = c * state_[i] + s * proposal_[i];
+  proposal_.clear();
+}
+
+
+void GaussianFieldSimulator::Apply(const double * noise, size_t n_batch, double * field)
+{
+  Profiling::RunScope run;
+  Profiling::RecordFields(n_batch);
+  Profiling::RecordPaddedSize(nx_tot_, ny_tot_, nz_tot_);
+  size_t n_field = GetFieldSize();
+  for (size_t b = 0; b < n_batch; b++) {
+    std::copy(noise + b * n_real_, noise + (b + 1) * n_real_, real_data_);
+    FilterRealData();
+    Profiling::ScopedTimer timer("extract");
+    double * out = field + b * n_field;
+    for (size_t k = 0; k < nz_; k++)
+      for (size_t j = 0; j < ny_; j++)
+        for (size_t i = 0; i < nx_; i++)
+          out[i + nx_ * (j + ny_ * k)] = real_data_[i + nx_tot_ * (j + ny_tot_ * k)];
+  }
+}
+
+
+void GaussianFieldSimulator::ApplyAdjoint(const double * field_gradient, size_t n_batch, double * noise)
+{
+  Profiling::RunScope run;
+  Profiling::RecordFields(n_batch);
+  Profiling::RecordPaddedSize(nx_tot_, ny_tot_, nz_tot_);
+  size_t n_field = GetFieldSize();
+  for (size_t b = 0; b < n_batch; b++) {
+    {
+      Profiling::ScopedTimer timer("insert");
+      const double * in = field_gradient + b * n_field;
+      std::fill(real_data_, real_data_ + n_real_, 0.0);
+      for (size_t k = 0; k < nz_; k++)
+        for (size_t j = 0; j < ny_; j++)
+          for (size_t i = 0; i < nx_; i++)
+            real_data_[i + nx_tot_ * (j + ny_tot_ * k)] = in[i + nx_ * (j + ny_ * k)];
+    }
+    FilterRealData();
+    std::copy(real_data_, real_data_ + n_real_, noise + b * n_real_);
+  }
+}
+
+
+void GaussianFieldSimulator::FilterRealData()
+{
+  {
+    Profiling::ScopedTimer timer("fft");
+    NRLibPrivate::ComputeFFTMany(fft_size_, 1, real_data_, complex_data_);
+  }
+  {
+    // Both scalings of Simulate, 1/sqrt(N) before and after, in one factor.
+    Profiling::ScopedTimer timer("convolve");
+    double scale = 1.0 / static_cast<double>(n_real_);
+    const double * sqrt_spectrum = sqrt_spectrum_->Data();
+    for (size_t i = 0; i < n_complex_; i++)
+      complex_data_[i] *= scale * sqrt_spectrum[i];
+  }
+  Profiling::ScopedTimer timer("inverse_fft");
+  NRLibPrivate::ComputeFFTManyInverse(fft_size_, 1, complex_data_, real_data_);
+}
+
+
+void GaussianFieldSimulator::UpdateState(std::vector<std::complex<double> > & w, double rho, bool filtered)
+{
+  Profiling::ScopedTimer timer("noise");
+  InitializeSpectralRandom();
+
+  // The transform of real white noise is Hermitian. Values that are their own
+  // conjugate partner are real with variance 1, the others are complex with
+  // variance 1/2 in the real and imaginary parts. Partners in the planes
+  // i = 0 and i = nx_tot/2 are both stored, and the second is set from the first.
+  double a          = std::sqrt(std::max(1.0 - rho * rho, 0.0));
+  const double * sqrt_spectrum = sqrt_spectrum_->Data();
+  double half       = std::sqrt(0.5);
+  size_t nxc        = nx_tot_ / 2 + 1;
+  size_t i_nyquist  = (nx_tot_ % 2 == 0) ? nx_tot_ / 2 : nxc;
+  for (size_t k = 0; k < nz_tot_; k++) {
+    size_t k_partner = (nz_tot_ - k) % nz_tot_;
+    for (size_t j = 0; j < ny_tot_; j++) {
+      size_t j_partner = (ny_tot_ - j) % ny_tot_;
+      for (size_t i = 0; i < nxc; i++) {
+        size_t index = i + nxc * (j + ny_tot_ * k);
+        if (i == 0 || i == i_nyquist) {
+          size_t partner = i + nxc * (j_partner + ny_tot_ * k_partner);
+          if (partner == index)
+            w[index] = rho * w[index].real() + a * spectral_random_.Norm01();
+          else if (partner < index)
+            w[index] = std::conj(w[partner]);
+          else
+            w[index] = rho * w[index] + a * half * std::complex<double>(spectral_random_.Norm01(),
+                                                                          spectral_random_.Norm01());
+        }
+        else {
+          w[index] = rho * w[index] + a * half * std::complex<double>(spectral_random_.Norm01(),
+                                                                        spectral_random_.Norm01());
+        }
+        if (filtered)
+          complex_data_[index] = sqrt_spectrum[index] * w[index];
+      }
+    }
+  }
+}
+
+
+void GaussianFieldSimulator::InverseToField(std::vector<double> & field)
+{
+  {
+    Profiling::ScopedTimer timer("inverse_fft");
+    NRLibPrivate::ComputeFFTManyInverse(fft_size_, 1, complex_data_, real_data_);
+  }
+  Profiling::ScopedTimer timer("extract");
+  double scale = 1.0 / std::sqrt(static_cast<double>(n_real_));
+  field.resize(nx_ * ny_ * nz_);
+  for (size_t k = 0; k < nz_; k++)
+    for (size_t j = 0; j < ny_; j++)
+      for (size_t i = 0; i < nx_; i++)
+        field[i + nx_ * (j + ny_ * k)] = scale * real_data_[i + nx_tot_ * (j + ny_tot_ * k)];
+}
+
+
+void GaussianFieldSimulator::InitializeSpectralRandom()
+{
+  if (!spectral_random_initialized_) {
+    spectral_random_.Initialize(NRLib::Random::DrawUint32());
+    spectral_random_initialized_ = true;
+  }
+}
+
+
+void NRLib::SimulateGaussianFieldJobs(const std::vector<GaussianFieldJob> & jobs,
+                                      std::vector<std::vector<double> >   & fields_out,
+                                      size_t                                n_threads)
+{
+  fields_out.assign(jobs.size(), std::vector<double>());
+  if (jobs.empty())
+    return;
+
+  // Cost of each job, from the size of the padded grid
+  std::vector<std::pair<double, size_t> > order;
+  for (size_t j = 0; j < jobs.size(); j++) {
+    const GaussianFieldJob & job = jobs[j];
+    if (job.variogram == NULL)
+      throw Exception("Job " + NRLib::ToString(j) + " has no variogram.");
+    std::vector<size_t> padding = FindNDimPadding(*job.variogram, job.nx, job.dx, job.ny, job.dy, job.nz, job.dz);
+    double n = static_cast<double>(job.nx + padding[0]);
+    for (size_t d = 1; d < padding.size(); d++)
+      n *= static_cast<double>(((d == 1) ? job.ny : job.nz) + padding[d]);
+    order.push_back(std::make_pair(-n * std::log(n + 1.0), j));
+  }
+  std::sort(order.begin(), order.end());
+
+  if (n_threads == 0)
+    n_threads = std::max(1U, std::thread::hardware_concurrency());
+  n_threads = std::min(n_threads, jobs.size());
+
+  // Each thread takes the next job in the order until there are no more.
+  std::atomic<size_t>             next(0);
+  std::vector<std::exception_ptr> errors(n_threads);
+  auto run_jobs = [&](size_t t) {
+    try {
+      for (size_t o = next++; o < order.size(); o = next++) {
+        const GaussianFieldJob & job = jobs[order[o].second];
+        GaussianFieldSimulator simulator(*job.variogram, job.nx, job.dx, job.ny, job.dy, job.nz, job.dz);
+        RandomGenerator rg(job.seed);
+        simulator.Simulate(fields_out[order[o].second], rg);
+      }
+    }
+    catch (...) {
+      errors[t] = std::current_exception();
+      next      = order.size();
+    }
+  };
+
+  if (n_threads == 1) {
+    run_jobs(0);
+  }
+  else {
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < n_threads; t++)
+      threads.push_back(std::thread(run_jobs, t));
+    for (size_t t = 0; t < n_threads; t++)
+      threads[t].join();
+  }
+  for (size_t t = 0; t < n_threads; t++) {
+    if (errors[t])
+      std::rethrow_exception(errors[t]);
+  }
+}
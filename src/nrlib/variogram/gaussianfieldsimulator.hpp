@@ -0,0 +1,219 @@
+// Copyright (c)  2011, Norwegian Computing Center
+// All rights reserved.
+// Redistribution and use in source and binary forms, with or without modification,
+// are permitted provided that the following conditions are met:
+// •  Redistributions of source code must retain the above copyright notice, this
+//    list of conditions and the following disclaimer.
+// •  Redistributions in binary form must reproduce the above copyright notice, this list of
+//    conditions and the following disclaimer in the documentation and/or other materials
+//    provided with the distribution.
+// THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY
+// EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+// OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT
+// SHALL THE COPYRIGHT HOLDER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL,
+// SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT
+// OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION)
+// HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY,
+// OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
+// EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+
+#ifndef NRLIB_VARIOGRAM_GAUSSIANFIELDSIMULATOR_HPP
+#define NRLIB_VARIOGRAM_GAUSSIANFIELDSIMULATOR_HPP
+
+#include <complex>
+#include <cstdlib>
+#include <memory>
+#include <vector>
+
+#include "../random/randomgenerator.hpp"
+
+namespace NRLib {
+  class FilterSpectrum;
+  class Variogram;
+
+  /// Simulation of Gaussian fields with a fixed variogram and grid. The
+  /// square root of the filter spectrum is computed once, so that repeated
+  /// simulations only need the noise and the transforms.
+  ///
+  /// The simulator also keeps a latent noise state in the Fourier domain,
+  /// used for sequences of correlated fields (gradual deformation). A state
+  /// w gives the field F^-1(S w), where S is the filter. Updating the state
+  /// and computing the field needs a single inverse transform.
+  class GaussianFieldSimulator {
+  public:
+    /// ny and/or nz may be 1. Negative padding gives the default padding,
+    /// see FindNDimPadding.
+    GaussianFieldSimulator(const Variogram & variogram,
+                           size_t            nx,
+                           double            dx,
+                           size_t            ny        = 1,
+                           double            dy        = -1.0,
+                           size_t            nz        = 1,
+                           double            dz        = -1.0,
+                           int               padding_x = -1,
+                           int               padding_y = -1,
+                           int               padding_z = -1,
+                           double            scaling_x = 1.0,
+                           double            scaling_y = 1.0,
+                           double            scaling_z = 1.0);
+
+    ~GaussianFieldSimulator();
+
+    size_t GetNX()    const { return nx_; }
+    size_t GetNY()    const { return ny_; }
+    size_t GetNZ()    const { return nz_; }
+    size_t GetNXtot() const { return nx_tot_; }
+    size_t GetNYtot() const { return ny_tot_; }
+    size_t GetNZtot() const { return nz_tot_; }
+    /// Number of simulated directions; 1, 2 or 3.
+    size_t GetNDim()  const { return n_dim_; }
+    /// Number of noise values, nxtot*nytot*nztot.
+    size_t GetNoiseSize() const { return n_real_; }
+    /// Number of field values, nx*ny*nz.
+    size_t GetFieldSize() const { return nx_ * ny_ * nz_; }
+
+    /// A new realization, nx*ny*nz values with i running fastest. Uses the
+    /// same random numbers as Simulate1D/2D/3DGaussianField, and gives the
+    /// same values.
+    void Simulate(std::vector<double> & field);
+
+    /// As above, but draws the noise from rg instead of NRLib::Random, so
+    /// that several simulators can be used in parallel. With rg seeded with
+    /// s, the field is the same as with NRLib::Random initialized with s.
+    void Simulate(std::vector<double> & field, RandomGenerator & rg);
+
+    /// A new realization as from Simulate, together with its derivatives
+    /// d/dx, d/dy and d/dz (GetNDim() of them) and, if laplacian is true, its
+    /// Laplacian. derivatives gets the components one after the other, each
+    /// with GetFieldSize() values. The derivatives are exact for the periodic
+    /// field on the padded grid: the filtered spectrum is multiplied by i*k
+    /// (zero at the Nyquist frequency) or -|k|^2, and all components are
+    /// transformed back in one batched inverse FFT.
+    void SimulateWithDerivatives(std::vector<double> & field,
+                                 std::vector<double> & derivatives,
+                                 bool                  laplacian);
+
+    /// As above, with the noise from rg.
+    void SimulateWithDerivatives(std::vector<double> & field,
+                                 std::vector<double> & derivatives,
+                                 bool                  laplacian,
+                                 RandomGenerator     & rg);
+
+    /// Draws a new, independent state.
+    void ResetState();
+
+    /// Field of the current state. Draws a state if there is none.
+    void GetField(std::vector<double> & field);
+
+    /// Updates the state to rho*w + sqrt(1 - rho^2)*e, where e is new
+    /// noise, and gives the field of the new state. Draws a state if there
+    /// is none, in which case the field is independent of earlier fields.
+    void Step(double rho, std::vector<double> & field);
+
+    /// Field of cos(theta)*w + sin(theta)*v, where w is the current state and
+    /// v is an independent proposal state. The state is not changed, so this
+    /// may be called with many values of theta.
+    void Deform(double theta, std::vector<double> & field);
+
+    /// Sets the state to cos(theta)*w + sin(theta)*v. The next call to Deform
+    /// draws a new proposal.
+    void AcceptDeformation(double theta);
+
+    /// Applies the simulation operator, field = L*noise, to n_batch noise
+    /// vectors. noise has n_batch*GetNoiseSize() values, one padded grid
+    /// after the other with i running fastest, and field gets
+    /// n_batch*GetFieldSize() values. L is the operator used by Simulate, so
+    /// noise drawn in the order of Simulate gives the same field.
+    void Apply(const double * noise, size_t n_batch, double * field);
+
+    /// Applies the adjoint operator, noise = L^T*field_gradient, to n_batch
+    /// vectors. L is a crop of a symmetric circulant matrix, so L^T is the
+    /// same filter applied to the zero-padded gradient.
+    void ApplyAdjoint(const double * field_gradient, size_t n_batch, double * noise);
+
+  private:
+    /// Simulate with noise from rg, or from NRLib::Random if rg is NULL.
+    void SimulateField(std::vector<double> & field, RandomGenerator * rg);
+
+    /// Transform of the noise from rg, or from NRLib::Random if rg is NULL,
+    /// multiplied by the filter. Leaves the result in the complex buffer.
+    void FilterNoise(RandomGenerator * rg);
+
+    void SimulateFieldWithDerivatives(std::vector<double> & field,
+                                      std::vector<double> & derivatives,
+                                      bool                  laplacian,
+                                      RandomGenerator     * rg);
+
+    /// Multiplies the transform of the real buffer by the filter and
+    /// transforms back. The result is scaled by 1/N, as L.
+    void FilterRealData();
+
+    /// w = rho*w + sqrt(1 - rho^2)*e, where e is the Fourier transform of
+    /// white noise (unitary scaling). With rho = 0, w is replaced.
+    /// If filtered is true, the filtered state is written to the FFT buffer.
+    void UpdateState(std::vector<std::complex<double> > & w, double rho, bool filtered);
+
+    /// Inverse transform of the FFT buffer, scaled and copied to field.
+    void InverseToField(std::vector<double> & field);
+
+    void InitializeSpectralRandom();
+
+    size_t n_dim_;
+    size_t nx_;
+    size_t ny_;
+    size_t nz_;
+    size_t nx_tot_;
+    size_t ny_tot_;
+    size_t nz_tot_;
+    size_t n_real_;
+    size_t n_complex_;
+    /// Cell sizes, for the derivatives.
+    double dx_;
+    double dy_;
+    double dz_;
+    /// Transform size, slowest varying direction first.
+    std::vector<int> fft_size_;
+
+    double               * real_data_;
+    std::complex<double> * complex_data_;
+    /// Square root of the real part of the filter spectrum.
+    std::shared_ptr<const FilterSpectrum> sqrt_spectrum_;
+
+    /// Latent state and proposal state. Empty until used.
+    std::vector<std::complex<double> > state_;
+    std::vector<std::complex<double> > proposal_;
+    RandomGenerator                    spectral_random_;
+    bool                               spectral_random_initialized_;
+
+    // Make copying illegal.
+    GaussianFieldSimulator(const GaussianFieldSimulator &);
+    GaussianFieldSimulator & operator=(const GaussianFieldSimulator &);
+  };
+
+  /// A field to simulate with SimulateGaussianFieldJobs.
+  struct GaussianFieldJob {
+    const Variogram * variogram;
+    size_t            nx;
+    double            dx;
+    /// ny and/or nz may be 1.
+    size_t            ny;
+    double            dy;
+    size_t            nz;
+    double            dz;
+    unsigned long     seed;
+  };
+
+  /// Simulates one field for each job, running n_threads jobs at a time
+  /// (0 means one per core). Job j draws its noise from a generator seeded
+  /// with jobs[j].seed, so the result does not depend on the scheduling,
+  /// and is the same as from Simulate1D/2D/3DGaussianField after
+  /// NRLib::Random::Initialize(jobs[j].seed). The jobs are started in
+  /// order of decreasing size of the padded grid, so that the total time
+  /// is close to that of the largest job. fields_out[j] gets the field of
+  /// job j, with i running fastest.
+  void SimulateGaussianFieldJobs(const std::vector<GaussianFieldJob>   & jobs,
+                                 std::vector<std::vector<double> >     & fields_out,
+                                 size_t                                  n_threads = 0);
+}
+
+#endif // NRLIB_VARIOGRAM_GAUSSIANFIELDSIMULATOR_HPP
@@ -0,0 +1,119 @@
+/// Unit tests for sampling of corner-point grids
+
+#include <nrlib/eclipsegrid/eclipsegeometry.hpp>
+#include <nrlib/geometry/line.hpp>
+#include <nrlib/geometry/point.hpp>
+#include <nrlib/grid/grid.hpp>
+#include <nrlib/random/random.hpp>
+#include <nrlib/variogram/eclipsegridsampling.hpp>
+#include <nrlib/variogram/gaussianfield.hpp>
+#include <nrlib/variogram/variogram.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <cmath>
+
+using namespace NRLib;
+
+namespace {
+  // Slightly tilted pillars, with layers that dip in x and a few inactive cells.
+  EclipseGeometry MakeGeometry(size_t ni, size_t nj, size_t nk)
+  {
+    EclipseGeometry geometry(ni, nj, nk);
+    for (size_t j = 0; j <= nj; j++) {
+      for (size_t i = 0; i <= ni; i++) {
+        Point top(100.0 * i, 80.0 * j, 1000.0);
+        Point bot(100.0 * i + 20.0, 80.0 * j + 10.0, 1100.0);
+        geometry.SetCoordLine(i, j, Line(top, bot));
+      }
+    }
+    for (size_t k = 0; k < nk; k++) {
+      for (size_t j = 0; j < nj; j++) {
+        for (size_t i = 0; i < ni; i++) {
+          for (size_t c = 0; c < 2; c++)
+            for (size_t b = 0; b < 2; b++)
+              for (size_t a = 0; a < 2; a++)
+                geometry.SetZCorner(i, j, k, a, b, c, 1000.0 + 0.5 * (i + a) + 4.0 * (k + c));
+          geometry.SetActive(i, j, k, (i + 2 * j + 3 * k) % 7 != 0);
+        }
+      }
+    }
+    return geometry;
+  }
+}
+
+BOOST_AUTO_TEST_SUITE( TestEclipseGridSampling )
+
+BOOST_AUTO_TEST_CASE( CentersAndLinearInterpolation )
+{
+  EclipseGeometry geometry = MakeGeometry(12, 9, 6);
+  EclipseGridSampling sampling(geometry, 25.0, 30.0, 1.5);
+
+  const std::vector<size_t> & active  = sampling.GetActiveIndices();
+  const std::vector<double> & centers = sampling.GetCellCenters();
+  size_t n_active = 0;
+  for (size_t index = 0; index < geometry.GetN(); index++)
+    n_active += geometry.IsActive(index) ? 1 : 0;
+  BOOST_REQUIRE(sampling.GetN() == n_active);
+  for (size_t c = 0; c < active.size(); c += 5) {
+    size_t i, j, k;
+    geometry.GetIJK(active[c], i, j, k);
+    Point p = geometry.FindCellCenterPoint(i, j, k);
+    BOOST_CHECK_SMALL(centers[3 * c] - p.x, 1e-9);
+    BOOST_CHECK_SMALL(centers[3 * c + 1] - p.y, 1e-9);
+    BOOST_CHECK_SMALL(centers[3 * c + 2] - p.z, 1e-9);
+  }
+
+  // Trilinear interpolation is exact for linear functions.
+  size_t nx = sampling.GetNX();
+  size_t ny = sampling.GetNY();
+  size_t nz = sampling.GetNZ();
+  std::vector<double> box(nx * ny * nz);
+  for (size_t k = 0; k < nz; k++)
+    for (size_t j = 0; j < ny; j++)
+      for (size_t i = 0; i < nx; i++)
+        box[i + j * nx + k * nx * ny] = 1.0 + 0.01 * (sampling.GetX0() + i * sampling.GetDX())
+                                      - 0.02 * (sampling.GetY0() + j * sampling.GetDY())
+                                      + 0.3 * (sampling.GetZ0() + k * sampling.GetDZ());
+  std::vector<double> values(sampling.GetN());
+  sampling.Sample(&box[0], &values[0]);
+  for (size_t c = 0; c < values.size(); c++)
+    BOOST_CHECK_CLOSE(values[c], 1.0 + 0.01 * centers[3 * c] - 0.02 * centers[3 * c + 1] + 0.3 * centers[3 * c + 2], 1e-9);
+}
+
+BOOST_AUTO_TEST_CASE( CachedPerGeometry )
+{
+  EclipseGeometry geometry = MakeGeometry(6, 5, 4);
+  std::shared_ptr<const EclipseGridSampling> first = EclipseGridSampling::Get(geometry, 25.0, 30.0, 1.5);
+  BOOST_TEST(EclipseGridSampling::Get(geometry, 25.0, 30.0, 1.5) == first);
+  BOOST_TEST(EclipseGridSampling::Get(geometry, 25.0, 30.0, 2.0) != first);
+  geometry.SetActive(0, 0, 0, !geometry.IsActive(0, 0, 0));
+  BOOST_TEST(EclipseGridSampling::Get(geometry, 25.0, 30.0, 1.5) != first);
+}
+
+BOOST_AUTO_TEST_CASE( SimulationMatchesSampledBox )
+{
+  EclipseGeometry geometry = MakeGeometry(12, 9, 6);
+  EclipseGridSampling sampling(geometry, 25.0, 30.0, 1.5);
+  Variogram * v = Variogram::Create(Variogram::SPHERICAL, 1.5, 400.0, 300.0, 10.0, 20.0);
+
+  std::vector<double> values(2 * sampling.GetN());
+  Random::Initialize(8L);
+  SimulateGaussianFieldOnEclipseGrid(*v, sampling, 2, &values[0]);
+
+  std::vector<Grid<double> > boxes;
+  Random::Initialize(8L);
+  Simulate3DGaussianField(*v, sampling.GetNX(), sampling.GetDX(), sampling.GetNY(), sampling.GetDY(),
+                          sampling.GetNZ(), sampling.GetDZ(), 2, boxes,
+                          -1, -1, -1, 1.0, 1.0, 1.0, GaussianFieldPlan::LEAN);
+  std::vector<double> expected(sampling.GetN());
+  for (size_t m = 0; m < 2; m++) {
+    std::vector<double> box(boxes[m].begin(), boxes[m].end());
+    sampling.Sample(&box[0], &expected[0]);
+    for (size_t c = 0; c < expected.size(); c += 7)
+      BOOST_CHECK_SMALL(values[m * sampling.GetN() + c] - expected[c], 1e-12);
+  }
+  delete v;
+}
+
+BOOST_AUTO_TEST_SUITE_END()
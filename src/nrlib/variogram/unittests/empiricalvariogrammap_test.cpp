@@ -0,0 +1,186 @@
+/// Unit tests for EmpiricalVariogramMap
+
+#include <nrlib/grid/grid.hpp>
+#include <nrlib/random/randomgenerator.hpp>
+#include <nrlib/variogram/empiricalvariogrammap.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <cmath>
+#include <limits>
+#include <vector>
+
+using namespace NRLib;
+
+namespace {
+  /// Sum of squared differences and number of pairs for lag (a, b, c), by looping over all pairs.
+  void BruteForceLag(const std::vector<double> & field, const std::vector<bool> & mask,
+                     int nx, int ny, int nz, int a, int b, int c,
+                     double & sum, double & n)
+  {
+    sum = 0.0;
+    n   = 0.0;
+    for (int k = 0; k < nz; k++) {
+      for (int j = 0; j < ny; j++) {
+        for (int i = 0; i < nx; i++) {
+          int i2 = i + a;
+          int j2 = j + b;
+          int k2 = k + c;
+          if (i2 < 0 || i2 >= nx || j2 < 0 || j2 >= ny || k2 < 0 || k2 >= nz)
+            continue;
+          size_t p = i + nx * (j + ny * k);
+          size_t q = i2 + nx * (j2 + ny * k2);
+          if (!mask[p] || !mask[q])
+            continue;
+          double d = field[q] - field[p];
+          sum += d * d;
+          n   += 1.0;
+        }
+      }
+    }
+  }
+}
+
+BOOST_AUTO_TEST_SUITE( TestEmpiricalVariogramMap )
+
+BOOST_AUTO_TEST_CASE( MapMatchesBruteForce )
+{
+  const int nx = 7;
+  const int ny = 5;
+  const int nz = 3;
+  const int n  = nx * ny * nz;
+  RandomGenerator rg(1234);
+
+  std::vector<bool> mask(n);
+  bool * mask_array = new bool[n];
+  for (int i = 0; i < n; i++) {
+    mask[i]       = rg.Unif01() < 0.8;
+    mask_array[i] = mask[i];
+  }
+  EmpiricalVariogramMap estimator(nx, 10.0, ny, 20.0, nz, 2.0, mask_array);
+  delete [] mask_array;
+
+  std::vector<std::vector<double> > fields(2, std::vector<double>(n));
+  for (size_t f = 0; f < fields.size(); f++) {
+    for (int i = 0; i < n; i++)
+      fields[f][i] = 100.0 + rg.Norm01();
+    estimator.AddField(&fields[f][0]);
+  }
+  BOOST_TEST(estimator.GetNRealizations() == 2U);
+
+  Grid<double> gamma;
+  Grid<double> pairs;
+  estimator.GetVariogramMap(gamma, pairs);
+  BOOST_TEST(gamma.GetNI() == 2U * nx - 1);
+  BOOST_TEST(gamma.GetNJ() == 2U * ny - 1);
+  BOOST_TEST(gamma.GetNK() == 2U * nz - 1);
+
+  for (int c = 1 - nz; c < nz; c++) {
+    for (int b = 1 - ny; b < ny; b++) {
+      for (int a = 1 - nx; a < nx; a++) {
+        double sum_total = 0.0;
+        double n_total   = 0.0;
+        for (size_t f = 0; f < fields.size(); f++) {
+          double sum, n_pairs;
+          BruteForceLag(fields[f], mask, nx, ny, nz, a, b, c, sum, n_pairs);
+          sum_total += sum;
+          n_total   += n_pairs;
+        }
+        BOOST_CHECK_EQUAL(pairs(a + nx - 1, b + ny - 1, c + nz - 1), n_total);
+        if (n_total > 0.0)
+          BOOST_CHECK_SMALL(gamma(a + nx - 1, b + ny - 1, c + nz - 1) - sum_total / (2.0 * n_total), 1e-9);
+        else
+          BOOST_TEST(std::isnan(gamma(a + nx - 1, b + ny - 1, c + nz - 1)));
+      }
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE( UndefinedValuesInMaskedCells )
+{
+  const int nx = 6;
+  const int ny = 4;
+  const int n  = nx * ny;
+  RandomGenerator rg(77);
+
+  bool * mask = new bool[n];
+  std::vector<double> field(n);
+  std::vector<double> field_nan(n);
+  for (int i = 0; i < n; i++) {
+    mask[i]      = (i % 5 != 2);
+    field[i]     = mask[i] ? rg.Norm01() : 0.0;
+    field_nan[i] = mask[i] ? field[i] : std::numeric_limits<double>::quiet_NaN();
+  }
+  EmpiricalVariogramMap estimator(nx, 10.0, ny, 10.0, 1, 1.0, mask);
+  EmpiricalVariogramMap estimator_nan(nx, 10.0, ny, 10.0, 1, 1.0, mask);
+  delete [] mask;
+  estimator.AddField(&field[0]);
+  estimator_nan.AddField(&field_nan[0]);
+
+  Grid<double> gamma, gamma_nan, pairs;
+  estimator.GetVariogramMap(gamma, pairs);
+  estimator_nan.GetVariogramMap(gamma_nan, pairs);
+  for (size_t i = 0; i < gamma.GetN(); i++) {
+    BOOST_TEST(std::isnan(gamma_nan(i)) == (pairs(i) == 0.0));
+    if (pairs(i) > 0.0)
+      BOOST_CHECK_SMALL(gamma_nan(i) - gamma(i), 1e-9);
+  }
+}
+
+BOOST_AUTO_TEST_CASE( BinnedVariogramMatchesBruteForce )
+{
+  const int nx = 12;
+  const int ny = 9;
+  const int n  = nx * ny;
+  const double dx = 1.0;
+  const double dy = 1.5;
+  RandomGenerator rg(42);
+
+  std::vector<bool>   mask(n, true);
+  std::vector<double> field(n);
+  for (int i = 0; i < n; i++)
+    field[i] = rg.Norm01();
+  EmpiricalVariogramMap estimator(nx, dx, ny, dy);
+  estimator.AddField(&field[0]);
+
+  const double bin_width = 2.0;
+  std::vector<double> distance, gamma, pairs;
+  estimator.GetRadialVariogram(bin_width, 0, distance, gamma, pairs);
+  std::vector<double> dir_distance, dir_gamma, dir_pairs;
+  estimator.GetDirectionalVariogram(0.0, 0.0, 0.1, bin_width, 4, dir_distance, dir_gamma, dir_pairs);
+  BOOST_TEST(dir_gamma.size() == 4U);
+
+  std::vector<double> sum(gamma.size(), 0.0), count(gamma.size(), 0.0);
+  std::vector<double> dir_sum(4, 0.0), dir_count(4, 0.0);
+  for (int b = 0; b < ny; b++) {
+    for (int a = 1 - nx; a < nx; a++) {
+      if (b == 0 && a <= 0)
+        continue; // Each pair once
+      double s, n_pairs;
+      BruteForceLag(field, mask, nx, ny, 1, a, b, 0, s, n_pairs);
+      double dist = std::sqrt(a * dx * a * dx + b * dy * b * dy);
+      size_t bin  = static_cast<size_t>(dist / bin_width);
+      BOOST_REQUIRE(bin < sum.size());
+      sum[bin]   += s;
+      count[bin] += n_pairs;
+      if (b == 0 && bin < 4) {
+        dir_sum[bin]   += s;
+        dir_count[bin] += n_pairs;
+      }
+    }
+  }
+  for (size_t bin = 0; bin < gamma.size(); bin++) {
+    BOOST_CHECK_EQUAL(pairs[bin], count[bin]);
+    if (count[bin] > 0.0)
+      BOOST_CHECK_SMALL(gamma[bin] - sum[bin] / (2.0 * count[bin]), 1e-9);
+  }
+  for (size_t bin = 0; bin < 4; bin++) {
+    BOOST_CHECK_EQUAL(dir_pairs[bin], dir_count[bin]);
+    if (dir_count[bin] > 0.0)
+      BOOST_CHECK_SMALL(dir_gamma[bin] - dir_sum[bin] / (2.0 * dir_count[bin]), 1e-9);
+    else
+      BOOST_TEST(std::isnan(dir_gamma[bin]));
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
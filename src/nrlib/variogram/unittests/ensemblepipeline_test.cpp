@@ -0,0 +1,106 @@
+/// Unit tests for the pipelined ensemble simulation
+
+#include <nrlib/exception/exception.hpp>
+#include <nrlib/grid/grid.hpp>
+#include <nrlib/grid/grid2d.hpp>
+#include <nrlib/random/random.hpp>
+#include <nrlib/random/randomgenerator.hpp>
+#include <nrlib/variogram/ensemblepipeline.hpp>
+#include <nrlib/variogram/gaussianfield.hpp>
+#include <nrlib/variogram/variogram.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+using namespace NRLib;
+
+BOOST_AUTO_TEST_SUITE( TestEnsemblePipeline )
+
+BOOST_AUTO_TEST_CASE( StagesRunInOrderWithoutSharingBuffers )
+{
+  const size_t n_items   = 50;
+  const size_t n_buffers = 2;
+  std::vector<size_t>            noise(n_buffers), work(n_buffers);
+  std::vector<std::atomic<int> > noise_users(n_buffers), work_users(n_buffers);
+  std::vector<size_t>            generated, output;
+  // Boost.Test is not thread safe, so errors in the stages are counted.
+  std::atomic<int>               errors(0);
+
+  RunEnsemblePipeline(n_items, n_buffers,
+    [&](size_t r, size_t b) {
+      errors += (noise_users[b]++ != 0);
+      generated.push_back(r);
+      noise[b] = r;
+      noise_users[b]--;
+    },
+    [&](size_t r, size_t b, size_t w) {
+      errors += (noise_users[b]++ != 0) + (work_users[w]++ != 0) + (noise[b] != r);
+      work[w] = 10 * noise[b];
+      noise_users[b]--;
+      work_users[w]--;
+    },
+    [&](size_t r, size_t w) {
+      errors += (work_users[w]++ != 0) + (work[w] != 10 * r);
+      output.push_back(r);
+      work_users[w]--;
+    });
+
+  BOOST_TEST(errors == 0);
+  BOOST_REQUIRE(generated.size() == n_items);
+  BOOST_REQUIRE(output.size() == n_items);
+  for (size_t r = 0; r < n_items; r++) {
+    BOOST_TEST(generated[r] == r);
+    BOOST_TEST(output[r] == r);
+  }
+}
+
+BOOST_AUTO_TEST_CASE( ExceptionIsRethrown )
+{
+  size_t n_output = 0;
+  BOOST_CHECK_THROW(RunEnsemblePipeline(20, 2,
+                                        [](size_t r, size_t) { if (r == 5) throw Exception("noise"); },
+                                        [](size_t, size_t, size_t) {},
+                                        [&](size_t, size_t) { n_output++; }),
+                    Exception);
+  BOOST_TEST(n_output <= 5U);
+
+  BOOST_CHECK_THROW(RunEnsemblePipeline(20, 2,
+                                        [](size_t, size_t) {},
+                                        [](size_t, size_t, size_t) {},
+                                        [](size_t r, size_t) { if (r == 3) throw Exception("output"); }),
+                    Exception);
+}
+
+BOOST_AUTO_TEST_CASE( EnsembleMatchesSingleFields )
+{
+  std::unique_ptr<Variogram> v(Variogram::Create(Variogram::EXPONENTIAL, 1.5, 300.0, 200.0, 50.0));
+
+  std::vector<Grid2D<double> > ensemble2d, single2d;
+  RandomGenerator rg(99L);
+  Simulate2DGaussianField(*v, 40, 20.0, 30, 20.0, 4, ensemble2d, &rg);
+  RandomGenerator rg_single(99L);
+  for (int m = 0; m < 4; m++)
+    Simulate2DGaussianField(*v, 40, 20.0, 30, 20.0, 1, single2d, &rg_single);
+  BOOST_REQUIRE(ensemble2d.size() == 4U);
+  for (size_t m = 0; m < 4; m++) {
+    for (size_t i = 0; i < ensemble2d[m].GetStorage().size(); i++)
+      BOOST_TEST(ensemble2d[m].GetStorage()[i] == single2d[m].GetStorage()[i]);
+  }
+
+  std::vector<Grid<double> > ensemble3d, single3d;
+  Random::Initialize(7L);
+  Simulate3DGaussianField(*v, 20, 20.0, 16, 20.0, 8, 10.0, 3, ensemble3d);
+  Random::Initialize(7L);
+  for (int m = 0; m < 3; m++)
+    Simulate3DGaussianField(*v, 20, 20.0, 16, 20.0, 8, 10.0, 1, single3d);
+  BOOST_REQUIRE(ensemble3d.size() == 3U);
+  for (size_t m = 0; m < 3; m++) {
+    for (size_t i = 0; i < ensemble3d[m].GetStorage().size(); i++)
+      BOOST_TEST(ensemble3d[m].GetStorage()[i] == single3d[m].GetStorage()[i]);
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -112,4 +112,39 @@ BOOST_AUTO_TEST_CASE( SmoothenedFFTCovGrid3D )
   BOOST_CHECK_CLOSE(grid(0,  0, 43), grid(0, 0, 1), 1e-6);
 }
 
+BOOST_AUTO_TEST_CASE( BlockSupportFFTCovGrid )
+{
+  // Block averages of a smooth variogram, compared with averages over
+  // m points in each of the two blocks.
+  Variogram * v = Variogram::Create(Variogram::GAUSSIAN, 1.5, 100.0, 100.0, 100.0);
+  double dx = 20.0;
+  v->SetBlockSupport(dx);
+  FFTCovGrid1D cg(*v, 200, dx);
+  const std::vector<double> & grid = cg.GetCov();
+  const int m = 40;
+  for (int lag = 0; lag < 8; lag++) {
+    double expected = 0.0;
+    for (int a = 0; a < m; a++)
+      for (int b = 0; b < m; b++)
+        expected += v->GetCov(lag * dx + (a - b) * dx / m);
+    expected /= m * m;
+    BOOST_CHECK_CLOSE(grid[lag], expected, 0.5);
+  }
+  BOOST_CHECK_LT(grid[0], 1.0);
+  BOOST_CHECK_CLOSE(grid[199], grid[1], 1e-6);
+
+  // Blocks along x only do not change the correlation along y, as the
+  // gaussian variogram is separable.
+  Variogram * point_support = Variogram::Create(Variogram::GAUSSIAN, 1.5, 100.0, 100.0, 100.0);
+  v->SetBlockSupport(dx, 0.0, 0.0);
+  FFTCovGrid3D cg3d(*v, 64, dx, 64, dx, 32, dx);
+  FFTCovGrid3D point(*point_support, 64, dx, 64, dx, 32, dx);
+  BOOST_CHECK_CLOSE(cg3d.GetCov()(0, 0, 0), grid[0], 0.5);
+  BOOST_CHECK_CLOSE(cg3d.GetCov()(1, 0, 0), grid[1], 0.5);
+  for (size_t j = 0; j < 4; j++)
+    BOOST_CHECK_CLOSE(cg3d.GetCov()(0, j, 0) / cg3d.GetCov()(0, 0, 0), point.GetCov()(0, j, 0), 0.5);
+  delete point_support;
+  delete v;
+}
+
 BOOST_AUTO_TEST_SUITE_END()
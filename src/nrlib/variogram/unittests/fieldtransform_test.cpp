@@ -0,0 +1,110 @@
+/// Unit tests for FieldTransform
+
+#include <nrlib/exception/exception.hpp>
+#include <nrlib/variogram/fieldtransform.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+using namespace NRLib;
+
+BOOST_AUTO_TEST_SUITE( TestFieldTransform )
+
+BOOST_AUTO_TEST_CASE( StepsAreAppliedInOrder )
+{
+  // Large enough to run in parallel
+  const size_t n = 300000;
+  std::vector<double> values(n), trend(n);
+  for (size_t i = 0; i < n; i++) {
+    values[i] = std::sin(0.001 * i);
+    trend[i]  = 0.5 * std::cos(0.003 * i);
+  }
+
+  FieldTransform transform;
+  transform.AddAffine(0.3, -0.1);
+  transform.AddTrend(trend);
+  transform.AddExp();
+  std::vector<double> out(n);
+  transform.Apply(&values[0], n, &out[0]);
+  for (size_t i = 0; i < n; i++)
+    BOOST_REQUIRE_CLOSE(out[i], std::exp(0.3 * values[i] - 0.1 + trend[i]), 1e-12);
+
+  BOOST_CHECK_THROW(transform.Apply(&values[0], n, reinterpret_cast<signed char *>(&out[0])), Exception);
+  // The trend must cover the whole field, not only the values transformed
+  BOOST_CHECK_THROW(transform.Apply(&values[0], n - 1, &out[0]), Exception);
+
+  // In parts, as layer by layer
+  const size_t layer = 70000;
+  std::vector<double> parts(n);
+  for (size_t begin = 0; begin < n; begin += layer) {
+    size_t m = std::min(layer, n - begin);
+    transform.Apply(&values[begin], begin, m, n, &parts[begin]);
+  }
+  for (size_t i = 0; i < n; i++)
+    BOOST_REQUIRE_EQUAL(parts[i], out[i]);
+  BOOST_CHECK_THROW(transform.Apply(&values[0], n - 10, 20, n, &parts[0]), Exception);
+}
+
+BOOST_AUTO_TEST_CASE( LognormalMoments )
+{
+  FieldTransform transform;
+  transform.AddLognormal(10.0, 2.0);
+  // Integrate over the standard normal density
+  const size_t n  = 20001;
+  const double dz = 0.001;
+  std::vector<double> z(n), x(n);
+  for (size_t i = 0; i < n; i++)
+    z[i] = (static_cast<double>(i) - 0.5 * (n - 1)) * dz;
+  transform.Apply(&z[0], n, &x[0]);
+  double mean = 0.0;
+  double m2   = 0.0;
+  for (size_t i = 0; i < n; i++) {
+    double w = std::exp(-0.5 * z[i] * z[i]) * dz / std::sqrt(2.0 * std::acos(-1.0));
+    mean += w * x[i];
+    m2   += w * x[i] * x[i];
+  }
+  BOOST_CHECK_CLOSE(mean, 10.0, 1e-4);
+  BOOST_CHECK_CLOSE(std::sqrt(m2 - mean * mean), 2.0, 1e-3);
+}
+
+BOOST_AUTO_TEST_CASE( TableAndThresholds )
+{
+  std::vector<double> x, y;
+  x.push_back(-1.0); y.push_back(0.0);
+  x.push_back( 0.0); y.push_back(10.0);
+  x.push_back( 2.0); y.push_back(20.0);
+  std::vector<double> values;
+  values.push_back(-3.0);
+  values.push_back(-0.5);
+  values.push_back( 1.0);
+  values.push_back( 5.0);
+
+  FieldTransform table;
+  table.AddTable(x, y);
+  std::vector<double> out(values.size());
+  table.Apply(&values[0], values.size(), &out[0]);
+  BOOST_CHECK_EQUAL(out[0], 0.0);
+  BOOST_CHECK_CLOSE(out[1], 5.0, 1e-12);
+  BOOST_CHECK_CLOSE(out[2], 15.0, 1e-12);
+  BOOST_CHECK_EQUAL(out[3], 20.0);
+
+  std::vector<double> thresholds;
+  thresholds.push_back(2.0);
+  thresholds.push_back(15.0);
+  table.SetThresholds(thresholds);
+  std::vector<signed char> codes(values.size());
+  table.Apply(&values[0], values.size(), &codes[0]);
+  BOOST_CHECK_EQUAL(codes[0], 0);
+  BOOST_CHECK_EQUAL(codes[1], 1);
+  BOOST_CHECK_EQUAL(codes[2], 2);
+  BOOST_CHECK_EQUAL(codes[3], 2);
+
+  std::vector<double> decreasing(2, 1.0);
+  BOOST_CHECK_THROW(table.SetThresholds(decreasing), Exception);
+  BOOST_CHECK_THROW(table.AddTable(decreasing, y), Exception);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
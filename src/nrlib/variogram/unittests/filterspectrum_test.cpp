@@ -0,0 +1,119 @@
+/// Unit tests for the on-disk cache of filter spectra
+
+#include <nrlib/grid/grid.hpp>
+#include <nrlib/grid/grid2d.hpp>
+#include <nrlib/random/random.hpp>
+#include <nrlib/variogram/filterspectrum.hpp>
+#include <nrlib/variogram/gaussianfield.hpp>
+#include <nrlib/variogram/gaussianfieldsimulator.hpp>
+#include <nrlib/variogram/variogram.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <filesystem>
+#include <memory>
+
+using namespace NRLib;
+
+namespace {
+  /// Turns on the cache in an empty temporary directory while in scope.
+  class TemporaryCache {
+  public:
+    TemporaryCache()
+      : directory_((std::filesystem::temp_directory_path() / "nrlib_filterspectrum_test").string())
+    {
+      std::filesystem::remove_all(directory_);
+      FilterSpectrum::SetCacheDirectory(directory_);
+    }
+
+    ~TemporaryCache()
+    {
+      FilterSpectrum::SetCacheDirectory("");
+      std::error_code error;
+      std::filesystem::remove_all(directory_, error);
+    }
+
+  private:
+    std::string directory_;
+  };
+
+  void Ramp(std::vector<double> & values, size_t n, int & n_calls)
+  {
+    n_calls++;
+    values.resize(n);
+    for (size_t i = 0; i < n; i++)
+      values[i] = 0.5 * i;
+  }
+}
+
+BOOST_AUTO_TEST_SUITE( TestFilterSpectrum )
+
+BOOST_AUTO_TEST_CASE( SecondGetIsMapped )
+{
+  TemporaryCache cache;
+  int n_calls = 0;
+  auto compute = [&](std::vector<double> & values) { Ramp(values, 100, n_calls); };
+
+  std::shared_ptr<const FilterSpectrum> first  = FilterSpectrum::Get("ramp", 100, compute);
+  std::shared_ptr<const FilterSpectrum> second = FilterSpectrum::Get("ramp", 100, compute);
+  BOOST_TEST(n_calls == 1);
+  BOOST_TEST(second->IsMapped());
+  BOOST_REQUIRE(second->Size() == 100U);
+  for (size_t i = 0; i < 100; i++)
+    BOOST_TEST(second->Data()[i] == first->Data()[i]);
+
+  // A different size for the same key is computed again.
+  std::shared_ptr<const FilterSpectrum> other = FilterSpectrum::Get("ramp", 50, [&](std::vector<double> & values) { Ramp(values, 50, n_calls); });
+  BOOST_TEST(n_calls == 2);
+  BOOST_TEST(other->Size() == 50U);
+}
+
+BOOST_AUTO_TEST_CASE( NoCacheByDefault )
+{
+  int n_calls = 0;
+  auto compute = [&](std::vector<double> & values) { Ramp(values, 10, n_calls); };
+  FilterSpectrum::Get("ramp", 10, compute);
+  std::shared_ptr<const FilterSpectrum> second = FilterSpectrum::Get("ramp", 10, compute);
+  BOOST_TEST(n_calls == 2);
+  BOOST_TEST(!second->IsMapped());
+}
+
+BOOST_AUTO_TEST_CASE( KeyDependsOnVariogram )
+{
+  std::unique_ptr<Variogram> a(Variogram::Create(Variogram::EXPONENTIAL, 1.5, 500.0, 300.0, 100.0));
+  std::unique_ptr<Variogram> b(Variogram::Create(Variogram::EXPONENTIAL, 1.5, 500.0, 300.0, 100.5));
+  std::unique_ptr<Variogram> c(Variogram::Create(Variogram::GAUSSIAN,    1.5, 500.0, 300.0, 100.0));
+  std::string key = FilterSpectrum::MakeKey(*a, "real", 64, 20.0);
+  BOOST_TEST(key == FilterSpectrum::MakeKey(*a, "real", 64, 20.0));
+  BOOST_TEST(key != FilterSpectrum::MakeKey(*b, "real", 64, 20.0));
+  BOOST_TEST(key != FilterSpectrum::MakeKey(*c, "real", 64, 20.0));
+  BOOST_TEST(key != FilterSpectrum::MakeKey(*a, "real", 64, 20.5));
+  BOOST_TEST(key != FilterSpectrum::MakeKey(*a, "complex", 64, 20.0));
+}
+
+BOOST_AUTO_TEST_CASE( CachedSimulationIsUnchanged )
+{
+  std::unique_ptr<Variogram> v(Variogram::Create(Variogram::SPHERICAL, 1.5, 500.0, 300.0, 100.0));
+  std::vector<Grid2D<double> > expected;
+  std::vector<double>          expected_field;
+  Random::Initialize(42L);
+  Simulate2DGaussianField(*v, 40, 20.0, 30, 20.0, 1, expected);
+  GaussianFieldSimulator(*v, 40, 20.0, 30, 20.0, 10, 10.0).Simulate(expected_field);
+
+  TemporaryCache cache;
+  for (int pass = 0; pass < 2; pass++) {
+    std::vector<Grid2D<double> > fields;
+    std::vector<double>          field;
+    Random::Initialize(42L);
+    Simulate2DGaussianField(*v, 40, 20.0, 30, 20.0, 1, fields);
+    GaussianFieldSimulator(*v, 40, 20.0, 30, 20.0, 10, 10.0).Simulate(field);
+    BOOST_REQUIRE(fields[0].GetStorage().size() == expected[0].GetStorage().size());
+    for (size_t i = 0; i < fields[0].GetStorage().size(); i++)
+      BOOST_TEST(fields[0].GetStorage()[i] == expected[0].GetStorage()[i]);
+    BOOST_REQUIRE(field.size() == expected_field.size());
+    for (size_t i = 0; i < field.size(); i++)
+      BOOST_TEST(field[i] == expected_field[i]);
+  }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
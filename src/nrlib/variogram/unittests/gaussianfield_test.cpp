@@ -1,5 +1,7 @@
 /// Unit tests for gaussian field simulation
 
+#include <nrlib/exception/exception.hpp>
+#include <nrlib/grid/grid.hpp>
 #include <nrlib/grid/grid2d.hpp>
 #include <nrlib/random/random.hpp>
 #include <nrlib/variogram/gaussianfield.hpp>
@@ -7,8 +9,30 @@
 
 #include <boost/test/unit_test.hpp>
 
+#include <cmath>
+
 using namespace NRLib;
 
+namespace {
+  // Stores the layers of the last field, with x fastest.
+  class LayerCollector : public GaussianFieldSink {
+  public:
+    LayerCollector(size_t nx, size_t ny, size_t nz) : values(nx * ny * nz), nx_(nx), ny_(ny) {}
+
+    void AddLayer(size_t k, size_t ni, size_t nj, const double * layer, size_t stride)
+    {
+      for (size_t j = 0; j < nj; j++)
+        for (size_t i = 0; i < ni; i++)
+          values[i + nx_ * (j + ny_ * k)] = layer[i + j * stride];
+    }
+
+    std::vector<double> values;
+  private:
+    size_t nx_;
+    size_t ny_;
+  };
+}
+
 BOOST_AUTO_TEST_SUITE( TestGaussianField )
 
 BOOST_AUTO_TEST_CASE( Sim2dComparison )
@@ -37,7 +61,10 @@ BOOST_AUTO_TEST_CASE( Sim2dValues )
   Variogram * v = Variogram::Create(Variogram::EXPONENTIAL, 1.5, 1000.0, 500.0, 250.0);
   std::vector<Grid2D<double> > fields;
   RandomGenerator * rg = new RandomGenerator(321);
+  // The values are from before FillNorm01 was used for the noise.
+  SetLegacyNoise(true);
   Simulate2DGaussianField(*v, 757, 20, 757, 20, 1, fields, rg);
+  SetLegacyNoise(false);
   delete rg;
   delete v;
   const std::vector<double> & values = fields[0].GetStorage();
@@ -71,4 +98,188 @@ BOOST_AUTO_TEST_CASE(Sim2dValuesSmall, * boost::unit_test::disabled())
   BOOST_CHECK_CLOSE(values[22 * 22 - 1], 0.84887146362306831, 1e-11);
 }
 
+BOOST_AUTO_TEST_CASE( SimMultipleFields )
+{
+  Variogram * v1 = Variogram::Create(Variogram::SPHERICAL, 1.5, 500.0, 300.0, 40.0);
+  Variogram * v2 = Variogram::Create(Variogram::SPHERICAL, 1.5, 200.0, 100.0, 20.0);
+  std::vector<const Variogram *> both;
+  both.push_back(v1);
+  both.push_back(v2);
+  std::vector<const Variogram *> first(1, v1);
+
+  std::vector<Grid<double> > fields, again, single;
+  Random::Initialize(123L);
+  SimulateMultipleGaussianFields(both, 30, 20.0, 20, 20.0, 10, 5.0, fields);
+  Random::Initialize(123L);
+  SimulateMultipleGaussianFields(both, 30, 20.0, 20, 20.0, 10, 5.0, again);
+  // v2 has shorter ranges, so the common padding is the one of v1.
+  Random::Initialize(123L);
+  SimulateMultipleGaussianFields(first, 30, 20.0, 20, 20.0, 10, 5.0, single);
+
+  BOOST_TEST(fields.size() == 2U);
+  BOOST_TEST(fields[1].GetNI() == 30U);
+  BOOST_TEST(fields[1].GetNJ() == 20U);
+  BOOST_TEST(fields[1].GetNK() == 10U);
+  for (size_t i = 0; i < fields[0].GetStorage().size(); i++) {
+    BOOST_TEST(fields[0].GetStorage()[i] == again[0].GetStorage()[i]);
+    BOOST_TEST(fields[1].GetStorage()[i] == again[1].GetStorage()[i]);
+    BOOST_CHECK_CLOSE(fields[0].GetStorage()[i], single[0].GetStorage()[i], 1e-8);
+  }
+  BOOST_TEST(fields[0].GetStorage()[0] != fields[1].GetStorage()[0]);
+  delete v1;
+  delete v2;
+}
+
+BOOST_AUTO_TEST_CASE( SimMultipleFieldsVariance )
+{
+  Variogram * v = Variogram::Create(Variogram::EXPONENTIAL, 1.5, 20.0, 20.0, 20.0);
+  std::vector<const Variogram *> variograms(4, v);
+  std::vector<Grid<double> > fields1d, fields2d;
+  Random::Initialize(42L);
+  SimulateMultipleGaussianFields(variograms, 5000, 1.0, 1, -1.0, 1, -1.0, fields1d);
+  SimulateMultipleGaussianFields(variograms, 200, 1.0, 200, 1.0, 1, -1.0, fields2d);
+  BOOST_TEST(fields1d.size() == 4U);
+  BOOST_TEST(fields2d[3].GetNK() == 1U);
+
+  double sum = 0.0, sum2 = 0.0, n = 0.0;
+  for (size_t m = 0; m < fields2d.size(); m++) {
+    const std::vector<double> & values = fields2d[m].GetStorage();
+    for (size_t i = 0; i < values.size(); i++) {
+      sum  += values[i];
+      sum2 += values[i] * values[i];
+      n    += 1.0;
+    }
+  }
+  double mean = sum / n;
+  BOOST_TEST(std::abs(mean) < 0.2);
+  BOOST_TEST(std::abs(sum2 / n - mean * mean - 1.0) < 0.2);
+  delete v;
+}
+
+BOOST_AUTO_TEST_CASE( Sim1dTracesMatchSingleTraces )
+{
+  // More traces than one batch, to cover the last, partial batch.
+  Variogram * v = Variogram::Create(Variogram::SPHERICAL, 1.5, 40.0);
+  size_t nx = 57;
+  size_t n_traces = 1100;
+  std::vector<double> traces(n_traces * nx);
+  Random::Initialize(11L);
+  Simulate1DGaussianTraces(*v, nx, 2.0, n_traces, &traces[0]);
+
+  Random::Initialize(11L);
+  std::vector<double> single(nx);
+  for (size_t t = 0; t < n_traces; t++) {
+    Simulate1DGaussianField(*v, nx, 2.0, single);
+    if (t % 100 != 0 && t != n_traces - 1)
+      continue;
+    for (size_t i = 0; i < nx; i++)
+      BOOST_CHECK_SMALL(traces[t * nx + i] - single[i], 1e-12);
+  }
+  delete v;
+}
+
+BOOST_AUTO_TEST_CASE( SimPointsCovariance )
+{
+  // Two points 20 apart, simulated many times with few features each.
+  Variogram * v = Variogram::Create(Variogram::GAUSSIAN, 1.5, 50.0, 30.0, 1.0, 30.0, 0.0, 2.0);
+  const double points[4] = {100.0, 200.0, 112.0, 216.0};
+  size_t n_real = 20000;
+  double sum_00 = 0.0, sum_01 = 0.0;
+  RandomGenerator rg(5L);
+  for (size_t r = 0; r < n_real; r++) {
+    double values[2];
+    SimulateGaussianFieldAtPoints(*v, points, 2, 2, 50, values, &rg);
+    sum_00 += values[0] * values[0];
+    sum_01 += values[0] * values[1];
+  }
+  BOOST_CHECK_CLOSE(sum_00 / n_real, 4.0, 5.0);
+  BOOST_CHECK_SMALL(sum_01 / n_real - v->GetCov(12.0, 16.0), 0.15);
+  BOOST_CHECK_THROW(SimulateGaussianFieldAtPoints(*v, points, 1, 4, 50, &sum_00, &rg), Exception);
+  delete v;
+}
+
+BOOST_AUTO_TEST_CASE( SimAtCellsMatchesGrid )
+{
+  Variogram * v = Variogram::Create(Variogram::SPHERICAL, 1.5, 300.0, 200.0, 20.0);
+  size_t nx = 30, ny = 20, nz = 9;
+  std::vector<size_t> cells;
+  for (size_t c = nx * ny * nz; c-- > 0;) {
+    if (c % 7 != 3)
+      cells.push_back(c);
+  }
+  cells.push_back(5);
+
+  Random::Initialize(21L);
+  std::vector<Grid<double> > fields;
+  Simulate3DGaussianField(*v, nx, 20.0, ny, 20.0, nz, 2.0, 2, fields);
+  BOOST_REQUIRE(fields.size() == 2U);
+
+  Random::Initialize(21L);
+  std::vector<double> values(2 * cells.size());
+  SimulateGaussianFieldAtCells(*v, nx, 20.0, ny, 20.0, nz, 2.0, cells, 2, &values[0]);
+  for (size_t m = 0; m < 2; m++)
+    for (size_t c = 0; c < cells.size(); c++)
+      BOOST_CHECK_SMALL(values[m * cells.size() + c] - fields[m](cells[c]), 1e-10);
+
+  cells.push_back(nx * ny * nz);
+  BOOST_CHECK_THROW(SimulateGaussianFieldAtCells(*v, nx, 20.0, ny, 20.0, nz, 2.0, cells, 1, &values[0]), Exception);
+  delete v;
+}
+
+BOOST_AUTO_TEST_CASE( Sim2dSinkMatchesStandard )
+{
+  Variogram * v = Variogram::Create(Variogram::GAUSSIAN, 1.5, 300.0, 200.0, 20.0, 0.4);
+  size_t nx = 35, ny = 24;
+
+  RandomGenerator rg(5UL);
+  std::vector<Grid2D<double> > fields;
+  Simulate2DGaussianField(*v, nx, 20.0, ny, 20.0, 2, fields, &rg);
+  rg.Initialize(5UL);
+  LayerCollector collector(nx, ny, 1);
+  Simulate2DGaussianField(*v, nx, 20.0, ny, 20.0, 2, collector, &rg);
+  // The collector keeps the last field
+  for (size_t i = 0; i < nx * ny; i++)
+    BOOST_TEST(collector.values[i] == fields[1].GetStorage()[i]);
+  delete v;
+}
+
+BOOST_AUTO_TEST_CASE( SimSlabsLayers )
+{
+  Variogram * v = Variogram::Create(Variogram::EXPONENTIAL, 1.5, 100.0, 60.0, 20.0, 0.3);
+  size_t nx = 40, ny = 30, nz = 400;
+  double dz = 2.0;
+
+  // The first layer is the 2D simulation with the same noise.
+  RandomGenerator rg(17UL);
+  std::vector<Grid2D<double> > fields;
+  Simulate2DGaussianField(*v, nx, 10.0, ny, 10.0, 1, fields, &rg, -1, -1, 1.0, 1.0, GaussianFieldPlan::LEAN);
+  LayerCollector collector(nx, ny, nz);
+  rg.Initialize(17UL);
+  Simulate3DGaussianFieldSlabs(*v, 20.0, nx, 10.0, ny, 10.0, nz, dz, 1, collector, &rg);
+  for (size_t i = 0; i < nx * ny; i++)
+    BOOST_CHECK_SMALL(collector.values[i] - fields[0].GetStorage()[i], 1e-10);
+
+  // Correlation between neighbouring layers.
+  double sum_lag = 0.0;
+  double sum_var = 0.0;
+  for (size_t k = 0; k + 1 < nz; k++) {
+    for (size_t i = 0; i < nx * ny; i++) {
+      sum_lag += collector.values[i + k * nx * ny] * collector.values[i + (k + 1) * nx * ny];
+      sum_var += collector.values[i + k * nx * ny] * collector.values[i + k * nx * ny];
+    }
+  }
+  BOOST_CHECK_CLOSE(sum_lag / sum_var, std::exp(-3.0 * dz / 20.0), 5.0);
+
+  // A vertical section
+  LayerCollector section(nx, 1, 5);
+  Simulate3DGaussianFieldSlabs(*v, 20.0, nx, 10.0, 1, 10.0, 5, dz, 1, section, &rg);
+  for (size_t i = 0; i < section.values.size(); i++)
+    BOOST_TEST(std::isfinite(section.values[i]));
+
+  BOOST_CHECK_THROW(Simulate3DGaussianFieldSlabs(*v, 0.0, nx, 10.0, ny, 10.0, nz, dz, 1, collector), Exception);
+  v->SetAngles(0.3, 0.1);
+  BOOST_CHECK_THROW(Simulate3DGaussianFieldSlabs(*v, 20.0, nx, 10.0, ny, 10.0, nz, dz, 1, collector), Exception);
+  delete v;
+}
+
 BOOST_AUTO_TEST_SUITE_END()
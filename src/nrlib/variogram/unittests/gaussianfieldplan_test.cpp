@@ -0,0 +1,99 @@
+/// Unit tests for the gaussian field simulation planner
+
+#include <nrlib/exception/exception.hpp>
+#include <nrlib/fft/workspacepool.hpp>
+#include <nrlib/grid/grid.hpp>
+#include <nrlib/grid/grid2d.hpp>
+#include <nrlib/random/random.hpp>
+#include <nrlib/variogram/gaussianfield.hpp>
+#include <nrlib/variogram/gaussianfieldplan.hpp>
+#include <nrlib/variogram/variogram.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+using namespace NRLib;
+
+BOOST_AUTO_TEST_SUITE( TestGaussianFieldPlan )
+
+BOOST_AUTO_TEST_CASE( StrategyOrder )
+{
+  Variogram * v = Variogram::Create(Variogram::SPHERICAL, 1.5, 1000.0, 500.0, 250.0);
+  GaussianFieldPlan standard = EstimateGaussianFieldResources(GaussianFieldPlan::STANDARD, *v, 100, 20.0, 80, 20.0, 20, 10.0, 1);
+  GaussianFieldPlan lean     = EstimateGaussianFieldResources(GaussianFieldPlan::LEAN, *v, 100, 20.0, 80, 20.0, 20, 10.0, 1);
+  GaussianFieldPlan single   = EstimateGaussianFieldResources(GaussianFieldPlan::SINGLE_PRECISION, *v, 100, 20.0, 80, 20.0, 20, 10.0, 1);
+  BOOST_TEST(standard.padded_size.size() == 3U);
+  BOOST_TEST(lean.peak_bytes < standard.peak_bytes);
+  BOOST_TEST(single.peak_bytes < lean.peak_bytes);
+  BOOST_TEST(standard.flops > 0.0);
+
+  BOOST_TEST(PlanGaussianFieldSimulation(*v, 100, 20.0, 80, 20.0, 20, 10.0, 1, 0).strategy == GaussianFieldPlan::STANDARD);
+  BOOST_TEST(PlanGaussianFieldSimulation(*v, 100, 20.0, 80, 20.0, 20, 10.0, 1, lean.peak_bytes).strategy == GaussianFieldPlan::LEAN);
+  BOOST_TEST(PlanGaussianFieldSimulation(*v, 100, 20.0, 80, 20.0, 20, 10.0, 1, single.peak_bytes).strategy == GaussianFieldPlan::SINGLE_PRECISION);
+  BOOST_CHECK_THROW(PlanGaussianFieldSimulation(*v, 100, 20.0, 80, 20.0, 20, 10.0, 1, single.peak_bytes - 1), Exception);
+  delete v;
+}
+
+BOOST_AUTO_TEST_CASE( PooledBuffersCountAgainstBudget )
+{
+  Variogram * v = Variogram::Create(Variogram::SPHERICAL, 1.5, 1000.0, 500.0, 250.0);
+  GaussianFieldPlan lean = EstimateGaussianFieldResources(GaussianFieldPlan::LEAN, *v, 100, 20.0, 80, 20.0, 20, 10.0, 1);
+  WorkspacePool::ReleaseUnused();
+  WorkspacePool::Release(WorkspacePool::Acquire(1000000), 1000000);
+  size_t pooled = WorkspacePool::GetPooledBytes();
+  BOOST_REQUIRE(pooled > 0U);
+
+  // Fits together with the pool, which is kept.
+  BOOST_TEST(PlanGaussianFieldSimulation(*v, 100, 20.0, 80, 20.0, 20, 10.0, 1, lean.peak_bytes + pooled).strategy == GaussianFieldPlan::LEAN);
+  BOOST_TEST(WorkspacePool::GetPooledBytes() == pooled);
+
+  // Only fits without the pool, which is released. The strategy is the same.
+  BOOST_TEST(PlanGaussianFieldSimulation(*v, 100, 20.0, 80, 20.0, 20, 10.0, 1, lean.peak_bytes).strategy == GaussianFieldPlan::LEAN);
+  BOOST_TEST(WorkspacePool::GetPooledBytes() == 0U);
+  delete v;
+}
+
+BOOST_AUTO_TEST_CASE( Sim3dLeanMatchesStandard )
+{
+  Variogram * v = Variogram::Create(Variogram::EXPONENTIAL, 1.5, 500.0, 300.0, 100.0);
+  std::vector<Grid<double> > standard, lean, single;
+  Random::Initialize(123L);
+  Simulate3DGaussianField(*v, 30, 20.0, 20, 20.0, 10, 10.0, 2, standard);
+  Random::Initialize(123L);
+  Simulate3DGaussianField(*v, 30, 20.0, 20, 20.0, 10, 10.0, 2, lean,
+                          -1, -1, -1, 1.0, 1.0, 1.0, GaussianFieldPlan::LEAN);
+  Random::Initialize(123L);
+  Simulate3DGaussianField(*v, 30, 20.0, 20, 20.0, 10, 10.0, 2, single,
+                          -1, -1, -1, 1.0, 1.0, 1.0, GaussianFieldPlan::SINGLE_PRECISION);
+  delete v;
+
+  BOOST_REQUIRE(lean.size() == 2U);
+  for (size_t m = 0; m < 2; ++m) {
+    const std::vector<double> & a = standard[m].GetStorage();
+    const std::vector<double> & b = lean[m].GetStorage();
+    const std::vector<double> & c = single[m].GetStorage();
+    BOOST_REQUIRE(a.size() == b.size());
+    for (size_t i = 0; i < a.size(); ++i) {
+      BOOST_TEST(a[i] == b[i]);
+      BOOST_CHECK_SMALL(a[i] - c[i], 1e-4);
+    }
+  }
+}
+
+BOOST_AUTO_TEST_CASE( Sim2dLeanMatchesStandard )
+{
+  Variogram * v = Variogram::Create(Variogram::GAUSSIAN, 1.5, 500.0, 300.0, 100.0);
+  std::vector<Grid2D<double> > standard, lean;
+  RandomGenerator rg1(321), rg2(321);
+  Simulate2DGaussianField(*v, 40, 20.0, 30, 20.0, 1, standard, &rg1);
+  Simulate2DGaussianField(*v, 40, 20.0, 30, 20.0, 1, lean, &rg2,
+                          -1, -1, 1.0, 1.0, GaussianFieldPlan::LEAN);
+  delete v;
+
+  const std::vector<double> & a = standard[0].GetStorage();
+  const std::vector<double> & b = lean[0].GetStorage();
+  BOOST_REQUIRE(a.size() == b.size());
+  for (size_t i = 0; i < a.size(); ++i)
+    BOOST_TEST(a[i] == b[i]);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
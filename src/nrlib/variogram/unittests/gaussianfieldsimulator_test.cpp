@@ -0,0 +1,284 @@
+/// Unit tests for the reusable gaussian field simulator
+
+#include <nrlib/exception/exception.hpp>
+#include <nrlib/grid/grid.hpp>
+#include <nrlib/grid/grid2d.hpp>
+#include <nrlib/random/random.hpp>
+#include <nrlib/variogram/gaussianfield.hpp>
+#include <nrlib/variogram/gaussianfieldsimulator.hpp>
+#include <nrlib/variogram/variogram.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+#include <cmath>
+
+using namespace NRLib;
+
+namespace {
+  double Mean(const std::vector<double> & x)
+  {
+    double sum = 0.0;
+    for (size_t i = 0; i < x.size(); i++)
+      sum += x[i];
+    return sum / x.size();
+  }
+
+  double Covariance(const std::vector<double> & x, const std::vector<double> & y)
+  {
+    double mx = Mean(x);
+    double my = Mean(y);
+    double sum = 0.0;
+    for (size_t i = 0; i < x.size(); i++)
+      sum += (x[i] - mx) * (y[i] - my);
+    return sum / x.size();
+  }
+}
+
+BOOST_AUTO_TEST_SUITE( TestGaussianFieldSimulator )
+
+BOOST_AUTO_TEST_CASE( SimulateMatchesGaussianField )
+{
+  Variogram * v = Variogram::Create(Variogram::EXPONENTIAL, 1.5, 500.0, 300.0, 100.0);
+  std::vector<double> field;
+
+  std::vector<Grid<double> > fields3d;
+  Random::Initialize(123L);
+  Simulate3DGaussianField(*v, 30, 20.0, 20, 20.0, 10, 10.0, 1, fields3d);
+  GaussianFieldSimulator sim3d(*v, 30, 20.0, 20, 20.0, 10, 10.0);
+  Random::Initialize(123L);
+  sim3d.Simulate(field);
+  BOOST_TEST(sim3d.GetNDim() == 3U);
+  BOOST_REQUIRE(field.size() == fields3d[0].GetStorage().size());
+  for (size_t i = 0; i < field.size(); i++)
+    BOOST_CHECK_CLOSE(field[i], fields3d[0].GetStorage()[i], 1e-9);
+
+  std::vector<Grid2D<double> > fields2d;
+  Random::Initialize(123L);
+  Simulate2DGaussianField(*v, 40, 20.0, 30, 20.0, 1, fields2d);
+  GaussianFieldSimulator sim2d(*v, 40, 20.0, 30, 20.0);
+  Random::Initialize(123L);
+  sim2d.Simulate(field);
+  BOOST_REQUIRE(field.size() == fields2d[0].GetStorage().size());
+  for (size_t i = 0; i < field.size(); i++)
+    BOOST_CHECK_CLOSE(field[i], fields2d[0].GetStorage()[i], 1e-9);
+
+  std::vector<double> field1d(75);
+  Random::Initialize(123L);
+  Simulate1DGaussianField(*v, 75, 20.0, field1d);
+  GaussianFieldSimulator sim1d(*v, 75, 20.0);
+  Random::Initialize(123L);
+  sim1d.Simulate(field);
+  BOOST_REQUIRE(field.size() == 75U);
+  for (size_t i = 0; i < field.size(); i++)
+    BOOST_CHECK_CLOSE(field[i], field1d[i], 1e-9);
+  delete v;
+}
+
+BOOST_AUTO_TEST_CASE( SequenceCorrelation )
+{
+  Variogram * v = Variogram::Create(Variogram::SPHERICAL, 1.5, 3.0, 3.0, 3.0);
+  GaussianFieldSimulator sim(*v, 120, 1.0, 100, 1.0, 5, 1.0);
+  Random::Initialize(2L);
+  double rho = 0.8;
+  std::vector<double> previous, current;
+  sim.Step(rho, previous);
+  double var = 0.0, cov = 0.0;
+  int n_steps = 5;
+  for (int t = 0; t < n_steps; t++) {
+    sim.Step(rho, current);
+    var += Covariance(current, current) / n_steps;
+    cov += Covariance(previous, current) / n_steps;
+    previous.swap(current);
+  }
+  BOOST_CHECK_SMALL(var - 1.0, 0.05);
+  BOOST_CHECK_SMALL(cov - rho, 0.05);
+  BOOST_CHECK_THROW(sim.Step(1.5, current), Exception);
+  delete v;
+}
+
+BOOST_AUTO_TEST_CASE( SpectralStateMatchesCovariance )
+{
+  // Odd padded size in 1D, even in 2D
+  Variogram * v = Variogram::Create(Variogram::GAUSSIAN, 1.5, 10.0, 10.0, 10.0);
+  Random::Initialize(9L);
+  GaussianFieldSimulator sim1d(*v, 4000, 1.0);
+  GaussianFieldSimulator sim2d(*v, 150, 1.0, 150, 1.0);
+  std::vector<double> field1d, field2d;
+  sim1d.GetField(field1d);
+  sim2d.GetField(field2d);
+
+  // Lag 3 in x: the correlation is that of the variogram.
+  std::vector<double> x, y;
+  for (size_t j = 0; j < 150; j++) {
+    for (size_t i = 0; i + 3 < 150; i++) {
+      x.push_back(field2d[i + 150 * j]);
+      y.push_back(field2d[i + 3 + 150 * j]);
+    }
+  }
+  BOOST_CHECK_SMALL(Covariance(field2d, field2d) - 1.0, 0.1);
+  BOOST_CHECK_SMALL(Covariance(x, y) - v->GetCorr(3.0, 0.0), 0.1);
+  BOOST_CHECK_SMALL(Covariance(field1d, field1d) - 1.0, 0.15);
+  delete v;
+}
+
+BOOST_AUTO_TEST_CASE( Deformation )
+{
+  Variogram * v = Variogram::Create(Variogram::EXPONENTIAL, 1.5, 50.0, 50.0, 10.0);
+  GaussianFieldSimulator sim(*v, 40, 5.0, 30, 5.0, 6, 2.0);
+  Random::Initialize(77L);
+  std::vector<double> current, deformed, zero, accepted;
+  sim.GetField(current);
+  sim.Deform(0.0, zero);
+  for (size_t i = 0; i < current.size(); i++)
+    BOOST_CHECK_CLOSE(zero[i], current[i], 1e-9);
+
+  sim.Deform(0.3, deformed);
+  BOOST_TEST(deformed[0] != current[0]);
+  sim.AcceptDeformation(0.3);
+  sim.GetField(accepted);
+  for (size_t i = 0; i < current.size(); i++)
+    BOOST_CHECK_CLOSE(accepted[i], deformed[i], 1e-9);
+  BOOST_CHECK_THROW(sim.AcceptDeformation(0.3), Exception);
+  delete v;
+}
+
+BOOST_AUTO_TEST_CASE( ApplyMatchesSimulate )
+{
+  Variogram * v = Variogram::Create(Variogram::GAUSSIAN, 0.5, 100.0, 60.0, 40.0);
+  GaussianFieldSimulator sim(*v, 30, 10.0, 20, 10.0, 8, 5.0);
+
+  // The noise of Simulate for a 3D grid.
+  size_t nx = sim.GetNXtot();
+  size_t ny = sim.GetNYtot();
+  size_t nz = sim.GetNZtot();
+  std::vector<double> noise(2 * sim.GetNoiseSize());
+  Random::Initialize(77L);
+  for (size_t b = 0; b < 2; b++)
+    FillGaussianNoise(&noise[b * sim.GetNoiseSize()], nx, ny, nz, NULL);
+
+  std::vector<double> field(2 * sim.GetFieldSize());
+  sim.Apply(&noise[0], 2, &field[0]);
+
+  Random::Initialize(77L);
+  std::vector<double> expected;
+  for (size_t b = 0; b < 2; b++) {
+    sim.Simulate(expected);
+    BOOST_REQUIRE(expected.size() == sim.GetFieldSize());
+    for (size_t i = 0; i < expected.size(); i++)
+      BOOST_CHECK_SMALL(field[b * sim.GetFieldSize() + i] - expected[i], 1e-10);
+  }
+  delete v;
+}
+
+BOOST_AUTO_TEST_CASE( AdjointDotProduct )
+{
+  // <L e, g> = <e, L^T g> for random e and g.
+  Variogram * v = Variogram::Create(Variogram::EXPONENTIAL, 1.0, 50.0, 20.0, 10.0, 30.0);
+  GaussianFieldSimulator sim2d(*v, 45, 2.0, 31, 2.0);
+  GaussianFieldSimulator sim1d(*v, 101, 1.0);
+  GaussianFieldSimulator * sims[] = { &sim1d, &sim2d };
+  Random::Initialize(5L);
+  for (size_t s = 0; s < 2; s++) {
+    GaussianFieldSimulator & sim = *sims[s];
+    size_t n_batch = 3;
+    std::vector<double> e(n_batch * sim.GetNoiseSize());
+    std::vector<double> g(n_batch * sim.GetFieldSize());
+    for (size_t i = 0; i < e.size(); i++)
+      e[i] = Random::Norm01();
+    for (size_t i = 0; i < g.size(); i++)
+      g[i] = Random::Norm01();
+
+    std::vector<double> le(g.size());
+    std::vector<double> ltg(e.size());
+    sim.Apply(&e[0], n_batch, &le[0]);
+    sim.ApplyAdjoint(&g[0], n_batch, &ltg[0]);
+    for (size_t b = 0; b < n_batch; b++) {
+      double lhs = 0.0;
+      double rhs = 0.0;
+      for (size_t i = 0; i < sim.GetFieldSize(); i++)
+        lhs += le[b * sim.GetFieldSize() + i] * g[b * sim.GetFieldSize() + i];
+      for (size_t i = 0; i < sim.GetNoiseSize(); i++)
+        rhs += e[b * sim.GetNoiseSize() + i] * ltg[b * sim.GetNoiseSize() + i];
+      BOOST_CHECK_CLOSE(lhs, rhs, 1e-8);
+    }
+  }
+  delete v;
+}
+
+BOOST_AUTO_TEST_CASE( JobsMatchSeededSimulation )
+{
+  Variogram * v = Variogram::Create(Variogram::SPHERICAL, 1.5, 400.0, 200.0, 50.0);
+  std::vector<GaussianFieldJob> jobs;
+  GaussianFieldJob job = { v, 30, 20.0, 20, 20.0, 10, 10.0, 11UL };
+  jobs.push_back(job);
+  GaussianFieldJob job2d = { v, 60, 10.0, 50, 10.0, 1, -1.0, 12UL };
+  jobs.push_back(job2d);
+  GaussianFieldJob job1d = { v, 100, 5.0, 1, -1.0, 1, -1.0, 13UL };
+  jobs.push_back(job1d);
+  GaussianFieldJob small = { v, 10, 20.0, 10, 20.0, 5, 10.0, 14UL };
+  jobs.push_back(small);
+
+  std::vector<std::vector<double> > fields;
+  SimulateGaussianFieldJobs(jobs, fields, 3);
+  BOOST_REQUIRE(fields.size() == jobs.size());
+  for (size_t j = 0; j < jobs.size(); j++) {
+    GaussianFieldSimulator sim(*v, jobs[j].nx, jobs[j].dx, jobs[j].ny, jobs[j].dy, jobs[j].nz, jobs[j].dz);
+    std::vector<double> expected;
+    Random::Initialize(jobs[j].seed);
+    sim.Simulate(expected);
+    BOOST_REQUIRE(fields[j].size() == expected.size());
+    for (size_t i = 0; i < expected.size(); i++)
+      BOOST_REQUIRE_EQUAL(fields[j][i], expected[i]);
+  }
+  delete v;
+}
+
+BOOST_AUTO_TEST_CASE( DerivativesMatchDifferences )
+{
+  // A smooth field, so that central differences are close to the derivatives.
+  Variogram * v = Variogram::Create(Variogram::GAUSSIAN, 2.0, 300.0, 200.0, 100.0);
+  size_t nx = 40, ny = 30, nz = 12;
+  double dx = 10.0, dy = 8.0, dz = 5.0;
+  GaussianFieldSimulator sim(*v, nx, dx, ny, dy, nz, dz);
+  std::vector<double> expected, field, derivatives;
+  Random::Initialize(321L);
+  sim.Simulate(expected);
+  Random::Initialize(321L);
+  sim.SimulateWithDerivatives(field, derivatives, true);
+  BOOST_REQUIRE(field.size() == expected.size());
+  for (size_t i = 0; i < field.size(); i++)
+    BOOST_CHECK_CLOSE(field[i], expected[i], 1e-9);
+
+  size_t n = field.size();
+  BOOST_REQUIRE(derivatives.size() == 4 * n);
+  size_t stride[3] = { 1, nx, nx * ny };
+  double d[3]      = { dx, dy, dz };
+  double error[4]  = { 0.0, 0.0, 0.0, 0.0 };
+  double norm[4]   = { 0.0, 0.0, 0.0, 0.0 };
+  for (size_t k = 2; k < nz - 2; k++) {
+    for (size_t j = 2; j < ny - 2; j++) {
+      for (size_t i = 2; i < nx - 2; i++) {
+        size_t index = i + nx * (j + ny * k);
+        double laplacian = 0.0;
+        for (size_t c = 0; c < 3; c++) {
+          double difference = (field[index + stride[c]] - field[index - stride[c]]) / (2.0 * d[c]);
+          error[c] += std::pow(derivatives[c * n + index] - difference, 2);
+          norm[c]  += std::pow(difference, 2);
+          laplacian += (field[index + stride[c]] - 2.0 * field[index] + field[index - stride[c]]) / (d[c] * d[c]);
+        }
+        error[3] += std::pow(derivatives[3 * n + index] - laplacian, 2);
+        norm[3]  += std::pow(laplacian, 2);
+      }
+    }
+  }
+  for (size_t c = 0; c < 4; c++)
+    BOOST_CHECK_LT(std::sqrt(error[c] / norm[c]), 0.05);
+
+  // Without the Laplacian, only the derivatives of the 2D field.
+  GaussianFieldSimulator sim2d(*v, nx, dx, ny, dy);
+  sim2d.SimulateWithDerivatives(field, derivatives, false);
+  BOOST_TEST(derivatives.size() == 2 * field.size());
+  delete v;
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,239 @@
+/// Unit tests for variogram types
+
+#include <nrlib/exception/exception.hpp>
+#include <nrlib/grid/grid.hpp>
+#include <nrlib/random/random.hpp>
+#include <nrlib/random/randomgenerator.hpp>
+#include <nrlib/variogram/fftcovgrid.hpp>
+#include <nrlib/variogram/gaussianfield.hpp>
+#include <nrlib/variogram/variogram.hpp>
+#include <nrlib/variogram/variogramtypes.hpp>
+
+#include <boost/test/unit_test.hpp>
+
+using namespace NRLib;
+
+BOOST_AUTO_TEST_SUITE( TestVariogramTypes )
+
+BOOST_AUTO_TEST_CASE( NestedCovarianceIsSum )
+{
+  Variogram * sph = Variogram::Create(Variogram::SPHERICAL, 1.5, 200.0, 100.0, 10.0, 0.5);
+  Variogram * gau = Variogram::Create(Variogram::GAUSSIAN, 1.5, 1000.0, 800.0, 40.0);
+  std::vector<double> weights;
+  weights.push_back(0.6);
+  weights.push_back(0.3);
+  std::vector<const Variogram *> structures;
+  structures.push_back(sph);
+  structures.push_back(gau);
+  NestedVario nested(weights, structures, 0.1);
+
+  BOOST_CHECK_CLOSE(nested.GetCov(0.0, 0.0, 0.0), 1.0, 1e-12);
+  BOOST_CHECK_CLOSE(nested.GetStdDev(), 1.0, 1e-12);
+  BOOST_CHECK_CLOSE(nested.GetCov(50.0, 20.0, 2.0),
+                    0.6 * sph->GetCov(50.0, 20.0, 2.0) + 0.3 * gau->GetCov(50.0, 20.0, 2.0), 1e-10);
+  BOOST_CHECK_CLOSE(nested.GetCov(30.0, 10.0),
+                    0.6 * sph->GetCov(30.0, 10.0) + 0.3 * gau->GetCov(30.0, 10.0), 1e-10);
+  BOOST_CHECK_CLOSE(nested.GetCov(300.0),
+                    0.3 * gau->GetCov(300.0), 1e-10);
+  BOOST_TEST(nested.GetRangeX() == 1000.0);
+  BOOST_TEST(nested.GetRangeZ() == 40.0);
+
+  // The structures are copied
+  Variogram * clone = nested.Clone();
+  delete sph;
+  delete gau;
+  BOOST_CHECK_CLOSE(clone->GetCov(50.0, 20.0, 2.0), nested.GetCov(50.0, 20.0, 2.0), 1e-12);
+  delete clone;
+}
+
+BOOST_AUTO_TEST_CASE( NestedPaddingFromLongestStructure )
+{
+  Variogram * sph = Variogram::Create(Variogram::SPHERICAL, 1.5, 100.0, 800.0, 10.0);
+  Variogram * exp = Variogram::Create(Variogram::EXPONENTIAL, 1.5, 600.0, 50.0, 5.0);
+  std::vector<double> weights(2, 0.5);
+  std::vector<const Variogram *> structures;
+  structures.push_back(sph);
+  structures.push_back(exp);
+  NestedVario nested(weights, structures);
+
+  std::vector<size_t> pad     = FindNDimPadding(nested, 100, 10.0, 80, 10.0, 20, 1.0);
+  std::vector<size_t> pad_sph = FindNDimPadding(*sph, 100, 10.0, 80, 10.0, 20, 1.0);
+  std::vector<size_t> pad_exp = FindNDimPadding(*exp, 100, 10.0, 80, 10.0, 20, 1.0);
+  BOOST_TEST(pad.size() == 3U);
+  for (size_t d = 0; d < 3; d++)
+    BOOST_TEST(pad[d] == std::max(pad_sph[d], pad_exp[d]));
+  BOOST_TEST(FindNDimPadding(nested, 100, 10.0).size() == 1U);
+
+  // The covariance grid is the weighted sum of the structures' grids
+  FFTCovGrid2D cov(nested, 64, 10.0, 32, 10.0);
+  FFTCovGrid2D cov_sph(*sph, 64, 10.0, 32, 10.0);
+  FFTCovGrid2D cov_exp(*exp, 64, 10.0, 32, 10.0);
+  for (size_t i = 0; i < cov.GetCov().GetN(); i += 7)
+    BOOST_CHECK_CLOSE(cov.GetCov()(i), 0.5 * cov_sph.GetCov()(i) + 0.5 * cov_exp.GetCov()(i), 1e-10);
+
+  std::vector<Grid<double> > fields;
+  Random::Initialize(31L);
+  Simulate3DGaussianField(nested, 20, 10.0, 15, 10.0, 5, 1.0, 1, fields);
+  BOOST_TEST(fields.size() == 1U);
+  delete sph;
+  delete exp;
+}
+
+BOOST_AUTO_TEST_CASE( NestedInvalidInput )
+{
+  Variogram * sph = Variogram::Create(Variogram::SPHERICAL, 1.5, 100.0);
+  std::vector<const Variogram *> structures(1, sph);
+  BOOST_CHECK_THROW(NestedVario(std::vector<double>(2, 1.0), structures), Exception);
+  BOOST_CHECK_THROW(NestedVario(std::vector<double>(1, -1.0), structures), Exception);
+  BOOST_CHECK_THROW(NestedVario(std::vector<double>(1, 1.0), structures, -0.5), Exception);
+  BOOST_CHECK_THROW(NestedVario(std::vector<double>(), std::vector<const Variogram *>()), Exception);
+
+  // Pure nugget
+  NestedVario nugget(std::vector<double>(), std::vector<const Variogram *>(), 2.0);
+  BOOST_CHECK_CLOSE(nugget.GetCov(0.0), 2.0, 1e-12);
+  BOOST_TEST(nugget.GetCov(1.0) == 0.0);
+  delete sph;
+}
+
+BOOST_AUTO_TEST_CASE( CorrArrayMatchesScalar )
+{
+  std::vector<Variogram *> variograms;
+  for (int type = Variogram::CONSTANT; type < Variogram::N_TYPES; type++)
+    variograms.push_back(Variogram::Create(static_cast<Variogram::Type>(type), 1.2, 100.0, 60.0, 20.0, 0.3, 0.1, 2.0));
+  std::vector<double> weights(2, 0.45);
+  std::vector<const Variogram *> structures(variograms.begin() + 1, variograms.begin() + 3);
+  variograms.push_back(new NestedVario(weights, structures, 0.1));
+
+  // Enough lags for several blocks and threads. Include zero lags.
+  size_t n = 40000;
+  std::vector<double> dx(n), dy(n), dz(n), corr(n);
+  Random::Initialize(3L);
+  for (size_t i = 0; i < n; i++) {
+    dx[i] = (i % 100 == 0) ? 0.0 : 200.0 * (Random::Unif01() - 0.5);
+    dy[i] = (i % 100 == 0) ? 0.0 : 200.0 * (Random::Unif01() - 0.5);
+    dz[i] = (i % 100 == 0) ? 0.0 : 50.0 * (Random::Unif01() - 0.5);
+  }
+
+  for (size_t v = 0; v < variograms.size(); v++) {
+    const Variogram & vario = *variograms[v];
+    vario.GetCorrArray(&dx[0], NULL, NULL, n, &corr[0]);
+    for (size_t i = 0; i < n; i += 37)
+      BOOST_CHECK_CLOSE(corr[i], vario.GetCorr(dx[i]), 1e-10);
+    vario.GetCorrArray(&dx[0], &dy[0], NULL, n, &corr[0]);
+    for (size_t i = 0; i < n; i += 37)
+      BOOST_CHECK_CLOSE(corr[i], vario.GetCorr(dx[i], dy[i]), 1e-10);
+    vario.GetCorrArray(&dx[0], &dy[0], &dz[0], n, &corr[0]);
+    for (size_t i = 0; i < n; i += 37)
+      BOOST_CHECK_CLOSE(corr[i], vario.GetCorr(dx[i], dy[i], dz[i]), 1e-10);
+  }
+  for (size_t v = 0; v < variograms.size(); v++)
+    delete variograms[v];
+}
+
+BOOST_AUTO_TEST_CASE( CloneInFrameKeepsCovariance )
+{
+  const double angle = 0.6;
+  std::vector<Variogram *> variograms;
+  variograms.push_back(Variogram::Create(Variogram::SPHERICAL, 1.5, 100.0, 40.0, 10.0, 0.2, 0.1));
+  variograms.push_back(Variogram::Create(Variogram::GAUSSIAN, 1.5, 80.0, 30.0, 5.0, 1.3));
+  std::vector<double> weights(2, 0.45);
+  std::vector<const Variogram *> structures(variograms.begin(), variograms.end());
+  variograms.push_back(new NestedVario(weights, structures, 0.1));
+
+  for (size_t v = 0; v < variograms.size(); v++) {
+    Variogram * local = variograms[v]->CloneInFrame(angle);
+    for (int n = 0; n < 20; n++) {
+      // Lag (a, b, c) in the local frame
+      double a = 7.0 * n - 60.0;
+      double b = 40.0 - 3.0 * n;
+      double c = 0.5 * n - 4.0;
+      double x = std::cos(angle) * a - std::sin(angle) * b;
+      double y = std::sin(angle) * a + std::cos(angle) * b;
+      BOOST_CHECK_SMALL(local->GetCorr(a, b, c) - variograms[v]->GetCorr(x, y, c), 1e-12);
+    }
+    delete local;
+  }
+
+  // Variograms along the axes of the frame get zero azimuth.
+  Variogram * along = Variogram::Create(Variogram::SPHERICAL, 1.5, 100.0, 40.0, 10.0, angle);
+  Variogram * local = along->CloneInFrame(angle);
+  BOOST_TEST(local->GetAzimuthAngle() == 0.0);
+  BOOST_TEST(local->GetRangeX() == 100.0);
+  delete local;
+  along->SetAngles(angle + 0.5 * 3.14159265358979323846);
+  local = along->CloneInFrame(angle);
+  BOOST_TEST(local->GetAzimuthAngle() == 0.0);
+  BOOST_TEST(local->GetRangeX() == 40.0);
+  BOOST_TEST(local->GetRangeY() == 100.0);
+  delete local;
+  delete along;
+
+  for (size_t v = 0; v < variograms.size(); v++)
+    delete variograms[v];
+}
+
+BOOST_AUTO_TEST_CASE( SpectralFrequencyMatchesCorrelation )
+{
+  // The correlation is the characteristic function of the frequencies,
+  // E[cos(w h)], which is estimated by the mean over many draws.
+  std::vector<Variogram *> variograms;
+  for (int type = Variogram::CONSTANT; type < Variogram::N_TYPES; type++)
+    variograms.push_back(Variogram::Create(static_cast<Variogram::Type>(type), 1.2, 100.0, 60.0, 20.0, 0.3, 0.1, 2.0));
+  std::vector<double> weights(2, 0.45);
+  std::vector<const Variogram *> structures(variograms.begin() + 1, variograms.begin() + 3);
+  variograms.push_back(new NestedVario(weights, structures, 0.0));
+
+  const double lags[4][3] = {{0.0, 0.0, 0.0}, {30.0, 0.0, 0.0}, {20.0, -25.0, 4.0}, {-10.0, 15.0, 12.0}};
+  size_t n_draws = 200000;
+  RandomGenerator rg(17L);
+  for (size_t v = 0; v < variograms.size(); v++) {
+    const Variogram & vario = *variograms[v];
+    std::vector<double> sum(4, 0.0);
+    for (size_t draw = 0; draw < n_draws; draw++) {
+      double w[3];
+      vario.DrawSpectralFrequency(rg, w);
+      for (size_t l = 0; l < 4; l++)
+        sum[l] += std::cos(w[0] * lags[l][0] + w[1] * lags[l][1] + w[2] * lags[l][2]);
+    }
+    for (size_t l = 0; l < 4; l++) {
+      double corr = vario.GetCorr(lags[l][0], lags[l][1], lags[l][2]);
+      BOOST_CHECK_MESSAGE(std::abs(sum[l] / n_draws - corr) < 0.01,
+                          vario.GetName() << " lag " << l << ": " << sum[l] / n_draws << " vs " << corr);
+    }
+  }
+  for (size_t v = 0; v < variograms.size(); v++)
+    delete variograms[v];
+}
+
+BOOST_AUTO_TEST_CASE( CovMatrix )
+{
+  Variogram * v = Variogram::Create(Variogram::EXPONENTIAL, 1.5, 50.0, 30.0, 10.0, 0.4, 0.0, 1.5);
+  size_t n_a = 7;
+  size_t n_b = 1500;
+  std::vector<double> a(3 * n_a), b(3 * n_b);
+  Random::Initialize(4L);
+  for (size_t i = 0; i < a.size(); i++)
+    a[i] = 100.0 * Random::Unif01();
+  for (size_t i = 0; i < b.size(); i++)
+    b[i] = 100.0 * Random::Unif01();
+
+  std::vector<double> cov(n_a * n_b);
+  v->GetCovMatrix(&a[0], n_a, &b[0], n_b, 3, &cov[0]);
+  for (size_t i = 0; i < n_a; i++)
+    for (size_t j = 0; j < n_b; j += 11)
+      BOOST_CHECK_CLOSE(cov[i * n_b + j],
+                        v->GetCovpoint(a[3 * i], a[3 * i + 1], a[3 * i + 2], b[3 * j], b[3 * j + 1], b[3 * j + 2]),
+                        1e-10);
+
+  // 2D points, matrix of a point set with itself.
+  std::vector<double> cov_aa(n_a * n_a);
+  v->GetCovMatrix(&a[0], n_a, &a[0], n_a, 2, &cov_aa[0]);
+  BOOST_CHECK_CLOSE(cov_aa[0], 2.25, 1e-12);
+  BOOST_CHECK_CLOSE(cov_aa[1], v->GetCovpoint(a[0], a[1], a[2], a[3]), 1e-10);
+  BOOST_CHECK_CLOSE(cov_aa[n_a], cov_aa[1], 1e-12);
+
+  BOOST_CHECK_THROW(v->GetCovMatrix(&a[0], n_a, &b[0], n_b, 4, &cov[0]), Exception);
+  delete v;
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -19,10 +19,16 @@
 // OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS SOFTWARE,
 // EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
+#include <algorithm>
+#include <cmath>
 #include <string>
+#include <thread>
+#include <vector>
 #include <stdio.h>
 #include <assert.h>
 #include "../exception/exception.hpp"
+#include "../math/constants.hpp"
+#include "../random/randomgenerator.hpp"
 #include "variogram.hpp"
 #include "variogramtypes.hpp"
 
@@ -39,7 +45,10 @@ Variogram::Variogram(double range_x,
     range_y_(range_y),
     range_z_(range_z),
     azimuth_angle_(azimuth_angle),
-    dip_angle_(dip_angle)
+    dip_angle_(dip_angle),
+    block_x_(0.0),
+    block_y_(0.0),
+    block_z_(0.0)
 {
   var_ = std_dev * std_dev;
   EstimateFactors();
@@ -52,12 +61,24 @@ Variogram::Variogram()
     range_z_(1.0),
     azimuth_angle_(0.0),
     dip_angle_(0.0),
-    var_(1.0)
+    var_(1.0),
+    block_x_(0.0),
+    block_y_(0.0),
+    block_z_(0.0)
 {
   EstimateFactors();
 }
 
 
+std::string Variogram::GetDescription() const
+{
+  char buffer[256];
+  snprintf(buffer, sizeof(buffer), "%s(%.17g,%.17g,%.17g,%.17g,%.17g,%.17g)", GetName().c_str(),
+           range_x_, range_y_, range_z_, azimuth_angle_, dip_angle_, var_);
+  return std::string(buffer);
+}
+
+
 Variogram* Variogram::Create(Type type, double power, double range_x,
                              double range_y, double range_z, double azimuth_angle,
                              double dip_angle, double std_dev)
@@ -130,6 +151,14 @@ void Variogram::SetStdDev(double std_dev) {
   var_ = std_dev*std_dev;
 }
 
+void Variogram::SetBlockSupport(double bx, double by, double bz) {
+  if (bx < 0.0 || by < 0.0 || bz < 0.0)
+    throw Exception("The block sizes can not be negative.");
+  block_x_ = bx;
+  block_y_ = by;
+  block_z_ = bz;
+}
+
 //
 // FUNCTION: Vario::SetRange, Vario::SetSubRange, Vario::SetSubSubRange
 //
@@ -220,6 +249,144 @@ double Variogram::GetCorr(double dx) const
   return corr;
 }
 
+namespace {
+  // Number of lags in each block of GetCorrArray.
+  const size_t corr_block_size = 1024;
+
+  // Calls f(begin, end) for consecutive ranges of [0, n) in parallel, with at
+  // least min_size items in each range.
+  template <typename F>
+  void ParallelRanges(size_t n, size_t min_size, F f)
+  {
+    size_t n_threads = std::min<size_t>(std::max(1U, std::thread::hardware_concurrency()),
+                                        (n + min_size - 1) / min_size);
+    if (n_threads <= 1) {
+      f(0, n);
+      return;
+    }
+    size_t size = (n + n_threads - 1) / n_threads;
+    std::vector<std::thread> threads;
+    for (size_t begin = 0; begin < n; begin += size)
+      threads.push_back(std::thread(f, begin, std::min(n, begin + size)));
+    for (size_t t = 0; t < threads.size(); t++)
+      threads[t].join();
+  }
+}
+
+void Variogram::Corr1DArray(const double * dist, size_t n, double * corr) const
+{
+  for (size_t i = 0; i < n; i++)
+    corr[i] = Corr1D(dist[i]);
+}
+
+void Variogram::GetCorrBlock(const double * dx, const double * dy, const double * dz, size_t n, double * corr) const
+{
+  // The distances are stored in corr, and transformed in place.
+  if (dy == NULL) {
+    for (size_t i = 0; i < n; i++)
+      corr[i] = Distance(dx[i]);
+  }
+  else if (dz == NULL) {
+    for (size_t i = 0; i < n; i++)
+      corr[i] = Distance(dx[i], dy[i]);
+  }
+  else {
+    for (size_t i = 0; i < n; i++)
+      corr[i] = Distance(dx[i], dy[i], dz[i]);
+  }
+  Corr1DArray(corr, n, corr);
+}
+
+void Variogram::GetCorrArray(const double * dx, const double * dy, const double * dz, size_t n, double * corr) const
+{
+  ParallelRanges(n, 16 * corr_block_size, [&](size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i += corr_block_size) {
+      size_t m = std::min(corr_block_size, end - i);
+      GetCorrBlock(dx + i,
+                   (dy == NULL) ? NULL : dy + i,
+                   (dz == NULL) ? NULL : dz + i,
+                   m,
+                   corr + i);
+    }
+  });
+}
+
+void Variogram::GetCovMatrix(const double * points_a, size_t n_a,
+                             const double * points_b, size_t n_b,
+                             size_t dim, double * cov) const
+{
+  if (dim < 1 || dim > 3)
+    throw Exception("The points must have 1, 2 or 3 coordinates.");
+
+  // Enough rows in each thread to make starting it worthwhile.
+  size_t min_rows = std::max<size_t>(1, 16 * corr_block_size / std::max<size_t>(1, n_b));
+  ParallelRanges(n_a, min_rows, [&](size_t begin, size_t end) {
+    std::vector<double> lags(dim * corr_block_size);
+    for (size_t i = begin; i < end; i++) {
+      const double * a = points_a + i * dim;
+      double       * row = cov + i * n_b;
+      for (size_t j0 = 0; j0 < n_b; j0 += corr_block_size) {
+        size_t m = std::min(corr_block_size, n_b - j0);
+        for (size_t d = 0; d < dim; d++) {
+          double * lag = &lags[d * corr_block_size];
+          for (size_t j = 0; j < m; j++)
+            lag[j] = points_b[(j0 + j) * dim + d] - a[d];
+        }
+        GetCorrBlock(&lags[0],
+                     (dim > 1) ? &lags[corr_block_size] : NULL,
+                     (dim > 2) ? &lags[2 * corr_block_size] : NULL,
+                     m,
+                     row + j0);
+        for (size_t j = 0; j < m; j++)
+          row[j0 + j] *= var_;
+      }
+    }
+  });
+}
+
+Variogram * Variogram::CloneInFrame(double angle) const
+{
+  // Without dip, the covariance is the same for azimuths pi apart.
+  double period  = (dip_angle_ == 0.0) ? NRLib::Pi : 2.0 * NRLib::Pi;
+  double azimuth = azimuth_angle_ - angle;
+  azimuth -= period * std::floor(azimuth / period + 0.5);
+
+  const double tolerance = 1e-9;
+  Variogram * variogram = Clone();
+  if (std::abs(azimuth) < tolerance) {
+    azimuth = 0.0;
+  }
+  else if (dip_angle_ == 0.0 && std::abs(std::abs(azimuth) - 0.5 * NRLib::Pi) < tolerance) {
+    variogram->SetRanges(range_y_, range_x_, range_z_);
+    azimuth = 0.0;
+  }
+  variogram->SetAngles(azimuth, dip_angle_);
+  return variogram;
+}
+
+void Variogram::DrawSpectralFrequency(RandomGenerator & rg, double * w) const
+{
+  double u[3];
+  DrawUnitFrequency(rg, u);
+
+  // The normalized distance is |U h|, where U is the upper triangular
+  // Cholesky factor of the anisotropy form, so the frequency is U^T u.
+  double u11 = std::sqrt(txx_);
+  double u12 = 0.5 * txy_ / u11;
+  double u13 = 0.5 * txz_ / u11;
+  double u22 = std::sqrt(std::max(tyy_ - u12 * u12, 0.0));
+  double u23 = (u22 > 0.0) ? (0.5 * tyz_ - u12 * u13) / u22 : 0.0;
+  double u33 = std::sqrt(std::max(tzz_ - u13 * u13 - u23 * u23, 0.0));
+  w[0] = u11 * u[0];
+  w[1] = u12 * u[0] + u22 * u[1];
+  w[2] = u13 * u[0] + u23 * u[1] + u33 * u[2];
+}
+
+void Variogram::DrawUnitFrequency(RandomGenerator & /*rg*/, double * /*u*/) const
+{
+  throw Exception("The spectral density of " + GetName() + " variograms is not available.");
+}
+
 //- Variograms:
 double Variogram::GetVariogram(double dx, double dy, double dz) const
 {
@@ -26,6 +26,8 @@
 #include <cmath>
 
 namespace NRLib {
+class RandomGenerator;
+
 class Variogram
 {
 public:
@@ -50,7 +52,16 @@ public:
                              double range_y = 1.0, double range_z = 1.0, double azimuth_angle = 0.0,
                              double dip_angle = 0.0, double std_dev = 1.0);
   virtual Variogram*  Clone()    const = 0;
+  /// Copy expressed in a frame rotated by angle (radians, counterclockwise)
+  /// relative to this one, such as the local frame of a rotated Volume or
+  /// RegularSurfaceRotated. An azimuth along an axis of the frame is set to
+  /// exactly zero, swapping the x and y ranges if needed, so that the padding
+  /// uses the range along each axis.
+  virtual Variogram*  CloneInFrame(double angle) const;
   virtual std::string GetName()  const = 0;
+  /// All parameters of the variogram as a string, so that two variograms
+  /// with the same description have the same covariance function.
+  virtual std::string GetDescription() const;
 
   double              GetRangeX() const {return range_x_;}
   double              GetRangeY() const {return range_y_;}
@@ -73,12 +84,35 @@ public:
 
   void SetStdDev(double std_dev);
   void SetRanges(double range_x, double range_y, double range_z);
+  /// Block support for simulation on a coarse grid: the simulated values
+  /// are averages over blocks of size bx*by*bz along the grid axes, rather
+  /// than point values. Zero sizes, the default, give point support. Only
+  /// FFTCovGrid uses this, by multiplying the spectrum of its covariance
+  /// grid by the transfer function of the block average. GetCorr and GetCov
+  /// are always the point covariance.
+  void SetBlockSupport(double bx, double by = 0.0, double bz = 0.0);
+  double GetBlockX() const { return block_x_; }
+  double GetBlockY() const { return block_y_; }
+  double GetBlockZ() const { return block_z_; }
+  bool   HasBlockSupport() const { return block_x_ > 0.0 || block_y_ > 0.0 || block_z_ > 0.0; }
   /// Correlation function with distance as input for 3D.
   virtual double GetCorr(double dx, double dy, double dz) const;
   /// Correlation function with distance as input for 2D.
   virtual double GetCorr(double dx, double dy) const;
   /// Correlation function with distance as input for 1D.
   virtual double GetCorr(double dx) const;
+  /// Correlation function for n lags (dx[i], dy[i], dz[i]). dz, or dy and
+  /// dz, may be NULL for 2D and 1D lags. The lags are evaluated in blocks,
+  /// in parallel when there are many of them. corr may not overlap the lags.
+  void GetCorrArray(const double * dx, const double * dy, const double * dz, size_t n, double * corr) const;
+  /// Serial version of GetCorrArray, used for each block.
+  virtual void GetCorrBlock(const double * dx, const double * dy, const double * dz, size_t n, double * corr) const;
+  /// Covariance matrix between n_a and n_b points with dim = 1, 2 or 3
+  /// coordinates each, stored point after point. cov gets n_a*n_b values,
+  /// with the points of b running fastest. Rows are evaluated in parallel.
+  void GetCovMatrix(const double * points_a, size_t n_a,
+                    const double * points_b, size_t n_b,
+                    size_t dim, double * cov) const;
   /// Correlation functions with points as input for 3D.
   double GetCorrpoint(double x1, double y1, double z1, double x2, double y2, double z2) const {return GetCorr(x2-x1, y2-y1, z2-z1);}
   /// Correlation functions with points as input for 2D.
@@ -104,6 +138,11 @@ public:
   double GetCovpoint(double x1, double y1, double x2, double y2) const { return var_*GetCorr(x2-x1, y2-y1);}
   /// Covariance function with points as input in 1D.
   double GetCovpoint(double x1, double x2) const { return var_*GetCorr(x2-x1);}
+  /// Draws a frequency w (three values) from the spectral measure of the
+  /// correlation function in 3D, so that GetCorr(dx, dy, dz) is the expected
+  /// value of cos(w[0]*dx + w[1]*dy + w[2]*dz). Used for simulation at
+  /// scattered points.
+  virtual void DrawSpectralFrequency(RandomGenerator & rg, double * w) const;
   /// Defines the minimum range-to-grid size ratio for valid simulation
   /// given the specific variogram. Should be a constant per variogram
   /// type.
@@ -111,6 +150,13 @@ public:
 protected:
   /// Defines 1D correlation function. Different for every variogram.
   virtual double Corr1D(double dist) const = 0 ;
+  /// Corr1D for n distances, used by GetCorrBlock. The variogram types
+  /// override this with a loop over their own correlation function, to avoid
+  /// a virtual call per distance. dist and corr may be the same array.
+  virtual void Corr1DArray(const double * dist, size_t n, double * corr) const;
+  /// As DrawSpectralFrequency, for Corr1D of the normalized distance in 3D.
+  /// Throws for variograms without a known spectral measure.
+  virtual void DrawUnitFrequency(RandomGenerator & rg, double * u) const;
 
 private:
   void EstimateFactors();
@@ -132,6 +178,10 @@ private:
   double dip_angle_;
   /// Variance
   double var_;
+  /// Block support, see SetBlockSupport
+  double block_x_;
+  double block_y_;
+  double block_z_;
 
   // Variables precalculated for anisotropy:
   double      txx_;
@@ -20,9 +20,34 @@
 // EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 
 #include "variogramtypes.hpp"
+#include "../exception/exception.hpp"
+#include "../random/randomgenerator.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <stdio.h>
 
 namespace NRLib {
 
+namespace {
+  const double pi = 3.14159265358979323846;
+
+  // Multivariate t-distribution with dof degrees of freedom and scale kappa,
+  // which is the spectral measure of the Matern correlation with smoothness
+  // dof/2, (kappa r)^nu K_nu(kappa r) up to a constant. dof = 1 gives exp(-kappa r).
+  void DrawStudentFrequency(RandomGenerator & rg, double kappa, int dof, double * u)
+  {
+    double chi2 = 0.0;
+    for (int i = 0; i < dof; i++) {
+      double g = rg.Norm01();
+      chi2 += g * g;
+    }
+    double scale = kappa / std::sqrt(chi2);
+    for (int d = 0; d < 3; d++)
+      u[d] = scale * rg.Norm01();
+  }
+}
+
 ConstVario::ConstVario(const double range_x,
            const double range_y,
            const double range_z,
@@ -87,6 +112,13 @@ GenExpVario::GenExpVario() : Variogram()
   power_ = 1.0;
 }
 
+std::string GenExpVario::GetDescription() const
+{
+  char buffer[32];
+  snprintf(buffer, sizeof(buffer), ",%.17g", power_);
+  return Variogram::GetDescription() + buffer;
+}
+
 Matern32Vario::Matern32Vario(const double range_x,
        const double range_y,
        const double range_z,
@@ -123,4 +155,239 @@ Matern72Vario::Matern72Vario(const double range_x,
 Matern72Vario::Matern72Vario() : Variogram()
 {}
 
+namespace {
+  double LongestRange(const std::vector<const Variogram *> & structures, int direction)
+  {
+    double range = 0.0;
+    for (size_t i = 0; i < structures.size(); i++) {
+      if (direction == 0)
+        range = std::max(range, structures[i]->GetRangeX());
+      else if (direction == 1)
+        range = std::max(range, structures[i]->GetRangeY());
+      else
+        range = std::max(range, structures[i]->GetRangeZ());
+    }
+    // A pure nugget model has no range.
+    return (range > 0.0) ? range : 1.0;
+  }
+
+  double TotalSill(const std::vector<double> & weights, double nugget)
+  {
+    double sill = nugget;
+    for (size_t i = 0; i < weights.size(); i++)
+      sill += weights[i];
+    return sill;
+  }
+}
+
+NestedVario::NestedVario(const std::vector<double>            & weights,
+                         const std::vector<const Variogram *> & structures,
+                         const double                           nugget)
+  : Variogram(LongestRange(structures, 0),
+              LongestRange(structures, 1),
+              LongestRange(structures, 2),
+              0.0,
+              0.0,
+              std::sqrt(std::max(TotalSill(weights, nugget), 0.0))),
+    weights_(weights),
+    nugget_(nugget),
+    sill_(TotalSill(weights, nugget))
+{
+  if (weights.size() != structures.size())
+    throw Exception("A nested variogram needs one weight for each structure.");
+  if (nugget < 0.0)
+    throw Exception("The nugget of a nested variogram can not be negative.");
+  for (size_t i = 0; i < weights.size(); i++) {
+    if (weights[i] < 0.0)
+      throw Exception("The weights of a nested variogram can not be negative.");
+  }
+  if (sill_ <= 0.0)
+    throw Exception("The total sill of a nested variogram must be positive.");
+
+  for (size_t i = 0; i < structures.size(); i++)
+    structures_.push_back(structures[i]->Clone());
+}
+
+NestedVario::NestedVario(const NestedVario &vario)
+  : Variogram(vario),
+    weights_(vario.weights_),
+    nugget_(vario.nugget_),
+    sill_(vario.sill_)
+{
+  for (size_t i = 0; i < vario.structures_.size(); i++)
+    structures_.push_back(vario.structures_[i]->Clone());
+}
+
+Variogram * NestedVario::CloneInFrame(double angle) const
+{
+  std::vector<const Variogram *> structures;
+  for (size_t i = 0; i < structures_.size(); i++)
+    structures.push_back(structures_[i]->CloneInFrame(angle));
+  NestedVario * nested = new NestedVario(weights_, structures, nugget_);
+  for (size_t i = 0; i < structures.size(); i++)
+    delete structures[i];
+  return nested;
+}
+
+std::string NestedVario::GetDescription() const
+{
+  char buffer[64];
+  snprintf(buffer, sizeof(buffer), "nested(%.17g", nugget_);
+  std::string description(buffer);
+  for (size_t i = 0; i < structures_.size(); i++) {
+    snprintf(buffer, sizeof(buffer), ",%.17g*", weights_[i]);
+    description += buffer + structures_[i]->GetDescription();
+  }
+  return description + ")";
+}
+
+NestedVario::~NestedVario()
+{
+  for (size_t i = 0; i < structures_.size(); i++)
+    delete structures_[i];
+}
+
+double NestedVario::GetCorr(double dx, double dy, double dz) const
+{
+  double cov = (dx == 0.0 && dy == 0.0 && dz == 0.0) ? nugget_ : 0.0;
+  for (size_t i = 0; i < structures_.size(); i++)
+    cov += weights_[i] * structures_[i]->GetCorr(dx, dy, dz);
+  return cov / sill_;
+}
+
+double NestedVario::GetCorr(double dx, double dy) const
+{
+  double cov = (dx == 0.0 && dy == 0.0) ? nugget_ : 0.0;
+  for (size_t i = 0; i < structures_.size(); i++)
+    cov += weights_[i] * structures_[i]->GetCorr(dx, dy);
+  return cov / sill_;
+}
+
+double NestedVario::GetCorr(double dx) const
+{
+  double cov = (dx == 0.0) ? nugget_ : 0.0;
+  for (size_t i = 0; i < structures_.size(); i++)
+    cov += weights_[i] * structures_[i]->GetCorr(dx);
+  return cov / sill_;
+}
+
+void NestedVario::GetCorrBlock(const double * dx, const double * dy, const double * dz, size_t n, double * corr) const
+{
+  for (size_t i = 0; i < n; i++) {
+    bool zero = dx[i] == 0.0 && (dy == NULL || dy[i] == 0.0) && (dz == NULL || dz[i] == 0.0);
+    corr[i] = zero ? nugget_ : 0.0;
+  }
+  std::vector<double> structure_corr(n);
+  for (size_t s = 0; s < structures_.size(); s++) {
+    structures_[s]->GetCorrBlock(dx, dy, dz, n, &structure_corr[0]);
+    for (size_t i = 0; i < n; i++)
+      corr[i] += weights_[s] * structure_corr[i];
+  }
+  for (size_t i = 0; i < n; i++)
+    corr[i] /= sill_;
+}
+
+double NestedVario::GetMinimumRangeToGridRatio() const
+{
+  double ratio = 1.0;
+  for (size_t i = 0; i < structures_.size(); i++)
+    ratio = std::max(ratio, structures_[i]->GetMinimumRangeToGridRatio());
+  return ratio;
+}
+
+void ConstVario::DrawUnitFrequency(RandomGenerator & /*rg*/, double * u) const
+{
+  u[0] = u[1] = u[2] = 0.0;
+}
+
+void ExpVario::DrawUnitFrequency(RandomGenerator & rg, double * u) const
+{
+  DrawStudentFrequency(rg, 3.0, 1, u);
+}
+
+void SphVario::DrawUnitFrequency(RandomGenerator & rg, double * u) const
+{
+  // The spherical correlation is the overlap of two balls with diameter 1,
+  // so the spectral density is the square of the transform of the ball,
+  // (sin(t) - t cos(t))^2 / t^6 with t = |u|/2. The density of t, with the
+  // surface of the sphere, is drawn by rejection from 4 on [0, 1] and 4/t^2
+  // above 1, which are upper bounds.
+  double t;
+  for (;;) {
+    double v = rg.Unif01Open();
+    t = (rg.Unif01() < 0.5) ? v : 1.0 / v;
+    double bound = (t <= 1.0) ? 4.0 : 4.0 / (t * t);
+    double f     = (std::sin(t) - t * std::cos(t)) / (t * t);
+    if (rg.Unif01() * bound < f * f)
+      break;
+  }
+  double length = 0.0;
+  for (int d = 0; d < 3; d++) {
+    u[d] = rg.Norm01();
+    length += u[d] * u[d];
+  }
+  double scale = 2.0 * t / std::sqrt(length);
+  for (int d = 0; d < 3; d++)
+    u[d] *= scale;
+}
+
+void GauVario::DrawUnitFrequency(RandomGenerator & rg, double * u) const
+{
+  // exp(-3 r^2) is the characteristic function of N(0, 6)
+  for (int d = 0; d < 3; d++)
+    u[d] = std::sqrt(6.0) * rg.Norm01();
+}
+
+void GenExpVario::DrawUnitFrequency(RandomGenerator & rg, double * u) const
+{
+  // exp(-3 r^p) = E[exp(-S r^2)] where S is positive stable with index
+  // alpha = p/2, drawn with Kanter's representation. u is then N(0, 2S).
+  if (power_ <= 0.0 || power_ > 2.0)
+    throw Exception("The spectral density of the general exponential variogram requires a power in (0, 2].");
+  double alpha = 0.5 * power_;
+  double s     = 1.0;
+  if (alpha < 1.0) {
+    double v = pi * rg.Unif01Open();
+    double e = -std::log(rg.Unif01Open());
+    s = std::sin(alpha * v) / std::pow(std::sin(v), 1.0 / alpha)
+      * std::pow(std::sin((1.0 - alpha) * v) / e, (1.0 - alpha) / alpha);
+  }
+  s *= std::pow(3.0, 1.0 / alpha);
+  double scale = std::sqrt(2.0 * s);
+  for (int d = 0; d < 3; d++)
+    u[d] = scale * rg.Norm01();
+}
+
+void Matern32Vario::DrawUnitFrequency(RandomGenerator & rg, double * u) const
+{
+  DrawStudentFrequency(rg, 4.744, 3, u);
+}
+
+void Matern52Vario::DrawUnitFrequency(RandomGenerator & rg, double * u) const
+{
+  DrawStudentFrequency(rg, 5.918, 5, u);
+}
+
+void Matern72Vario::DrawUnitFrequency(RandomGenerator & rg, double * u) const
+{
+  DrawStudentFrequency(rg, 6.877, 7, u);
+}
+
+void NestedVario::DrawSpectralFrequency(RandomGenerator & rg, double * w) const
+{
+  double total = 0.0;
+  for (size_t i = 0; i < weights_.size(); i++)
+    total += weights_[i];
+  w[0] = w[1] = w[2] = 0.0;
+  if (total <= 0.0)
+    return;
+  double target = rg.Unif01() * total;
+  size_t i      = 0;
+  while (i + 1 < structures_.size() && target >= weights_[i]) {
+    target -= weights_[i];
+    i++;
+  }
+  structures_[i]->DrawSpectralFrequency(rg, w);
+}
+
 } // namespace NRLib
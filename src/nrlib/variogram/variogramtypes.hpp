@@ -22,8 +22,10 @@
 #ifndef NRLIB_VARIOGRAM_VARIOGRAMTYPES_HPP
 #define NRLIB_VARIOGRAM_VARIOGRAMTYPES_HPP
 
+#include <algorithm>
 #include <cmath>
 #include <string>
+#include <vector>
 #include "variogram.hpp"
 
 namespace NRLib {
@@ -56,6 +58,10 @@ public:
   virtual double GetMinimumRangeToGridRatio() const { return 1.0; }
 protected:
   double Corr1D(double) const {return 1.0;}
+  void Corr1DArray(const double *, size_t n, double * corr) const {
+    std::fill(corr, corr + n, 1.0);
+  }
+  virtual void DrawUnitFrequency(RandomGenerator & rg, double * u) const;
 };
 
 class ExpVario : public Variogram
@@ -86,6 +92,11 @@ public:
 protected:
   virtual double Corr1D(double dist) const {
                          return exp(-3.0*dist);}
+  virtual void Corr1DArray(const double * dist, size_t n, double * corr) const {
+    for (size_t i = 0; i < n; i++)
+      corr[i] = std::exp(-3.0*dist[i]);
+  }
+  virtual void DrawUnitFrequency(RandomGenerator & rg, double * u) const;
 };
 
 class SphVario : public Variogram
@@ -118,6 +129,14 @@ protected:
     if(dist<1.0) return(1.0-dist*(1.5-(0.5*dist*dist)));
     else return 0.0;
   }
+  virtual void Corr1DArray(const double * dist, size_t n, double * corr) const
+  {
+    for (size_t i = 0; i < n; i++) {
+      double d = dist[i];
+      corr[i] = (d < 1.0) ? 1.0 - d*(1.5 - 0.5*d*d) : 0.0;
+    }
+  }
+  virtual void DrawUnitFrequency(RandomGenerator & rg, double * u) const;
 };
 
 class GauVario : public Variogram
@@ -148,6 +167,12 @@ public:
 protected:
   virtual double Corr1D(double dist) const
   { return std::exp(-3.0*dist*dist); }
+  virtual void Corr1DArray(const double * dist, size_t n, double * corr) const
+  {
+    for (size_t i = 0; i < n; i++)
+      corr[i] = std::exp(-3.0*dist[i]*dist[i]);
+  }
+  virtual void DrawUnitFrequency(RandomGenerator & rg, double * u) const;
 };
 
 class GenExpVario : public Variogram
@@ -171,6 +196,7 @@ public:
   GenExpVario();
   GenExpVario(const GenExpVario &vario) : Variogram(vario) {power_ = vario.power_;}
   virtual std::string  GetName()      const {return "general exponential";}
+  virtual std::string  GetDescription() const;
   virtual Variogram *Clone() const {return new GenExpVario(*this);}
 
   /// If power == 1.5, the ratio is 3.23, and power == 2 is the same
@@ -178,9 +204,17 @@ public:
   /// if power is between these two. Also, 3.23 is raised to 4.0 in
   /// case linear interpolation is too optimistic.
   virtual double GetMinimumRangeToGridRatio() const { return 4.0 + (power_ - 1.5) * 5.34; }
+
+  double GetPower() const { return power_; }
 protected:
   virtual double Corr1D(double dist) const {
     return std::exp(-3.0 * std::pow(dist,power_));}
+  virtual void Corr1DArray(const double * dist, size_t n, double * corr) const {
+    const double power = power_;
+    for (size_t i = 0; i < n; i++)
+      corr[i] = std::exp(-3.0 * std::pow(dist[i], power));
+  }
+  virtual void DrawUnitFrequency(RandomGenerator & rg, double * u) const;
 
 private:
   double      power_;
@@ -213,6 +247,13 @@ protected:
     const double sd = 4.744 * dist; // distance to ensure 0.05 correlation at range
     return std::exp(-sd) * (1.0 + sd);
   }
+  virtual void Corr1DArray(const double * dist, size_t n, double * corr) const {
+    for (size_t i = 0; i < n; i++) {
+      const double sd = 4.744 * dist[i];
+      corr[i] = std::exp(-sd) * (1.0 + sd);
+    }
+  }
+  virtual void DrawUnitFrequency(RandomGenerator & rg, double * u) const;
 
 private:
 };
@@ -244,6 +285,13 @@ protected:
     const double sd = 5.918 * dist; // distance to ensure 0.05 correlation at range
     return std::exp(-sd) * (1.0 + sd + sd * sd / 3.0);
   }
+  virtual void Corr1DArray(const double * dist, size_t n, double * corr) const {
+    for (size_t i = 0; i < n; i++) {
+      const double sd = 5.918 * dist[i];
+      corr[i] = std::exp(-sd) * (1.0 + sd + sd * sd / 3.0);
+    }
+  }
+  virtual void DrawUnitFrequency(RandomGenerator & rg, double * u) const;
 
 private:
 };
@@ -275,10 +323,70 @@ protected:
     const double sd = 6.877 * dist; // distance to ensure 0.05 correlation at range
     return std::exp(-sd) * (1.0 + sd + 2.0/5.0 * std::pow(sd, 2) + std::pow(sd, 3) / 15.0);
   }
+  virtual void Corr1DArray(const double * dist, size_t n, double * corr) const {
+    for (size_t i = 0; i < n; i++) {
+      const double sd = 6.877 * dist[i];
+      corr[i] = std::exp(-sd) * (1.0 + sd + 2.0/5.0 * sd * sd + sd * sd * sd / 15.0);
+    }
+  }
+  virtual void DrawUnitFrequency(RandomGenerator & rg, double * u) const;
 
 private:
 };
 
+class NestedVario : public Variogram
+{
+public:
+  /// \param[in] weights    Sill of each structure.
+  /// \param[in] structures The structures. They are copied.
+  /// \param[in] nugget     Sill of the nugget effect.
+  /// The covariance is the sum of the covariances of the structures, scaled
+  /// by their weights, plus the nugget at zero distance. The variance is
+  /// the sum of the weights and the nugget. The ranges are the longest
+  /// ranges of the structures.
+  /// Can be used in 1D, 2D and 3D
+  NestedVario(const std::vector<double>          & weights,
+              const std::vector<const Variogram *> & structures,
+              const double                           nugget = 0.0);
+  NestedVario(const NestedVario &vario);
+  virtual ~NestedVario();
+
+  virtual Variogram *Clone() const { return new NestedVario(*this); }
+  /// Each structure is expressed in the frame.
+  virtual Variogram *CloneInFrame(double angle) const;
+  virtual std::string    GetName()      const { return "nested"; }
+  virtual std::string    GetDescription() const;
+
+  virtual double GetCorr(double dx, double dy, double dz) const;
+  virtual double GetCorr(double dx, double dy) const;
+  virtual double GetCorr(double dx) const;
+  virtual void   GetCorrBlock(const double * dx, const double * dy, const double * dz, size_t n, double * corr) const;
+  /// Frequency of a structure chosen with probability proportional to its
+  /// weight. The nugget effect has no spectral measure, and is left out.
+  virtual void   DrawSpectralFrequency(RandomGenerator & rg, double * w) const;
+
+  /// The largest ratio of the structures. Note that FindNDimPadding
+  /// uses the padding of each structure instead.
+  virtual double GetMinimumRangeToGridRatio() const;
+
+  size_t            GetNStructures()          const { return structures_.size(); }
+  const Variogram & GetStructure(size_t i)    const { return *structures_[i]; }
+  double            GetWeight(size_t i)       const { return weights_[i]; }
+  double            GetNugget()               const { return nugget_; }
+
+protected:
+  /// Not used, since GetCorr is overridden.
+  virtual double Corr1D(double dist) const { return (dist == 0.0) ? 1.0 : 0.0; }
+
+private:
+  std::vector<double>      weights_;
+  std::vector<Variogram *> structures_;
+  double                   nugget_;
+  /// Sum of weights and nugget
+  double                   sill_;
+
+  NestedVario & operator=(const NestedVario &);
+};
 
 }
 
@@ -0,0 +1,20 @@
+import numpy as np
+
+import gaussianfft as grf
+
+
+def test_cache_dir_gives_same_fields(tmp_path):
+    v = grf.variogram('spherical', 200.0, 100.0, 20.0, azimuth=30.0)
+    grf.seed(7)
+    expected = grf.simulate(v, 40, 10.0, 30, 10.0, 5, 5.0)
+    try:
+        grf.cache_dir(tmp_path / 'spectra')
+        assert grf.cache_dir() == str(tmp_path / 'spectra')
+        for _ in range(2):
+            grf.seed(7)
+            field = grf.simulate(v, 40, 10.0, 30, 10.0, 5, 5.0)
+            assert np.array_equal(field, expected)
+        assert len(list((tmp_path / 'spectra').glob('spectrum-*.bin'))) == 1
+    finally:
+        grf.cache_dir(None)
+    assert grf.cache_dir() is None
@@ -0,0 +1,52 @@
+import numpy as np
+import pytest
+
+import gaussianfft as grf
+
+
+def test_fft_backends_give_same_fields():
+    default = grf.fft_backend()
+    assert default in ('fftw', 'portable')
+    v = grf.variogram('gaussian', 150.0, 100.0, 30.0, azimuth=20.0)
+    grf.seed(11)
+    expected = grf.simulate(v, 45, 10.0, 35, 10.0, 7, 5.0)
+    try:
+        grf.fft_backend('portable')
+        assert grf.fft_backend() == 'portable'
+        grf.seed(11)
+        field = grf.simulate(v, 45, 10.0, 35, 10.0, 7, 5.0)
+    finally:
+        grf.fft_backend(default)
+    assert np.allclose(field, expected, atol=1e-10)
+
+
+def test_unknown_fft_backend():
+    default = grf.fft_backend()
+    with pytest.raises(RuntimeError):
+        grf.fft_backend('no such backend')
+    assert grf.fft_backend() == default
+
+
+def test_fft_threads():
+    assert grf.fft_threads() == 1
+    with pytest.raises(RuntimeError):
+        grf.fft_threads(0)
+    v = grf.variogram('spherical', 200.0, 100.0)
+    grf.seed(4)
+    expected = grf.simulate(v, 60, 10.0, 40, 10.0)
+    try:
+        grf.fft_threads(2)
+        assert grf.fft_threads() == 2
+        grf.seed(4)
+        field = grf.simulate(v, 60, 10.0, 40, 10.0)
+    finally:
+        grf.fft_threads(1)
+    assert np.allclose(field, expected, atol=1e-10)
+
+
+def test_fft_benchmark():
+    timings = grf.fft_benchmark((64, 48, 10), repeats=2)
+    assert 'portable' in timings
+    assert all(seconds >= 0.0 for seconds in timings.values())
+    with pytest.raises(RuntimeError):
+        grf.fft_benchmark((64, 0))
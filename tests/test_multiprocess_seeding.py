@@ -1,9 +1,11 @@
 from time import sleep
 
+import pickle
+
 import gaussianfft as grf
 import unittest
 import numpy as np
-from multiprocessing import Process, Queue, set_start_method
+from multiprocessing import Process, Queue, get_context, set_start_method
 
 
 def create_realization():
@@ -20,6 +22,11 @@ def run_simulation_process(q, dt):
     q.put((grf.seed(), s))
 
 
+def run_simulation_stream(stream):
+    grf.seed(stream)
+    return create_realization()
+
+
 class TestMultiprocessSeeding(unittest.TestCase):
     def test_mp(self):
         """ Two random fields are generated in two different processes using the multiprocessing module. The purpose
@@ -61,6 +68,28 @@ class TestMultiprocessSeeding(unittest.TestCase):
         self.assertTrue(np.all(np.allclose(seq_sim_1, sim_1)))
         self.assertTrue(np.all(np.allclose(seq_sim_2, sim_2)))
 
+    def test_streams(self):
+        """ Processes started at the same time with different streams give different, reproducible fields. """
+        streams = grf.seed_streams(123, 3)
+        self.assertEqual(len(streams), 3)
+        self.assertTrue(all(stream.seed == 123 for stream in streams))
+
+        with get_context('spawn').Pool(3) as pool:
+            sims = pool.map(run_simulation_stream, streams)
+
+        self.assertFalse(np.allclose(sims[0], sims[1]))
+        self.assertFalse(np.allclose(sims[1], sims[2]))
+
+        # The first stream is the same as seeding with the master seed
+        grf.seed(123)
+        self.assertTrue(np.allclose(create_realization(), sims[0]))
+
+        # Streams survive pickling, and are not advanced by being used
+        stream = pickle.loads(pickle.dumps(streams[2]))
+        self.assertTrue(np.allclose(run_simulation_stream(stream), sims[2]))
+        self.assertTrue(np.allclose(run_simulation_stream(streams[2]), sims[2]))
+        self.assertTrue(np.allclose(run_simulation_stream(grf.seed_streams(123, 3)[2]), sims[2]))
+
 
 if __name__ == '__main__':
     unittest.main()
@@ -0,0 +1,43 @@
+import numpy as np
+import pytest
+
+import gaussianfft as grf
+
+
+def test_nested_variogram_corr():
+    short = grf.variogram('spherical', 100.0, 50.0, 5.0)
+    long = grf.variogram('gaussian', 800.0, 400.0, 20.0, azimuth=30.0)
+    v = grf.nested_variogram([(0.6, short), (0.3, long)], nugget=0.1)
+    assert v.corr(0.0, 0.0, 0.0) == pytest.approx(1.0)
+    assert v.corr(40.0, 10.0, 1.0) == pytest.approx(0.6 * short.corr(40.0, 10.0, 1.0) + 0.3 * long.corr(40.0, 10.0, 1.0))
+    assert v.corr(200.0) == pytest.approx(0.3 * long.corr(200.0))
+
+
+def test_nested_variogram_keeps_copies():
+    v = grf.nested_variogram([(1.0, grf.variogram('exponential', 100.0))])
+    assert v.corr(50.0) == pytest.approx(grf.variogram('exponential', 100.0).corr(50.0))
+
+
+def test_nested_variogram_padding_from_longest_structure():
+    short = grf.variogram('spherical', 100.0, 800.0, 10.0)
+    long = grf.variogram('exponential', 600.0, 50.0, 5.0)
+    v = grf.nested_variogram([(0.5, short), (0.5, long)])
+    args = (100, 10.0, 80, 10.0, 20, 1.0)
+    sizes = [grf.simulation_size(w, *args) for w in (short, long)]
+    assert list(grf.simulation_size(v, *args)) == [max(s) for s in zip(*sizes)]
+
+
+def test_nested_variogram_simulation():
+    v = grf.nested_variogram([(0.5, grf.variogram('spherical', 20.0)), (0.3, grf.variogram('gaussian', 10.0))],
+                             nugget=0.2)
+    grf.seed(12)
+    field = grf.simulate(v, 300, 1.0, 300, 1.0)
+    assert field.size == 300 * 300
+    assert abs(np.var(field) - 1.0) < 0.2
+
+
+def test_nested_variogram_invalid():
+    with pytest.raises(RuntimeError):
+        grf.nested_variogram([(-1.0, grf.variogram('spherical', 10.0))])
+    with pytest.raises(RuntimeError):
+        grf.nested_variogram([], nugget=0.0)
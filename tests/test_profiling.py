@@ -0,0 +1,90 @@
+import json
+
+import numpy as np
+import pytest
+
+import gaussianfft as grf
+
+
+@pytest.fixture
+def profiling():
+    grf.profiling(True)
+    yield
+    grf.profiling(False)
+
+
+def test_profiling_is_off_by_default():
+    assert grf.profiling() is False
+
+
+def test_last_run_stats_3d(profiling):
+    grf.seed(1234)
+    v = grf.variogram('spherical', 1000.0, 250.0, 125.0)
+    nx, ny, nz = 50, 30, 10
+    grf.simulate(v, nx, 50.0, ny, 17.0, nz, 4.0)
+    stats = grf.last_run_stats()
+
+    assert len(stats['padded_size']) == 3
+    for size, factors in zip(stats['padded_size'], stats['fft_factors']):
+        assert int(np.prod(factors)) == size
+        assert max(factors) <= 7
+    assert stats['n_fields'] == 1
+    for stage in ['padding', 'covariance', 'filter', 'noise', 'fft', 'convolve', 'inverse_fft', 'extract', 'copy_out']:
+        assert stats['seconds'][stage] >= 0.0
+
+    # Two FFT grids of real and complex data, and the covariance and noise grids
+    n = int(np.prod(stats['padded_size']))
+    assert stats['peak_bytes'] >= 4 * n * 8
+    assert stats['bytes_allocated'] >= stats['peak_bytes']
+    # The FFT buffers are kept for the next simulation
+    assert stats['pooled_bytes'] > 0
+
+
+def test_last_run_stats_several_fields(profiling, tmp_path):
+    grf.seed(1234)
+    v = grf.variogram('spherical', 1000.0, 250.0, 125.0)
+    files = [tmp_path / 'real_{}.storm'.format(i) for i in range(3)]
+    grf.simulate_to_file(files, v, 40, 50.0, 30, 17.0, 10, 4.0)
+    stats = grf.last_run_stats()
+
+    assert stats['n_fields'] == 3
+    assert stats['seconds']['noise'] > 0.0
+    assert stats['seconds']['extract'] > 0.0
+    names = [event['name'] for event in json.loads(grf.last_run_trace())['traceEvents']]
+    assert names.count('noise') == 3
+    assert names.count('extract') == 3
+
+
+def test_last_run_stats_1d(profiling):
+    grf.seed(1234)
+    v = grf.variogram('gaussian', 100.0)
+    grf.simulate(v, 100, 1.0)
+    stats = grf.last_run_stats()
+    assert len(stats['padded_size']) == 1
+    assert stats['padded_size'][0] >= grf.simulation_size(v, 100, 1.0)[0]
+    assert 'fft' in stats['seconds']
+    assert 'inverse_fft' in stats['seconds']
+
+
+def test_profiling_does_not_change_result():
+    v = grf.variogram('exponential', 200.0, 100.0)
+    grf.seed(42)
+    a = grf.simulate(v, 40, 10.0, 30, 10.0)
+    grf.profiling(True)
+    try:
+        grf.seed(42)
+        b = grf.simulate(v, 40, 10.0, 30, 10.0)
+    finally:
+        grf.profiling(False)
+    assert np.array_equal(a, b)
+
+
+def test_last_run_trace(profiling):
+    v = grf.variogram('gaussian', 250.0)
+    grf.simulate(v, 50, 10.0, 50, 10.0)
+    trace = json.loads(grf.last_run_trace())
+    names = {event['name'] for event in trace['traceEvents']}
+    assert {'noise', 'fft', 'inverse_fft'} <= names
+    for event in trace['traceEvents']:
+        assert event['ph'] == 'X'
+        assert event['dur'] >= 0.0
@@ -17,8 +17,13 @@ class TestRmsGridModels(unittest.TestCase):
             # Not in RMS context, use other values instead
             d = (90, 120, 45)
         v = grf.variogram('matern52', 312.0, 312.0, 312.0)
-        grf.seed(1323)
-        f_vec = grf.simulate(v, d[0], 20.0, d[1], 20.0, d[2], 20.0)
+        # The regression values are from before the noise was made in blocks
+        grf.legacy_noise(True)
+        try:
+            grf.seed(1323)
+            f_vec = grf.simulate(v, d[0], 20.0, d[1], 20.0, d[2], 20.0)
+        finally:
+            grf.legacy_noise(False)
         f = np.array(f_vec).reshape(d, order='F')
         # Regression:
         self.assertAlmostEqual(f[11 + 10, 22 + 10, 13 + 10], -1.9465313106735047, 2)
@@ -1,3 +1,6 @@
+import numpy as np
+import pytest
+
 import gaussianfft as grf
 
 def test_simulation_size_1d():
@@ -28,3 +31,53 @@ def test_simulation_size_3d_uneven():
     assert a[0] == 528
     assert a[1] == 320
     assert a[2] == 135
+
+def test_simulate_rotated_frame():
+    # A variogram along the rotated grid axes is the same as an unrotated one.
+    grf.seed(21)
+    aligned = grf.simulate(grf.variogram('spherical', 400.0, 100.0, azimuth=35.0), 60, 20.0, 50, 20.0, rotation=35.0)
+    grf.seed(21)
+    expected = grf.simulate(grf.variogram('spherical', 400.0, 100.0), 60, 20.0, 50, 20.0)
+    assert np.array_equal(aligned, expected)
+
+    grf.seed(21)
+    across = grf.simulate(grf.variogram('spherical', 400.0, 100.0, azimuth=125.0), 60, 20.0, 50, 20.0, rotation=35.0)
+    grf.seed(21)
+    expected = grf.simulate(grf.variogram('spherical', 100.0, 400.0), 60, 20.0, 50, 20.0)
+    assert np.array_equal(across, expected)
+
+def test_legacy_noise():
+    v = grf.variogram('exponential', 200.0, 100.0)
+    assert not grf.legacy_noise()
+    grf.seed(8)
+    blocked = grf.simulate(v, 40, 10.0, 30, 10.0)
+    grf.legacy_noise(True)
+    try:
+        assert grf.legacy_noise()
+        grf.seed(8)
+        legacy = grf.simulate(v, 40, 10.0, 30, 10.0)
+        grf.seed(8)
+        assert np.array_equal(grf.simulate(v, 40, 10.0, 30, 10.0), legacy)
+    finally:
+        grf.legacy_noise(False)
+    assert not np.allclose(blocked, legacy)
+    assert abs(np.std(blocked) - np.std(legacy)) < 0.5
+
+def test_simulate_block_support():
+    v = grf.variogram('gaussian', 60.0)
+    nx, dx = 2000, 20.0
+    grf.seed(30)
+    point = grf.simulate(v, nx, dx)
+    grf.seed(30)
+    assert np.array_equal(grf.simulate(v, nx, dx, block=(0.0,)), point)
+
+    # Variance of the block averages, from the point covariance
+    offsets = (np.arange(40) + 0.5) * dx / 40
+    lags = (offsets[:, None] - offsets[None, :]).ravel()
+    expected = np.mean([v.corr(h) for h in lags])
+    grf.seed(30)
+    block = grf.simulate(v, nx, dx, block=(dx,))
+    assert abs(np.var(block) - expected) < 0.1
+    assert np.var(block) < np.var(point)
+    with pytest.raises(RuntimeError):
+        grf.simulate(v, nx, dx, block=(-1.0,))
@@ -14,7 +14,14 @@ def _cov_mat_genexp(range_: int, n: int, distance: int) -> npt.NDArray[np.double
     return s
 
 # Values for the tests below have been set based on the specific seed being used above. Using a random seed could
-# cause the tests to fail from time to time.
+# cause the tests to fail from time to time. The seeds were chosen with the legacy noise.
+
+@pytest.fixture(autouse=True)
+def legacy_noise():
+    grf.legacy_noise(True)
+    yield
+    grf.legacy_noise(False)
+
 
 @pytest.fixture
 def simulated_field():
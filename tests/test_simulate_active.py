@@ -0,0 +1,52 @@
+import numpy as np
+import pytest
+
+import gaussianfft as grf
+
+
+def test_mask_matches_simulate_3d():
+    v = grf.variogram('spherical', 300.0, 200.0, 20.0)
+    nx, ny, nz = 30, 20, 12
+    actnum = np.ones((nx, ny, nz), dtype=np.int32)
+    actnum[:10, :, 3:7] = 0
+    actnum[:, 15:, :] = 0
+    mask = actnum.astype(bool)
+
+    grf.seed(31)
+    full = grf.simulate(v, nx, 20.0, ny, 20.0, nz, 2.0)
+    grf.seed(31)
+    active = grf.simulate_active(v, mask, nx, 20.0, ny, 20.0, nz, 2.0)
+    assert active.shape == (mask.sum(),)
+    assert np.allclose(active, full[mask.ravel(order='F')])
+
+
+def test_indices_in_any_order():
+    v = grf.variogram('exponential', 300.0, 200.0, 20.0)
+    nx, ny, nz = 25, 15, 8
+    indices = np.array([nx * ny * nz - 1, 0, 17, 17, 900])
+    grf.seed(5)
+    full = grf.simulate(v, nx, 20.0, ny, 20.0, nz, 2.0)
+    grf.seed(5)
+    active = grf.simulate_active(v, indices, nx, 20.0, ny, 20.0, nz, 2.0)
+    assert np.allclose(active, full[indices])
+
+
+def test_mask_matches_simulate_2d_with_transform():
+    v = grf.variogram('gaussian', 200.0, 100.0)
+    nx, ny = 40, 30
+    mask = np.zeros((nx, ny), dtype=bool)
+    mask[5:25, 10:] = True
+    t = grf.Transform().affine(0.5, 2.0)
+    grf.seed(12)
+    full = grf.simulate(v, nx, 10.0, ny, 10.0, transform=t)
+    grf.seed(12)
+    active = grf.simulate_active(v, mask, nx, 10.0, ny, 10.0, transform=t)
+    assert np.allclose(active, full[mask.ravel(order='F')])
+
+
+def test_invalid_selection():
+    v = grf.variogram('gaussian', 200.0)
+    with pytest.raises(Exception):
+        grf.simulate_active(v, np.ones(10, dtype=bool), 20, 10.0)
+    with pytest.raises(Exception):
+        grf.simulate_active(v, np.array([0, 20]), 20, 10.0)
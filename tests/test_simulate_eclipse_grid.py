@@ -0,0 +1,55 @@
+import numpy as np
+import pytest
+
+import gaussianfft as grf
+
+
+def _write_box_grid(path, ni, nj, nk, dx, dy, dz, inactive=()):
+    """ Regular box grid with vertical pillars, as an Eclipse grid file. """
+    coord = []
+    for j in range(nj + 1):
+        for i in range(ni + 1):
+            coord += [i * dx, j * dy, 0.0, i * dx, j * dy, nk * dz]
+    zcorn = []
+    for k in range(nk):
+        for c in range(2):
+            zcorn += [(k + c) * dz] * (4 * ni * nj)
+    actnum = [1] * (ni * nj * nk)
+    for index in inactive:
+        actnum[index] = 0
+    with open(path, 'w') as f:
+        f.write('SPECGRID\n%d %d %d 1 F /\n\n' % (ni, nj, nk))
+        f.write('COORD\n' + '\n'.join(' '.join(str(v) for v in coord[n:n + 6]) for n in range(0, len(coord), 6)) + '\n/\n\n')
+        f.write('ZCORN\n' + '\n'.join(str(v) for v in zcorn) + '\n/\n\n')
+        f.write('ACTNUM\n' + '\n'.join(str(v) for v in actnum) + '\n/\n')
+
+
+def test_simulate_eclipse_grid_active_cells(tmp_path):
+    path = str(tmp_path / 'box.grdecl')
+    _write_box_grid(path, 8, 6, 4, 50.0, 50.0, 2.0, inactive=(0, 5, 17))
+    grid = grf.EclipseGrid(path)
+    assert (grid.ni, grid.nj, grid.nk) == (8, 6, 4)
+    active = grid.active_indices()
+    assert len(active) == 8 * 6 * 4 - 3
+    assert 5 not in active
+
+    v = grf.variogram('spherical', 300.0, 200.0, 6.0)
+    grf.seed(4)
+    values = grf.simulate_eclipse_grid(v, grid, 25.0, 25.0, 1.0)
+    assert values.shape == (len(active),)
+    grf.seed(4)
+    assert np.array_equal(grf.simulate_eclipse_grid(v, grid, 25.0, 25.0, 1.0), values)
+    assert grf.simulate_eclipse_grid(v, grid, 25.0, 25.0, 1.0, n_realizations=3).shape == (3, len(active))
+
+
+def test_simulate_eclipse_grid_parameter(tmp_path):
+    path = str(tmp_path / 'box.grdecl')
+    _write_box_grid(path, 4, 3, 2, 50.0, 50.0, 2.0)
+    grid = grf.EclipseGrid(path)
+    v = grf.variogram('gaussian', 200.0, 200.0, 5.0)
+    values = grf.simulate_eclipse_grid(v, grid, 25.0, 25.0, 1.0)
+    grid.add_parameter('FIELD', values)
+    with pytest.raises(Exception):
+        grid.add_parameter('SHORT', values[:-1])
+    grid.write(str(tmp_path / 'out.grdecl'))
+    assert 'FIELD' in (tmp_path / 'out.grdecl').read_text()
@@ -0,0 +1,43 @@
+import numpy as np
+import pytest
+
+import gaussianfft as grf
+
+
+def _jobs():
+    v1 = grf.variogram('spherical', 200.0, 100.0, 10.0)
+    v2 = grf.variogram('gaussian', 50.0, 50.0)
+    v3 = grf.variogram('exponential', 30.0)
+    return [
+        dict(variogram=v1, nx=40, dx=10.0, ny=30, dy=10.0, nz=10, dz=1.0, seed=1),
+        dict(variogram=v2, nx=50, dx=5.0, ny=20, dy=5.0, seed=2),
+        dict(variogram=v3, nx=100, dx=1.0, seed=3),
+        dict(variogram=v1, nx=10, dx=10.0, ny=10, dy=10.0, nz=5, dz=1.0),
+    ]
+
+
+def test_simulate_jobs_matches_seeded_simulate():
+    jobs = _jobs()
+    grf.seed(10)
+    fields = grf.simulate_jobs(jobs, n_threads=3)
+    assert len(fields) == len(jobs)
+    for job, field in zip(jobs[:3], fields):
+        grf.seed(job['seed'])
+        expected = grf.simulate(job['variogram'], job['nx'], job['dx'],
+                                job.get('ny', 1), job.get('dy', -1.0),
+                                job.get('nz', 1), job.get('dz', -1.0))
+        assert np.allclose(field, expected, atol=1e-12)
+
+
+def test_simulate_jobs_independent_of_threads():
+    grf.seed(10)
+    serial = grf.simulate_jobs(_jobs(), n_threads=1)
+    grf.seed(10)
+    parallel = grf.simulate_jobs(_jobs())
+    for a, b in zip(serial, parallel):
+        assert np.array_equal(a, b)
+
+
+def test_simulate_jobs_missing_keys():
+    with pytest.raises(RuntimeError):
+        grf.simulate_jobs([dict(nx=10, dx=1.0)])
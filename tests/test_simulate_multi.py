@@ -0,0 +1,46 @@
+import numpy as np
+import pytest
+
+import gaussianfft as grf
+
+
+@pytest.mark.parametrize('shape', [(1000,), (60, 50), (30, 20, 10)])
+def test_simulate_multi_shapes(shape):
+    variograms = [
+        grf.variogram('spherical', 100.0, 80.0, 20.0),
+        grf.variogram('gaussian', 50.0, 50.0, 10.0),
+        grf.variogram('exponential', 200.0, 100.0, 30.0),
+    ]
+    args = []
+    for n in shape:
+        args += [n, 5.0]
+    grf.seed(1337)
+    fields = grf.simulate_multi(variograms, *args)
+    assert len(fields) == len(variograms)
+    for f in fields:
+        assert f.size == np.prod(shape)
+        assert np.all(np.isfinite(f))
+    assert not np.allclose(fields[0], fields[1])
+
+
+def test_simulate_multi_is_reproducible():
+    variograms = [grf.variogram('spherical', 100.0), grf.variogram('matern52', 40.0)]
+    grf.seed(2024)
+    first = grf.simulate_multi(variograms, 40, 5.0, 30, 5.0)
+    grf.seed(2024)
+    second = grf.simulate_multi(variograms, 40, 5.0, 30, 5.0)
+    for a, b in zip(first, second):
+        assert np.array_equal(a, b)
+
+
+def test_simulate_multi_variance():
+    v = grf.variogram('exponential', 10.0, 10.0)
+    grf.seed(7)
+    fields = grf.simulate_multi([v] * 8, 100, 1.0, 100, 1.0)
+    values = np.concatenate(fields)
+    assert abs(np.mean(values)) < 0.1
+    assert abs(np.var(values) - 1.0) < 0.15
+
+
+def test_simulate_multi_empty():
+    assert grf.simulate_multi([], 10, 1.0) == []
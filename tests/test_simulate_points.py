@@ -0,0 +1,33 @@
+import numpy as np
+import pytest
+
+import gaussianfft as grf
+
+
+def test_simulate_points_shapes():
+    v = grf.variogram('exponential', 100.0, 50.0, 10.0)
+    grf.seed(3)
+    assert grf.simulate_points(v, np.linspace(0.0, 1000.0, 7)).shape == (7,)
+    assert grf.simulate_points(v, np.zeros((5, 2))).shape == (5,)
+    assert grf.simulate_points(v, np.zeros((4, 3)), n_features=10).shape == (4,)
+    with pytest.raises(Exception):
+        grf.simulate_points(v, np.zeros((4, 4)))
+
+
+def test_simulate_points_seed():
+    v = grf.variogram('matern52', 200.0, 100.0, azimuth=30.0)
+    xy = np.random.default_rng(1).uniform(0.0, 5000.0, size=(100, 2))
+    grf.seed(11)
+    first = grf.simulate_points(v, xy)
+    grf.seed(11)
+    assert np.array_equal(grf.simulate_points(v, xy), first)
+
+
+def test_simulate_points_covariance():
+    v = grf.variogram('spherical', 40.0)
+    points = np.array([[0.0], [15.0], [1.0e6]])
+    grf.seed(5)
+    values = np.array([grf.simulate_points(v, points, n_features=50) for _ in range(4000)])
+    assert abs(np.var(values[:, 0]) - 1.0) < 0.1
+    assert abs(np.mean(values[:, 0] * values[:, 1]) - v.corr(15.0)) < 0.1
+    assert abs(np.mean(values[:, 0] * values[:, 2])) < 0.1
@@ -0,0 +1,48 @@
+import numpy as np
+import pytest
+
+import gaussianfft as grf
+
+
+def test_simulate_slabs_vertical_correlation():
+    v = grf.variogram('exponential', 200.0, 100.0)
+    nx, ny, nz, dz = 30, 20, 500, 1.0
+    grf.seed(4)
+    z = grf.simulate_slabs(v, 10.0, nx, 20.0, ny, 20.0, nz, dz)
+    assert z.shape == (nx * ny * nz,)
+    layers = z.reshape((nz, nx * ny))
+    rho = np.sum(layers[:-1] * layers[1:]) / np.sum(layers[:-1] ** 2)
+    assert abs(rho - np.exp(-3.0 * dz / 10.0)) < 0.05
+    assert abs(np.var(z) - 1.0) < 0.2
+
+
+def test_simulate_slabs_out_and_callback():
+    v = grf.variogram('spherical', 100.0, 100.0)
+    args = (5.0, 20, 10.0, 15, 10.0, 8, 1.0)
+    grf.seed(9)
+    expected = grf.simulate_slabs(v, *args)
+
+    out = np.empty(20 * 15 * 8)
+    grf.seed(9)
+    result = grf.simulate_slabs(v, *args, out=out)
+    assert np.shares_memory(result, out)
+    assert np.array_equal(out, expected)
+
+    layers = {}
+    grf.seed(9)
+    assert grf.simulate_slabs(v, *args, callback=lambda k, layer: layers.__setitem__(k, layer)) is None
+    assert sorted(layers) == list(range(8))
+    assert np.array_equal(np.concatenate([layers[k] for k in range(8)]), expected)
+
+    with pytest.raises(RuntimeError):
+        grf.simulate_slabs(grf.variogram('spherical', 100.0, 100.0, 5.0, dip=10.0), *args)
+    with pytest.raises(RuntimeError):
+        grf.simulate_slabs(v, 0.0, *args[1:])
+
+
+def test_simulate_slabs_vertical_section():
+    v = grf.variogram('gaussian', 100.0)
+    grf.seed(3)
+    z = grf.simulate_slabs(v, 5.0, 40, 10.0, 1, 10.0, 30, 1.0)
+    assert z.shape == (40 * 30,)
+    assert np.all(np.isfinite(z))
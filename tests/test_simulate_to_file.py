@@ -0,0 +1,56 @@
+import numpy as np
+import pytest
+
+import gaussianfft as grf
+
+
+def read_storm_binary(path, n):
+    content = path.read_bytes()
+    # The file ends with the binary data followed by '0' (number of barriers)
+    assert content.endswith(b'0')
+    header = content[:-(4 * n + 1)].decode()
+    data = np.frombuffer(content[-(4 * n + 1):-1], dtype='>f4')
+    return header, data
+
+
+def test_simulate_to_file_matches_simulate(tmp_path):
+    v = grf.variogram('gaussian', 500.0, 200.0, 20.0)
+    nx, ny, nz = 20, 15, 7
+    dx, dy, dz = 25.0, 30.0, 4.0
+
+    grf.seed(4321)
+    files = [tmp_path / 'real_{}.storm'.format(i) for i in range(3)]
+    grf.simulate_to_file(files, v, nx, dx, ny, dy, nz, dz)
+
+    grf.seed(4321)
+    expected = [grf.simulate(v, nx, dx, ny, dy, nz, dz) for _ in files]
+
+    for f, e in zip(files, expected):
+        header, data = read_storm_binary(f, nx * ny * nz)
+        assert header.startswith('storm_petro_binary')
+        assert '{} {} {}'.format(nx, ny, nz) in header
+        assert np.allclose(data, e.astype(np.float32), atol=1e-5)
+
+
+def test_simulate_to_file_mask(tmp_path):
+    v = grf.variogram('spherical', 300.0, 300.0, 10.0)
+    nx, ny, nz = 10, 8, 4
+    mask = np.ones((nx, ny, nz), dtype=bool)
+    mask[:5, :, 1] = False
+
+    f = tmp_path / 'masked.storm'
+    grf.seed(99)
+    grf.simulate_to_file(str(f), v, nx, 10.0, ny, 10.0, nz, 2.0,
+                         mask=mask.flatten(order='F'), missing_code=-999.0)
+    header, data = read_storm_binary(f, nx * ny * nz)
+    values = data.reshape((nx, ny, nz), order='F')
+    assert '-999' in header
+    assert np.all(values[~mask] == -999.0)
+    assert np.all(values[mask] != -999.0)
+
+
+def test_simulate_to_file_wrong_mask_size(tmp_path):
+    v = grf.variogram('spherical', 300.0)
+    with pytest.raises(RuntimeError):
+        grf.simulate_to_file(tmp_path / 'x.storm', v, 10, 1.0, 10, 1.0, 10, 1.0,
+                             mask=np.ones(10, dtype=bool))
@@ -0,0 +1,28 @@
+import numpy as np
+
+import gaussianfft as grf
+
+
+def test_simulate_traces_matches_simulate():
+    v = grf.variogram('spherical', 30.0)
+    grf.seed(1234)
+    traces = grf.simulate_traces(v, 5, 80, 1.5)
+    assert traces.shape == (5, 80)
+    grf.seed(1234)
+    for t in range(5):
+        assert np.allclose(traces[t], grf.simulate(v, 80, 1.5), atol=1e-12)
+
+
+def test_simulate_traces_statistics():
+    v = grf.variogram('exponential', 10.0)
+    grf.seed(2)
+    traces = grf.simulate_traces(v, 3000, 50, 1.0)
+    assert abs(np.mean(traces)) < 0.05
+    assert abs(np.var(traces) - 1.0) < 0.05
+    corr = np.mean(traces[:, :-10] * traces[:, 10:])
+    assert abs(corr - v.corr(10.0)) < 0.05
+
+
+def test_simulate_traces_empty():
+    v = grf.variogram('gaussian', 10.0)
+    assert grf.simulate_traces(v, 0, 20, 1.0).shape == (0, 20)
@@ -0,0 +1,49 @@
+import numpy as np
+import pytest
+
+import gaussianfft as grf
+
+
+def _plan(max_memory=0):
+    v = grf.variogram('spherical', 1000.0, 250.0, 125.0)
+    return grf.advanced.simulation_plan(v, 100, 20.0, 80, 20.0, 20, 10.0, max_memory=max_memory)
+
+
+def test_plan_without_limit_is_standard():
+    plan = _plan()
+    assert plan['strategy'] == 'standard'
+    assert len(plan['padded_size']) == 3
+    assert plan['peak_bytes'] >= max(plan['buffers'].values())
+    assert plan['flops'] > 0
+
+
+def test_plan_selects_lean_strategy():
+    standard = _plan()
+    lean = _plan(max_memory=standard['peak_bytes'] - 1)
+    assert lean['strategy'] in ('lean', 'single_precision')
+    assert lean['peak_bytes'] < standard['peak_bytes']
+
+
+def test_plan_raises_if_nothing_fits():
+    with pytest.raises(RuntimeError):
+        _plan(max_memory=1024)
+
+
+def test_lean_simulation_equals_standard():
+    v = grf.variogram('exponential', 500.0, 300.0, 100.0)
+    args = (v, 30, 20.0, 20, 20.0, 10, 10.0)
+    standard = grf.advanced.simulation_plan(*args)
+    lean = grf.advanced.simulation_plan(*args, max_memory=standard['peak_bytes'] - 1)
+    assert lean['strategy'] == 'lean'
+
+    grf.seed(123)
+    a = grf.advanced.simulate(*args)
+    grf.seed(123)
+    b = grf.advanced.simulate(*args, max_memory=lean['peak_bytes'])
+    assert np.array_equal(a, b)
+
+
+def test_simulate_raises_before_running():
+    v = grf.variogram('gaussian', 1000.0)
+    with pytest.raises(RuntimeError):
+        grf.advanced.simulate(v, 1000, 1.0, 1000, 1.0, 1000, 1.0, max_memory=2**20)
@@ -0,0 +1,119 @@
+import itertools
+
+import numpy as np
+import pytest
+
+import gaussianfft as grf
+
+
+@pytest.mark.parametrize('args', [(200, 5.0), (60, 5.0, 40, 5.0), (30, 5.0, 20, 5.0, 10, 2.0)])
+def test_simulator_matches_simulate(args):
+    v = grf.variogram('exponential', 100.0, 60.0, 10.0)
+    sim = grf.Simulator(v, *args)
+    assert len(sim.padded_size) == len(args) // 2
+    grf.seed(100)
+    expected = [grf.simulate(v, *args) for _ in range(2)]
+    grf.seed(100)
+    actual = [sim.simulate() for _ in range(2)]
+    for a, e in zip(actual, expected):
+        assert np.allclose(a, e, rtol=1e-10, atol=1e-12)
+
+
+def test_simulator_sequence_correlation():
+    v = grf.variogram('spherical', 3.0, 3.0)
+    sim = grf.Simulator(v, 200, 1.0, 200, 1.0)
+    grf.seed(5)
+    rho = 0.7
+    fields = list(sim.sequence(rho, 6))
+    assert len(fields) == 6
+    corr = [np.corrcoef(a, b)[0, 1] for a, b in zip(fields[:-1], fields[1:])]
+    assert abs(np.mean(corr) - rho) < 0.05
+    assert all(abs(np.var(f) - 1.0) < 0.1 for f in fields)
+
+
+def test_simulator_sequence_starts_with_current_state():
+    v = grf.variogram('gaussian', 20.0)
+    sim = grf.Simulator(v, 50, 1.0, 40, 1.0)
+    grf.seed(3)
+    current = sim.field()
+    first = next(iter(sim.sequence(0.5)))
+    assert np.array_equal(current, first)
+    infinite = sim.sequence(0.99)
+    assert len(list(itertools.islice(infinite, 4))) == 4
+    with pytest.raises(RuntimeError):
+        sim.sequence(2.0)
+
+
+def test_simulator_deformation():
+    v = grf.variogram('exponential', 30.0, 30.0, 5.0)
+    sim = grf.Simulator(v, 30, 2.0, 30, 2.0, 8, 1.0)
+    grf.seed(8)
+    current = sim.field()
+    assert np.allclose(sim.deform(0.0), current)
+    deformed = sim.deform(0.4)
+    assert not np.allclose(deformed, current)
+    assert np.allclose(sim.deform(0.4), deformed)
+    sim.accept(0.4)
+    assert np.allclose(sim.field(), deformed)
+    with pytest.raises(RuntimeError):
+        sim.accept(0.4)
+
+
+def test_simulator_step_rejects_invalid_correlation():
+    v = grf.variogram('spherical', 10.0)
+    sim = grf.Simulator(v, 100, 1.0)
+    with pytest.raises(RuntimeError):
+        sim.step(1.5)
+
+
+def test_simulator_apply_adjoint_dot_product():
+    v = grf.variogram('exponential', 40.0, 20.0)
+    sim = grf.Simulator(v, 50, 2.0, 30, 2.0)
+    assert sim.noise_size == int(np.prod(sim.padded_size))
+    rng = np.random.default_rng(1)
+    e = rng.standard_normal((4, sim.noise_size))
+    g = rng.standard_normal((4, 50 * 30))
+    le = sim.apply(e)
+    ltg = sim.apply_adjoint(g)
+    assert le.shape == g.shape
+    assert ltg.shape == e.shape
+    assert np.allclose(np.sum(le * g, axis=1), np.sum(e * ltg, axis=1))
+
+
+def test_simulator_apply_batch_and_out():
+    v = grf.variogram('spherical', 30.0)
+    sim = grf.Simulator(v, 200, 1.0)
+    rng = np.random.default_rng(2)
+    e = rng.standard_normal((3, sim.noise_size))
+    batch = sim.apply(e)
+    for b in range(3):
+        assert np.allclose(sim.apply(e[b]), batch[b])
+    out = np.empty((3, 200))
+    result = sim.apply(e, out=out)
+    assert np.shares_memory(result, out)
+    assert np.allclose(out, batch)
+    with pytest.raises(RuntimeError):
+        sim.apply(e[:, :-1])
+    with pytest.raises(RuntimeError):
+        sim.apply(e, out=np.empty((3, 199)))
+
+
+def test_simulator_derivatives():
+    v = grf.variogram('gaussian', 300.0, 200.0)
+    nx, dx, ny, dy = 60, 10.0, 50, 8.0
+    sim = grf.Simulator(v, nx, dx, ny, dy)
+    grf.seed(12)
+    expected = sim.simulate()
+    grf.seed(12)
+    field, derivatives = sim.simulate_with_derivatives(laplacian=True)
+    assert np.allclose(field, expected)
+    assert derivatives.shape == (3, nx * ny)
+    z = field.reshape((ny, nx))
+    gy, gx = np.gradient(z, dy, dx)
+    inner = (slice(2, -2), slice(2, -2))
+    for derivative, difference in zip(derivatives[:2], (gx, gy)):
+        derivative = derivative.reshape((ny, nx))
+        error = np.linalg.norm(derivative[inner] - difference[inner])
+        assert error < 0.05 * np.linalg.norm(difference[inner])
+    _, derivatives = sim.simulate_with_derivatives()
+    assert derivatives.shape == (2, nx * ny)
@@ -0,0 +1,60 @@
+import numpy as np
+import pytest
+
+import gaussianfft as grf
+
+
+def test_transform_matches_numpy():
+    v = grf.variogram('spherical', 50.0, 30.0)
+    nx, ny = 40, 30
+    trend = np.linspace(0.0, 1.0, nx * ny)
+    grf.seed(100)
+    z = grf.simulate(v, nx, 5.0, ny, 5.0)
+    grf.seed(100)
+    t = grf.Transform().affine(0.5, 2.0).trend(trend).exp()
+    x = grf.simulate(v, nx, 5.0, ny, 5.0, transform=t)
+    assert x.dtype == np.float64
+    assert np.allclose(x, np.exp(0.5 * z + 2.0 + trend))
+    assert np.allclose(t.apply(z), x)
+
+
+def test_transform_thresholds_give_int8():
+    v = grf.variogram('gaussian', 20.0)
+    grf.seed(7)
+    z = grf.simulate(v, 200, 1.0, 100, 1.0)
+    grf.seed(7)
+    t = grf.Transform().thresholds([-0.5, 0.5])
+    assert t.has_thresholds
+    facies = grf.simulate(v, 200, 1.0, 100, 1.0, transform=t)
+    assert facies.dtype == np.int8
+    assert np.array_equal(facies, np.digitize(z, [-0.5, 0.5]))
+
+
+def test_transform_3d_thresholds_match_untransformed():
+    v = grf.variogram('spherical', 80.0, 60.0, 10.0)
+    grf.seed(21)
+    z = grf.simulate(v, 30, 5.0, 20, 5.0, 8, 2.0)
+    grf.seed(21)
+    t = grf.Transform().affine(2.0, 0.5).thresholds([0.0, 1.0])
+    facies = grf.simulate(v, 30, 5.0, 20, 5.0, 8, 2.0, transform=t)
+    assert facies.dtype == np.int8
+    assert np.array_equal(facies, np.digitize(2.0 * z + 0.5, [0.0, 1.0]))
+
+
+def test_transform_table_and_lognormal():
+    z = np.array([[-3.0, -0.5], [1.0, 5.0]])
+    t = grf.Transform().table([-1.0, 0.0, 2.0], [0.0, 10.0, 20.0])
+    out = t.apply(z)
+    assert out.shape == z.shape
+    assert np.allclose(out, [[0.0, 5.0], [15.0, 20.0]])
+
+    x = grf.Transform().lognormal(10.0, 2.0).apply(np.random.RandomState(1).normal(size=200000))
+    assert abs(np.mean(x) - 10.0) < 0.05
+    assert abs(np.std(x) - 2.0) < 0.05
+
+
+def test_transform_trend_size():
+    v = grf.variogram('gaussian', 20.0)
+    t = grf.Transform().trend(np.zeros(10))
+    with pytest.raises(RuntimeError):
+        grf.simulate(v, 11, 1.0, transform=t)
@@ -0,0 +1,52 @@
+import numpy as np
+import pytest
+
+import gaussianfft as grf
+
+
+@pytest.mark.parametrize('vtype', ['exponential', 'spherical', 'gaussian', 'general_exponential',
+                                   'matern32', 'matern52', 'matern72'])
+def test_corr_array_matches_corr(vtype):
+    v = grf.variogram(vtype, 100.0, 60.0, 20.0, azimuth=30.0, dip=5.0, power=1.3)
+    rng = np.random.default_rng(7)
+    dx, dy, dz = rng.uniform(-150.0, 150.0, (3, 50, 40))
+    dx[0, 0] = dy[0, 0] = dz[0, 0] = 0.0
+
+    c1 = v.corr_array(dx)
+    c2 = v.corr_array(dx, dy)
+    c3 = v.corr_array(dx, dy, dz)
+    assert c1.shape == dx.shape
+    for i, j in [(0, 0), (3, 7), (49, 39), (20, 2)]:
+        assert c1[i, j] == pytest.approx(v.corr(dx[i, j]), rel=1e-10, abs=1e-14)
+        assert c2[i, j] == pytest.approx(v.corr(dx[i, j], dy[i, j]), rel=1e-10, abs=1e-14)
+        assert c3[i, j] == pytest.approx(v.corr(dx[i, j], dy[i, j], dz[i, j]), rel=1e-10, abs=1e-14)
+
+
+def test_corr_array_invalid_input():
+    v = grf.variogram('spherical', 10.0)
+    with pytest.raises(RuntimeError):
+        v.corr_array(np.zeros(5), np.zeros(4))
+    with pytest.raises(RuntimeError):
+        v.corr_array(np.zeros(5), dz=np.zeros(5))
+
+
+def test_cov_matrix():
+    v = grf.variogram('exponential', 50.0, 30.0, 10.0, azimuth=20.0)
+    rng = np.random.default_rng(8)
+    a = rng.uniform(0.0, 100.0, (30, 3))
+    b = rng.uniform(0.0, 100.0, (20, 3))
+    cov = v.cov_matrix(a, b)
+    assert cov.shape == (30, 20)
+    expected = np.array([[v.corr(*(q - p)) for q in b] for p in a])
+    assert np.allclose(cov, expected)
+
+    cov_aa = v.cov_matrix(a[:, :2])
+    assert cov_aa.shape == (30, 30)
+    assert np.allclose(cov_aa, cov_aa.T)
+    assert np.allclose(np.diag(cov_aa), 1.0)
+
+    x = np.linspace(0.0, 100.0, 11)
+    assert np.allclose(v.cov_matrix(x)[0], v.corr_array(x))
+
+    with pytest.raises(RuntimeError):
+        v.cov_matrix(a, b[:, :2])
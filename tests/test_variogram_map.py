@@ -0,0 +1,58 @@
+import numpy as np
+import pytest
+
+import gaussianfft as grf
+
+
+def _brute_force(field, mask, a, b):
+    nx, ny = field.shape
+    total, n = 0.0, 0
+    for i in range(nx):
+        for j in range(ny):
+            i2, j2 = i + a, j + b
+            if 0 <= i2 < nx and 0 <= j2 < ny and mask[i, j] and mask[i2, j2]:
+                total += (field[i2, j2] - field[i, j]) ** 2
+                n += 1
+    return total, n
+
+
+def test_variogram_map_matches_brute_force():
+    nx, ny = 8, 6
+    rng = np.random.RandomState(3)
+    field = rng.normal(size=(nx, ny))
+    mask = rng.uniform(size=(nx, ny)) < 0.8
+    vmap = grf.VariogramMap(nx, 1.0, ny, 1.0, mask=mask)
+    vmap.add(field)
+    assert vmap.n_realizations == 1
+    gamma, pairs = vmap.map()
+    assert gamma.shape == (2 * nx - 1, 2 * ny - 1, 1)
+    for a in range(1 - nx, nx):
+        for b in range(1 - ny, ny):
+            total, n = _brute_force(field, mask, a, b)
+            assert pairs[a + nx - 1, b + ny - 1, 0] == n
+            if n > 0:
+                assert gamma[a + nx - 1, b + ny - 1, 0] == pytest.approx(total / (2 * n))
+            else:
+                assert np.isnan(gamma[a + nx - 1, b + ny - 1, 0])
+
+
+def test_variogram_map_recovers_variogram():
+    v = grf.variogram('exponential', 20.0)
+    grf.seed(11)
+    vmap = grf.VariogramMap(100, 1.0, 100, 1.0)
+    for _ in range(20):
+        vmap.add(grf.simulate(v, 100, 1.0, 100, 1.0))
+    distance, gamma, pairs = vmap.radial(1.0, n_bins=15)
+    assert len(distance) == 15
+    assert np.isnan(distance[0])
+    expected = 1.0 - v.corr_array(distance[1:])
+    assert np.allclose(gamma[1:], expected, atol=0.1)
+
+    distance, gamma, pairs = vmap.directional(90.0, 1.0, tolerance=1.0, n_bins=10)
+    assert np.all(pairs[1:] == 20 * 100 * (100 - np.arange(1, 10)))
+
+
+def test_variogram_map_wrong_size():
+    vmap = grf.VariogramMap(10, 1.0, 10, 1.0)
+    with pytest.raises(RuntimeError):
+        vmap.add(np.zeros(99))
@@ -0,0 +1,45 @@
+import numpy as np
+
+import gaussianfft as grf
+
+
+def test_repeated_simulations_reuse_workspace():
+    v = grf.variogram('exponential', 300.0, 200.0, 20.0)
+    grf.release_workspace()
+    grf.seed(3)
+    a = grf.simulate(v, 40, 10.0, 30, 10.0, 10, 2.0)
+    grf.seed(3)
+    b = grf.simulate(v, 40, 10.0, 30, 10.0, 10, 2.0)
+    assert np.array_equal(a, b)
+    assert grf.release_workspace() > 0
+    assert grf.release_workspace() == 0
+
+
+def test_huge_pages_do_not_change_result():
+    v = grf.variogram('gaussian', 200.0, 100.0)
+    grf.seed(5)
+    a = grf.simulate(v, 300, 5.0, 200, 5.0)
+    grf.release_workspace()
+    grf.huge_pages(True)
+    try:
+        assert grf.huge_pages()
+        grf.seed(5)
+        b = grf.simulate(v, 300, 5.0, 200, 5.0)
+    finally:
+        grf.huge_pages(False)
+        grf.release_workspace()
+    assert not grf.huge_pages()
+    assert np.array_equal(a, b)
+
+
+def test_workspace_limit():
+    limit = grf.workspace_limit()
+    assert limit > 0
+    v = grf.variogram('exponential', 300.0, 200.0, 20.0)
+    try:
+        grf.workspace_limit(0)
+        grf.simulate(v, 40, 10.0, 30, 10.0, 10, 2.0)
+        assert grf.release_workspace() == 0
+    finally:
+        grf.workspace_limit(limit)
+    assert grf.workspace_limit() == limit